@@ -0,0 +1,291 @@
+/****************************************************************************************
+ *   FileName    : ChannelLatencyBench.c
+ *   Description : Telechips Control Channel Latency Benchmark
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <dbus/dbus.h>
+#include "DBusMsgDef.h"
+
+/*
+ * Round trip of method_mediaplayback_get_state through dbus-daemon and
+ * through the peer channel of a running daemon started with
+ * --control-socket. The call does no work in the daemon, so the numbers are
+ * the cost of the transport.
+ *
+ *   ChannelLatencyBench [--session] [--socket path] [--count n]
+ */
+#define BENCH_DEFAULT_COUNT				10000
+#define BENCH_TIMEOUT_MS				1000
+#define BENCH_RECEIVE_SIZE				(64 * 1024)
+
+static uint64_t GetNanoseconds(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static int CompareSamples(const void *a, const void *b)
+{
+	uint64_t left = *(const uint64_t *)a;
+	uint64_t right = *(const uint64_t *)b;
+
+	return (left > right) - (left < right);
+}
+
+static void PrintResult(const char *name, uint64_t *samples, uint32_t count, uint64_t total)
+{
+	qsort(samples, count, sizeof(uint64_t), CompareSamples);
+	(void)printf("%-8s: p50 %7.1f us, p90 %7.1f us, p99 %7.1f us, max %7.1f us, %8.0f calls/s\n",
+				 name,
+				 (double)samples[count / 2U] / 1000.0,
+				 (double)samples[(count * 9U) / 10U] / 1000.0,
+				 (double)samples[(count * 99U) / 100U] / 1000.0,
+				 (double)samples[count - 1U] / 1000.0,
+				 (double)count * 1000000000.0 / (double)total);
+}
+
+static int32_t RunBus(DBusBusType type, uint64_t *samples, uint32_t count, uint64_t *total)
+{
+	int32_t ret = 0;
+	DBusError error;
+	DBusConnection *connection;
+	uint32_t idx;
+	uint64_t start;
+
+	dbus_error_init(&error);
+	connection = dbus_bus_get_private(type, &error);
+	if (connection == NULL)
+	{
+		(void)fprintf(stderr, "bus: %s\n", error.message);
+		dbus_error_free(&error);
+		ret = -1;
+	}
+	else
+	{
+		start = GetNanoseconds();
+		for (idx = 0; (idx < count) && (ret == 0); idx++)
+		{
+			DBusMessage *call = dbus_message_new_method_call(MEDIAPLAYBACK_PROCESS_DBUS_NAME,
+															 MEDIAPLAYBACK_PROCESS_OBJECT_PATH,
+															 MEDIAPLAYBACK_EVENT_INTERFACE,
+															 METHOD_MEDIAPLAYBACK_GET_STATE);
+			DBusMessage *reply;
+			uint64_t sent = GetNanoseconds();
+
+			reply = dbus_connection_send_with_reply_and_block(connection, call, BENCH_TIMEOUT_MS, &error);
+			samples[idx] = GetNanoseconds() - sent;
+			dbus_message_unref(call);
+			if (reply != NULL)
+			{
+				dbus_message_unref(reply);
+			}
+			else
+			{
+				(void)fprintf(stderr, "bus: %s\n", error.message);
+				dbus_error_free(&error);
+				ret = -1;
+			}
+		}
+		*total = GetNanoseconds() - start;
+		dbus_connection_close(connection);
+		dbus_connection_unref(connection);
+	}
+
+	return ret;
+}
+
+static int32_t ReceiveReply(int32_t fd, char *buffer, uint32_t serial)
+{
+	int32_t ret = -1;
+	bool done = false;
+
+	/* signals sent to every client may come before the reply */
+	while (done == false)
+	{
+		ssize_t length = recv(fd, buffer, BENCH_RECEIVE_SIZE, 0);
+
+		if (length > 0)
+		{
+			DBusError error;
+			DBusMessage *message;
+
+			dbus_error_init(&error);
+			message = dbus_message_demarshal(buffer, (int)length, &error);
+			if (message != NULL)
+			{
+				if (dbus_message_get_reply_serial(message) == serial)
+				{
+					ret = (dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_METHOD_RETURN) ? 0 : -1;
+					done = true;
+				}
+				dbus_message_unref(message);
+			}
+			else
+			{
+				dbus_error_free(&error);
+			}
+		}
+		else if ((length < 0) && (errno == EINTR))
+		{
+			;
+		}
+		else
+		{
+			done = true;
+		}
+	}
+
+	return ret;
+}
+
+static int32_t RunSocket(const char *path, uint64_t *samples, uint32_t count, uint64_t *total)
+{
+	int32_t ret = 0;
+	struct sockaddr_un address;
+	char *buffer = (char *)malloc(BENCH_RECEIVE_SIZE);
+	int32_t fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	uint32_t idx;
+	uint64_t start;
+
+	(void)memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	(void)strncpy(address.sun_path, path, sizeof(address.sun_path) - 1U);
+
+	if ((buffer == NULL) || (fd < 0) || (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0))
+	{
+		(void)fprintf(stderr, "socket: connect to %s failed: error(%d)\n", path, errno);
+		ret = -1;
+	}
+	else
+	{
+		start = GetNanoseconds();
+		for (idx = 0; (idx < count) && (ret == 0); idx++)
+		{
+			DBusMessage *call = dbus_message_new_method_call(NULL,
+															 MEDIAPLAYBACK_PROCESS_OBJECT_PATH,
+															 MEDIAPLAYBACK_EVENT_INTERFACE,
+															 METHOD_MEDIAPLAYBACK_GET_STATE);
+			char *data = NULL;
+			int length = 0;
+			uint64_t sent = GetNanoseconds();
+
+			dbus_message_set_serial(call, idx + 1U);
+			if ((!dbus_message_marshal(call, &data, &length)) ||
+				(send(fd, data, (size_t)length, MSG_NOSIGNAL) != (ssize_t)length) ||
+				(ReceiveReply(fd, buffer, idx + 1U) != 0))
+			{
+				(void)fprintf(stderr, "socket: call %u failed\n", idx);
+				ret = -1;
+			}
+			samples[idx] = GetNanoseconds() - sent;
+			if (data != NULL)
+			{
+				dbus_free(data);
+			}
+			dbus_message_unref(call);
+		}
+		*total = GetNanoseconds() - start;
+	}
+
+	if (fd >= 0)
+	{
+		(void)close(fd);
+	}
+	free(buffer);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	DBusBusType type = DBUS_BUS_SYSTEM;
+	const char *path = NULL;
+	uint32_t count = BENCH_DEFAULT_COUNT;
+	uint64_t *samples;
+	uint64_t total = 0;
+	int32_t idx;
+	int32_t ret = 0;
+
+	for (idx = 1; idx < argc; idx++)
+	{
+		if (strcmp(argv[idx], "--session") == 0)
+		{
+			type = DBUS_BUS_SESSION;
+		}
+		else if ((strcmp(argv[idx], "--socket") == 0) && ((idx + 1) < argc))
+		{
+			idx++;
+			path = argv[idx];
+		}
+		else if ((strcmp(argv[idx], "--count") == 0) && ((idx + 1) < argc))
+		{
+			idx++;
+			count = (uint32_t)strtoul(argv[idx], NULL, 10);
+		}
+		else
+		{
+			(void)fprintf(stderr, "usage: %s [--session] [--socket path] [--count n]\n", argv[0]);
+			ret = 1;
+		}
+	}
+
+	samples = (count > 0U) ? (uint64_t *)calloc(count, sizeof(uint64_t)) : NULL;
+	if ((ret == 0) && (samples != NULL))
+	{
+		(void)printf("%u calls of %s\n", count, METHOD_MEDIAPLAYBACK_GET_STATE);
+		if (RunBus(type, samples, count, &total) == 0)
+		{
+			PrintResult("bus", samples, count, total);
+		}
+		else
+		{
+			ret = 1;
+		}
+
+		if (path != NULL)
+		{
+			if (RunSocket(path, samples, count, &total) == 0)
+			{
+				PrintResult("socket", samples, count, total);
+			}
+			else
+			{
+				ret = 1;
+			}
+		}
+	}
+	free(samples);
+
+	return ret;
+}
@@ -0,0 +1,216 @@
+/****************************************************************************************
+ *   FileName    : CrossfadeBench.c
+ *   Description : Telechips Audio Crossfade Benchmark
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "AudioCrossfadeKernel.h"
+
+/*
+ * Cost of mixing a crossfade, the work the mixer adds on top of the second
+ * decoder while two tracks overlap, against the scalar reference, in ns per
+ * frame and in percent of one core. The fade runs in blocks of the mixer
+ * and ramps of AUDIO_CROSSFADE_SEGMENT frames, as in the daemon. The kernel
+ * must match the reference, and the gains must keep the power of the sum,
+ * start at the outgoing track and end at the incoming one.
+ */
+#define BENCH_CROSSFADE_RATE			48000
+#define BENCH_CROSSFADE_FRAMES			1024		/* per block */
+#define BENCH_CROSSFADE_SECONDS			12			/* the longest fade */
+#define BENCH_CROSSFADE_RUNS			20
+#define BENCH_CROSSFADE_POWER_TOLERANCE	(0.001)
+
+typedef void (*MixFunction)(float *mix, const float *in, const float *out, uint32_t frames,
+							const AudioCrossfadeRamp *ramp);
+
+static uint64_t GetNanoseconds(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static void FillSignal(float *data, uint32_t frames, double frequency, uint32_t seed)
+{
+	uint32_t frame;
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		double sample = 0.4 * sin((2.0 * M_PI * frequency * (double)frame) / (double)BENCH_CROSSFADE_RATE);
+
+		seed = (seed * 1103515245U) + 12345U;
+		data[frame * 2U] = (float)(sample + (0.05 * (((double)(seed >> 16) / 32768.0) - 1.0)));
+		data[(frame * 2U) + 1U] = (float)(sample * 0.5);
+	}
+}
+
+/* the whole fade, block by block and ramp by ramp */
+static uint64_t Fade(MixFunction mix, float *result, const float *in, const float *out, uint32_t length)
+{
+	uint64_t elapsed = 0;
+	uint32_t block;
+
+	for (block = 0; block < length; block += BENCH_CROSSFADE_FRAMES)
+	{
+		uint32_t frames = ((length - block) < (uint32_t)BENCH_CROSSFADE_FRAMES) ?
+						  (length - block) : (uint32_t)BENCH_CROSSFADE_FRAMES;
+		uint64_t start = GetNanoseconds();
+		uint32_t frame;
+
+		for (frame = 0; frame < frames; frame += AUDIO_CROSSFADE_SEGMENT)
+		{
+			uint32_t count = ((frames - frame) < (uint32_t)AUDIO_CROSSFADE_SEGMENT) ?
+							 (frames - frame) : (uint32_t)AUDIO_CROSSFADE_SEGMENT;
+			uint32_t sample = (block + frame) * (uint32_t)AUDIO_CROSSFADE_CHANNELS;
+			AudioCrossfadeRamp ramp;
+
+			AudioCrossfadeRampInit(&ramp, (uint64_t)block + frame, length, count);
+			mix(&result[sample], &in[sample], &out[sample], count, &ramp);
+		}
+		elapsed += GetNanoseconds() - start;
+	}
+
+	return elapsed;
+}
+
+/* the gains of every ramp keep in^2 + out^2 = 1 where the curve is taken */
+static double CheckCurve(uint32_t length)
+{
+	double worst = 0.0;
+	uint32_t frame;
+
+	for (frame = 0; frame <= length; frame += AUDIO_CROSSFADE_SEGMENT)
+	{
+		AudioCrossfadeRamp ramp;
+		double power;
+
+		AudioCrossfadeRampInit(&ramp, frame, length, AUDIO_CROSSFADE_SEGMENT);
+		power = ((double)ramp.inStart * (double)ramp.inStart) + ((double)ramp.outStart * (double)ramp.outStart);
+		if (fabs(power - 1.0) > worst)
+		{
+			worst = fabs(power - 1.0);
+		}
+	}
+
+	return worst;
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t ret = 0;
+	uint32_t seconds = BENCH_CROSSFADE_SECONDS;
+	uint32_t length;
+	size_t size;
+	float *in;
+	float *out;
+	float *reference;
+	float *kernel;
+
+	if (argc > 1)
+	{
+		seconds = (uint32_t)strtoul(argv[1], NULL, 10);
+	}
+
+	length = seconds * BENCH_CROSSFADE_RATE;
+	size = (size_t)length * AUDIO_CROSSFADE_CHANNELS * sizeof(float);
+	in = (float *)malloc(size);
+	out = (float *)malloc(size);
+	reference = (float *)malloc(size);
+	kernel = (float *)malloc(size);
+	if ((seconds == 0U) || (in == NULL) || (out == NULL) || (reference == NULL) || (kernel == NULL))
+	{
+		(void)fprintf(stderr, "usage: %s [seconds of fade]\n", argv[0]);
+		ret = 1;
+	}
+	else
+	{
+		uint64_t referenceTime = 0;
+		uint64_t kernelTime = 0;
+		double difference = 0.0;
+		double power;
+		uint32_t run;
+		uint32_t sample;
+		uint32_t last = (length - 1U) * (uint32_t)AUDIO_CROSSFADE_CHANNELS;
+
+		FillSignal(in, length, 440.0, 1U);
+		FillSignal(out, length, 1000.0, 2U);
+
+		for (run = 0; run < (uint32_t)BENCH_CROSSFADE_RUNS; run++)
+		{
+			referenceTime += Fade(AudioCrossfadeMixReference, reference, in, out, length);
+			kernelTime += Fade(AudioCrossfadeMix, kernel, in, out, length);
+		}
+
+		for (sample = 0; sample < (length * (uint32_t)AUDIO_CROSSFADE_CHANNELS); sample++)
+		{
+			if (fabs((double)reference[sample] - (double)kernel[sample]) > difference)
+			{
+				difference = fabs((double)reference[sample] - (double)kernel[sample]);
+			}
+		}
+		power = CheckCurve(length);
+
+		(void)printf("%u s fade at %u Hz, %u frames per block, kernel %s\n", seconds, BENCH_CROSSFADE_RATE,
+					 BENCH_CROSSFADE_FRAMES, AudioCrossfadeGetKernelName());
+		(void)printf("reference %6.3f ns/frame %6.3f%% of a core, %-6s %6.3f ns/frame %6.3f%% of a core, %5.2fx\n",
+					 (double)referenceTime / ((double)length * BENCH_CROSSFADE_RUNS),
+					 ((double)referenceTime * 100.0) / ((double)seconds * BENCH_CROSSFADE_RUNS * 1e9),
+					 AudioCrossfadeGetKernelName(),
+					 (double)kernelTime / ((double)length * BENCH_CROSSFADE_RUNS),
+					 ((double)kernelTime * 100.0) / ((double)seconds * BENCH_CROSSFADE_RUNS * 1e9),
+					 (double)referenceTime / (double)kernelTime);
+		(void)printf("largest difference %g, power off by %g, first frame %.6f, last frame %.6f\n",
+					 difference, power, (double)kernel[0], (double)kernel[last]);
+
+		/* only a fused multiply and add of the reference may differ */
+		if (difference > 1e-6)
+		{
+			(void)fprintf(stderr, "kernel differs from the reference\n");
+			ret = 1;
+		}
+		if (power > BENCH_CROSSFADE_POWER_TOLERANCE)
+		{
+			(void)fprintf(stderr, "the fade does not keep the power\n");
+			ret = 1;
+		}
+		/* the fade starts with the outgoing track alone and ends with the incoming one */
+		if ((fabs((double)kernel[0] - (double)out[0]) > 1e-6) ||
+			(fabs((double)kernel[last] - (double)in[last]) > 1e-3))
+		{
+			(void)fprintf(stderr, "the fade does not start or end at the tracks\n");
+			ret = 1;
+		}
+	}
+
+	free(in);
+	free(out);
+	free(reference);
+	free(kernel);
+
+	return ret;
+}
@@ -0,0 +1,153 @@
+/****************************************************************************************
+ *   FileName    : DBusDispatchBench.c
+ *   Description : Telechips DBus Method Dispatch Benchmark
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "DBusMsgDef.h"
+#include "DBusMethodTable.h"
+
+/*
+ * Compares the member lookup of the daemon with the linear
+ * dbus_message_is_method_call() scan it replaced. The daemon methods are
+ * padded with synthetic names up to BENCH_METHOD_COUNT and every name is
+ * looked up in turn, so a linear scan pays on average half of the list.
+ */
+#define BENCH_METHOD_COUNT				128
+#define BENCH_NAME_LENGTH				64
+#define BENCH_ROUNDS					20000
+
+static const char *s_names[BENCH_METHOD_COUNT];
+static char s_synthetic[BENCH_METHOD_COUNT][BENCH_NAME_LENGTH];
+static char s_members[BENCH_METHOD_COUNT][BENCH_NAME_LENGTH];
+static volatile int32_t s_sink;
+
+static uint64_t GetNanoseconds(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static int32_t LookupLinear(const char *interface, const char *member)
+{
+	int32_t found = -1;
+	uint32_t idx;
+
+	/* what dbus_message_is_method_call() compares for every candidate */
+	for (idx = 0; (idx < (uint32_t)BENCH_METHOD_COUNT) && (found < 0); idx++)
+	{
+		if ((strcmp(interface, MEDIAPLAYBACK_EVENT_INTERFACE) == 0) &&
+			(strcmp(member, s_names[idx]) == 0))
+		{
+			found = (int32_t)idx;
+		}
+	}
+
+	return found;
+}
+
+int main(void)
+{
+	static DBusMethodTable table;
+	char interface[] = MEDIAPLAYBACK_EVENT_INTERFACE;
+	uint64_t start;
+	uint64_t linear;
+	uint64_t hashed;
+	uint32_t round;
+	uint32_t idx;
+	int32_t ret = 0;
+
+	for (idx = 0; idx < (uint32_t)BENCH_METHOD_COUNT; idx++)
+	{
+		if (idx < (uint32_t)TotalMethodMediaPlaybackEvents)
+		{
+			s_names[idx] = g_methodMediaPlaybackEventNames[idx];
+		}
+		else
+		{
+			(void)snprintf(s_synthetic[idx], BENCH_NAME_LENGTH, "method_mediaplayback_synthetic_%03u", idx);
+			s_names[idx] = s_synthetic[idx];
+		}
+		/* members arrive in their own buffers, not as the table pointers */
+		(void)snprintf(s_members[idx], BENCH_NAME_LENGTH, "%s", s_names[idx]);
+	}
+
+	if (DBusMethodTableInitialize(&table, s_names, (uint32_t)BENCH_METHOD_COUNT) != 0)
+	{
+		(void)fprintf(stderr, "method table initialize failed\n");
+		ret = 1;
+	}
+	else
+	{
+		for (idx = 0; idx < (uint32_t)BENCH_METHOD_COUNT; idx++)
+		{
+			if ((LookupLinear(interface, s_members[idx]) != (int32_t)idx) ||
+				(DBusMethodTableLookup(&table, s_members[idx]) != (int32_t)idx))
+			{
+				(void)fprintf(stderr, "lookup mismatch for %s\n", s_members[idx]);
+				ret = 1;
+			}
+		}
+		if (DBusMethodTableLookup(&table, "method_mediaplayback_unknown") != -1)
+		{
+			(void)fprintf(stderr, "unknown member was found\n");
+			ret = 1;
+		}
+	}
+
+	if (ret == 0)
+	{
+		start = GetNanoseconds();
+		for (round = 0; round < (uint32_t)BENCH_ROUNDS; round++)
+		{
+			for (idx = 0; idx < (uint32_t)BENCH_METHOD_COUNT; idx++)
+			{
+				s_sink = LookupLinear(interface, s_members[idx]);
+			}
+		}
+		linear = GetNanoseconds() - start;
+
+		start = GetNanoseconds();
+		for (round = 0; round < (uint32_t)BENCH_ROUNDS; round++)
+		{
+			for (idx = 0; idx < (uint32_t)BENCH_METHOD_COUNT; idx++)
+			{
+				s_sink = DBusMethodTableLookup(&table, s_members[idx]);
+			}
+		}
+		hashed = GetNanoseconds() - start;
+
+		(void)printf("methods: %d, lookups: %d\n", BENCH_METHOD_COUNT, BENCH_METHOD_COUNT * BENCH_ROUNDS);
+		(void)printf("linear scan : %8.1f ns/lookup\n",
+					 (double)linear / ((double)BENCH_METHOD_COUNT * (double)BENCH_ROUNDS));
+		(void)printf("hash table  : %8.1f ns/lookup\n",
+					 (double)hashed / ((double)BENCH_METHOD_COUNT * (double)BENCH_ROUNDS));
+	}
+
+	return ret;
+}
@@ -0,0 +1,1045 @@
+/****************************************************************************************
+ *   FileName    : DBusLoadBench.c
+ *   Description : Telechips DBus Method Load Generator
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		/* mkdtemp */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <dbus/dbus.h>
+#include "DBusMsgDef.h"
+
+/*
+ * Load on the method interface of TCMediaPlayback from many clients at once.
+ * A private dbus-daemon is started in a temporary directory and the daemon
+ * is started on it with fakesink, so nothing else on the box is disturbed.
+ * Every client thread has its own connection and calls a weighted mix of
+ *
+ *   play		play_start of the media file with a new playID
+ *   stop		play_stop of the playID the clients saw last
+ *   seek		play_seek of that playID to a random second
+ *   status		get_status
+ *
+ * at --rate calls per second (0: as fast as replies come back). A reply is
+ * timed from when its call was due, not from when it was sent, so a daemon
+ * that falls behind shows up in the latency instead of slowing the clients.
+ * A signal is timed from the first call it answers that was still waiting:
+ * play to playing, stop to stopped, seek to seek_completed.
+ *
+ * Overwritten and refused commands and the waits for the command slot come
+ * from get_command_stats, the CPU time of the daemon and of the bus from
+ * /proc. The result is one JSON object on stdout.
+ *
+ *   DBusLoadBench [--daemon path] [--media file] [--sink name] [--clients n]
+ *                 [--rate calls/s] [--duration s] [--mix play:stop:seek:status]
+ *                 [--bus address [--pid daemon-pid]]
+ *
+ * With --bus the clients load a bus and daemon that are already running.
+ */
+#define LOAD_DEFAULT_DAEMON				"../src/TCMediaPlayback"
+#define LOAD_DEFAULT_SINK				"fakesink"
+#define LOAD_DEFAULT_CLIENTS			8
+#define LOAD_DEFAULT_RATE				50
+#define LOAD_DEFAULT_DURATION			10
+#define LOAD_DEFAULT_MIX				"10:10:30:50"
+#define LOAD_MAX_CLIENTS				256
+#define LOAD_TIMEOUT_MS					5000
+#define LOAD_START_TIMEOUT_MS			10000
+#define LOAD_SETTLE_MS					1000
+#define LOAD_PENDING_SLOTS				1024
+#define LOAD_SEEK_SECONDS				30
+#define LOAD_TRACK_SECONDS				60
+#define LOAD_TRACK_RATE					44100
+
+#define LOAD_OPERATION_LIST(X) \
+	X(Play,			"play",		METHOD_MEDIAPLAYBACK_PLAY_START,	SIGNAL_MEDIAPLAYBACK_PLAYING) \
+	X(Stop,			"stop",		METHOD_MEDIAPLAYBACK_PLAY_STOP,		SIGNAL_MEDIAPLAYBACK_STOPPED) \
+	X(Seek,			"seek",		METHOD_MEDIAPLAYBACK_PLAY_SEEK,		SIGNAL_MEDIAPLAYBACK_SEEK_COMPLETED) \
+	X(Status,		"status",	METHOD_MEDIAPLAYBACK_GET_STATUS,	NULL)
+
+#define LOAD_OPERATION_ENUM(name, text, method, signal)		LoadOperation##name,
+typedef enum {
+	LOAD_OPERATION_LIST(LOAD_OPERATION_ENUM)
+	TotalLoadOperations
+} LoadOperation;
+
+#define LOAD_OPERATION_NAME(name, text, method, signal)		text,
+static const char *s_operationNames[TotalLoadOperations] = {
+	LOAD_OPERATION_LIST(LOAD_OPERATION_NAME)
+};
+
+#define LOAD_OPERATION_METHOD(name, text, method, signal)	method,
+static const char *s_operationMethods[TotalLoadOperations] = {
+	LOAD_OPERATION_LIST(LOAD_OPERATION_METHOD)
+};
+
+#define LOAD_OPERATION_SIGNAL(name, text, method, signal)	signal,
+static const char *s_operationSignals[TotalLoadOperations] = {
+	LOAD_OPERATION_LIST(LOAD_OPERATION_SIGNAL)
+};
+
+typedef struct stLoadSamples {
+	uint64_t *values;				/* ns */
+	uint32_t count;
+	uint32_t size;
+} LoadSamples;
+
+typedef struct stLoadClient {
+	pthread_t thread;
+	DBusConnection *connection;
+	uint32_t seed;
+	uint64_t first;					/* ns, when the first call is due */
+	LoadSamples replies[TotalLoadOperations];
+	uint32_t accepted[TotalLoadOperations];
+	uint32_t rejected[TotalLoadOperations];	/* the method returned an error code */
+	uint32_t failed[TotalLoadOperations];	/* error reply or timeout */
+} LoadClient;
+
+typedef struct stLoadPending {
+	int32_t playID;
+	uint64_t sent;					/* ns, 0 if nothing waits */
+} LoadPending;
+
+typedef struct stLoadCommandStats {
+	dbus_uint32_t posted;
+	dbus_uint32_t overwritten;
+	dbus_uint32_t refused;
+	dbus_uint32_t lockWaitMax;		/* us */
+	dbus_uint64_t lockWaitSum;		/* us */
+} LoadCommandStats;
+
+typedef struct stLoadOptions {
+	const char *daemon;
+	const char *media;
+	const char *sink;
+	const char *bus;
+	pid_t pid;
+	uint32_t clients;
+	uint32_t rate;
+	uint32_t duration;
+	uint32_t mix[TotalLoadOperations];
+} LoadOptions;
+
+static LoadClient s_clients[LOAD_MAX_CLIENTS];
+static LoadOptions s_options;
+static uint32_t s_mixTotal = 0;
+static uint64_t s_end = 0;
+
+static int32_t s_playID = 0;
+static int32_t s_nextPlayID = 1;
+
+static pthread_mutex_t s_pendingMutex = PTHREAD_MUTEX_INITIALIZER;
+static LoadPending s_pending[TotalLoadOperations][LOAD_PENDING_SLOTS];
+static LoadSamples s_signalDelays[TotalLoadOperations];
+static uint32_t s_signals[TotalLoadOperations];
+static volatile bool s_listening = false;
+
+static uint64_t GetNanoseconds(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static void SleepUntil(uint64_t due)
+{
+	struct timespec until;
+
+	until.tv_sec = (time_t)(due / 1000000000ULL);
+	until.tv_nsec = (long)(due % 1000000000ULL);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR)
+	{
+		;
+	}
+}
+
+static void AddSample(LoadSamples *samples, uint64_t value)
+{
+	uint32_t size;
+	uint64_t *values;
+
+	if (samples->count == samples->size)
+	{
+		size = (samples->size > 0U) ? (samples->size * 2U) : 1024U;
+		values = (uint64_t *)realloc(samples->values, (size_t)size * sizeof(uint64_t));
+		if (values != NULL)
+		{
+			samples->values = values;
+			samples->size = size;
+		}
+	}
+
+	if (samples->count < samples->size)
+	{
+		samples->values[samples->count] = value;
+		samples->count++;
+	}
+}
+
+static void MergeSamples(LoadSamples *to, const LoadSamples *from)
+{
+	uint32_t idx;
+
+	for (idx = 0; idx < from->count; idx++)
+	{
+		AddSample(to, from->values[idx]);
+	}
+}
+
+static int CompareValues(const void *a, const void *b)
+{
+	uint64_t left = *(const uint64_t *)a;
+	uint64_t right = *(const uint64_t *)b;
+
+	return (left > right) - (left < right);
+}
+
+static double GetPercentile(const LoadSamples *samples, uint32_t percent)
+{
+	uint32_t rank = ((samples->count * percent) + 99U) / 100U;
+
+	return (double)samples->values[(rank > 0U) ? (rank - 1U) : 0U] / 1000.0;
+}
+
+static void PrintSamples(const char *name, LoadSamples *samples)
+{
+	(void)printf("\"%s\": ", name);
+	if (samples->count > 0U)
+	{
+		qsort(samples->values, samples->count, sizeof(uint64_t), CompareValues);
+		(void)printf("{ \"count\": %u, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f }",
+					 samples->count, GetPercentile(samples, 50U), GetPercentile(samples, 90U),
+					 GetPercentile(samples, 99U), (double)samples->values[samples->count - 1U] / 1000.0);
+	}
+	else
+	{
+		(void)printf("{ \"count\": 0 }");
+	}
+}
+
+static void AddPending(LoadOperation operation, int32_t playID, uint64_t sent)
+{
+	LoadPending *pending = &s_pending[operation][(uint32_t)playID % (uint32_t)LOAD_PENDING_SLOTS];
+
+	/* a flood of calls for one playID is answered from the first one waiting */
+	(void)pthread_mutex_lock(&s_pendingMutex);
+	if ((pending->sent == 0U) || (pending->playID != playID))
+	{
+		pending->playID = playID;
+		pending->sent = sent;
+	}
+	(void)pthread_mutex_unlock(&s_pendingMutex);
+}
+
+static uint64_t TakePending(LoadOperation operation, int32_t playID)
+{
+	LoadPending *pending = &s_pending[operation][(uint32_t)playID % (uint32_t)LOAD_PENDING_SLOTS];
+	uint64_t sent = 0;
+
+	(void)pthread_mutex_lock(&s_pendingMutex);
+	if ((pending->sent != 0U) && (pending->playID == playID))
+	{
+		sent = pending->sent;
+		pending->sent = 0;
+	}
+	(void)pthread_mutex_unlock(&s_pendingMutex);
+
+	return sent;
+}
+
+static int32_t GetLastInt32(DBusMessage *message, bool first)
+{
+	DBusMessageIter iter;
+	dbus_int32_t value = 0;
+	bool done = false;
+
+	if (dbus_message_iter_init(message, &iter))
+	{
+		do
+		{
+			if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_INT32)
+			{
+				dbus_message_iter_get_basic(&iter, &value);
+				done = first;
+			}
+		} while ((done == false) && dbus_message_iter_next(&iter));
+	}
+
+	return (int32_t)value;
+}
+
+static void OnSignal(DBusMessage *message, uint64_t received)
+{
+	uint32_t operation;
+	int32_t playID;
+	uint64_t sent;
+
+	for (operation = 0; operation < (uint32_t)TotalLoadOperations; operation++)
+	{
+		if ((s_operationSignals[operation] != NULL) &&
+			dbus_message_is_signal(message, MEDIAPLAYBACK_EVENT_INTERFACE, s_operationSignals[operation]))
+		{
+			/* the playID is the last int32 of every signal */
+			playID = GetLastInt32(message, false);
+			if (operation == (uint32_t)LoadOperationPlay)
+			{
+				__atomic_store_n(&s_playID, playID, __ATOMIC_RELAXED);
+			}
+
+			sent = TakePending((LoadOperation)operation, playID);
+			if (sent != 0U)
+			{
+				AddSample(&s_signalDelays[operation], received - sent);
+			}
+			s_signals[operation]++;
+		}
+	}
+}
+
+static void *ListenerThread(void *arg)
+{
+	DBusConnection *connection = (DBusConnection *)arg;
+	DBusMessage *message;
+
+	while (s_listening)
+	{
+		(void)dbus_connection_read_write(connection, 100);
+		message = dbus_connection_pop_message(connection);
+		while (message != NULL)
+		{
+			if (dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_SIGNAL)
+			{
+				OnSignal(message, GetNanoseconds());
+			}
+			dbus_message_unref(message);
+			message = dbus_connection_pop_message(connection);
+		}
+	}
+
+	return NULL;
+}
+
+static LoadOperation PickOperation(uint32_t *seed)
+{
+	uint32_t pick = (uint32_t)rand_r(seed) % s_mixTotal;
+	uint32_t operation = 0;
+
+	while (pick >= s_options.mix[operation])
+	{
+		pick -= s_options.mix[operation];
+		operation++;
+	}
+
+	return (LoadOperation)operation;
+}
+
+static DBusMessage *CreateCall(LoadOperation operation, uint32_t *seed, int32_t *playID)
+{
+	DBusMessage *call = dbus_message_new_method_call(MEDIAPLAYBACK_PROCESS_DBUS_NAME,
+													 MEDIAPLAYBACK_PROCESS_OBJECT_PATH,
+													 MEDIAPLAYBACK_EVENT_INTERFACE,
+													 s_operationMethods[operation]);
+	uint8_t zero = 0;
+	uint8_t second;
+	dbus_int32_t id;
+
+	if (call != NULL)
+	{
+		if (operation == LoadOperationPlay)
+		{
+			id = __atomic_fetch_add(&s_nextPlayID, 1, __ATOMIC_RELAXED);
+			(void)dbus_message_append_args(call,
+										   DBUS_TYPE_STRING, &s_options.media,
+										   DBUS_TYPE_BYTE, &zero,
+										   DBUS_TYPE_BYTE, &zero,
+										   DBUS_TYPE_BYTE, &zero,
+										   DBUS_TYPE_BYTE, &zero,
+										   DBUS_TYPE_INT32, &id,
+										   DBUS_TYPE_BYTE, &zero,
+										   DBUS_TYPE_INVALID);
+		}
+		else if (operation == LoadOperationStop)
+		{
+			id = __atomic_load_n(&s_playID, __ATOMIC_RELAXED);
+			(void)dbus_message_append_args(call, DBUS_TYPE_INT32, &id, DBUS_TYPE_INVALID);
+		}
+		else if (operation == LoadOperationSeek)
+		{
+			id = __atomic_load_n(&s_playID, __ATOMIC_RELAXED);
+			second = (uint8_t)((uint32_t)rand_r(seed) % (uint32_t)LOAD_SEEK_SECONDS);
+			(void)dbus_message_append_args(call,
+										   DBUS_TYPE_BYTE, &zero,
+										   DBUS_TYPE_BYTE, &zero,
+										   DBUS_TYPE_BYTE, &second,
+										   DBUS_TYPE_INT32, &id,
+										   DBUS_TYPE_INVALID);
+		}
+		else
+		{
+			id = 0;
+		}
+		*playID = (int32_t)id;
+	}
+
+	return call;
+}
+
+static void CallOperation(LoadClient *client, LoadOperation operation, uint64_t due)
+{
+	DBusError error;
+	DBusMessage *call;
+	DBusMessage *reply;
+	int32_t playID = 0;
+
+	dbus_error_init(&error);
+	call = CreateCall(operation, &client->seed, &playID);
+	if (call != NULL)
+	{
+		/* the signal may come before the reply */
+		if (s_operationSignals[operation] != NULL)
+		{
+			AddPending(operation, playID, GetNanoseconds());
+		}
+
+		reply = dbus_connection_send_with_reply_and_block(client->connection, call, LOAD_TIMEOUT_MS, &error);
+		AddSample(&client->replies[operation], GetNanoseconds() - due);
+		if (reply == NULL)
+		{
+			dbus_error_free(&error);
+			client->failed[operation]++;
+		}
+		else
+		{
+			if ((operation != LoadOperationStatus) && (GetLastInt32(reply, true) != 0))
+			{
+				client->rejected[operation]++;
+			}
+			else
+			{
+				if (operation == LoadOperationPlay)
+				{
+					__atomic_store_n(&s_playID, playID, __ATOMIC_RELAXED);
+				}
+				client->accepted[operation]++;
+			}
+			dbus_message_unref(reply);
+		}
+		dbus_message_unref(call);
+	}
+}
+
+static void *ClientThread(void *arg)
+{
+	LoadClient *client = (LoadClient *)arg;
+	uint64_t interval = (s_options.rate > 0U) ? (1000000000ULL / (uint64_t)s_options.rate) : 0U;
+	uint64_t due = client->first;
+
+	while (due < s_end)
+	{
+		if (interval > 0U)
+		{
+			SleepUntil(due);
+		}
+		else
+		{
+			due = GetNanoseconds();
+		}
+		CallOperation(client, PickOperation(&client->seed), due);
+		due += interval;
+	}
+
+	return NULL;
+}
+
+static DBusConnection *OpenConnection(const char *address, bool quiet)
+{
+	DBusError error;
+	DBusConnection *connection;
+
+	dbus_error_init(&error);
+	connection = dbus_connection_open_private(address, &error);
+	if ((connection != NULL) && (!dbus_bus_register(connection, &error)))
+	{
+		dbus_connection_close(connection);
+		dbus_connection_unref(connection);
+		connection = NULL;
+	}
+	if ((connection == NULL) && (quiet == false))
+	{
+		(void)fprintf(stderr, "%s: %s\n", address, error.message);
+	}
+	dbus_error_free(&error);
+
+	return connection;
+}
+
+static void CloseConnection(DBusConnection *connection)
+{
+	if (connection != NULL)
+	{
+		dbus_connection_close(connection);
+		dbus_connection_unref(connection);
+	}
+}
+
+static bool GetCommandStats(DBusConnection *connection, LoadCommandStats *stats)
+{
+	bool ret = false;
+	DBusError error;
+	DBusMessage *call = dbus_message_new_method_call(MEDIAPLAYBACK_PROCESS_DBUS_NAME,
+													 MEDIAPLAYBACK_PROCESS_OBJECT_PATH,
+													 MEDIAPLAYBACK_EVENT_INTERFACE,
+													 METHOD_MEDIAPLAYBACK_GET_COMMAND_STATS);
+	DBusMessage *reply = NULL;
+
+	dbus_error_init(&error);
+	(void)memset(stats, 0, sizeof(LoadCommandStats));
+	if (call != NULL)
+	{
+		reply = dbus_connection_send_with_reply_and_block(connection, call, LOAD_TIMEOUT_MS, &error);
+		dbus_message_unref(call);
+	}
+	if (reply != NULL)
+	{
+		ret = (dbus_message_get_args(reply, &error,
+									 DBUS_TYPE_UINT32, &stats->posted,
+									 DBUS_TYPE_UINT32, &stats->overwritten,
+									 DBUS_TYPE_UINT32, &stats->refused,
+									 DBUS_TYPE_UINT32, &stats->lockWaitMax,
+									 DBUS_TYPE_UINT64, &stats->lockWaitSum,
+									 DBUS_TYPE_INVALID) != 0);
+		dbus_message_unref(reply);
+	}
+	if (ret == false)
+	{
+		(void)fprintf(stderr, "%s: %s\n", METHOD_MEDIAPLAYBACK_GET_COMMAND_STATS,
+					  (error.message != NULL) ? error.message : "no reply");
+	}
+	dbus_error_free(&error);
+
+	return ret;
+}
+
+static double GetCpuSeconds(pid_t pid)
+{
+	double seconds = 0.0;
+	char path[64];
+	char line[1024];
+	const char *fields;
+	unsigned long user = 0;
+	unsigned long system = 0;
+	FILE *file;
+
+	(void)snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+	file = (pid > 0) ? fopen(path, "r") : NULL;
+	if (file != NULL)
+	{
+		/* utime and stime are the 14th and 15th fields, counted after the command name */
+		if ((fgets(line, (int)sizeof(line), file) != NULL) && ((fields = strrchr(line, ')')) != NULL) &&
+			(sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &user, &system) == 2))
+		{
+			seconds = (double)(user + system) / (double)sysconf(_SC_CLK_TCK);
+		}
+		(void)fclose(file);
+	}
+
+	return seconds;
+}
+
+static pid_t Spawn(char *const argv[], const char *address)
+{
+	pid_t pid = fork();
+
+	if (pid == 0)
+	{
+		/* whichever bus the daemon asks for, it gets the private one */
+		if (address != NULL)
+		{
+			(void)setenv("DBUS_SYSTEM_BUS_ADDRESS", address, 1);
+			(void)setenv("DBUS_SESSION_BUS_ADDRESS", address, 1);
+		}
+		(void)execvp(argv[0], argv);
+		_exit(127);
+	}
+	else if (pid < 0)
+	{
+		(void)fprintf(stderr, "fork of %s failed: error(%d)\n", argv[0], errno);
+	}
+	else
+	{
+		;
+	}
+
+	return pid;
+}
+
+static void Terminate(pid_t pid)
+{
+	if (pid > 0)
+	{
+		(void)kill(pid, SIGTERM);
+		(void)waitpid(pid, NULL, 0);
+	}
+}
+
+static int32_t WriteBusConfig(const char *path, const char *busSocket)
+{
+	int32_t ret = -1;
+	FILE *file = fopen(path, "w");
+
+	if (file != NULL)
+	{
+		(void)fprintf(file,
+					  "<!DOCTYPE busconfig PUBLIC \"-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN\"\n"
+					  " \"http://www.freedesktop.org/standards/dbus/1.0/busconfig.dtd\">\n"
+					  "<busconfig>\n"
+					  "  <type>session</type>\n"
+					  "  <listen>unix:path=%s</listen>\n"
+					  "  <auth>EXTERNAL</auth>\n"
+					  "  <policy context=\"default\">\n"
+					  "    <allow send_destination=\"*\" eavesdrop=\"true\"/>\n"
+					  "    <allow eavesdrop=\"true\"/>\n"
+					  "    <allow own=\"*\"/>\n"
+					  "  </policy>\n"
+					  "  <limit name=\"max_replies_per_connection\">100000</limit>\n"
+					  "</busconfig>\n", busSocket);
+		ret = (fclose(file) == 0) ? 0 : -1;
+	}
+
+	return ret;
+}
+
+static int32_t WriteTrack(const char *path)
+{
+	int32_t ret = -1;
+	uint32_t frames = (uint32_t)LOAD_TRACK_RATE * (uint32_t)LOAD_TRACK_SECONDS;
+	uint32_t bytes = frames * 4U;
+	uint32_t header[11];
+	int16_t samples[2048];
+	uint32_t written;
+	uint32_t idx;
+	FILE *file = fopen(path, "wb");
+
+	/* 16 bit stereo PCM, a quiet 430 Hz sawtooth */
+	header[0] = 0x46464952U;		/* "RIFF" */
+	header[1] = 36U + bytes;
+	header[2] = 0x45564157U;		/* "WAVE" */
+	header[3] = 0x20746d66U;		/* "fmt " */
+	header[4] = 16U;
+	header[5] = 1U | (2U << 16);	/* PCM, 2 channels */
+	header[6] = (uint32_t)LOAD_TRACK_RATE;
+	header[7] = (uint32_t)LOAD_TRACK_RATE * 4U;
+	header[8] = 4U | (16U << 16);	/* block align, bits per sample */
+	header[9] = 0x61746164U;		/* "data" */
+	header[10] = bytes;
+
+	for (idx = 0; idx < 2048U; idx++)
+	{
+		samples[idx] = (int16_t)((int32_t)(((idx / 2U) % 100U) * 40U) - 2000);
+	}
+
+	if ((file != NULL) && (fwrite(header, sizeof(header), 1, file) == 1U))
+	{
+		ret = 0;
+		for (written = 0; (written < bytes) && (ret == 0); written += (uint32_t)sizeof(samples))
+		{
+			idx = ((bytes - written) < (uint32_t)sizeof(samples)) ? (bytes - written) : (uint32_t)sizeof(samples);
+			ret = (fwrite(samples, idx, 1, file) == 1U) ? 0 : -1;
+		}
+	}
+	if ((file != NULL) && (fclose(file) != 0))
+	{
+		ret = -1;
+	}
+
+	return ret;
+}
+
+static bool WaitForName(DBusConnection *connection, pid_t daemon)
+{
+	bool owned = false;
+	uint64_t timeout = GetNanoseconds() + ((uint64_t)LOAD_START_TIMEOUT_MS * 1000000ULL);
+
+	while ((owned == false) && (GetNanoseconds() < timeout) && (waitpid(daemon, NULL, WNOHANG) == 0))
+	{
+		owned = (dbus_bus_name_has_owner(connection, MEDIAPLAYBACK_PROCESS_DBUS_NAME, NULL) != 0);
+		if (owned == false)
+		{
+			(void)usleep(10000);
+		}
+	}
+
+	return owned;
+}
+
+static DBusConnection *WaitForBus(const char *address, pid_t bus)
+{
+	DBusConnection *connection = NULL;
+	uint64_t timeout = GetNanoseconds() + ((uint64_t)LOAD_START_TIMEOUT_MS * 1000000ULL);
+
+	while ((connection == NULL) && (GetNanoseconds() < timeout) && (waitpid(bus, NULL, WNOHANG) == 0))
+	{
+		connection = OpenConnection(address, true);
+		if (connection == NULL)
+		{
+			(void)usleep(10000);
+		}
+	}
+
+	return connection;
+}
+
+static void PrintReport(const LoadCommandStats *begin, const LoadCommandStats *end,
+						double daemonCpu, double busCpu, double seconds)
+{
+	LoadSamples replies;
+	uint32_t operation;
+	uint32_t client;
+	uint32_t accepted;
+	uint32_t rejected;
+	uint32_t failed;
+
+	(void)printf("{\n");
+	(void)printf("  \"clients\": %u,\n  \"rate\": %u,\n  \"duration_s\": %.1f,\n",
+				 s_options.clients, s_options.rate, seconds);
+	(void)printf("  \"mix\": { ");
+	for (operation = 0; operation < (uint32_t)TotalLoadOperations; operation++)
+	{
+		(void)printf("\"%s\": %u%s", s_operationNames[operation], s_options.mix[operation],
+					 (operation + 1U < (uint32_t)TotalLoadOperations) ? ", " : " },\n");
+	}
+
+	(void)printf("  \"operations_us\": {\n");
+	for (operation = 0; operation < (uint32_t)TotalLoadOperations; operation++)
+	{
+		(void)memset(&replies, 0, sizeof(replies));
+		accepted = 0;
+		rejected = 0;
+		failed = 0;
+		for (client = 0; client < s_options.clients; client++)
+		{
+			MergeSamples(&replies, &s_clients[client].replies[operation]);
+			accepted += s_clients[client].accepted[operation];
+			rejected += s_clients[client].rejected[operation];
+			failed += s_clients[client].failed[operation];
+		}
+
+		(void)printf("    \"%s\": { \"accepted\": %u, \"rejected\": %u, \"failed\": %u, ",
+					 s_operationNames[operation], accepted, rejected, failed);
+		PrintSamples("reply", &replies);
+		if (s_operationSignals[operation] != NULL)
+		{
+			(void)printf(", \"signals\": %u, ", s_signals[operation]);
+			PrintSamples("signal", &s_signalDelays[operation]);
+		}
+		(void)printf(" }%s\n", (operation + 1U < (uint32_t)TotalLoadOperations) ? "," : "");
+		free(replies.values);
+	}
+	(void)printf("  },\n");
+
+	(void)printf("  \"commands\": { \"posted\": %u, \"overwritten\": %u, \"refused\": %u, "
+				 "\"lock_wait_max_us\": %u, \"lock_wait_sum_us\": %llu },\n",
+				 end->posted - begin->posted, end->overwritten - begin->overwritten,
+				 end->refused - begin->refused, end->lockWaitMax,
+				 (unsigned long long)(end->lockWaitSum - begin->lockWaitSum));
+	(void)printf("  \"cpu_percent\": { \"daemon\": %.1f, \"bus\": %.1f }\n}\n",
+				 (daemonCpu * 100.0) / seconds, (busCpu * 100.0) / seconds);
+}
+
+static int32_t RunLoad(const char *address, pid_t daemon, pid_t bus)
+{
+	int32_t ret = 0;
+	DBusConnection *monitor = OpenConnection(address, false);
+	pthread_t listener;
+	LoadCommandStats begin;
+	LoadCommandStats end;
+	double daemonCpu;
+	double busCpu;
+	uint64_t start;
+	uint64_t stagger;
+	uint32_t client;
+	uint32_t started = 0;
+
+	if ((monitor == NULL) || (GetCommandStats(monitor, &begin) == false))
+	{
+		ret = -1;
+	}
+	else
+	{
+		dbus_bus_add_match(monitor, "type='signal',interface='" MEDIAPLAYBACK_EVENT_INTERFACE "'", NULL);
+		s_listening = true;
+		if (pthread_create(&listener, NULL, ListenerThread, monitor) != 0)
+		{
+			s_listening = false;
+			ret = -1;
+		}
+	}
+
+	for (client = 0; (client < s_options.clients) && (ret == 0); client++)
+	{
+		s_clients[client].connection = OpenConnection(address, false);
+		s_clients[client].seed = client + 1U;
+		ret = (s_clients[client].connection != NULL) ? 0 : -1;
+	}
+
+	if (ret == 0)
+	{
+		daemonCpu = GetCpuSeconds(daemon);
+		busCpu = GetCpuSeconds(bus);
+		start = GetNanoseconds();
+		s_end = start + ((uint64_t)s_options.duration * 1000000000ULL);
+
+		/* spread the clients over one interval, so they do not call in lockstep */
+		stagger = (s_options.rate > 0U) ? (1000000000ULL / ((uint64_t)s_options.rate * (uint64_t)s_options.clients)) : 0U;
+		for (client = 0; client < s_options.clients; client++)
+		{
+			s_clients[client].first = start + ((uint64_t)client * stagger);
+			if (pthread_create(&s_clients[client].thread, NULL, ClientThread, &s_clients[client]) == 0)
+			{
+				started++;
+			}
+		}
+		for (client = 0; client < started; client++)
+		{
+			(void)pthread_join(s_clients[client].thread, NULL);
+		}
+
+		/* signals of the last calls are still on their way */
+		(void)usleep((useconds_t)LOAD_SETTLE_MS * 1000U);
+		daemonCpu = GetCpuSeconds(daemon) - daemonCpu;
+		busCpu = GetCpuSeconds(bus) - busCpu;
+
+		if ((started == s_options.clients) && GetCommandStats(monitor, &end))
+		{
+			PrintReport(&begin, &end, daemonCpu, busCpu,
+						(double)(GetNanoseconds() - start) / 1000000000.0);
+		}
+		else
+		{
+			ret = -1;
+		}
+	}
+
+	if (s_listening)
+	{
+		s_listening = false;
+		(void)pthread_join(listener, NULL);
+	}
+	CloseConnection(monitor);
+	for (client = 0; client < s_options.clients; client++)
+	{
+		CloseConnection(s_clients[client].connection);
+	}
+
+	return ret;
+}
+
+static int32_t Run(void)
+{
+	int32_t ret = -1;
+	char directory[] = "/tmp/tcmp-load-XXXXXX";
+	char config[PATH_MAX];
+	char busSocket[PATH_MAX];
+	char track[PATH_MAX];
+	char address[PATH_MAX + 16];
+	char configArgument[PATH_MAX + 16];
+	char *busArguments[] = { "dbus-daemon", "--nofork", configArgument, NULL };
+	char *daemonArguments[] = { (char *)s_options.daemon, "--no-daemon",
+								"--audio-sink", (char *)s_options.sink,
+								"--video-sink", (char *)s_options.sink, NULL };
+	DBusConnection *connection = NULL;
+	pid_t bus = -1;
+	pid_t daemon = -1;
+
+	if (s_options.bus != NULL)
+	{
+		ret = RunLoad(s_options.bus, s_options.pid, -1);
+	}
+	else if (mkdtemp(directory) != NULL)
+	{
+		(void)snprintf(config, sizeof(config), "%s/bus.conf", directory);
+		(void)snprintf(busSocket, sizeof(busSocket), "%s/bus", directory);
+		(void)snprintf(track, sizeof(track), "%s/track.wav", directory);
+		(void)snprintf(address, sizeof(address), "unix:path=%s", busSocket);
+		(void)snprintf(configArgument, sizeof(configArgument), "--config-file=%s", config);
+
+		if ((s_options.media == NULL) && (WriteTrack(track) == 0))
+		{
+			s_options.media = track;
+		}
+
+		if ((s_options.media != NULL) && (WriteBusConfig(config, busSocket) == 0))
+		{
+			bus = Spawn(busArguments, NULL);
+			connection = (bus > 0) ? WaitForBus(address, bus) : NULL;
+			daemon = (connection != NULL) ? Spawn(daemonArguments, address) : -1;
+		}
+
+		if ((daemon > 0) && WaitForName(connection, daemon))
+		{
+			ret = RunLoad(address, daemon, bus);
+		}
+		else
+		{
+			(void)fprintf(stderr, "%s did not come up on %s\n", s_options.daemon, address);
+		}
+
+		CloseConnection(connection);
+		Terminate(daemon);
+		Terminate(bus);
+		(void)unlink(track);
+		(void)unlink(config);
+		(void)unlink(busSocket);
+		(void)rmdir(directory);
+	}
+	else
+	{
+		(void)fprintf(stderr, "mkdtemp failed: error(%d)\n", errno);
+	}
+
+	return ret;
+}
+
+static int32_t ParseMix(const char *mix)
+{
+	int32_t ret = 0;
+	const char *next = mix;
+	char *end;
+	uint32_t operation;
+
+	s_mixTotal = 0;
+	for (operation = 0; (operation < (uint32_t)TotalLoadOperations) && (ret == 0); operation++)
+	{
+		s_options.mix[operation] = (uint32_t)strtoul(next, &end, 10);
+		s_mixTotal += s_options.mix[operation];
+		if ((end == next) || ((*end != ':') && (operation + 1U < (uint32_t)TotalLoadOperations)))
+		{
+			ret = -1;
+		}
+		next = end + 1;
+	}
+
+	return ((ret == 0) && (s_mixTotal > 0U)) ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t ret = 0;
+	const char *mix = LOAD_DEFAULT_MIX;
+	int32_t idx;
+
+	s_options.daemon = LOAD_DEFAULT_DAEMON;
+	s_options.sink = LOAD_DEFAULT_SINK;
+	s_options.clients = LOAD_DEFAULT_CLIENTS;
+	s_options.rate = LOAD_DEFAULT_RATE;
+	s_options.duration = LOAD_DEFAULT_DURATION;
+
+	for (idx = 1; (idx < argc) && (ret == 0); idx++)
+	{
+		if ((idx + 1) >= argc)
+		{
+			ret = -1;
+		}
+		else if (strcmp(argv[idx], "--daemon") == 0)
+		{
+			idx++;
+			s_options.daemon = argv[idx];
+		}
+		else if (strcmp(argv[idx], "--media") == 0)
+		{
+			idx++;
+			s_options.media = argv[idx];
+		}
+		else if (strcmp(argv[idx], "--sink") == 0)
+		{
+			idx++;
+			s_options.sink = argv[idx];
+		}
+		else if (strcmp(argv[idx], "--clients") == 0)
+		{
+			idx++;
+			s_options.clients = (uint32_t)strtoul(argv[idx], NULL, 10);
+		}
+		else if (strcmp(argv[idx], "--rate") == 0)
+		{
+			idx++;
+			s_options.rate = (uint32_t)strtoul(argv[idx], NULL, 10);
+		}
+		else if (strcmp(argv[idx], "--duration") == 0)
+		{
+			idx++;
+			s_options.duration = (uint32_t)strtoul(argv[idx], NULL, 10);
+		}
+		else if (strcmp(argv[idx], "--mix") == 0)
+		{
+			idx++;
+			mix = argv[idx];
+		}
+		else if (strcmp(argv[idx], "--bus") == 0)
+		{
+			idx++;
+			s_options.bus = argv[idx];
+		}
+		else if (strcmp(argv[idx], "--pid") == 0)
+		{
+			idx++;
+			s_options.pid = (pid_t)strtol(argv[idx], NULL, 10);
+		}
+		else
+		{
+			ret = -1;
+		}
+	}
+
+	if ((ret != 0) || (ParseMix(mix) != 0) || (s_options.clients == 0U) ||
+		(s_options.clients > (uint32_t)LOAD_MAX_CLIENTS) || (s_options.duration == 0U) ||
+		((s_options.bus != NULL) && (s_options.media == NULL)))
+	{
+		(void)fprintf(stderr, "usage: %s [--daemon path] [--media file] [--sink name] [--clients n]\n"
+					  "\t[--rate calls/s] [--duration s] [--mix play:stop:seek:status]\n"
+					  "\t[--bus address [--pid daemon-pid]]\n", argv[0]);
+		ret = -1;
+	}
+	else
+	{
+		/* a daemon that dies under load must not take the generator with it */
+		(void)signal(SIGPIPE, SIG_IGN);
+		(void)dbus_threads_init_default();
+		ret = Run();
+	}
+
+	return (ret == 0) ? 0 : 1;
+}
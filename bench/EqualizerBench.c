@@ -0,0 +1,233 @@
+/****************************************************************************************
+ *   FileName    : EqualizerBench.c
+ *   Description : Telechips Audio Equalizer Benchmark
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "AudioEqualizerKernel.h"
+
+/*
+ * Cost of the equalizer kernel against the scalar reference it replaces,
+ * in ns per sample per band, for every sample format the element accepts.
+ * Both run the same eight bands over the same signal in buffers of the
+ * size a 48 kHz decoder pushes; the output of the kernel is compared with
+ * the reference so a fast but wrong kernel does not pass unnoticed.
+ */
+#define BENCH_EQUALIZER_RATE			48000
+#define BENCH_EQUALIZER_CHANNELS		2
+#define BENCH_EQUALIZER_FRAMES			1024		/* per buffer */
+#define BENCH_EQUALIZER_SECONDS			60			/* of audio per run */
+
+typedef void (*ProcessFunction)(const AudioEqualizerCoefficients *coefficients, AudioEqualizerState *state,
+								void *data, uint32_t frames, uint32_t channels, AudioEqualizerFormat format);
+
+static const char *s_formatNames[TotalAudioEqualizerFormats] = { "f32", "s16", "s32" };
+
+static const AudioEqualizerBand s_bands[AUDIO_EQUALIZER_BANDS] = {
+	{ AudioEqualizerLowShelf,	80.0f,		0.7f,	4.0f },
+	{ AudioEqualizerPeak,		200.0f,		1.0f,	-2.0f },
+	{ AudioEqualizerPeak,		500.0f,		1.0f,	1.5f },
+	{ AudioEqualizerPeak,		1000.0f,	1.0f,	-1.0f },
+	{ AudioEqualizerPeak,		2000.0f,	1.0f,	2.0f },
+	{ AudioEqualizerPeak,		4000.0f,	1.0f,	-1.5f },
+	{ AudioEqualizerPeak,		8000.0f,	1.0f,	2.5f },
+	{ AudioEqualizerHighShelf,	12000.0f,	0.7f,	3.0f }
+};
+
+static uint64_t GetNanoseconds(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static size_t GetSampleSize(AudioEqualizerFormat format)
+{
+	return (format == AudioEqualizerS16) ? sizeof(int16_t) :
+		   ((format == AudioEqualizerS32) ? sizeof(int32_t) : sizeof(float));
+}
+
+/* a sweep with some noise, so every band has work */
+static void FillSignal(void *data, uint32_t samples, AudioEqualizerFormat format)
+{
+	uint32_t seed = 1;
+	uint32_t idx;
+
+	for (idx = 0; idx < samples; idx++)
+	{
+		double t = (double)(idx / BENCH_EQUALIZER_CHANNELS) / (double)BENCH_EQUALIZER_RATE;
+		double sample;
+
+		seed = (seed * 1103515245U) + 12345U;
+		sample = (0.4 * sin(2.0 * M_PI * (50.0 + (2000.0 * t)) * t)) +
+				 (0.05 * (((double)(seed >> 16) / 32768.0) - 1.0));
+
+		if (format == AudioEqualizerS16)
+		{
+			((int16_t *)data)[idx] = (int16_t)(sample * 32767.0);
+		}
+		else if (format == AudioEqualizerS32)
+		{
+			((int32_t *)data)[idx] = (int32_t)(sample * 2147483647.0);
+		}
+		else
+		{
+			((float *)data)[idx] = (float)sample;
+		}
+	}
+}
+
+static uint64_t Run(ProcessFunction process, const AudioEqualizerCoefficients *coefficients, const void *signal,
+					void *data, uint32_t buffers, AudioEqualizerFormat format)
+{
+	size_t bytes = (size_t)BENCH_EQUALIZER_FRAMES * BENCH_EQUALIZER_CHANNELS * GetSampleSize(format);
+	AudioEqualizerState state;
+	uint64_t elapsed = 0;
+	uint32_t idx;
+
+	AudioEqualizerReset(&state);
+	for (idx = 0; idx < buffers; idx++)
+	{
+		uint64_t start;
+
+		/* every buffer is fresh input, the copy is not timed */
+		(void)memcpy(data, (const uint8_t *)signal + ((size_t)(idx % 16U) * bytes), bytes);
+		start = GetNanoseconds();
+		process(coefficients, &state, data, BENCH_EQUALIZER_FRAMES, BENCH_EQUALIZER_CHANNELS, format);
+		elapsed += GetNanoseconds() - start;
+	}
+
+	return elapsed;
+}
+
+static double Compare(const void *a, const void *b, uint32_t samples, AudioEqualizerFormat format)
+{
+	double worst = 0.0;
+	uint32_t idx;
+
+	for (idx = 0; idx < samples; idx++)
+	{
+		double difference;
+
+		if (format == AudioEqualizerS16)
+		{
+			difference = fabs((double)((const int16_t *)a)[idx] - (double)((const int16_t *)b)[idx]) / 32768.0;
+		}
+		else if (format == AudioEqualizerS32)
+		{
+			difference = fabs((double)((const int32_t *)a)[idx] - (double)((const int32_t *)b)[idx]) / 2147483648.0;
+		}
+		else
+		{
+			difference = fabs((double)((const float *)a)[idx] - (double)((const float *)b)[idx]);
+		}
+
+		if (difference > worst)
+		{
+			worst = difference;
+		}
+	}
+
+	return worst;
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t ret = 0;
+	uint32_t seconds = BENCH_EQUALIZER_SECONDS;
+	uint32_t samples = 16U * BENCH_EQUALIZER_FRAMES * BENCH_EQUALIZER_CHANNELS;
+	AudioEqualizerCoefficients coefficients;
+	void *signal = malloc((size_t)samples * sizeof(float));
+	void *reference = malloc((size_t)samples * sizeof(float));
+	void *kernel = malloc((size_t)samples * sizeof(float));
+
+	if (argc > 1)
+	{
+		seconds = (uint32_t)strtoul(argv[1], NULL, 10);
+	}
+
+	if ((seconds == 0U) || (signal == NULL) || (reference == NULL) || (kernel == NULL))
+	{
+		(void)fprintf(stderr, "usage: %s [seconds of audio]\n", argv[0]);
+		ret = 1;
+	}
+	else
+	{
+		uint32_t buffers = (seconds * BENCH_EQUALIZER_RATE) / BENCH_EQUALIZER_FRAMES;
+		double work = (double)buffers * BENCH_EQUALIZER_FRAMES * BENCH_EQUALIZER_CHANNELS * AUDIO_EQUALIZER_BANDS;
+		uint32_t format;
+
+		AudioEqualizerDesign(s_bands, AUDIO_EQUALIZER_BANDS, BENCH_EQUALIZER_RATE, &coefficients);
+		(void)printf("%u s of %u Hz, %u channels, %u bands, %u frames per buffer, kernel %s\n",
+					 seconds, BENCH_EQUALIZER_RATE, BENCH_EQUALIZER_CHANNELS, AUDIO_EQUALIZER_BANDS,
+					 BENCH_EQUALIZER_FRAMES, AudioEqualizerGetKernelName());
+
+		for (format = 0; format < (uint32_t)TotalAudioEqualizerFormats; format++)
+		{
+			AudioEqualizerState state;
+			uint64_t referenceTime;
+			uint64_t kernelTime;
+			double error;
+
+			FillSignal(signal, samples, (AudioEqualizerFormat)format);
+
+			/* the whole signal in one state, as a stream */
+			(void)memcpy(reference, signal, (size_t)samples * GetSampleSize((AudioEqualizerFormat)format));
+			(void)memcpy(kernel, signal, (size_t)samples * GetSampleSize((AudioEqualizerFormat)format));
+			AudioEqualizerReset(&state);
+			AudioEqualizerProcessReference(&coefficients, &state, reference, samples / BENCH_EQUALIZER_CHANNELS,
+										   BENCH_EQUALIZER_CHANNELS, (AudioEqualizerFormat)format);
+			AudioEqualizerReset(&state);
+			AudioEqualizerProcess(&coefficients, &state, kernel, samples / BENCH_EQUALIZER_CHANNELS,
+								  BENCH_EQUALIZER_CHANNELS, (AudioEqualizerFormat)format);
+			error = Compare(reference, kernel, samples, (AudioEqualizerFormat)format);
+
+			referenceTime = Run(AudioEqualizerProcessReference, &coefficients, signal, reference, buffers,
+								(AudioEqualizerFormat)format);
+			kernelTime = Run(AudioEqualizerProcess, &coefficients, signal, kernel, buffers,
+							 (AudioEqualizerFormat)format);
+
+			(void)printf("%s: reference %6.3f ns/sample/band, %-6s %6.3f ns/sample/band, %5.2fx, max error %g\n",
+						 s_formatNames[format], (double)referenceTime / work, AudioEqualizerGetKernelName(),
+						 (double)kernelTime / work, (double)referenceTime / (double)kernelTime, error);
+
+			/* one LSB of s16 is far above any rounding difference */
+			if (error > (1.0 / 32768.0))
+			{
+				(void)fprintf(stderr, "%s: kernel differs from the reference\n", s_formatNames[format]);
+				ret = 1;
+			}
+		}
+	}
+
+	free(signal);
+	free(reference);
+	free(kernel);
+
+	return ret;
+}
@@ -0,0 +1,177 @@
+/****************************************************************************************
+ *   FileName    : LoudnessBench.c
+ *   Description : Telechips Audio Loudness Benchmark
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "AudioLoudnessKernel.h"
+
+/*
+ * Speed of the loudness meter a library pass runs on every track, against
+ * the scalar reference, in ns per frame and times real time. The meter must
+ * also measure: a 1 kHz sine at -23 dBFS on both channels is -23 LUFS by
+ * definition, and the kernel has to agree with the reference on a noisy
+ * sweep.
+ */
+#define BENCH_LOUDNESS_RATE				48000
+#define BENCH_LOUDNESS_CHANNELS			2
+#define BENCH_LOUDNESS_FRAMES			1024		/* per buffer */
+#define BENCH_LOUDNESS_SECONDS			600			/* of audio per run, a long track */
+#define BENCH_LOUDNESS_SINE_LEVEL		(-23.0)		/* dBFS and LUFS */
+#define BENCH_LOUDNESS_TOLERANCE		(0.1)		/* LU */
+
+typedef void (*ProcessFunction)(AudioLoudnessMeter *meter, const float *data, uint32_t frames);
+
+static uint64_t GetNanoseconds(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static void FillSine(float *data, uint32_t frames, double level)
+{
+	double amplitude = pow(10.0, level / 20.0);
+	uint32_t frame;
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		float sample = (float)(amplitude * sin((2.0 * M_PI * 1000.0 * (double)frame) / (double)BENCH_LOUDNESS_RATE));
+
+		data[frame * 2U] = sample;
+		data[(frame * 2U) + 1U] = sample;
+	}
+}
+
+/* a sweep with some noise and a quiet middle, so the gates have work */
+static void FillSignal(float *data, uint32_t frames)
+{
+	uint32_t seed = 1;
+	uint32_t frame;
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		double t = (double)frame / (double)BENCH_LOUDNESS_RATE;
+		double level = ((frame / BENCH_LOUDNESS_RATE) % 4U == 2U) ? 0.02 : 0.4;
+		double sample = level * sin(2.0 * M_PI * (50.0 + (2000.0 * t)) * t);
+
+		seed = (seed * 1103515245U) + 12345U;
+		data[frame * 2U] = (float)(sample + (0.05 * (((double)(seed >> 16) / 32768.0) - 1.0)));
+		data[(frame * 2U) + 1U] = (float)(sample * 0.5);
+	}
+}
+
+static float Measure(ProcessFunction process, const float *data, uint32_t frames, uint64_t *elapsed)
+{
+	AudioLoudnessMeter *meter = (AudioLoudnessMeter *)malloc(sizeof(AudioLoudnessMeter));
+	float loudness = AUDIO_LOUDNESS_SILENCE;
+	uint32_t frame;
+
+	*elapsed = 0;
+	if (meter != NULL)
+	{
+		AudioLoudnessMeterInit(meter, BENCH_LOUDNESS_RATE, BENCH_LOUDNESS_CHANNELS);
+		for (frame = 0; frame < frames; frame += BENCH_LOUDNESS_FRAMES)
+		{
+			uint32_t count = ((frames - frame) < (uint32_t)BENCH_LOUDNESS_FRAMES) ?
+							 (frames - frame) : (uint32_t)BENCH_LOUDNESS_FRAMES;
+			uint64_t start = GetNanoseconds();
+
+			process(meter, &data[frame * BENCH_LOUDNESS_CHANNELS], count);
+			*elapsed += GetNanoseconds() - start;
+		}
+		loudness = AudioLoudnessMeterGetIntegrated(meter);
+		free(meter);
+	}
+
+	return loudness;
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t ret = 0;
+	uint32_t seconds = BENCH_LOUDNESS_SECONDS;
+	uint32_t frames;
+	float *signal;
+
+	if (argc > 1)
+	{
+		seconds = (uint32_t)strtoul(argv[1], NULL, 10);
+	}
+
+	frames = seconds * BENCH_LOUDNESS_RATE;
+	signal = (float *)malloc((size_t)frames * BENCH_LOUDNESS_CHANNELS * sizeof(float));
+	if ((seconds == 0U) || (signal == NULL))
+	{
+		(void)fprintf(stderr, "usage: %s [seconds of audio]\n", argv[0]);
+		ret = 1;
+	}
+	else
+	{
+		uint64_t referenceTime;
+		uint64_t kernelTime;
+		float reference;
+		float kernel;
+
+		(void)printf("%u s of %u Hz, %u channels, %u frames per buffer, kernel %s\n", seconds,
+					 BENCH_LOUDNESS_RATE, BENCH_LOUDNESS_CHANNELS, BENCH_LOUDNESS_FRAMES, AudioLoudnessGetKernelName());
+
+		FillSine(signal, frames, BENCH_LOUDNESS_SINE_LEVEL);
+		reference = Measure(AudioLoudnessMeterProcessReference, signal, frames, &referenceTime);
+		kernel = Measure(AudioLoudnessMeterProcess, signal, frames, &kernelTime);
+		(void)printf("sine %.1f dBFS: reference %.2f LUFS, %s %.2f LUFS\n", BENCH_LOUDNESS_SINE_LEVEL, reference,
+					 AudioLoudnessGetKernelName(), kernel);
+		if ((fabs((double)reference - BENCH_LOUDNESS_SINE_LEVEL) > BENCH_LOUDNESS_TOLERANCE) ||
+			(fabs((double)kernel - BENCH_LOUDNESS_SINE_LEVEL) > BENCH_LOUDNESS_TOLERANCE))
+		{
+			(void)fprintf(stderr, "sine is not measured at %.1f LUFS\n", BENCH_LOUDNESS_SINE_LEVEL);
+			ret = 1;
+		}
+
+		FillSignal(signal, frames);
+		reference = Measure(AudioLoudnessMeterProcessReference, signal, frames, &referenceTime);
+		kernel = Measure(AudioLoudnessMeterProcess, signal, frames, &kernelTime);
+		(void)printf("sweep: reference %.2f LUFS %6.3f ns/frame %6.0fx real time, "
+					 "%-6s %.2f LUFS %6.3f ns/frame %6.0fx real time, %5.2fx\n",
+					 reference, (double)referenceTime / (double)frames,
+					 ((double)seconds * 1e9) / (double)referenceTime,
+					 AudioLoudnessGetKernelName(), kernel, (double)kernelTime / (double)frames,
+					 ((double)seconds * 1e9) / (double)kernelTime, (double)referenceTime / (double)kernelTime);
+
+		/* both sum the same squares in the same order, only a fused multiply and add may differ */
+		if (fabs((double)reference - (double)kernel) > 0.01)
+		{
+			(void)fprintf(stderr, "kernel differs from the reference\n");
+			ret = 1;
+		}
+	}
+
+	free(signal);
+
+	return ret;
+}
@@ -0,0 +1,659 @@
+/****************************************************************************************
+ *   FileName    : PlaybackBench.c
+ *   Description : Telechips Headless Playback Benchmark
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		/* mkdtemp */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include "TCLog.h"
+#include "TCTime.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MultiMediaLatency.h"
+
+/*
+ * End to end latency of the player as the daemon drives it, on a box
+ * without audio or video hardware: MultiMediaManager renders into fakesink
+ * instead of alsasink and v4l2sink, still synchronised to the clock.
+ *
+ * Every cycle plays one track of the corpus and measures, in milliseconds,
+ *   start			play request to the first buffer rendered
+ *   pause			pause request to the paused callback
+ *   resume			resume request to the first buffer rendered
+ *   seek			seek request to the first buffer rendered at the new position
+ *   track_change	stop request to the first buffer of the next track
+ * The first buffer is taken from the sink probes of MultiMediaLatency.
+ *
+ * The corpus is a set of generated WAV files unless --corpus names a
+ * directory of media files. The result is one JSON object on stdout with
+ * percentiles of every metric, the CPU time and the peak RSS of the run.
+ *
+ *   PlaybackBench [--cycles count] [--corpus directory] [--sink name]
+ */
+#define BENCH_DEFAULT_CYCLES			20
+#define BENCH_TRACK_COUNT				4
+#define BENCH_TRACK_SECONDS				20
+#define BENCH_SEEK_SECOND				10
+#define BENCH_SETTLE_MS					300
+#define BENCH_TIMEOUT_MS				5000
+#define BENCH_MAX_TRACKS				64
+#define BENCH_DEFAULT_SINK				"fakesink"
+
+#define BENCH_METRIC_LIST(X) \
+	X(Start,			"start") \
+	X(Pause,			"pause") \
+	X(Resume,			"resume") \
+	X(Seek,				"seek") \
+	X(TrackChange,		"track_change")
+
+#define BENCH_METRIC_ENUM(name, text)		BenchMetric##name,
+typedef enum {
+	BENCH_METRIC_LIST(BENCH_METRIC_ENUM)
+	TotalBenchMetrics
+} BenchMetric;
+
+#define BENCH_METRIC_NAME(name, text)		text,
+static const char *s_metricNames[TotalBenchMetrics] = {
+	BENCH_METRIC_LIST(BENCH_METRIC_NAME)
+};
+
+typedef enum {
+	BenchEventPaused,
+	BenchEventStopped,
+	BenchEventError,
+	TotalBenchEvents
+} BenchEvent;
+
+typedef struct stBenchTrack {
+	char path[PATH_MAX];
+	uint8_t content;				/* MultiMediaContentType */
+} BenchTrack;
+
+typedef struct stBenchSamples {
+	double *values;					/* ms */
+	uint32_t count;
+} BenchSamples;
+
+static pthread_mutex_t s_eventMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_eventCond = PTHREAD_COND_INITIALIZER;
+static uint32_t s_events[TotalBenchEvents];
+
+static BenchTrack s_tracks[BENCH_MAX_TRACKS];
+static uint32_t s_trackCount = 0;
+static BenchSamples s_samples[TotalBenchMetrics];
+static uint32_t s_errors = 0;
+
+static void PostEvent(BenchEvent event)
+{
+	(void)pthread_mutex_lock(&s_eventMutex);
+	s_events[event]++;
+	(void)pthread_cond_broadcast(&s_eventCond);
+	(void)pthread_mutex_unlock(&s_eventMutex);
+}
+
+static void OnPaused(int32_t playID)
+{
+	(void)playID;
+	PostEvent(BenchEventPaused);
+}
+
+static void OnStopped(int32_t playID)
+{
+	(void)playID;
+	PostEvent(BenchEventStopped);
+}
+
+static void OnError(int32_t code, int32_t playID)
+{
+	(void)fprintf(stderr, "player error(%d), playID(%d)\n", code, playID);
+	PostEvent(BenchEventError);
+}
+
+static uint32_t GetEventCount(BenchEvent event)
+{
+	uint32_t count;
+
+	(void)pthread_mutex_lock(&s_eventMutex);
+	count = s_events[event];
+	(void)pthread_mutex_unlock(&s_eventMutex);
+
+	return count;
+}
+
+/* time the event count passed seen, -1 on timeout */
+static int64_t WaitEvent(BenchEvent event, uint32_t seen)
+{
+	int64_t now = TCTimeGetMonotonicNs();
+	int64_t deadline = now + ((int64_t)BENCH_TIMEOUT_MS * 1000000);
+	int64_t ret = -1;
+	struct timespec wait;
+
+	(void)pthread_mutex_lock(&s_eventMutex);
+	while ((s_events[event] == seen) && (now < deadline))
+	{
+		(void)clock_gettime(CLOCK_REALTIME, &wait);
+		wait.tv_nsec += 10000000;
+		if (wait.tv_nsec >= 1000000000)
+		{
+			wait.tv_sec++;
+			wait.tv_nsec -= 1000000000;
+		}
+		(void)pthread_cond_timedwait(&s_eventCond, &s_eventMutex, &wait);
+		now = TCTimeGetMonotonicNs();
+	}
+	if (s_events[event] != seen)
+	{
+		ret = now;
+	}
+	(void)pthread_mutex_unlock(&s_eventMutex);
+
+	return ret;
+}
+
+/* time the sink rendered the first buffer for a request made at or after since, -1 on timeout */
+static int64_t WaitFirstBuffer(MultiMediaLatencyRequest request, MultiMediaLatencySink sink, int64_t since)
+{
+	MultiMediaLatencyEvent events[MULTIMEDIA_LATENCY_EVENTS];
+	int64_t deadline = TCTimeGetMonotonicNs() + ((int64_t)BENCH_TIMEOUT_MS * 1000000);
+	int64_t ret = -1;
+	uint32_t count;
+	uint32_t idx;
+
+	while ((ret < 0) && (TCTimeGetMonotonicNs() < deadline))
+	{
+		count = MultiMediaLatencyGetEvents(events, (uint32_t)MULTIMEDIA_LATENCY_EVENTS);
+		for (idx = 0; (idx < count) && (ret < 0); idx++)
+		{
+			if ((events[idx].request == (uint32_t)request) && (events[idx].sink == (uint32_t)sink) &&
+				(events[idx].received >= since))
+			{
+				ret = events[idx].received + ((int64_t)events[idx].latency * 1000);
+			}
+		}
+		if (ret < 0)
+		{
+			(void)usleep(1000);
+		}
+	}
+
+	return ret;
+}
+
+static void AddSample(BenchMetric metric, int64_t begin, int64_t end)
+{
+	BenchSamples *samples = &s_samples[metric];
+
+	if (end < 0)
+	{
+		(void)fprintf(stderr, "%s timed out\n", s_metricNames[metric]);
+		s_errors++;
+	}
+	else
+	{
+		samples->values[samples->count] = (double)(end - begin) / 1000000.0;
+		samples->count++;
+	}
+}
+
+static void Settle(void)
+{
+	(void)usleep((useconds_t)BENCH_SETTLE_MS * 1000U);
+}
+
+static int32_t RunPipeline(const char *description)
+{
+	int32_t ret = -1;
+	GError *error = NULL;
+	GstElement *pipeline = gst_parse_launch(description, &error);
+
+	if (pipeline != NULL)
+	{
+		GstBus *bus = gst_element_get_bus(pipeline);
+		GstMessage *message;
+
+		(void)gst_element_set_state(pipeline, GST_STATE_PLAYING);
+		message = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE,
+											 (GstMessageType)(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+		if ((message != NULL) && (GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS))
+		{
+			ret = 0;
+		}
+		if (message != NULL)
+		{
+			gst_message_unref(message);
+		}
+		(void)gst_element_set_state(pipeline, GST_STATE_NULL);
+		gst_object_unref(bus);
+		gst_object_unref(pipeline);
+	}
+	if (error != NULL)
+	{
+		(void)fprintf(stderr, "%s: %s\n", description, error->message);
+		g_error_free(error);
+	}
+
+	return ret;
+}
+
+/* a box without gst-plugins-base fails here at once instead of timing out every cycle */
+static int32_t CheckElements(const char *corpus, const char *sink)
+{
+	const char *names[] = { "playbin", sink, "audiotestsrc", "wavenc", "filesink" };
+	uint32_t count = (corpus != NULL) ? 2U : (uint32_t)(sizeof(names) / sizeof(names[0]));
+	int32_t ret = 0;
+	uint32_t idx;
+
+	for (idx = 0; idx < count; idx++)
+	{
+		GstElementFactory *factory = gst_element_factory_find(names[idx]);
+
+		if (factory != NULL)
+		{
+			gst_object_unref(factory);
+		}
+		else
+		{
+			(void)fprintf(stderr, "GStreamer element %s is not installed\n", names[idx]);
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+static int32_t GenerateCorpus(const char *directory)
+{
+	static const uint32_t rates[BENCH_TRACK_COUNT] = { 44100, 48000, 32000, 22050 };
+	char description[PATH_MAX + 256];
+	int32_t ret = 0;
+	uint32_t idx;
+
+	for (idx = 0; (idx < (uint32_t)BENCH_TRACK_COUNT) && (ret == 0); idx++)
+	{
+		BenchTrack *track = &s_tracks[s_trackCount];
+
+		(void)snprintf(track->path, sizeof(track->path), "%s/track%u.wav", directory, idx);
+		(void)snprintf(description, sizeof(description),
+					   "audiotestsrc num-buffers=%u samplesperbuffer=1024 freq=%u ! "
+					   "audio/x-raw,format=S16LE,rate=%u,channels=2 ! wavenc ! filesink location=%s",
+					   (rates[idx] * (uint32_t)BENCH_TRACK_SECONDS) / 1024U, 220U * (idx + 1U), rates[idx], track->path);
+		ret = RunPipeline(description);
+		track->content = (uint8_t)MultiMediaContentTypeAudio;
+		s_trackCount++;
+	}
+
+	return ret;
+}
+
+static void RemoveCorpus(const char *directory)
+{
+	uint32_t idx;
+
+	for (idx = 0; idx < s_trackCount; idx++)
+	{
+		(void)unlink(s_tracks[idx].path);
+	}
+	(void)rmdir(directory);
+}
+
+static bool IsVideoFile(const char *name)
+{
+	static const char *extensions[] = { ".mp4", ".m4v", ".mkv", ".avi", ".mov", ".ts", ".webm" };
+	const char *extension = strrchr(name, '.');
+	bool video = false;
+	uint32_t idx;
+
+	for (idx = 0; (extension != NULL) && (idx < (uint32_t)(sizeof(extensions) / sizeof(extensions[0]))); idx++)
+	{
+		if (strcasecmp(extension, extensions[idx]) == 0)
+		{
+			video = true;
+		}
+	}
+
+	return video;
+}
+
+static int CompareTracks(const void *a, const void *b)
+{
+	return strcmp(((const BenchTrack *)a)->path, ((const BenchTrack *)b)->path);
+}
+
+static int32_t ReadCorpus(const char *directory)
+{
+	DIR *dir = opendir(directory);
+	struct dirent *entry;
+	struct stat status;
+	int32_t ret = -1;
+
+	if (dir != NULL)
+	{
+		while (((entry = readdir(dir)) != NULL) && (s_trackCount < (uint32_t)BENCH_MAX_TRACKS))
+		{
+			BenchTrack *track = &s_tracks[s_trackCount];
+
+			(void)snprintf(track->path, sizeof(track->path), "%s/%s", directory, entry->d_name);
+			if ((entry->d_name[0] != '.') && (stat(track->path, &status) == 0) && S_ISREG(status.st_mode))
+			{
+				track->content = IsVideoFile(entry->d_name) ? (uint8_t)MultiMediaContentTypeVideo :
+															  (uint8_t)MultiMediaContentTypeAudio;
+				s_trackCount++;
+			}
+		}
+		(void)closedir(dir);
+		qsort(s_tracks, s_trackCount, sizeof(BenchTrack), CompareTracks);
+		ret = (s_trackCount > 0U) ? 0 : -1;
+	}
+
+	return ret;
+}
+
+static MultiMediaLatencySink GetSink(const BenchTrack *track)
+{
+	return (track->content == (uint8_t)MultiMediaContentTypeVideo) ? MultiMediaLatencyVideo : MultiMediaLatencyAudio;
+}
+
+static int32_t StartTrack(const BenchTrack *track, int32_t playID, int64_t *rendered)
+{
+	int64_t begin = TCTimeGetMonotonicNs();
+	int32_t ret = MultiMediaPlayStartAV(track->content, track->path, 0, 0, 0, playID, 0);
+
+	if (ret == 0)
+	{
+		*rendered = WaitFirstBuffer(MultiMediaLatencyPlay, GetSink(track), begin);
+		AddSample(BenchMetricStart, begin, *rendered);
+		ret = (*rendered < 0) ? -1 : 0;
+	}
+	else
+	{
+		(void)fprintf(stderr, "%s: play request refused(%d)\n", track->path, ret);
+		s_errors++;
+	}
+
+	return ret;
+}
+
+static void RunCycles(uint32_t cycles)
+{
+	int32_t playID = 1;
+	int64_t begin;
+	int64_t rendered = -1;
+	uint32_t seen;
+	uint32_t cycle;
+	int32_t ret;
+
+	ret = StartTrack(&s_tracks[0], playID, &rendered);
+	for (cycle = 0; (cycle < cycles) && (ret == 0); cycle++)
+	{
+		const BenchTrack *track = &s_tracks[cycle % s_trackCount];
+		const BenchTrack *next = &s_tracks[(cycle + 1U) % s_trackCount];
+
+		Settle();
+		seen = GetEventCount(BenchEventPaused);
+		begin = TCTimeGetMonotonicNs();
+		(void)MultiMediaPlayPause(playID);
+		AddSample(BenchMetricPause, begin, WaitEvent(BenchEventPaused, seen));
+
+		Settle();
+		begin = TCTimeGetMonotonicNs();
+		(void)MultiMediaPlayResume(playID);
+		AddSample(BenchMetricResume, begin, WaitFirstBuffer(MultiMediaLatencyResume, GetSink(track), begin));
+
+		Settle();
+		begin = TCTimeGetMonotonicNs();
+		(void)MultiMediaPlaySeek(0, 0, (uint8_t)BENCH_SEEK_SECOND, playID);
+		AddSample(BenchMetricSeek, begin, WaitFirstBuffer(MultiMediaLatencySeek, GetSink(track), begin));
+
+		Settle();
+		seen = GetEventCount(BenchEventStopped);
+		begin = TCTimeGetMonotonicNs();
+		(void)MultiMediaPlayStop(playID);
+		if (WaitEvent(BenchEventStopped, seen) >= 0)
+		{
+			playID++;
+			ret = StartTrack(next, playID, &rendered);
+			AddSample(BenchMetricTrackChange, begin, rendered);
+		}
+		else
+		{
+			(void)fprintf(stderr, "stop timed out\n");
+			s_errors++;
+			ret = -1;
+		}
+	}
+
+	seen = GetEventCount(BenchEventStopped);
+	if (MultiMediaPlayStop(playID) == 0)
+	{
+		(void)WaitEvent(BenchEventStopped, seen);
+	}
+}
+
+static int CompareValues(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+/* nearest rank */
+static double GetPercentile(const BenchSamples *samples, uint32_t percent)
+{
+	uint32_t rank = ((samples->count * percent) + 99U) / 100U;
+
+	return samples->values[(rank > 0U) ? (rank - 1U) : 0U];
+}
+
+static void PrintReport(uint32_t cycles, const char *sink, const struct rusage *begin, const struct rusage *end)
+{
+	uint32_t metric;
+	uint32_t idx;
+	double sum;
+	double user = ((double)(end->ru_utime.tv_sec - begin->ru_utime.tv_sec) * 1000.0) +
+				  ((double)(end->ru_utime.tv_usec - begin->ru_utime.tv_usec) / 1000.0);
+	double system = ((double)(end->ru_stime.tv_sec - begin->ru_stime.tv_sec) * 1000.0) +
+					((double)(end->ru_stime.tv_usec - begin->ru_stime.tv_usec) / 1000.0);
+
+	(void)printf("{\n");
+	(void)printf("  \"cycles\": %u,\n  \"tracks\": %u,\n  \"sink\": \"%s\",\n", cycles, s_trackCount, sink);
+	(void)printf("  \"metrics_ms\": {\n");
+	for (metric = 0; metric < (uint32_t)TotalBenchMetrics; metric++)
+	{
+		BenchSamples *samples = &s_samples[metric];
+
+		(void)printf("    \"%s\": ", s_metricNames[metric]);
+		if (samples->count > 0U)
+		{
+			qsort(samples->values, samples->count, sizeof(double), CompareValues);
+			sum = 0.0;
+			for (idx = 0; idx < samples->count; idx++)
+			{
+				sum += samples->values[idx];
+			}
+			(void)printf("{ \"count\": %u, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+						 "\"max\": %.3f, \"mean\": %.3f }",
+						 samples->count, samples->values[0], GetPercentile(samples, 50U), GetPercentile(samples, 90U),
+						 GetPercentile(samples, 99U), samples->values[samples->count - 1U], sum / (double)samples->count);
+		}
+		else
+		{
+			(void)printf("{ \"count\": 0 }");
+		}
+		(void)printf("%s\n", (metric + 1U < (uint32_t)TotalBenchMetrics) ? "," : "");
+	}
+	(void)printf("  },\n");
+	(void)printf("  \"cpu_user_ms\": %.1f,\n  \"cpu_system_ms\": %.1f,\n", user, system);
+	(void)printf("  \"peak_rss_kb\": %ld,\n  \"errors\": %u\n}\n", end->ru_maxrss, s_errors);
+}
+
+static void *MainLoopThread(void *arg)
+{
+	g_main_loop_run((GMainLoop *)arg);
+	return NULL;
+}
+
+static int32_t Run(uint32_t cycles, const char *corpus, const char *sink)
+{
+	int32_t ret;
+	char generated[] = "/tmp/tcmp-bench-XXXXXX";
+	TcMultiMediaEventCB cb;
+	GMainLoop *loop;
+	pthread_t loopThread;
+	struct rusage begin;
+	struct rusage end;
+	uint32_t metric;
+
+	if (CheckElements(corpus, sink) != 0)
+	{
+		ret = -1;
+	}
+	else if (corpus != NULL)
+	{
+		ret = ReadCorpus(corpus);
+	}
+	else if (mkdtemp(generated) != NULL)
+	{
+		ret = GenerateCorpus(generated);
+	}
+	else
+	{
+		ret = -1;
+	}
+
+	/* one start per cycle and the first one */
+	for (metric = 0; metric < (uint32_t)TotalBenchMetrics; metric++)
+	{
+		s_samples[metric].values = (double *)calloc((size_t)cycles + 1U, sizeof(double));
+		if (s_samples[metric].values == NULL)
+		{
+			ret = -1;
+		}
+	}
+
+	loop = g_main_loop_new(NULL, FALSE);
+	if ((ret == 0) && (loop != NULL) && (MultiMediaInitialize() == 1) &&
+		(pthread_create(&loopThread, NULL, MainLoopThread, loop) == 0))
+	{
+		(void)memset(&cb, 0, sizeof(cb));
+		cb.MultiMediaPlayPausedCB = OnPaused;
+		cb.MultiMediaPlayStoppedCB = OnStopped;
+		cb.MultiMediaErrorOccurredCB = OnError;
+		SetEventCallBackFunctions(&cb);
+		MultiMediaSetAudioSink(sink, NULL);
+		MultiMediaSetVideoSink(sink);
+		MultiMediaSetAlbumArtSharedMemory(0);
+
+		(void)getrusage(RUSAGE_SELF, &begin);
+		RunCycles(cycles);
+		(void)getrusage(RUSAGE_SELF, &end);
+
+		MultiMediaRelease();
+		g_main_loop_quit(loop);
+		(void)pthread_join(loopThread, NULL);
+
+		PrintReport(cycles, sink, &begin, &end);
+		ret = (s_errors == 0U) ? 0 : -1;
+	}
+	else
+	{
+		(void)fprintf(stderr, "no corpus or the player failed to initialize\n");
+		ret = -1;
+	}
+
+	if (loop != NULL)
+	{
+		g_main_loop_unref(loop);
+	}
+	if (corpus == NULL)
+	{
+		RemoveCorpus(generated);
+	}
+	for (metric = 0; metric < (uint32_t)TotalBenchMetrics; metric++)
+	{
+		free(s_samples[metric].values);
+	}
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t ret = 0;
+	uint32_t cycles = BENCH_DEFAULT_CYCLES;
+	const char *corpus = NULL;
+	const char *sink = BENCH_DEFAULT_SINK;
+	int32_t idx;
+
+	for (idx = 1; (idx < argc) && (ret == 0); idx++)
+	{
+		if ((strcmp(argv[idx], "--cycles") == 0) && ((idx + 1) < argc))
+		{
+			idx++;
+			cycles = (uint32_t)strtoul(argv[idx], NULL, 10);
+		}
+		else if ((strcmp(argv[idx], "--corpus") == 0) && ((idx + 1) < argc))
+		{
+			idx++;
+			corpus = argv[idx];
+		}
+		else if ((strcmp(argv[idx], "--sink") == 0) && ((idx + 1) < argc))
+		{
+			idx++;
+			sink = argv[idx];
+		}
+		else
+		{
+			ret = -1;
+		}
+	}
+
+	if ((ret != 0) || (cycles == 0U))
+	{
+		(void)fprintf(stderr, "usage: %s [--cycles count] [--corpus directory] [--sink name]\n", argv[0]);
+		ret = -1;
+	}
+	else
+	{
+		gst_init(NULL, NULL);
+		TCLogInitialize("TC_MEDIA_PLAYBACK_BENCH", NULL, 1);
+		MultiMediaSetDebugLevel(TCLogLevelError);
+		ret = Run(cycles, corpus, sink);
+	}
+
+	return (ret == 0) ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+/****************************************************************************************
+ *   FileName    : PositionSignalBench.c
+ *   Description : Telechips Position Signal Benchmark
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <dbus/dbus.h>
+#include "TCDBusRawAPI.h"
+#include "DBusMsgDef.h"
+
+/*
+ * Cost of one signal_mediaplayback_playpostion as the daemon builds it:
+ *
+ *   varargs	CreateDBusMsgSignal(), as before user-040
+ *   iter		dbus_message_new_signal() and dbus_message_iter_append_basic(),
+ *				what SendPlayPosition() does now
+ *   copy		dbus_message_copy() of a header prepared once, then the same
+ *				appends; the removed signal templates
+ *
+ * Every message gets a serial and is locked as dbus_connection_send() does,
+ * then freed; the transport is not part of the numbers. malloc, calloc and
+ * realloc are counted by wrapping the glibc allocator, which also catches
+ * the calls made inside libdbus.
+ */
+#define BENCH_SIGNAL_COUNT				200000
+
+typedef DBusMessage *(*BenchCreate_fn)(const DBusMessage *prepared, uint32_t idx);
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+
+static uint64_t s_allocations = 0;
+
+void *malloc(size_t size)
+{
+	s_allocations++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+	s_allocations++;
+	return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+	s_allocations++;
+	return __libc_realloc(pointer, size);
+}
+
+static uint64_t GetNanoseconds(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static DBusMessage *AppendPosition(DBusMessage *message, uint32_t idx)
+{
+	DBusMessage *ret = NULL;
+	DBusMessageIter iter;
+	uint8_t hour = 0;
+	uint8_t min = (uint8_t)((idx / 60U) % 60U);
+	uint8_t sec = (uint8_t)(idx % 60U);
+	int32_t playID = 1;
+
+	if (message != NULL)
+	{
+		dbus_message_iter_init_append(message, &iter);
+		if (dbus_message_iter_append_basic(&iter, DBUS_TYPE_BYTE, &hour) &&
+			dbus_message_iter_append_basic(&iter, DBUS_TYPE_BYTE, &min) &&
+			dbus_message_iter_append_basic(&iter, DBUS_TYPE_BYTE, &sec) &&
+			dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &playID))
+		{
+			ret = message;
+		}
+		else
+		{
+			dbus_message_unref(message);
+		}
+	}
+
+	return ret;
+}
+
+static DBusMessage *CreateVarargs(const DBusMessage *prepared, uint32_t idx)
+{
+	uint8_t hour = 0;
+	uint8_t min = (uint8_t)((idx / 60U) % 60U);
+	uint8_t sec = (uint8_t)(idx % 60U);
+	int32_t playID = 1;
+
+	(void)prepared;
+	return CreateDBusMsgSignal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, MEDIAPLAYBACK_EVENT_INTERFACE,
+							   SIGNAL_MEDIAPLAYBACK_PLAYPOSITION,
+							   DBUS_TYPE_BYTE, &hour,
+							   DBUS_TYPE_BYTE, &min,
+							   DBUS_TYPE_BYTE, &sec,
+							   DBUS_TYPE_INT32, &playID,
+							   DBUS_TYPE_INVALID);
+}
+
+static DBusMessage *CreateIter(const DBusMessage *prepared, uint32_t idx)
+{
+	(void)prepared;
+	return AppendPosition(dbus_message_new_signal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, MEDIAPLAYBACK_EVENT_INTERFACE,
+												  SIGNAL_MEDIAPLAYBACK_PLAYPOSITION), idx);
+}
+
+static DBusMessage *CreateCopy(const DBusMessage *prepared, uint32_t idx)
+{
+	return AppendPosition(dbus_message_copy(prepared), idx);
+}
+
+static int32_t Run(const char *name, BenchCreate_fn create, const DBusMessage *prepared, uint32_t count)
+{
+	int32_t ret = 0;
+	uint64_t allocations;
+	uint64_t start;
+	uint64_t elapsed;
+	uint32_t idx;
+
+	/* warm up libdbus' caches before anything is counted */
+	for (idx = 0; (idx < 1000U) && (ret == 0); idx++)
+	{
+		DBusMessage *message = create(prepared, idx);
+		if (message != NULL)
+		{
+			dbus_message_unref(message);
+		}
+		else
+		{
+			ret = -1;
+		}
+	}
+
+	allocations = s_allocations;
+	start = GetNanoseconds();
+	for (idx = 0; (idx < count) && (ret == 0); idx++)
+	{
+		DBusMessage *message = create(prepared, idx);
+		if (message != NULL)
+		{
+			dbus_message_set_serial(message, idx + 1U);
+			dbus_message_lock(message);
+			dbus_message_unref(message);
+		}
+		else
+		{
+			ret = -1;
+		}
+	}
+	elapsed = GetNanoseconds() - start;
+
+	if (ret == 0)
+	{
+		(void)printf("%-8s: %6.2f allocations/signal, %7.1f ns/signal\n", name,
+					 (double)(s_allocations - allocations) / (double)count, (double)elapsed / (double)count);
+	}
+	else
+	{
+		(void)fprintf(stderr, "%s: signal %u could not be built\n", name, idx);
+	}
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t ret = 0;
+	uint32_t count = BENCH_SIGNAL_COUNT;
+	DBusMessage *prepared = NULL;
+
+	if (argc > 1)
+	{
+		count = (uint32_t)strtoul(argv[1], NULL, 10);
+	}
+	if (count != 0U)
+	{
+		prepared = dbus_message_new_signal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, MEDIAPLAYBACK_EVENT_INTERFACE,
+										   SIGNAL_MEDIAPLAYBACK_PLAYPOSITION);
+	}
+
+	if (prepared == NULL)
+	{
+		(void)fprintf(stderr, "usage: %s [count]\n", argv[0]);
+		ret = 1;
+	}
+	else
+	{
+		(void)printf("%u signals of %s\n", count, SIGNAL_MEDIAPLAYBACK_PLAYPOSITION);
+		ret |= Run("varargs", CreateVarargs, prepared, count);
+		ret |= Run("iter", CreateIter, prepared, count);
+		ret |= Run("copy", CreateCopy, prepared, count);
+		dbus_message_unref(prepared);
+	}
+
+	return (ret == 0) ? 0 : 1;
+}
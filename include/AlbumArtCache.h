@@ -0,0 +1,86 @@
+/****************************************************************************************
+ *   FileName    : AlbumArtCache.h
+ *   Description : Telechips Album Art Cache header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef ALBUM_ART_CACHE_H
+#define ALBUM_ART_CACHE_H
+
+#include <gst/gst.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ALBUMART_CACHE_DEFAULT_BUDGET		(8 * 1024)		/* KB of encoded images kept in memory */
+#define ALBUMART_CACHE_DEFAULT_DISK_BUDGET	(32 * 1024)		/* KB of files kept in the cache directory */
+#define ALBUMART_CACHE_MAX_FOLDER_IMAGE		(4 * 1024 * 1024)
+
+/*
+ * Encoded album art is kept by the xxHash64 of its bytes, so a cover embedded
+ * in every track of an album is stored, sealed into a memfd and scaled once.
+ * The least recently used images are dropped when the budget is exceeded.
+ *
+ * With a cache directory, derived data such as scaled thumbnails is also
+ * written to <directory>/<hash>-<variant>.bin and survives a restart.
+ *
+ * The cover image of a track folder is looked up on a worker thread, which
+ * calls AlbumArtCacheFolderImageCB with it. A folder without a cover calls
+ * nothing.
+ */
+typedef struct stAlbumArtCacheStatistics {
+	uint32_t hits;					/* image found by its hash or folder */
+	uint32_t misses;
+	uint32_t folderImages;			/* covers read from the track folder */
+	uint32_t diskHits;
+	uint32_t diskMisses;
+	uint32_t evictions;
+	uint32_t entries;
+	uint32_t bytes;
+	uint32_t budget;
+} AlbumArtCacheStatistics;
+
+typedef void (*AlbumArtCacheFolderImage_cb)(int32_t playID, GstBuffer *image, uint64_t hash);
+
+typedef struct stAlbumArtCacheEventCB {
+	AlbumArtCacheFolderImage_cb		AlbumArtCacheFolderImageCB;
+} TcAlbumArtCacheEventCB;
+
+int32_t AlbumArtCacheSetBudget(const char *kilobytes);
+int32_t AlbumArtCacheSetDirectory(const char *directory);
+int32_t AlbumArtCacheInitialize(void);
+void AlbumArtCacheRelease(void);
+uint64_t AlbumArtCacheHash(const uint8_t *data, uint32_t length);
+uint64_t AlbumArtCacheAdd(GstBuffer *image);
+void AlbumArtCacheSetEventCallBackFunctions(TcAlbumArtCacheEventCB *cb);
+int32_t AlbumArtCacheRequestFolderImage(const char *trackPath, int32_t playID);
+int32_t AlbumArtCacheGetFd(uint64_t hash);
+int32_t AlbumArtCacheLoadFile(uint64_t hash, const char *variant, uint8_t *data, uint32_t size);
+void AlbumArtCacheStoreFile(uint64_t hash, const char *variant, const uint8_t *data, uint32_t size);
+void AlbumArtCacheGetStatistics(AlbumArtCacheStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,55 @@
+/****************************************************************************************
+ *   FileName    : AlbumArtScaler.h
+ *   Description : Telechips Album Art Scaler header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef ALBUM_ART_SCALER_H
+#define ALBUM_ART_SCALER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	AlbumArtFormatARGB8888,		/* 32 bit, 0xAARRGGBB in native endian */
+	AlbumArtFormatRGB565,		/* 16 bit, native endian */
+	TotalAlbumArtFormats
+} AlbumArtFormat;
+
+uint32_t AlbumArtGetBytesPerPixel(AlbumArtFormat format);
+void AlbumArtFitSize(uint32_t srcWidth, uint32_t srcHeight, uint32_t maxWidth, uint32_t maxHeight,
+					uint32_t *width, uint32_t *height);
+/*
+ * Box filter an RGBA8888 image into dstWidth x dstHeight and store it in the display format.
+ * work must hold AlbumArtGetWorkSize(srcWidth, dstWidth) bytes.
+ */
+uint32_t AlbumArtGetWorkSize(uint32_t srcWidth, uint32_t dstWidth);
+void AlbumArtScale(const uint8_t *src, uint32_t srcWidth, uint32_t srcHeight, uint32_t srcStride,
+					uint8_t *dst, uint32_t dstWidth, uint32_t dstHeight, uint32_t dstStride,
+					AlbumArtFormat format, void *work);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
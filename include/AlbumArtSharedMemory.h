@@ -0,0 +1,116 @@
+/****************************************************************************************
+ *   FileName    : AlbumArtSharedMemory.h
+ *   Description : Telechips Album Art Shared Memory header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef ALBUM_ART_SHARED_MEMORY_H
+#define ALBUM_ART_SHARED_MEMORY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ALBUMART_SHM_MAX_SLOTS			4
+#define ALBUMART_SHM_DEFAULT_SLOTS		1		/* one slot takes an image of almost MEM_SIZE, as before the slots */
+#define ALBUMART_SHM_NO_SLOT			(0xFFFFFFFFU)
+
+/*
+ * Shared memory layout of KEY_NUM (version 1), MEM_SIZE bytes
+ *
+ *   AlbumArtShmHeader
+ *   slot[0 .. slotCount - 1], slotSize bytes each, first slot at headerSize:
+ *       AlbumArtShmSlot
+ *       encoded image (JPEG, PNG, ...), at most slotSize - sizeof(AlbumArtShmSlot) bytes
+ *
+ * Every slot is a seqlock. The daemon makes sequence odd, rewrites the slot
+ * and makes it even again. A reader
+ *
+ *   1. loads sequence (acquire) and retries later if it is odd,
+ *   2. copies the fields and the image it needs,
+ *   3. loads sequence again (after an acquire fence) and discards the copy
+ *      if it differs from the first load.
+ *
+ * generation grows by one for every image published into any slot, so the
+ * slot with the highest generation holds the latest image and a changed
+ * generation tells a list view its cached copy is stale. An image is kept
+ * in its slot until the slot is reused for the art of another track; the
+ * least recently published slot is reused first.
+ *
+ * slotCount is 1 unless --albumart-shm-slots asks for more, which divides
+ * the largest image by the count.
+ *
+ * An image is published before SIGNAL_MEDIAPLAYBACK_ALBUMART_COMPLETED, which
+ * carries its slot and generation, or ALBUMART_SHM_NO_SLOT if it does not
+ * fit. With --albumart-shm-on-request it is published on the first
+ * METHOD_MEDIAPLAYBACK_GET_ALBUMART_KEY of its track instead; the signal then
+ * carries ALBUMART_SHM_NO_SLOT and the image is in latestSlot once the reply
+ * arrives.
+ *
+ * The segment is only created when the first image is published. Clients
+ * that can take a file descriptor should prefer
+ * METHOD_MEDIAPLAYBACK_GET_ALBUMART_FD, which returns a sealed memfd holding
+ * exactly the current image.
+ */
+#define ALBUMART_SHM_MAGIC				(0x48534141U)	/* "AASH" */
+#define ALBUMART_SHM_VERSION			1
+
+typedef enum {
+	AlbumArtImageUnknown,
+	AlbumArtImageJPEG,
+	AlbumArtImagePNG,
+	AlbumArtImageGIF,
+	AlbumArtImageBMP,
+	TotalAlbumArtImageFormats
+} AlbumArtImageFormat;
+
+typedef struct stAlbumArtShmHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t slotCount;
+	uint32_t slotSize;
+	volatile uint32_t latestSlot;	/* slot written last, valid once its generation is not 0 */
+	uint32_t reserved[2];
+} AlbumArtShmHeader;
+
+typedef struct stAlbumArtShmSlot {
+	volatile uint32_t sequence;
+	uint32_t generation;			/* 0 if the slot was never written */
+	int32_t playID;
+	uint32_t length;
+	uint32_t format;				/* AlbumArtImageFormat */
+	uint32_t reserved[3];
+} AlbumArtShmSlot;
+
+int32_t AlbumArtSharedMemorySetSlots(const char *count);
+int32_t AlbumArtSharedMemoryInitialize(void);
+int32_t AlbumArtSharedMemoryRelease(void);
+int32_t AlbumArtSharedMemoryPublish(int32_t playID, const uint8_t *data, uint32_t length,
+									uint32_t *slot, uint32_t *generation);
+int32_t AlbumArtSharedMemoryCreateFd(const uint8_t *data, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
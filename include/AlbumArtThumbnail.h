@@ -0,0 +1,95 @@
+/****************************************************************************************
+ *   FileName    : AlbumArtThumbnail.h
+ *   Description : Telechips Album Art Thumbnail header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef ALBUM_ART_THUMBNAIL_H
+#define ALBUM_ART_THUMBNAIL_H
+
+#include <gst/gst.h>
+#include "AlbumArtScaler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ALBUMART_THUMBNAIL_KEY_NUM			(3444)
+#define ALBUMART_THUMBNAIL_MAX_SIZES		4
+#define ALBUMART_THUMBNAIL_MAX_DIMENSION	1024
+
+/*
+ * Shared memory layout (version 1)
+ *
+ *   AlbumArtThumbnailHeader
+ *   pixel data of thumbnail[0 .. count - 1], each at its offset
+ *
+ * Every thumbnail is the decoded album art scaled to fit maxWidth x maxHeight
+ * with its aspect ratio kept, stored in the header format, ready to blit.
+ * sequence is odd while the daemon rewrites the segment: a reader copies the
+ * image and retries if sequence was odd or changed meanwhile.
+ */
+#define ALBUMART_THUMBNAIL_MAGIC			(0x424D4854U)	/* "THMB" */
+#define ALBUMART_THUMBNAIL_VERSION			1
+
+typedef struct stAlbumArtThumbnailInfo {
+	uint32_t maxWidth;
+	uint32_t maxHeight;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;				/* bytes per line */
+	uint32_t offset;				/* from the start of the segment */
+	uint32_t capacity;				/* bytes reserved at offset */
+	uint32_t reserved;
+} AlbumArtThumbnailInfo;
+
+typedef struct stAlbumArtThumbnailHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t format;				/* AlbumArtFormat */
+	uint32_t count;
+	int32_t playID;					/* -1 if no thumbnail is published */
+	volatile uint32_t sequence;
+	uint32_t reserved;
+	AlbumArtThumbnailInfo thumbnails[ALBUMART_THUMBNAIL_MAX_SIZES];
+} AlbumArtThumbnailHeader;
+
+typedef void (*AlbumArtThumbnailCompleted_cb)(int32_t playID, uint32_t count);
+
+typedef struct stAlbumArtThumbnailEventCB {
+	AlbumArtThumbnailCompleted_cb		AlbumArtThumbnailCompletedCB;
+} TcAlbumArtThumbnailEventCB;
+
+int32_t AlbumArtThumbnailAddSize(const char *size);
+int32_t AlbumArtThumbnailSetFormat(const char *format);
+int32_t AlbumArtThumbnailInitialize(void);
+void AlbumArtThumbnailRelease(void);
+void AlbumArtThumbnailSetEventCallBackFunctions(TcAlbumArtThumbnailEventCB *cb);
+int32_t AlbumArtThumbnailRequest(GstSample *image, int32_t playID, uint64_t hash);
+int32_t AlbumArtThumbnailGetKey(int32_t *key, uint32_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,99 @@
+/****************************************************************************************
+ *   FileName    : AudioCrossfade.h
+ *   Description : Telechips Audio Crossfade header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef AUDIO_CROSSFADE_H
+#define AUDIO_CROSSFADE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <gst/gst.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Crossfade between consecutive tracks. Once a length is set, audio players
+ * no longer open the audio device: their audio sink is an input of the
+ * mixer, converted to AUDIO_CROSSFADE_RATE stereo F32, and one output
+ * pipeline of the mixer keeps the device open from track to track. Video
+ * players take the device back and close the output.
+ *
+ * When the next track starts, the player of the current one is handed to the
+ * mixer, which plays it on at full level until the first samples of the new
+ * track arrive and then fades the two over the length, or with a length of
+ * 0 plays it to its end and the new track right after. At most two tracks
+ * are mixed: a third one drops the oldest. The mixer posts
+ * AUDIO_CROSSFADE_ENDING_MESSAGE on the bus of a player
+ * AUDIO_CROSSFADE_LEAD_TIME before the fade has to start, so the next track
+ * has time to preroll.
+ */
+#define AUDIO_CROSSFADE_MAX_LENGTH			12000	/* ms */
+#define AUDIO_CROSSFADE_RATE				48000
+#define AUDIO_CROSSFADE_BLOCK_FRAMES		1024	/* mixed and pushed at once, 21 ms */
+#define AUDIO_CROSSFADE_QUEUE_BLOCKS		2		/* between the mixer and the device */
+#define AUDIO_CROSSFADE_LEAD_TIME			1000	/* ms */
+#define AUDIO_CROSSFADE_ENDING_MESSAGE		"crossfade-ending"
+
+/*
+ * A transition from one track to the next. start and end count frames of
+ * the output since it was opened, at AUDIO_CROSSFADE_RATE; the times are
+ * CLOCK_MONOTONIC ns the mixer produced those frames, the device plays them
+ * its buffer later.
+ */
+typedef struct stAudioCrossfadeTransition {
+	int32_t fromID;
+	int32_t toID;
+	uint64_t start;						/* first frame of the new track */
+	uint64_t end;						/* first frame without the old one */
+	int64_t startTime;
+	int64_t endTime;
+	int64_t fromPosition;				/* ns, where the old track was left */
+} AudioCrossfadeTransition;
+
+typedef void (*AudioCrossfadeTransition_cb)(const AudioCrossfadeTransition *transition);
+
+int32_t AudioCrossfadeSetLength(const char *seconds);
+/* ms, clamped to AUDIO_CROSSFADE_MAX_LENGTH, enables the mixer for the next player */
+uint32_t AudioCrossfadeSetLengthMs(uint32_t length);
+uint32_t AudioCrossfadeGetLength(void);
+bool AudioCrossfadeIsEnabled(void);
+void AudioCrossfadeSetEventCallBack(AudioCrossfadeTransition_cb cb);
+/* takes sink, the device sink of the output, if the output is not open yet */
+int32_t AudioCrossfadeOpen(GstElement *sink);
+bool AudioCrossfadeIsOpen(void);
+void AudioCrossfadeClose(void);
+void AudioCrossfadeRelease(void);
+/* audio sink of a player, the new current track of the mixer */
+GstElement *AudioCrossfadeCreateSink(int32_t playID);
+/* sink is the current track no longer played by its player, 0 if it is unknown */
+int32_t AudioCrossfadeHandOff(GstElement *sink, GstElement *pipeline);
+void AudioCrossfadeRemoveSink(GstElement *sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,71 @@
+/****************************************************************************************
+ *   FileName    : AudioCrossfadeKernel.h
+ *   Description : Telechips Audio Crossfade Kernel header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef AUDIO_CROSSFADE_KERNEL_H
+#define AUDIO_CROSSFADE_KERNEL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Mix of two tracks during a crossfade. The gains follow an equal power
+ * curve, cos for the outgoing and sin for the incoming track, so the sum
+ * keeps its loudness through the fade. The curve is taken at every
+ * AUDIO_CROSSFADE_SEGMENT frames and the gains move linearly in between,
+ * which the kernel does per frame without calling a sine.
+ */
+#define AUDIO_CROSSFADE_CHANNELS			2		/* interleaved F32, the mixer converts to it */
+#define AUDIO_CROSSFADE_SEGMENT				64		/* frames, under 1.5 ms at 48 kHz */
+
+/* gain of frame f is start + (step * f), of both channels */
+typedef struct stAudioCrossfadeRamp {
+	float inStart;
+	float inStep;
+	float outStart;
+	float outStep;
+} AudioCrossfadeRamp;
+
+/* ramp of frames from position, of a fade of length frames */
+void AudioCrossfadeRampInit(AudioCrossfadeRamp *ramp, uint64_t position, uint64_t length, uint32_t frames);
+/*
+ * mix = (in * in gain) + (out * out gain) over frames. AudioCrossfadeMix()
+ * runs two or four frames per vector (AVX2, SSE2 or NEON, as built) and
+ * AudioCrossfadeMixReference() one sample at a time; both do the same
+ * operations in the same order, so the samples only differ where the
+ * compiler fuses a multiply and add.
+ */
+void AudioCrossfadeMix(float *mix, const float *in, const float *out, uint32_t frames, const AudioCrossfadeRamp *ramp);
+void AudioCrossfadeMixReference(float *mix, const float *in, const float *out, uint32_t frames,
+								const AudioCrossfadeRamp *ramp);
+const char *AudioCrossfadeGetKernelName(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,76 @@
+/****************************************************************************************
+ *   FileName    : AudioEqualizer.h
+ *   Description : Telechips Audio Equalizer header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef AUDIO_EQUALIZER_H
+#define AUDIO_EQUALIZER_H
+
+#include <stdint.h>
+#include <gst/gst.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Parametric equalizer the player inserts as audio-filter of playbin. It
+ * takes interleaved F32, S16 and S32 and runs the bands with the kernels of
+ * AudioEqualizerKernel.h. A preset selected while playing is reached over
+ * AUDIO_EQUALIZER_RAMP ms, with the bands recomputed every block, so the
+ * change neither clicks nor restarts the pipeline. It also applies the
+ * loudness normalization gain of the track (AudioLoudness.h), ramped the same
+ * way when ReplayGain tags of the stream change it. With the flat preset and
+ * no gain the element is in passthrough and costs nothing.
+ */
+#define AUDIO_EQUALIZER_PRESET_LIST(X) \
+	X(Flat,			"flat") \
+	X(Bass,			"bass") \
+	X(Treble,		"treble") \
+	X(Vocal,		"vocal") \
+	X(Rock,			"rock") \
+	X(Classical,	"classical") \
+	X(Loudness,		"loudness")
+
+#define AUDIO_EQUALIZER_PRESET_ENUM(name, text)		AudioEqualizerPreset##name,
+typedef enum {
+	AUDIO_EQUALIZER_PRESET_LIST(AUDIO_EQUALIZER_PRESET_ENUM)
+	TotalAudioEqualizerPresets
+} AudioEqualizerPreset;
+
+#define AUDIO_EQUALIZER_RAMP			50		/* ms */
+
+extern const char *g_audioEqualizerPresetNames[TotalAudioEqualizerPresets];
+
+void AudioEqualizerDisable(void);
+int32_t AudioEqualizerSetPreset(const char *name);
+uint32_t AudioEqualizerGetPreset(void);
+/* dB, for the streams started from now on */
+void AudioEqualizerSetGain(float gain);
+GstElement *AudioEqualizerCreate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
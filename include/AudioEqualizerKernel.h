@@ -0,0 +1,94 @@
+/****************************************************************************************
+ *   FileName    : AudioEqualizerKernel.h
+ *   Description : Telechips Audio Equalizer Kernel header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef AUDIO_EQUALIZER_KERNEL_H
+#define AUDIO_EQUALIZER_KERNEL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_EQUALIZER_BANDS			8		/* unused bands pass the signal unchanged */
+#define AUDIO_EQUALIZER_CHANNELS		8
+
+typedef enum {
+	AudioEqualizerPeak,
+	AudioEqualizerLowShelf,
+	AudioEqualizerHighShelf,
+	TotalAudioEqualizerBandTypes
+} AudioEqualizerBandType;
+
+typedef enum {
+	AudioEqualizerF32,			/* interleaved, native endian */
+	AudioEqualizerS16,
+	AudioEqualizerS32,
+	TotalAudioEqualizerFormats
+} AudioEqualizerFormat;
+
+typedef struct stAudioEqualizerBand {
+	uint32_t type;				/* AudioEqualizerBandType */
+	float frequency;			/* Hz */
+	float q;
+	float gain;					/* dB, 0 passes the signal unchanged */
+} AudioEqualizerBand;
+
+/* biquads of the bands, normalized by a0, one band per array element */
+typedef struct stAudioEqualizerCoefficients {
+	float b0[AUDIO_EQUALIZER_BANDS];
+	float b1[AUDIO_EQUALIZER_BANDS];
+	float b2[AUDIO_EQUALIZER_BANDS];
+	float a1[AUDIO_EQUALIZER_BANDS];
+	float a2[AUDIO_EQUALIZER_BANDS];
+} AudioEqualizerCoefficients;
+
+/* transposed direct form II delay of every band and channel */
+typedef struct stAudioEqualizerState {
+	float z1[AUDIO_EQUALIZER_CHANNELS][AUDIO_EQUALIZER_BANDS];
+	float z2[AUDIO_EQUALIZER_CHANNELS][AUDIO_EQUALIZER_BANDS];
+} AudioEqualizerState;
+
+void AudioEqualizerDesign(const AudioEqualizerBand *bands, uint32_t count, uint32_t rate,
+						  AudioEqualizerCoefficients *coefficients);
+void AudioEqualizerReset(AudioEqualizerState *state);
+/*
+ * Run the bands in place over frames of interleaved samples. AudioEqualizerProcess()
+ * keeps the bands in the lanes of a vector (AVX2, SSE2 or NEON, as built) and
+ * AudioEqualizerProcessReference() runs them one after the other. Both do the
+ * same operations in the same order, so the samples only differ where the
+ * compiler fuses a multiply and add.
+ */
+void AudioEqualizerProcess(const AudioEqualizerCoefficients *coefficients, AudioEqualizerState *state,
+						   void *data, uint32_t frames, uint32_t channels, AudioEqualizerFormat format);
+void AudioEqualizerProcessReference(const AudioEqualizerCoefficients *coefficients, AudioEqualizerState *state,
+									void *data, uint32_t frames, uint32_t channels, AudioEqualizerFormat format);
+const char *AudioEqualizerGetKernelName(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
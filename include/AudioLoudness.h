@@ -0,0 +1,102 @@
+/****************************************************************************************
+ *   FileName    : AudioLoudness.h
+ *   Description : Telechips Audio Loudness Normalization header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef AUDIO_LOUDNESS_H
+#define AUDIO_LOUDNESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <gst/gst.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Loudness normalization. The gain of a track brings it to the target
+ * loudness and comes from its ReplayGain tags, or else from the integrated
+ * loudness (EBU R128) a background worker measured once and keeps in a
+ * cache file next to the media library index, keyed by path, size and
+ * modification time. A track that is not in the cache yet plays unchanged
+ * and is queued, so the gain applies from the next play on.
+ *
+ * The worker decodes at idle CPU and I/O priority and, while the player is
+ * playing, no faster than AUDIO_LOUDNESS_PLAYING_SPEED times real time.
+ * After a library scan it measures every track of the library the cache
+ * does not know yet.
+ */
+#define AUDIO_LOUDNESS_DEFAULT_TARGET		(-18.0f)	/* LUFS, the ReplayGain 2.0 reference level */
+#define AUDIO_LOUDNESS_MAX_BOOST			(12.0f)		/* dB */
+#define AUDIO_LOUDNESS_MAX_CUT				(-24.0f)	/* dB */
+#define AUDIO_LOUDNESS_PLAYING_SPEED		8
+#define AUDIO_LOUDNESS_QUEUE_SIZE			32
+#define AUDIO_LOUDNESS_CACHE_FILE			"loudness.cache"
+
+/*
+ * Cache file: the header and then the records in the order they were
+ * measured. A later record of a path replaces an earlier one; the file is
+ * compacted when it is loaded.
+ */
+#define AUDIO_LOUDNESS_CACHE_MAGIC			"TCLOUDN1"
+
+typedef struct stAudioLoudnessCacheHeader {
+	char magic[8];
+	uint32_t recordSize;
+	uint32_t reserved;
+} AudioLoudnessCacheHeader;
+
+typedef enum {
+	AudioLoudnessMeasured,				/* by the worker */
+	AudioLoudnessTagged,				/* from ReplayGain tags */
+	AudioLoudnessFailed,				/* could not be decoded, plays unchanged */
+	TotalAudioLoudnessSources
+} AudioLoudnessSource;
+
+typedef struct stAudioLoudnessRecord {
+	uint64_t pathHash;
+	uint64_t size;
+	int64_t mtime;
+	float loudness;						/* LUFS */
+	float peak;							/* largest absolute sample, 0 if unknown */
+	uint32_t source;					/* AudioLoudnessSource */
+	uint32_t reserved;
+} AudioLoudnessRecord;
+
+void AudioLoudnessDisable(void);
+bool AudioLoudnessIsEnabled(void);
+int32_t AudioLoudnessSetTarget(const char *target);
+int32_t AudioLoudnessInitialize(const char *cacheDir);
+void AudioLoudnessRelease(void);
+/* dB for the track, 0 and queued for the worker if its loudness is not known yet */
+float AudioLoudnessGetGain(const char *path);
+/* 1 and the gain in dB if the tags carry a ReplayGain track gain */
+int32_t AudioLoudnessGetTagGain(const GstTagList *tags, float *gain);
+void AudioLoudnessAnalyzeLibrary(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,91 @@
+/****************************************************************************************
+ *   FileName    : AudioLoudnessKernel.h
+ *   Description : Telechips Audio Loudness Kernel header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef AUDIO_LOUDNESS_KERNEL_H
+#define AUDIO_LOUDNESS_KERNEL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Integrated loudness of ITU-R BS.1770 / EBU R128: the channels are
+ * K-weighted (a high shelf and a high pass), their mean square is taken over
+ * 400 ms blocks every 100 ms, and the blocks above the absolute gate of
+ * -70 LUFS and then above the relative gate of 10 LU under their mean are
+ * averaged. Blocks are kept in a histogram of AUDIO_LOUDNESS_HISTOGRAM_STEP
+ * wide bins with the sum of their mean squares, so a track of any length
+ * needs no memory and only the relative gate is placed to half a bin.
+ */
+#define AUDIO_LOUDNESS_CHANNELS				2		/* more are downmixed by the decoder */
+#define AUDIO_LOUDNESS_LANES				(AUDIO_LOUDNESS_CHANNELS * 2)	/* both filters of every channel */
+#define AUDIO_LOUDNESS_SILENCE				(-70.0f)	/* LUFS, the absolute gate */
+#define AUDIO_LOUDNESS_HISTOGRAM_TOP		(10.0f)		/* LUFS */
+#define AUDIO_LOUDNESS_HISTOGRAM_STEP		(0.1f)		/* LU */
+#define AUDIO_LOUDNESS_HISTOGRAM_BINS		800
+
+typedef struct stAudioLoudnessMeter {
+	/* lane 2c filters channel c with the shelf, lane 2c + 1 its output with the high pass */
+	float b0[AUDIO_LOUDNESS_LANES];
+	float b1[AUDIO_LOUDNESS_LANES];
+	float b2[AUDIO_LOUDNESS_LANES];
+	float a1[AUDIO_LOUDNESS_LANES];
+	float a2[AUDIO_LOUDNESS_LANES];
+	float z1[AUDIO_LOUDNESS_LANES];
+	float z2[AUDIO_LOUDNESS_LANES];
+	float y[AUDIO_LOUDNESS_LANES];					/* output of the last frame */
+	float sum[AUDIO_LOUDNESS_LANES];				/* squares of the current 100 ms */
+	double subBlocks[3];							/* mean square of the last 100 ms, summed over channels */
+	uint32_t subBlockCount;
+	uint32_t subBlockFrames;
+	uint32_t subBlockDone;
+	uint32_t rate;
+	uint32_t channels;
+	float peak;										/* largest absolute sample */
+	uint64_t frames;
+	uint32_t histogram[AUDIO_LOUDNESS_HISTOGRAM_BINS];
+	double energy[AUDIO_LOUDNESS_HISTOGRAM_BINS];	/* sum of the mean squares of the blocks in the bin */
+} AudioLoudnessMeter;
+
+void AudioLoudnessMeterInit(AudioLoudnessMeter *meter, uint32_t rate, uint32_t channels);
+/*
+ * Measure frames of interleaved F32 samples. AudioLoudnessMeterProcess() runs
+ * the filters of all channels in the lanes of one vector (SSE2 or NEON, as
+ * built) and AudioLoudnessMeterProcessReference() runs them lane by lane;
+ * both do the same operations in the same order.
+ */
+void AudioLoudnessMeterProcess(AudioLoudnessMeter *meter, const float *data, uint32_t frames);
+void AudioLoudnessMeterProcessReference(AudioLoudnessMeter *meter, const float *data, uint32_t frames);
+/* LUFS, AUDIO_LOUDNESS_SILENCE if no block passed the gates */
+float AudioLoudnessMeterGetIntegrated(const AudioLoudnessMeter *meter);
+const char *AudioLoudnessGetKernelName(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
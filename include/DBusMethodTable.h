@@ -0,0 +1,56 @@
+/****************************************************************************************
+ *   FileName    : DBusMethodTable.h
+ *   Description : Telechips DBus Method Table header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef DBUS_METHOD_TABLE_H
+#define DBUS_METHOD_TABLE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DBUS_METHOD_TABLE_SLOTS			256		/* power of two, at least twice the method count */
+
+/*
+ * Maps a DBus member name to its index in a names table in one hash and,
+ * as the table is kept at most half full, usually one string compare.
+ * A slot holds the index plus one, 0 marks an empty slot.
+ */
+typedef struct stDBusMethodTable {
+	const char * const *names;
+	uint32_t count;
+	uint32_t hashes[DBUS_METHOD_TABLE_SLOTS];
+	uint16_t slots[DBUS_METHOD_TABLE_SLOTS];
+} DBusMethodTable;
+
+int32_t DBusMethodTableInitialize(DBusMethodTable *table, const char * const *names, uint32_t count);
+int32_t DBusMethodTableLookup(const DBusMethodTable *table, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -45,20 +45,48 @@ between Telechips and Company.
 #define SIGNAL_MEDIAPLAYBACK_SEEK_COMPLETED			"signal_mediaplayback_seek_completed"
 #define SIGNAL_MEDIAPLAYBACK_ERROR					"signal_mediaplayback_error"
 #define SIGNAL_MEDIAPLAYBACK_SAMPLERATE				"signal_mediaplayback_samplerate"
+#define SIGNAL_MEDIAPLAYBACK_LIBRARY_PROGRESS		"signal_mediaplayback_library_progress"
+#define SIGNAL_MEDIAPLAYBACK_LIBRARY_COMPLETED		"signal_mediaplayback_library_completed"
+#define SIGNAL_MEDIAPLAYBACK_ALBUMART_THUMBNAIL		"signal_mediaplayback_albumart_thumbnail"
+#define SIGNAL_MEDIAPLAYBACK_METADATA				"signal_mediaplayback_metadata"
+#define SIGNAL_MEDIAPLAYBACK_POSITION				"signal_mediaplayback_position"
+/*
+ * crossfade(int32 from playID, int32 to playID, uint64 start, uint64 end,
+ * int64 start time, int64 end time, int64 from position ns), sent once the
+ * next track is heard. start is the first frame of the new track and end
+ * the first one without the old track, counted at 48 kHz since the mixer
+ * opened the device; the times are CLOCK_MONOTONIC ns (AudioCrossfade.h).
+ */
+#define SIGNAL_MEDIAPLAYBACK_CROSSFADE				"signal_mediaplayback_crossfade"
 
+/*
+ * Each signal and method is listed once, as X(EnumName, MEMBER).
+ * The enum, the name tables in DBusMsgDefNames.c and the handler table of the
+ * daemon are expanded from the lists, so a new entry only needs its line here.
+ */
+#define MEDIAPLAYBACK_SIGNAL_LIST(X) \
+	X(Playing,				SIGNAL_MEDIAPLAYBACK_PLAYING) \
+	X(Stopped,				SIGNAL_MEDIAPLAYBACK_STOPPED) \
+	X(Paused,				SIGNAL_MEDIAPLAYBACK_PAUSED) \
+	X(Duration,				SIGNAL_MEDIAPLAYBACK_DURATION) \
+	X(PlayPostion,			SIGNAL_MEDIAPLAYBACK_PLAYPOSITION) \
+	X(TagInfo,				SIGNAL_MEDIAPLAYBACK_TAGINFO) \
+	X(AlbumArtKey,			SIGNAL_MEDIAPLAYBACK_ALBUMART_KEY) \
+	X(AlbumArtCompleted,		SIGNAL_MEDIAPLAYBACK_ALBUMART_COMPLETED) \
+	X(PlayEnded,				SIGNAL_MEDIAPLAYBACK_PLAY_ENDED) \
+	X(SeekCompleted,			SIGNAL_MEDIAPLAYBACK_SEEK_COMPLETED) \
+	X(Error,					SIGNAL_MEDIAPLAYBACK_ERROR) \
+	X(Samplerate,			SIGNAL_MEDIAPLAYBACK_SAMPLERATE) \
+	X(LibraryProgress,		SIGNAL_MEDIAPLAYBACK_LIBRARY_PROGRESS) \
+	X(LibraryCompleted,		SIGNAL_MEDIAPLAYBACK_LIBRARY_COMPLETED) \
+	X(AlbumArtThumbnail,		SIGNAL_MEDIAPLAYBACK_ALBUMART_THUMBNAIL) \
+	X(Metadata,				SIGNAL_MEDIAPLAYBACK_METADATA) \
+	X(Position,				SIGNAL_MEDIAPLAYBACK_POSITION) \
+	X(Crossfade,				SIGNAL_MEDIAPLAYBACK_CROSSFADE)
+
+#define MEDIAPLAYBACK_SIGNAL_LIST_ENUM(name, member)		SignalMediaPlayback##name,
 typedef enum {
-	SignalMediaPlaybackPlaying,
-	SignalMediaPlaybackStopped,
-	SignalMediaPlaybackPaused,
-	SignalMediaPlaybackDuration,
-	SignalMediaPlaybackPlayPostion,
-	SignalMediaPlaybackTagInfo,
-	SignalMediaPlaybackAlbumArtKey,
-	SignalMediaPlaybackAlbumArtCompleted,
-	SignalMediaPlaybackPlayEnded,
-	SignalMediaPlaybackSeekCompleted,
-	SignalMediaPlaybackError,
-	SignalMediaPlaybackSamplerate,
+	MEDIAPLAYBACK_SIGNAL_LIST(MEDIAPLAYBACK_SIGNAL_LIST_ENUM)
 	TotalSignalMediaPlaybackEvents
 } SignalMediaPlaybackEvent;
 extern const char *g_signalMediaPlaybackEventNames[TotalSignalMediaPlaybackEvents];
@@ -75,19 +103,131 @@ extern const char *g_signalMediaPlaybackEventNames[TotalSignalMediaPlaybackEvent
 #define METHOD_MEDIAPLAYBACK_GET_STATUS				"method_mediaplayback_get_status"
 #define METHOD_MEDIAPLAYBACK_GET_ALBUMART_KEY		"method_mediaplayback_get_albumart_key"
 #define METHOD_MEDIAPLAYBACK_GET_PLAY_ID			"method_mediaplayback_get_play_id"
+#define METHOD_MEDIAPLAYBACK_LIBRARY_SCAN			"method_mediaplayback_library_scan"
+#define METHOD_MEDIAPLAYBACK_LIBRARY_CANCEL			"method_mediaplayback_library_cancel"
+#define METHOD_MEDIAPLAYBACK_GET_ALBUMART_THUMBNAIL_KEY	"method_mediaplayback_get_albumart_thumbnail_key"
+#define METHOD_MEDIAPLAYBACK_GET_ALBUMART_FD		"method_mediaplayback_get_albumart_fd"
+#define METHOD_MEDIAPLAYBACK_GET_METADATA			"method_mediaplayback_get_metadata"
+#define METHOD_MEDIAPLAYBACK_GET_TAG_STATS			"method_mediaplayback_get_tag_stats"
+#define METHOD_MEDIAPLAYBACK_GET_ALBUMART_CACHE_STATS	"method_mediaplayback_get_albumart_cache_stats"
+/*
+ * get_state() returns int32 resource status, int32 playID, uint32 playback
+ * (MultiMediaPlaybackState), uint32 position ms, uint32 duration ms,
+ * double rate, boolean seekable, byte content type, int32 sample rate and
+ * the metadata as a{sv}, all from the daemon's last known state.
+ */
+#define METHOD_MEDIAPLAYBACK_GET_STATE				"method_mediaplayback_get_state"
+
+/*
+ * get_status_page() returns a read only memfd holding MultiMediaStatusPage
+ * (MultiMediaState.h) and its uint32 size. The daemon keeps the page up to
+ * date, so a client maps it once and polls it instead of calling get_state.
+ * File descriptors only pass over the bus, a control socket client gets
+ * org.freedesktop.DBus.Error.NotSupported, as for get_albumart_fd.
+ */
+#define METHOD_MEDIAPLAYBACK_GET_STATUS_PAGE		"method_mediaplayback_get_status_page"
+
+/*
+ * get_latency_stats() returns the time from a play, seek or resume request
+ * to the first buffer rendered by each sink (MultiMediaLatency.h):
+ *   a(uuiux)	the latest measurements, oldest first: request, sink, playID,
+ *				latency us, request time (CLOCK_MONOTONIC ns)
+ *   a(uuuuutau)	a histogram per request and sink: request, sink, count,
+ *				min us, max us, sum us, MULTIMEDIA_LATENCY_BUCKETS counts
+ */
+#define METHOD_MEDIAPLAYBACK_GET_LATENCY_STATS		"method_mediaplayback_get_latency_stats"
+
+/*
+ * get_command_stats() returns the use of the single command slot
+ * (MultiMediaCommandStatistics): uint32 posted, uint32 overwritten before the
+ * command thread took them, uint32 refused, uint32 longest wait for the slot
+ * in us and uint64 sum of the waits in us.
+ */
+#define METHOD_MEDIAPLAYBACK_GET_COMMAND_STATS		"method_mediaplayback_get_command_stats"
+
+/*
+ * get_pipeline_stats() returns the statistics of the current or last player
+ * pipeline (MultiMediaPipelineStats.h): int32 playID, uint32 ms it ran,
+ * uint32 elements added, uint32 warnings, uint32 clock lost, uint32 times
+ * buffered and for every element
+ *   a(ssuuttuuuuuuuuu)	name, factory, kind, buffers, bytes received,
+ *				process time sum us, process time max us, queue level,
+ *				queue level max, overruns, underruns, QoS late, QoS
+ *				dropped, discontinuities, warnings
+ */
+#define METHOD_MEDIAPLAYBACK_GET_PIPELINE_STATS		"method_mediaplayback_get_pipeline_stats"
+
+/*
+ * get_span_stats() returns int64 CLOCK_MONOTONIC ns and int64 CLOCK_BOOTTIME
+ * ns, both read now, so a client can place the spans after a suspend, and the
+ * latest spans of every thread (TCTime.h):
+ *   a(siixx)	name, playID, thread, begin (CLOCK_MONOTONIC ns), duration ns
+ */
+#define METHOD_MEDIAPLAYBACK_GET_SPAN_STATS			"method_mediaplayback_get_span_stats"
+
+/*
+ * set_equalizer_preset(string preset) returns int32 1 once the preset is
+ * selected, 0 for an unknown one. The playing track changes over 50 ms.
+ * get_equalizer_preset() returns string preset and as, all preset names.
+ */
+#define METHOD_MEDIAPLAYBACK_SET_EQUALIZER_PRESET	"method_mediaplayback_set_equalizer_preset"
+#define METHOD_MEDIAPLAYBACK_GET_EQUALIZER_PRESET	"method_mediaplayback_get_equalizer_preset"
+
+/*
+ * set_next_track(string path, byte content, int32 playID) returns int32 0
+ * once the track is queued: it plays when the current one ends, or fades in
+ * with a crossfade. An empty path clears it; the next play_start does not.
+ * set_crossfade(uint32 length ms) returns the granted length, at most
+ * 12000; 0 plays the tracks gapless. It applies from the next track on.
+ */
+#define METHOD_MEDIAPLAYBACK_SET_NEXT_TRACK			"method_mediaplayback_set_next_track"
+#define METHOD_MEDIAPLAYBACK_SET_CROSSFADE			"method_mediaplayback_set_crossfade"
+
+/*
+ * subscribe_position(uint32 interval ms) returns the granted interval. The
+ * caller then gets signal_mediaplayback_position(uint32 position ms,
+ * int32 playID) addressed to it alone, at most once per interval and only
+ * while the position moves. A subscription ends with unsubscribe_position()
+ * or when the caller leaves the bus.
+ */
+#define METHOD_MEDIAPLAYBACK_SUBSCRIBE_POSITION		"method_mediaplayback_subscribe_position"
+#define METHOD_MEDIAPLAYBACK_UNSUBSCRIBE_POSITION	"method_mediaplayback_unsubscribe_position"
+
+#define MEDIAPLAYBACK_METHOD_LIST(X) \
+	X(PlayStart,						METHOD_MEDIAPLAYBACK_PLAY_START) \
+	X(PlayStop,						METHOD_MEDIAPLAYBACK_PLAY_STOP) \
+	X(PlayPause,						METHOD_MEDIAPLAYBACK_PLAY_PAUSE) \
+	X(PlayResume,					METHOD_MEDIAPLAYBACK_PLAY_RESUME) \
+	X(PlaySeek,						METHOD_MEDIAPLAYBACK_PLAY_SEEK) \
+	X(SetDisplay,					METHOD_MEDIAPLAYBACK_SET_DISPLAY) \
+	X(SetDualDisplay,				METHOD_MEDIAPLAYBACK_SET_DUAL_DISPLAY) \
+	X(SetDebug,						METHOD_MEDIAPLAYBACK_SET_DEBUG) \
+	X(GetStatus,						METHOD_MEDIAPLAYBACK_GET_STATUS) \
+	X(GetAlbumArtKey,				METHOD_MEDIAPLAYBACK_GET_ALBUMART_KEY) \
+	X(GetPlayID,						METHOD_MEDIAPLAYBACK_GET_PLAY_ID) \
+	X(LibraryScan,					METHOD_MEDIAPLAYBACK_LIBRARY_SCAN) \
+	X(LibraryCancel,					METHOD_MEDIAPLAYBACK_LIBRARY_CANCEL) \
+	X(GetAlbumArtThumbnailKey,		METHOD_MEDIAPLAYBACK_GET_ALBUMART_THUMBNAIL_KEY) \
+	X(GetAlbumArtFd,					METHOD_MEDIAPLAYBACK_GET_ALBUMART_FD) \
+	X(GetMetadata,					METHOD_MEDIAPLAYBACK_GET_METADATA) \
+	X(GetTagStats,					METHOD_MEDIAPLAYBACK_GET_TAG_STATS) \
+	X(GetAlbumArtCacheStats,			METHOD_MEDIAPLAYBACK_GET_ALBUMART_CACHE_STATS) \
+	X(SubscribePosition,				METHOD_MEDIAPLAYBACK_SUBSCRIBE_POSITION) \
+	X(UnsubscribePosition,			METHOD_MEDIAPLAYBACK_UNSUBSCRIBE_POSITION) \
+	X(GetState,						METHOD_MEDIAPLAYBACK_GET_STATE) \
+	X(GetStatusPage,					METHOD_MEDIAPLAYBACK_GET_STATUS_PAGE) \
+	X(GetLatencyStats,				METHOD_MEDIAPLAYBACK_GET_LATENCY_STATS) \
+	X(GetCommandStats,				METHOD_MEDIAPLAYBACK_GET_COMMAND_STATS) \
+	X(GetPipelineStats,				METHOD_MEDIAPLAYBACK_GET_PIPELINE_STATS) \
+	X(SetEqualizerPreset,			METHOD_MEDIAPLAYBACK_SET_EQUALIZER_PRESET) \
+	X(GetEqualizerPreset,			METHOD_MEDIAPLAYBACK_GET_EQUALIZER_PRESET) \
+	X(SetNextTrack,					METHOD_MEDIAPLAYBACK_SET_NEXT_TRACK) \
+	X(SetCrossfade,					METHOD_MEDIAPLAYBACK_SET_CROSSFADE) \
+	X(GetSpanStats,					METHOD_MEDIAPLAYBACK_GET_SPAN_STATS)
 
+#define MEDIAPLAYBACK_METHOD_LIST_ENUM(name, member)		MethodMediaPlayback##name,
 typedef enum {
-	MethodMediaPlaybackPlayStart,
-	MethodMediaPlaybackPlayStop,
-	MethodMediaPlaybackPlayPause,
-	MethodMediaPlaybackPlayResume,
-	MethodMediaPlaybackPlaySeek,
-	MethodMediaPlaybackSetDisplay,
-	MethodMediaPlaybackSetDualDisplay,
-	MethodMediaPlaybackSetDebug,
-	MethodMediaPlaybackGetStatus,
-	MethodMediaPlaybackGetAlbumArtKey,
-	MethodMediaPlaybackGetPlayID,
+	MEDIAPLAYBACK_METHOD_LIST(MEDIAPLAYBACK_METHOD_LIST_ENUM)
 	TotalMethodMediaPlaybackEvents
 } MethodMediaPlaybackEvent;
 extern const char *g_methodMediaPlaybackEventNames[TotalMethodMediaPlaybackEvents];
@@ -0,0 +1,121 @@
+/****************************************************************************************
+ *   FileName    : MediaLibrary.h
+ *   Description : Telechips Media Library Scanner header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef MEDIA_LIBRARY_H
+#define MEDIA_LIBRARY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEDIA_LIBRARY_DEFAULT_INDEX_DIR		"/var/cache/TCMediaPlayback"
+#define MEDIA_LIBRARY_MAX_TAG_SIZE			512
+#define MEDIA_LIBRARY_MAX_WORKERS			16
+
+/*
+ * On-disk index layout (version 1)
+ *
+ *   MediaLibraryIndexHeader
+ *   MediaLibraryRecord[recordCount]      sorted by (pathHash, path)
+ *   string pool                          NUL terminated strings, offset 0 is ""
+ *
+ * The file is written once to a temporary name and renamed into place, so a
+ * reader can mmap it and use the records directly. A header with complete == 0
+ * is a checkpoint of an interrupted scan and is used to resume it, unless
+ * cancelled is set.
+ */
+#define MEDIA_LIBRARY_INDEX_MAGIC			"TCMLIDX1"
+#define MEDIA_LIBRARY_INDEX_VERSION			1
+
+#define MEDIA_LIBRARY_FLAG_COVER_ART		0x00000001U
+#define MEDIA_LIBRARY_FLAG_VIDEO			0x00000002U
+#define MEDIA_LIBRARY_FLAG_NO_TAG			0x00000004U
+
+typedef struct stMediaLibraryIndexHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t recordSize;
+	uint32_t recordCount;
+	uint32_t stringPoolOffset;
+	uint32_t stringPoolSize;
+	uint32_t complete;
+	uint32_t root;					/* string pool offset of the scanned root */
+	uint32_t mountPoint;			/* string pool offset of the mount point of root */
+	uint32_t cancelled;				/* 1 if the user cancelled the scan, it is not resumed */
+	int64_t scanTime;
+} MediaLibraryIndexHeader;
+
+typedef struct stMediaLibraryRecord {
+	uint32_t pathHash;
+	uint32_t path;
+	uint32_t title;
+	uint32_t artist;
+	uint32_t album;
+	uint32_t genre;
+	uint32_t durationMs;
+	uint32_t flags;
+	uint64_t size;
+	int64_t mtime;
+} MediaLibraryRecord;
+
+typedef struct stMediaLibraryTrack {
+	char title[MEDIA_LIBRARY_MAX_TAG_SIZE];
+	char artist[MEDIA_LIBRARY_MAX_TAG_SIZE];
+	char album[MEDIA_LIBRARY_MAX_TAG_SIZE];
+	char genre[MEDIA_LIBRARY_MAX_TAG_SIZE];
+	uint32_t durationMs;
+	uint32_t flags;
+} MediaLibraryTrack;
+
+typedef enum {
+	MediaLibraryScanCompleted,
+	MediaLibraryScanInterrupted,
+	MediaLibraryScanFailed,
+	TotalMediaLibraryScanResults
+} MediaLibraryScanResult;
+
+typedef void (*MediaLibraryScanProgress_cb)(const char *root, uint32_t scanned, uint32_t found);
+typedef void (*MediaLibraryScanCompleted_cb)(const char *root, uint32_t count, int32_t result);
+
+typedef struct stMediaLibraryEventCB {
+	MediaLibraryScanProgress_cb			MediaLibraryScanProgressCB;
+	MediaLibraryScanCompleted_cb		MediaLibraryScanCompletedCB;
+} TcMediaLibraryEventCB;
+
+int32_t MediaLibraryInitialize(const char *indexDir);
+void MediaLibraryRelease(void);
+void MediaLibrarySetEventCallBackFunctions(TcMediaLibraryEventCB *cb);
+int32_t MediaLibraryStartScan(const char *root);
+int32_t MediaLibraryCancelScan(void);
+int32_t MediaLibraryLookup(const char *path, MediaLibraryTrack *track);
+/* path and flags of the record at position, counted over the indexes of all roots; -1 past the last one */
+int32_t MediaLibraryGetPath(uint32_t position, char *path, size_t size, uint32_t *flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
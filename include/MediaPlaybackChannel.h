@@ -0,0 +1,82 @@
+/****************************************************************************************
+ *   FileName    : MediaPlaybackChannel.h
+ *   Description : Telechips Media Playback Peer Channel header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef MEDIAPLAYBACK_CHANNEL_H
+#define MEDIAPLAYBACK_CHANNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <dbus/dbus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEDIAPLAYBACK_CHANNEL_MAX_CLIENTS		8
+#define MEDIAPLAYBACK_CHANNEL_MAX_MESSAGE		(64 * 1024)
+#define MEDIAPLAYBACK_CHANNEL_PEER_PREFIX		":peer."
+
+/*
+ * Optional control channel for local clients that do not want every call
+ * and event to pass through dbus-daemon.
+ *
+ * The daemon listens on a SOCK_SEQPACKET Unix socket. Every packet holds one
+ * DBus message in wire format, as made by dbus_message_marshal() and read
+ * by dbus_message_demarshal(), so clients build and parse messages with
+ * libdbus as usual:
+ *
+ *   - a method call of mediaplayback.event or org.freedesktop.DBus.Properties
+ *     needs a serial set by the client; it goes through the same dispatch as
+ *     a call from the bus and its reply carries that serial as reply serial,
+ *   - methods that return a file descriptor (get_albumart_fd and
+ *     get_status_page) reply with org.freedesktop.DBus.Error.NotSupported;
+ *     dbus_message_demarshal() refuses a message that carries one,
+ *   - every signal the daemon broadcasts on the bus is sent to every client,
+ *   - a client that subscribes to the position gets its position signals
+ *     on the channel.
+ *
+ * A client is known to the daemon as MEDIAPLAYBACK_CHANNEL_PEER_PREFIX<n>,
+ * which is set as the sender of its calls. Events are dropped for a client
+ * that does not read its socket.
+ */
+typedef void (*MediaPlaybackChannelMethodCall_cb)(DBusMessage *message);
+typedef void (*MediaPlaybackChannelDisconnected_cb)(const char *peer);
+
+typedef struct stMediaPlaybackChannelEventCB {
+	MediaPlaybackChannelMethodCall_cb		MediaPlaybackChannelMethodCallCB;
+	MediaPlaybackChannelDisconnected_cb		MediaPlaybackChannelDisconnectedCB;
+} MediaPlaybackChannelEventCB;
+
+int32_t MediaPlaybackChannelSetPath(const char *path);
+int32_t MediaPlaybackChannelInitialize(const MediaPlaybackChannelEventCB *cb);
+void MediaPlaybackChannelRelease(void);
+bool MediaPlaybackChannelIsPeer(const char *name);
+int32_t MediaPlaybackChannelSend(DBusMessage *message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -31,18 +31,27 @@ extern "C" {
 
 void MediaPlaybackDBusInitialize(void);
 void MediaPlaybackDBusRelease(void);
+void MediaPlaybackSetPositionBroadcast(int32_t enable);
+void MediaPlaybackPropertiesChanged(uint32_t changed);
 
 void MediaPlaybackEmitPlaying(int32_t playID);
 void MediaPlaybackEmitStopped(int32_t playID);
 void MediaPlaybackEmitPaused(int32_t playID);
 void MediaPlaybackEmitDuration(uint32_t hour, uint32_t min, uint32_t sec, int32_t playID);
 void MediaPlaybackEmitPlayPosition(uint32_t hour, uint32_t min, uint32_t sec, int32_t playID);
+void MediaPlaybackEmitPosition(uint32_t position, int32_t playID);
 void MediaPlaybackEmitPlayTaginfo(MetaCategory category,const  char * info, int32_t playID);
-void MediaPlaybackEmitAlbumart(int32_t playID, uint32_t length);
+void MediaPlaybackEmitAlbumart(int32_t playID, uint32_t length, uint32_t slot, uint32_t generation);
 void MediaPlaybackEmitPlayEnded(int32_t playID);
 void MediaPlaybackEmitSeekCompleted(uint8_t hour, uint8_t min, uint8_t sec, int32_t playID);
 void MediaPlaybackEmitError(int32_t errCode, int32_t playID);
 void MediaPlaybackEmitSamplerate(int32_t samplerate, int32_t playID);
+void MediaPlaybackEmitLibraryProgress(const char *root, uint32_t scanned, uint32_t found);
+void MediaPlaybackEmitLibraryCompleted(const char *root, uint32_t count, int32_t result);
+void MediaPlaybackEmitAlbumArtThumbnail(int32_t playID, uint32_t count);
+void MediaPlaybackEmitMetadata(const MultiMediaMetadata *metadata, int32_t playID);
+struct stAudioCrossfadeTransition;
+void MediaPlaybackEmitCrossfade(const struct stAudioCrossfadeTransition *transition);
 
 
 #ifdef __cplusplus
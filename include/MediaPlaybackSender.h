@@ -0,0 +1,80 @@
+/****************************************************************************************
+ *   FileName    : MediaPlaybackSender.h
+ *   Description : Telechips Media Playback Event Sender header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef MEDIAPLAYBACK_SENDER_H
+#define MEDIAPLAYBACK_SENDER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEDIAPLAYBACK_SENDER_QUEUE_SIZE		256		/* power of 2 */
+#define MEDIAPLAYBACK_SENDER_LATEST_SLOTS	2
+
+/*
+ * Outbound events of the player threads, handed to one sender thread that
+ * builds and sends the DBus messages, so a slow bus never stalls playback.
+ *
+ * MediaPlaybackSenderPost() puts a copy of the event into a bounded lock-free
+ * queue and never drops it: when the queue is full the event waits in an
+ * overflow list, and later events follow it there until the sender caught
+ * up. MediaPlaybackSenderPostLatest() is for events where only the newest
+ * matters, such as the play position: a slot holds one event and a newer
+ * one replaces it if it was not sent yet.
+ *
+ * The sender calls MediaPlaybackSenderSend_cb for every event, in the order
+ * each thread posted them; the latest slots are sent after the queue. data
+ * belongs to the event and is freed by the callback. Events in a latest slot
+ * must not carry data.
+ */
+typedef struct stMediaPlaybackEvent {
+	uint32_t type;					/* defined by the user of the sender */
+	uint32_t signal;
+	int32_t playID;
+	int32_t value;
+	uint32_t args[3];
+	void *data;
+} MediaPlaybackEvent;
+
+typedef void (*MediaPlaybackSenderSend_cb)(MediaPlaybackEvent *event);
+
+typedef struct stMediaPlaybackSenderStatistics {
+	uint32_t posted;
+	uint32_t overflowed;			/* events that waited in the overflow list */
+	uint32_t replaced;				/* latest events replaced before they were sent */
+} MediaPlaybackSenderStatistics;
+
+int32_t MediaPlaybackSenderInitialize(MediaPlaybackSenderSend_cb cb);
+void MediaPlaybackSenderRelease(void);
+void MediaPlaybackSenderPost(const MediaPlaybackEvent *event);
+void MediaPlaybackSenderPostLatest(uint32_t slot, const MediaPlaybackEvent *event);
+void MediaPlaybackSenderGetStatistics(MediaPlaybackSenderStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
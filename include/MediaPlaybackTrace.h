@@ -0,0 +1,114 @@
+/****************************************************************************************
+ *   FileName    : MediaPlaybackTrace.h
+ *   Description : Telechips Media Playback Trace Ring header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef MEDIAPLAYBACK_TRACE_H
+#define MEDIAPLAYBACK_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEDIAPLAYBACK_TRACE_NAME			"/tc-mediaplayback-trace"
+#define MEDIAPLAYBACK_TRACE_MAGIC			(0x43525450U)	/* "PTRC" */
+#define MEDIAPLAYBACK_TRACE_VERSION			1
+#define MEDIAPLAYBACK_TRACE_MIN_ENTRIES		64
+#define MEDIAPLAYBACK_TRACE_MAX_ENTRIES		(1024 * 1024)
+
+/*
+ * Trace points of the hot paths, written as binary records instead of log
+ * lines. A record keeps the point and four integer arguments; the text is
+ * only made by TCMediaPlaybackTraceDump, which formats the arguments with
+ * the format given here.
+ */
+#define MEDIAPLAYBACK_TRACE_LIST(X) \
+	X(StateChanged,			"pipeline state %lld -> %lld") \
+	X(GstMessage,			"gst message type(0x%llx)") \
+	X(Signal,				"signal[%lld] playID(%lld) args(%lld, %lld)") \
+	X(Command,				"command(%lld) playID(%lld)") \
+	X(Span,					"span(%lld) playID(%lld) %lld ns")
+
+#define MEDIAPLAYBACK_TRACE_LIST_ENUM(name, format)		MediaPlaybackTrace##name,
+typedef enum {
+	MEDIAPLAYBACK_TRACE_LIST(MEDIAPLAYBACK_TRACE_LIST_ENUM)
+	TotalMediaPlaybackTracePoints
+} MediaPlaybackTracePoint;
+
+/*
+ * Layout of the POSIX shared memory MEDIAPLAYBACK_TRACE_NAME
+ *
+ *   MediaPlaybackTraceHeader
+ *   entry[0 .. entryCount - 1], MediaPlaybackTraceEntry each
+ *
+ * head counts the records ever written; record n is in entry
+ * n % entryCount and complete when its sequence is n + 1. A writer clears
+ * sequence, fills the entry and sets it, so a reader discards an entry
+ * whose sequence is not the one it expects. The segment stays in /dev/shm
+ * when the daemon dies, for the dump tool to read afterwards.
+ */
+typedef struct stMediaPlaybackTraceHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t entrySize;
+	uint32_t entryCount;				/* power of 2 */
+	uint32_t reserved;
+	volatile uint64_t head;
+	uint64_t padding[4];
+} MediaPlaybackTraceHeader;
+
+typedef struct stMediaPlaybackTraceEntry {
+	volatile uint64_t sequence;
+	uint64_t timestamp;					/* CLOCK_MONOTONIC ns */
+	uint32_t point;						/* MediaPlaybackTracePoint */
+	int32_t thread;
+	int64_t args[4];
+	uint64_t reserved;
+} MediaPlaybackTraceEntry;
+
+extern MediaPlaybackTraceHeader *g_mediaPlaybackTrace;
+
+/* costs one load while the ring is off */
+#define MEDIAPLAYBACK_TRACE(point, a0, a1, a2, a3) \
+		do \
+		{ \
+			if (g_mediaPlaybackTrace != NULL) \
+			{ \
+				MediaPlaybackTraceWrite((uint32_t)MediaPlaybackTrace##point, \
+										(int64_t)(a0), (int64_t)(a1), (int64_t)(a2), (int64_t)(a3)); \
+			} \
+		} while (0)
+
+int32_t MediaPlaybackTraceSetSize(const char *entries);
+int32_t MediaPlaybackTraceInitialize(void);
+void MediaPlaybackTraceRelease(void);
+void MediaPlaybackTraceWrite(uint32_t point, int64_t a0, int64_t a1, int64_t a2, int64_t a3);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
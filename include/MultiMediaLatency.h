@@ -0,0 +1,98 @@
+/****************************************************************************************
+ *   FileName    : MultiMediaLatency.h
+ *   Description : Telechips Multimedia Latency Probes header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef MULTI_MEDIA_LATENCY_H
+#define MULTI_MEDIA_LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * "Button to sound" and "button to picture": the time from receiving a
+ * play, seek or resume request to the first buffer the audio and the video
+ * sink render for it. A request arms both sinks. A buffer that reaches a
+ * sink which is not playing yet (a prerolling pipeline) is rendered once
+ * the pipeline goes to PLAYING, so it is counted then.
+ * Buffers of another playID, e.g. of a track the crossfade mixer still
+ * plays, are not counted.
+ *
+ * The last MULTIMEDIA_LATENCY_EVENTS measurements are kept as events, and
+ * every request and sink pair has a histogram of all of them.
+ */
+#define MULTIMEDIA_LATENCY_REQUEST_LIST(X) \
+	X(Play,			"play") \
+	X(Seek,			"seek") \
+	X(Resume,		"resume")
+
+#define MULTIMEDIA_LATENCY_REQUEST_ENUM(name, text)	MultiMediaLatency##name,
+typedef enum {
+	MULTIMEDIA_LATENCY_REQUEST_LIST(MULTIMEDIA_LATENCY_REQUEST_ENUM)
+	TotalMultiMediaLatencyRequests
+} MultiMediaLatencyRequest;
+
+typedef enum {
+	MultiMediaLatencyAudio,
+	MultiMediaLatencyVideo,
+	TotalMultiMediaLatencySinks
+} MultiMediaLatencySink;
+
+#define MULTIMEDIA_LATENCY_EVENTS		32
+#define MULTIMEDIA_LATENCY_BUCKETS		16		/* bucket 0 below 1 ms, bucket n below 2^n ms, the last one open */
+
+typedef struct stMultiMediaLatencyEvent {
+	uint32_t request;				/* MultiMediaLatencyRequest */
+	uint32_t sink;					/* MultiMediaLatencySink */
+	int32_t playID;
+	uint32_t latency;				/* us */
+	int64_t received;				/* monotonic ns */
+} MultiMediaLatencyEvent;
+
+typedef struct stMultiMediaLatencyHistogram {
+	uint32_t count;
+	uint32_t min;					/* us */
+	uint32_t max;					/* us */
+	uint64_t sum;					/* us */
+	uint32_t buckets[MULTIMEDIA_LATENCY_BUCKETS];
+} MultiMediaLatencyHistogram;
+
+extern const char *g_multiMediaLatencyRequestNames[TotalMultiMediaLatencyRequests];
+
+void MultiMediaLatencyArm(MultiMediaLatencyRequest request, int32_t playID, int64_t received);
+void MultiMediaLatencyCancel(void);
+void MultiMediaLatencyBuffer(MultiMediaLatencySink sink, int32_t playID, bool playing);
+void MultiMediaLatencyPlaying(void);
+uint32_t MultiMediaLatencyGetEvents(MultiMediaLatencyEvent *events, uint32_t count);
+void MultiMediaLatencyGetHistogram(MultiMediaLatencyRequest request, MultiMediaLatencySink sink,
+								   MultiMediaLatencyHistogram *histogram);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
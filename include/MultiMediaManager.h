@@ -38,18 +38,43 @@ between Telechips and Company.
 #define KEY_NUM							(3443)
 #define MEM_SIZE						(8*1024*1024)
 
+#define MULTIMEDIA_MAX_TAG_SIZE			512
+#define MULTIMEDIA_MAX_CODEC_SIZE		64
+
+
+/*
+ * Calls above MEDIAPLAYBACK_LOG_LEVEL (configure --with-log-level) are
+ * removed by the compiler. The others compare the level set with
+ * MultiMediaSetDebugLevel() before their arguments are evaluated and only
+ * then format the line in TCLog.
+ */
+#ifndef MEDIAPLAYBACK_LOG_LEVEL
+#define MEDIAPLAYBACK_LOG_LEVEL			TCLogLevelDebug
+#endif
+
+extern int32_t g_mediaPlaybackLogLevel;
+
+#define MEDIAPLAYBACK_LOG(level, format, arg...) \
+		do \
+		{ \
+			if (((int32_t)(level) <= (int32_t)MEDIAPLAYBACK_LOG_LEVEL) && \
+				((int32_t)(level) <= __atomic_load_n(&g_mediaPlaybackLogLevel, __ATOMIC_RELAXED))) \
+			{ \
+				(void)TCLog((level), "%s: "format"", __FUNCTION__, ##arg); \
+			} \
+		} while (0)
 
 #define ERROR_PRINTF(format, arg...) \
-		(void)TCLog(TCLogLevelError, "%s: "format"", __FUNCTION__, ##arg);
+		MEDIAPLAYBACK_LOG(TCLogLevelError, format, ##arg);
 
 #define WARN_PRINTF(format, arg...) \
-		(void)TCLog(TCLogLevelWarn, "%s: "format"", __FUNCTION__, ##arg);
+		MEDIAPLAYBACK_LOG(TCLogLevelWarn, format, ##arg);
 
 #define INFO_PRINTF(format, arg...) \
-		(void)TCLog(TCLogLevelInfo, "%s: "format"", __FUNCTION__, ##arg);
+		MEDIAPLAYBACK_LOG(TCLogLevelInfo, format, ##arg);
 
 #define DEBUG_PRINTF(format, arg...) \
-		(void)TCLog(TCLogLevelDebug, "%s: "format"", __FUNCTION__, ##arg);
+		MEDIAPLAYBACK_LOG(TCLogLevelDebug, format, ##arg);
 
 
 typedef void (*MultiMediaPlayStarted_cb)(int32_t playID);
@@ -57,9 +82,47 @@ typedef void (*MultiMediaPlayPaused_cb)(int32_t playID);
 typedef void (*MultiMediaPlayStopped_cb)(int32_t playID);
 typedef void (*MultiMediaPlayTimeChange_cb)(uint32_t hour, uint32_t min, uint32_t sec, int32_t playID);
 typedef void (*MultiMediaTotalTimeChange_cb)(uint32_t hour, uint32_t min, uint32_t sec, int32_t playID);
-typedef void (*MultiMediaID3InformationAll_cb)(const char * title,const char * artist, const char * album, const char * genre, int32_t playID);
+typedef void (*MultiMediaPositionChange_cb)(uint32_t position, int32_t playID);
+typedef struct stMultiMediaMetadata {
+	char title[MULTIMEDIA_MAX_TAG_SIZE];
+	char artist[MULTIMEDIA_MAX_TAG_SIZE];
+	char album[MULTIMEDIA_MAX_TAG_SIZE];
+	char genre[MULTIMEDIA_MAX_TAG_SIZE];
+	char composer[MULTIMEDIA_MAX_TAG_SIZE];
+	char codec[MULTIMEDIA_MAX_CODEC_SIZE];
+	uint32_t trackNumber;
+	uint32_t trackCount;
+	uint32_t discNumber;
+	uint32_t discCount;
+	uint32_t year;
+	uint32_t bitrate;				/* bits per second */
+	uint32_t channels;
+} MultiMediaMetadata;
+
+typedef void (*MultiMediaMetadata_cb)(const MultiMediaMetadata *metadata, int32_t playID);
+
+typedef struct stMultiMediaTagStatistics {
+	uint32_t received;				/* tag lists posted by the pipeline */
+	uint32_t ignored;				/* lists without an exported tag */
+	uint32_t changed;				/* lists that changed exported metadata */
+	uint32_t emitted;				/* category and metadata updates sent */
+	uint32_t deferred;				/* updates postponed by the rate limit */
+} MultiMediaTagStatistics;
+
+/*
+ * Commands are handed to the command thread through a single slot under
+ * s_cmdMutex, which the thread also keeps while it processes a command.
+ */
+typedef struct stMultiMediaCommandStatistics {
+	uint32_t posted;				/* commands written into the slot */
+	uint32_t overwritten;			/* posted over one the thread had not taken */
+	uint32_t refused;				/* busy, not playing or another playID */
+	uint32_t lockWaitMax;			/* us a caller waited for the slot */
+	uint64_t lockWaitSum;			/* us */
+} MultiMediaCommandStatistics;
+
 typedef void (*MultiMediaID3Information_cb)(MetaCategory category,const  char * info,int32_t playID);
-typedef void (*MultiMediaAlbumArt_cb)(int32_t playID, uint32_t length);
+typedef void (*MultiMediaAlbumArt_cb)(int32_t playID, uint32_t length, uint32_t slot, uint32_t generation);
 typedef void (*MultiMediaPlayCompleted_cb)(int32_t playID);
 typedef void (*MultiMediaSeekCompleted_cb)(uint8_t hour, uint8_t min, uint8_t sec,int32_t playID);
 typedef void (*MultiMediaErrorOccurred_cb)(int32_t code, int32_t playID);
@@ -72,14 +135,25 @@ typedef struct stMultiMediaEventCB {
 	MultiMediaPlayStopped_cb			MultiMediaPlayStoppedCB;
 	MultiMediaPlayTimeChange_cb			MultiMediaPlayTimeChangeCB;
 	MultiMediaTotalTimeChange_cb		MultiMediaTotalTimeChangeCB;
+	MultiMediaPositionChange_cb			MultiMediaPositionChangeCB;
 	MultiMediaID3Information_cb			MultiMediaID3InformationCB;
 	MultiMediaAlbumArt_cb				MultiMediaAlbumArtCB;
 	MultiMediaPlayCompleted_cb			MultiMediaPlayCompletedCB;
 	MultiMediaSeekCompleted_cb			MultiMediaSeekCompletedCB;
 	MultiMediaErrorOccurred_cb			MultiMediaErrorOccurredCB;
 	MultiMediaSamplerate_cb				MultiMediaSamplerateCB;
+	MultiMediaMetadata_cb				MultiMediaMetadataCB;
 } TcMultiMediaEventCB;
 
+/*
+ * The play position is queried every MultiMediaSetPositionInterval()
+ * milliseconds while playing. MultiMediaPositionChangeCB gets the position
+ * in milliseconds whenever it moved, MultiMediaPlayTimeChangeCB whenever
+ * the second changed. With an interval of 0 nothing is queried once the
+ * duration is known.
+ */
+#define MULTIMEDIA_POSITION_INTERVAL_DEFAULT	250
+
 void MultiMediaSetDebugLevel(int32_t level);
 int32_t MultiMediaInitialize(void);
 int32_t MultiMediaGetResourceStatus(void);
@@ -98,9 +172,21 @@ void MultiMediaPlayFastBackward(void);
 void MultiMediaPlayTurboFastForward(void);
 void MultiMediaPlayTurboFastBackward(void);
 int32_t MultiMediaPlaySeek(uint8_t hour, uint8_t min, uint8_t sec, int32_t id);
+/* played when the current track ends, or crossfaded into it; an empty path clears it */
+int32_t MultiMediaSetNextTrack(uint8_t content, const char *path, int32_t id);
 
 int32_t MultiMediaGetAlbumArt(uint8_t **buffer, uint32_t *length);
+/* the slot of the current image, with on request it is copied into the legacy segment on the first call */
+int32_t MultiMediaPublishAlbumArt(int32_t *playID, uint32_t *slot, uint32_t *generation);
+int32_t MultiMediaGetAlbumArtFd(int32_t *playID, uint32_t *length);
+int32_t MultiMediaGetMetadata(MultiMediaMetadata *metadata, int32_t *playID);
+void MultiMediaGetTagStatistics(MultiMediaTagStatistics *statistics);
+void MultiMediaGetCommandStatistics(MultiMediaCommandStatistics *statistics);
+void MultiMediaSetPositionInterval(uint32_t interval);
+void MultiMediaSetAlbumArtSharedMemory(int32_t enable);
+void MultiMediaSetAlbumArtSharedMemoryOnRequest(int32_t enable);
 void MultiMediaSetAudioSink(const char *audioSink,const char *device);
+void MultiMediaSetVideoSink(const char *videoSink);
 void MultiMediaSetV4LDevice(const char * device);
 void MultiMediaErrorOccurred(int32_t code, int32_t playID);
 int32_t getCurrentPlayID(void);
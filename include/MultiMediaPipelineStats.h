@@ -0,0 +1,113 @@
+/****************************************************************************************
+ *   FileName    : MultiMediaPipelineStats.h
+ *   Description : Telechips Multimedia Pipeline Statistics header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef MULTI_MEDIA_PIPELINE_STATS_H
+#define MULTI_MEDIA_PIPELINE_STATS_H
+
+#include <stdint.h>
+#include <gst/gst.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Statistics of the player pipeline, from pad probes on every element
+ * playbin adds and from the QoS, warning, buffering and clock lost messages
+ * on its bus. Bins are not listed, their children are.
+ *
+ *   filter and decoder	buffers pushed, bytes received and the time from a
+ *						buffer in to the first buffer out. buffers divided
+ *						by processSum is the throughput of a decoder.
+ *   queue				buffers held now and at most, times full and empty
+ *   audio sink			gaps in the timestamps and buffers that came after
+ *						their play time, so the ring buffer ran dry
+ *   any				late and dropped buffers from QoS, warnings
+ *
+ * Counters start from 0 with every pipeline and stay after it stopped.
+ * Detaching removes the probes, so a pipeline that plays on in the
+ * crossfade mixer no longer counts.
+ * With MultiMediaPipelineStatsSetFile() they are also written as JSON to
+ * the file every interval, replacing its content.
+ */
+#define MULTIMEDIA_ELEMENT_KIND_LIST(X) \
+	X(Filter,		"filter") \
+	X(Decoder,		"decoder") \
+	X(Queue,		"queue") \
+	X(AudioSink,	"audio_sink") \
+	X(VideoSink,	"video_sink")
+
+#define MULTIMEDIA_ELEMENT_KIND_ENUM(name, text)		MultiMediaElement##name,
+typedef enum {
+	MULTIMEDIA_ELEMENT_KIND_LIST(MULTIMEDIA_ELEMENT_KIND_ENUM)
+	TotalMultiMediaElementKinds
+} MultiMediaElementKind;
+
+#define MULTIMEDIA_PIPELINE_STATS_ELEMENTS			32
+#define MULTIMEDIA_PIPELINE_STATS_NAME				32
+#define MULTIMEDIA_PIPELINE_STATS_DEFAULT_INTERVAL	10		/* seconds */
+
+typedef struct stMultiMediaPipelineStats {
+	int32_t playID;
+	uint32_t elapsed;				/* ms the pipeline ran */
+	uint32_t elements;				/* elements added, also those beyond MULTIMEDIA_PIPELINE_STATS_ELEMENTS */
+	uint32_t warnings;
+	uint32_t clockLost;
+	uint32_t buffering;				/* times playback waited for buffering */
+} MultiMediaPipelineStats;
+
+typedef struct stMultiMediaElementStats {
+	char name[MULTIMEDIA_PIPELINE_STATS_NAME];
+	char factory[MULTIMEDIA_PIPELINE_STATS_NAME];
+	uint32_t kind;					/* MultiMediaElementKind */
+	uint32_t buffers;				/* pushed downstream, rendered by a sink */
+	uint64_t bytes;					/* received */
+	uint64_t processSum;			/* us */
+	uint32_t processMax;			/* us */
+	uint32_t level;					/* buffers in a queue */
+	uint32_t levelMax;
+	uint32_t overruns;
+	uint32_t underruns;
+	uint32_t late;					/* QoS messages */
+	uint32_t dropped;				/* buffers dropped, as the element reports in QoS */
+	uint32_t discontinuities;
+	uint32_t warnings;
+} MultiMediaElementStats;
+
+extern const char *g_multiMediaElementKindNames[TotalMultiMediaElementKinds];
+
+int32_t MultiMediaPipelineStatsSetFile(const char *path);
+int32_t MultiMediaPipelineStatsSetInterval(const char *seconds);
+void MultiMediaPipelineStatsInitialize(void);
+void MultiMediaPipelineStatsRelease(void);
+void MultiMediaPipelineStatsAttach(GstElement *pipeline, int32_t playID);
+void MultiMediaPipelineStatsDetach(void);
+void MultiMediaPipelineStatsMessage(GstMessage *msg);
+uint32_t MultiMediaPipelineStatsGet(MultiMediaPipelineStats *pipeline, MultiMediaElementStats *elements, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,140 @@
+/****************************************************************************************
+ *   FileName    : MultiMediaState.h
+ *   Description : Telechips Multimedia State Snapshot header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef MULTI_MEDIA_STATE_H
+#define MULTI_MEDIA_STATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	MultiMediaPlaybackStopped,
+	MultiMediaPlaybackPlaying,
+	MultiMediaPlaybackPaused,
+	MultiMediaPlaybackTrick,			/* fast forward or backward */
+	TotalMultiMediaPlaybackStates
+} MultiMediaPlaybackState;
+
+/* what changed, passed to MultiMediaStateChange_cb */
+#define MULTIMEDIA_STATE_RESOURCE			(1U << 0)
+#define MULTIMEDIA_STATE_PLAYID				(1U << 1)
+#define MULTIMEDIA_STATE_PLAYBACK			(1U << 2)
+#define MULTIMEDIA_STATE_DURATION			(1U << 3)
+#define MULTIMEDIA_STATE_RATE				(1U << 4)
+#define MULTIMEDIA_STATE_SEEKABLE			(1U << 5)
+#define MULTIMEDIA_STATE_CONTENT			(1U << 6)
+#define MULTIMEDIA_STATE_SAMPLERATE			(1U << 7)
+#define MULTIMEDIA_STATE_METADATA			(1U << 8)
+
+/*
+ * Copy of what the player last reported, kept up to date by the player
+ * threads and read under its own lock. Reading it never queries the
+ * pipeline or waits for a command in progress.
+ */
+typedef struct stMultiMediaState {
+	int32_t resourceStatus;
+	int32_t playID;
+	uint32_t playback;					/* MultiMediaPlaybackState */
+	uint32_t position;					/* ms, advanced by the elapsed time while playing */
+	uint32_t duration;					/* ms, 0 until known */
+	double rate;
+	bool seekable;
+	uint8_t content;					/* MultiMediaContentType */
+	int32_t samplerate;
+	bool metadataValid;
+	MultiMediaMetadata metadata;
+} MultiMediaState;
+
+/*
+ * Live status page, a MULTIMEDIA_STATUS_PAGE_SIZE memfd returned by
+ * METHOD_MEDIAPLAYBACK_GET_STATUS_PAGE. A client maps it read only once and
+ * reads the state without any IPC; the daemon rewrites it on every playback,
+ * position, duration or metadata change.
+ *
+ * The page is a seqlock. A reader
+ *
+ *   1. loads sequence (acquire) and retries if it is odd,
+ *   2. copies the fields it needs,
+ *   3. loads sequence again (after an acquire fence) and retries if it
+ *      differs from the first load.
+ *
+ * position was sampled at timestamp (CLOCK_MONOTONIC, ns). While playback is
+ * MultiMediaPlaybackPlaying or MultiMediaPlaybackTrick the current position
+ * is position + (now - timestamp) * rate, clamped to [0, duration]. A changed
+ * metadataGeneration tells the client to fetch the metadata again.
+ */
+#define MULTIMEDIA_STATUS_PAGE_MAGIC		(0x5350434DU)	/* "MCPS" */
+#define MULTIMEDIA_STATUS_PAGE_VERSION		1
+#define MULTIMEDIA_STATUS_PAGE_SIZE			4096
+
+typedef struct stMultiMediaStatusPage {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;						/* sizeof(MultiMediaStatusPage), grows with new fields */
+	volatile uint32_t sequence;
+	int32_t playID;
+	uint32_t playback;					/* MultiMediaPlaybackState */
+	int64_t position;					/* ns */
+	int64_t timestamp;					/* CLOCK_MONOTONIC ns when position was sampled */
+	double rate;
+	int64_t duration;					/* ns, 0 until known */
+	int32_t samplerate;
+	uint32_t metadataGeneration;
+	int32_t resourceStatus;
+	uint32_t seekable;
+	uint32_t content;					/* MultiMediaContentType */
+	uint32_t reserved[3];
+} MultiMediaStatusPage;
+
+/*
+ * Called from the thread that changed the state, without the state lock, with
+ * the MULTIMEDIA_STATE_* that took a new value. The position moves all the
+ * time and is never reported.
+ */
+typedef void (*MultiMediaStateChange_cb)(uint32_t changed);
+
+void MultiMediaStateSetEventCallBack(MultiMediaStateChange_cb cb);
+void MultiMediaStateRelease(void);
+
+void MultiMediaStateReset(int32_t playID, uint8_t content, int64_t startPosition);
+void MultiMediaStateSetResourceStatus(int32_t status);
+void MultiMediaStateSetPlayback(MultiMediaPlaybackState playback, double rate);
+void MultiMediaStateSetPosition(int64_t position);
+void MultiMediaStateSetDuration(int64_t duration);
+void MultiMediaStateSetSeekable(bool seekable);
+void MultiMediaStateSetSamplerate(int32_t samplerate);
+void MultiMediaStateSetMetadata(const MultiMediaMetadata *metadata);
+void MultiMediaStateGet(MultiMediaState *state);
+int32_t MultiMediaStateGetStatusPageFd(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
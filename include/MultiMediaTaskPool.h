@@ -0,0 +1,85 @@
+/****************************************************************************************
+ *   FileName    : MultiMediaTaskPool.h
+ *   Description : Telechips Multimedia Streaming Thread Pool header
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef MULTI_MEDIA_TASK_POOL_H
+#define MULTI_MEDIA_TASK_POOL_H
+
+#include <stdint.h>
+#include <gst/gst.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming threads of the player pipelines run on our own pool, installed
+ * from the STREAM_STATUS messages of the bus sync handler. A task is put in
+ * a class by the element owning it:
+ *
+ *   audio			the audio sink and the queue in front of it, also the
+ *					ring buffer thread of the sink, which is not a GstTask,
+ *					and the crossfade mixer with its output
+ *   decoder		multiqueue, demuxers, parsers and decoders
+ *   background		everything else, such as the source and typefind
+ *
+ * Every class has its scheduling policy, priority and CPUs, given as
+ * "policy[:priority][@cpus]", e.g. "fifo:60@2-3", "rr:30" or "other:5@0,1".
+ * The priority of "other" is a nice value. Without CAP_SYS_NICE the real time
+ * priority is lowered to RLIMIT_RTPRIO, or the thread stays SCHED_OTHER.
+ * Only the audio class is real time by default (fifo:60), decoder and
+ * background are "other".
+ *
+ * A task reserves its thread when it is created and holds it until it is
+ * finalized; a task created with its class full keeps the default pool.
+ * The thread then goes back to its class, so the next pipeline reuses it
+ * instead of creating a new one.
+ */
+#define MULTIMEDIA_THREAD_CLASS_LIST(X) \
+	X(Audio,		"audio") \
+	X(Decoder,		"decoder") \
+	X(Background,	"background")
+
+#define MULTIMEDIA_THREAD_CLASS_ENUM(name, text)		MultiMediaThread##name,
+typedef enum {
+	MULTIMEDIA_THREAD_CLASS_LIST(MULTIMEDIA_THREAD_CLASS_ENUM)
+	TotalMultiMediaThreadClasses
+} MultiMediaThreadClass;
+
+#define MULTIMEDIA_TASK_POOL_THREADS		8		/* per class */
+
+extern const char *g_multiMediaThreadClassNames[TotalMultiMediaThreadClasses];
+
+int32_t MultiMediaTaskPoolSetClass(MultiMediaThreadClass threadClass, const char *spec);
+void MultiMediaTaskPoolInitialize(void);
+void MultiMediaTaskPoolRelease(void);
+void MultiMediaTaskPoolStreamStatus(GstMessage *msg);
+/* puts the calling thread, one GStreamer did not create, in the class */
+void MultiMediaTaskPoolApplyClass(MultiMediaThreadClass threadClass);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
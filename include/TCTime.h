@@ -25,17 +25,63 @@ between Telechips and Company.
 #ifndef TC_TIME_H_
 #define TC_TIME_H_
 
+#include <stdint.h>
+
 typedef double float64_t;
 
-void SetTime(int32_t year, int32_t month, int32_t day, int32_t hour, int32_t minute, float64_t second);
-void SetCurrentTime(void);
-int32_t GetYear(void);
-int32_t GetMonth(void);
-int32_t GetDay(void);
-int32_t GetHour(void);
-int32_t GetMinute(void);
-float64_t GetSecond(void);
-float64_t GetSecondsUntilNow(void);
- 
-#endif
+/*
+ * Timestamps taken per call, safe from any thread. CLOCK_MONOTONIC does not
+ * jump with the wall clock; CLOCK_BOOTTIME also counts while suspended.
+ */
+int64_t TCTimeGetMonotonicNs(void);
+int64_t TCTimeGetMonotonicMs(void);
+int64_t TCTimeGetBoottimeNs(void);
+
+/*
+ * Spans measure the latency sensitive paths. A span may end on another
+ * thread than the one it began on and only its first end counts; a
+ * cancelled span is not recorded. Ended spans are kept in a ring of
+ * TCTIME_SPAN_RECORDS per thread, read with TCTimeSpanCollect(), and
+ * passed to the callback set with TCTimeSpanSetEndedCallBack(), e.g. the
+ * trace ring while it is on.
+ */
+#define TCTIME_SPAN_LIST(X) \
+	X(Method,		"method")	/* DBus method handler, playID is the method index */ \
+	X(Command,		"command")	/* player command in MediaStartThread */ \
+	X(Preroll,		"preroll")	/* play start until the pipeline prerolled */ \
+	X(Seek,			"seek")		/* seek request until the pipeline prerolled again */ \
+	X(Emit,			"emit")		/* event built and sent by the sender thread */
+
+#define TCTIME_SPAN_LIST_ENUM(name, text)		TCTimeSpan##name,
+typedef enum {
+	TCTIME_SPAN_LIST(TCTIME_SPAN_LIST_ENUM)
+	TotalTCTimeSpanNames
+} TCTimeSpanName;
+extern const char *g_tcTimeSpanNames[TotalTCTimeSpanNames];
+
+#define TCTIME_SPAN_RECORDS				64
 
+typedef struct stTCTimeSpan {
+	uint32_t name;						/* TCTimeSpanName */
+	int32_t playID;
+	int64_t begin;						/* monotonic ns, 0 if not running */
+} TCTimeSpan;
+
+typedef struct stTCTimeSpanRecord {
+	uint32_t name;						/* TCTimeSpanName */
+	int32_t playID;
+	int32_t thread;						/* that ended the span */
+	int64_t begin;						/* monotonic ns */
+	int64_t duration;					/* ns */
+} TCTimeSpanRecord;
+
+/* called on the thread that ended the span */
+typedef void (*TCTimeSpanEnded_cb)(const TCTimeSpanRecord *record);
+
+void TCTimeSpanSetEndedCallBack(TCTimeSpanEnded_cb cb);
+void TCTimeSpanBegin(TCTimeSpan *span, TCTimeSpanName name, int32_t playID);
+int64_t TCTimeSpanEnd(TCTimeSpan *span);
+void TCTimeSpanCancel(TCTimeSpan *span);
+uint32_t TCTimeSpanCollect(TCTimeSpanRecord *records, uint32_t count);
+
+#endif
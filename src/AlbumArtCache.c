@@ -0,0 +1,922 @@
+/****************************************************************************************
+ *   FileName    : AlbumArtCache.c
+ *   Description : Telechips Album Art Cache
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <gst/gst.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "TCLog.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "AlbumArtSharedMemory.h"
+#include "AlbumArtCache.h"
+
+#define XXH_PRIME64_1		(0x9E3779B185EBCA87ULL)
+#define XXH_PRIME64_2		(0xC2B2AE3D27D4EB4FULL)
+#define XXH_PRIME64_3		(0x165667B19E3779F9ULL)
+#define XXH_PRIME64_4		(0x85EBCA77C2B2AE63ULL)
+#define XXH_PRIME64_5		(0x27D4EB2F165667C5ULL)
+
+#define ALBUMART_CACHE_FILE_SUFFIX		".bin"
+
+typedef struct stCacheEntry {
+	uint64_t hash;
+	GstBuffer *buffer;
+	uint32_t length;
+	int32_t fd;						/* sealed memfd of buffer, -1 until requested */
+	GList link;						/* in s_lru, the head is the most recently used */
+} CacheEntry;
+
+typedef struct stFolderEntry {
+	time_t mtime;					/* of the directory when it was scanned */
+	char *file;						/* NULL if the directory has no cover */
+	uint64_t hash;					/* of file, 0 until read */
+} FolderEntry;
+
+typedef struct stCacheFile {
+	char *path;
+	time_t mtime;
+	uint32_t size;
+} CacheFile;
+
+static uint64_t Rotate64(uint64_t value, uint32_t bits);
+static uint64_t Read64(const uint8_t *data);
+static uint32_t Read32(const uint8_t *data);
+static uint64_t HashRound(uint64_t acc, uint64_t input);
+static uint64_t HashMergeRound(uint64_t acc, uint64_t value);
+static GstBuffer *LookupImage(uint64_t hash);
+static GstBuffer *AddImage(uint64_t hash, GstBuffer *image);
+static void TouchEntry(CacheEntry *entry);
+static void EvictEntries(void);
+static void FreeEntry(CacheEntry *entry);
+static void FreeFolderEntry(gpointer data);
+static GstBuffer *GetFolderImage(const char *trackPath, uint64_t *hash);
+static void *FolderThread(void *arg);
+static char *FindFolderImage(const char *directory);
+static GstBuffer *ReadFolderImage(const char *file, uint64_t *hash);
+static char *GetCacheFileName(uint64_t hash, const char *variant);
+static void PruneDirectory(void);
+static gint CompareCacheFiles(gconstpointer a, gconstpointer b);
+
+/* preferred first, matched case insensitively */
+static const char * const s_folderImageNames[] = {
+	"cover.jpg",
+	"folder.jpg",
+	"front.jpg",
+	"cover.png",
+	"folder.png",
+	"front.png"
+};
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static GHashTable *s_entries = NULL;		/* hash -> CacheEntry */
+static GHashTable *s_folders = NULL;		/* directory -> FolderEntry */
+static GQueue s_lru = G_QUEUE_INIT;
+static uint32_t s_budget = (uint32_t)ALBUMART_CACHE_DEFAULT_BUDGET * 1024U;
+static uint32_t s_bytes = 0;
+static char *s_directory = NULL;
+static uint64_t s_diskBytes = 0;
+static AlbumArtCacheStatistics s_statistics;
+
+/* the folder worker, only the latest request matters */
+static pthread_mutex_t s_folderMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_folderCond = PTHREAD_COND_INITIALIZER;
+static pthread_t s_folderThread;
+static bool s_folderRun = false;
+static char *s_pendingTrack = NULL;
+static int32_t s_pendingPlayID = -1;
+
+static AlbumArtCacheFolderImage_cb		AlbumArtCacheFolderImageCB = NULL;
+
+int32_t AlbumArtCacheSetBudget(const char *kilobytes)
+{
+	int32_t ret = 0;
+	char *end = NULL;
+	unsigned long value;
+
+	if (kilobytes != NULL)
+	{
+		value = strtoul(kilobytes, &end, 10);
+		/* 0 keeps only the image in use */
+		if ((end != kilobytes) && (*end == '\0') && (value <= (UINT32_MAX / 1024UL)))
+		{
+			s_budget = (uint32_t)value * 1024U;
+			ret = 1;
+		}
+	}
+
+	if (ret == 0)
+	{
+		ERROR_PRINTF("invalid album art cache size(%s)\n", (kilobytes != NULL) ? kilobytes : "null");
+	}
+
+	return ret;
+}
+
+int32_t AlbumArtCacheSetDirectory(const char *directory)
+{
+	int32_t ret = 0;
+
+	if ((directory != NULL) && (directory[0] != '\0'))
+	{
+		g_free(s_directory);
+		s_directory = g_strdup(directory);
+		ret = 1;
+	}
+	else
+	{
+		ERROR_PRINTF("invalid album art cache directory\n");
+	}
+
+	return ret;
+}
+
+int32_t AlbumArtCacheInitialize(void)
+{
+	int32_t ret = 1;
+	int32_t err;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	s_entries = g_hash_table_new(g_int64_hash, g_int64_equal);
+	s_folders = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, FreeFolderEntry);
+	(void)memset(&s_statistics, 0, sizeof(s_statistics));
+	s_bytes = 0;
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	if (s_directory != NULL)
+	{
+		if (g_mkdir_with_parents(s_directory, 0755) == 0)
+		{
+			PruneDirectory();
+		}
+		else
+		{
+			ERROR_PRINTF("album art cache directory(%s) failed: error(%d)\n", s_directory, errno);
+			g_free(s_directory);
+			s_directory = NULL;
+		}
+	}
+
+	s_folderRun = true;
+	err = pthread_create(&s_folderThread, NULL, FolderThread, NULL);
+	if (err != 0)
+	{
+		ERROR_PRINTF("pthread_create failed: error(%d), no folder covers\n", err);
+		s_folderRun = false;
+	}
+
+	INFO_PRINTF("budget(%u bytes), directory(%s)\n", s_budget, (s_directory != NULL) ? s_directory : "none");
+
+	return ret;
+}
+
+void AlbumArtCacheRelease(void)
+{
+	GList *link;
+
+	if (s_folderRun)
+	{
+		(void)pthread_mutex_lock(&s_folderMutex);
+		s_folderRun = false;
+		(void)pthread_cond_signal(&s_folderCond);
+		(void)pthread_mutex_unlock(&s_folderMutex);
+		(void)pthread_join(s_folderThread, NULL);
+
+		g_free(s_pendingTrack);
+		s_pendingTrack = NULL;
+	}
+
+	(void)pthread_mutex_lock(&s_mutex);
+	if (s_entries != NULL)
+	{
+		link = g_queue_pop_head_link(&s_lru);
+		while (link != NULL)
+		{
+			FreeEntry((CacheEntry *)link->data);
+			link = g_queue_pop_head_link(&s_lru);
+		}
+		g_hash_table_destroy(s_entries);
+		s_entries = NULL;
+		g_hash_table_destroy(s_folders);
+		s_folders = NULL;
+		s_bytes = 0;
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	g_free(s_directory);
+	s_directory = NULL;
+}
+
+uint64_t AlbumArtCacheHash(const uint8_t *data, uint32_t length)
+{
+	/* XXH64 with seed 0, words are read in host order (little endian on every target) */
+	const uint8_t *ptr = data;
+	const uint8_t *end = data + length;
+	uint64_t hash;
+
+	if (length >= 32U)
+	{
+		const uint8_t *limit = end - 32;
+		uint64_t v1 = XXH_PRIME64_1 + XXH_PRIME64_2;
+		uint64_t v2 = XXH_PRIME64_2;
+		uint64_t v3 = 0;
+		uint64_t v4 = 0ULL - XXH_PRIME64_1;
+
+		do
+		{
+			v1 = HashRound(v1, Read64(ptr));
+			v2 = HashRound(v2, Read64(ptr + 8));
+			v3 = HashRound(v3, Read64(ptr + 16));
+			v4 = HashRound(v4, Read64(ptr + 24));
+			ptr += 32;
+		} while (ptr <= limit);
+
+		hash = Rotate64(v1, 1U) + Rotate64(v2, 7U) + Rotate64(v3, 12U) + Rotate64(v4, 18U);
+		hash = HashMergeRound(hash, v1);
+		hash = HashMergeRound(hash, v2);
+		hash = HashMergeRound(hash, v3);
+		hash = HashMergeRound(hash, v4);
+	}
+	else
+	{
+		hash = XXH_PRIME64_5;
+	}
+
+	hash += (uint64_t)length;
+
+	while ((ptr + 8) <= end)
+	{
+		hash ^= HashRound(0, Read64(ptr));
+		hash = (Rotate64(hash, 27U) * XXH_PRIME64_1) + XXH_PRIME64_4;
+		ptr += 8;
+	}
+
+	if ((ptr + 4) <= end)
+	{
+		hash ^= (uint64_t)Read32(ptr) * XXH_PRIME64_1;
+		hash = (Rotate64(hash, 23U) * XXH_PRIME64_2) + XXH_PRIME64_3;
+		ptr += 4;
+	}
+
+	while (ptr < end)
+	{
+		hash ^= (uint64_t)(*ptr) * XXH_PRIME64_5;
+		hash = Rotate64(hash, 11U) * XXH_PRIME64_1;
+		ptr++;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+uint64_t AlbumArtCacheAdd(GstBuffer *image)
+{
+	uint64_t hash = 0;
+	GstBuffer *cached = NULL;
+	GstMapInfo mapInfo;
+
+	if ((image != NULL) && gst_buffer_map(image, &mapInfo, GST_MAP_READ))
+	{
+		hash = AlbumArtCacheHash(mapInfo.data, (uint32_t)mapInfo.size);
+		gst_buffer_unmap(image, &mapInfo);
+	}
+
+	if (hash != 0U)
+	{
+		(void)pthread_mutex_lock(&s_mutex);
+		if (s_entries != NULL)
+		{
+			/* the same cover of the next track keeps the entry of the first one */
+			cached = LookupImage(hash);
+			if (cached == NULL)
+			{
+				cached = AddImage(hash, image);
+			}
+		}
+		(void)pthread_mutex_unlock(&s_mutex);
+
+		if (cached != NULL)
+		{
+			gst_buffer_unref(cached);
+		}
+	}
+
+	return hash;
+}
+
+void AlbumArtCacheSetEventCallBackFunctions(TcAlbumArtCacheEventCB *cb)
+{
+	if (cb != NULL)
+	{
+		AlbumArtCacheFolderImageCB = cb->AlbumArtCacheFolderImageCB;
+	}
+}
+
+int32_t AlbumArtCacheRequestFolderImage(const char *trackPath, int32_t playID)
+{
+	int32_t ret = 0;
+
+	if (s_folderRun && (trackPath != NULL))
+	{
+		(void)pthread_mutex_lock(&s_folderMutex);
+		/* the cover of a track that was already left is not looked up */
+		g_free(s_pendingTrack);
+		s_pendingTrack = g_strdup(trackPath);
+		s_pendingPlayID = playID;
+		(void)pthread_cond_signal(&s_folderCond);
+		(void)pthread_mutex_unlock(&s_folderMutex);
+		ret = 1;
+	}
+
+	return ret;
+}
+
+static void *FolderThread(void *arg)
+{
+	char *track;
+	int32_t playID;
+	GstBuffer *image;
+	uint64_t hash;
+
+	(void)arg;
+
+	(void)pthread_mutex_lock(&s_folderMutex);
+	while (s_folderRun)
+	{
+		if (s_pendingTrack == NULL)
+		{
+			(void)pthread_cond_wait(&s_folderCond, &s_folderMutex);
+		}
+		else
+		{
+			track = s_pendingTrack;
+			playID = s_pendingPlayID;
+			s_pendingTrack = NULL;
+			(void)pthread_mutex_unlock(&s_folderMutex);
+
+			image = GetFolderImage(track, &hash);
+			if (image != NULL)
+			{
+				if (AlbumArtCacheFolderImageCB != NULL)
+				{
+					AlbumArtCacheFolderImageCB(playID, image, hash);
+				}
+				gst_buffer_unref(image);
+			}
+			g_free(track);
+
+			(void)pthread_mutex_lock(&s_folderMutex);
+		}
+	}
+	(void)pthread_mutex_unlock(&s_folderMutex);
+
+	return NULL;
+}
+
+static GstBuffer *GetFolderImage(const char *trackPath, uint64_t *hash)
+{
+	GstBuffer *image = NULL;
+	char *directory = NULL;
+	char *file = NULL;
+	bool known = false;
+	bool read = false;
+	struct stat dirStat;
+
+	*hash = 0;
+	if (trackPath != NULL)
+	{
+		directory = g_path_get_dirname(trackPath);
+	}
+
+	if ((directory != NULL) && (stat(directory, &dirStat) == 0) && S_ISDIR(dirStat.st_mode))
+	{
+		(void)pthread_mutex_lock(&s_mutex);
+		if (s_folders != NULL)
+		{
+			const FolderEntry *folder = (const FolderEntry *)g_hash_table_lookup(s_folders, directory);
+
+			/* a directory that changed since it was scanned is scanned again */
+			if ((folder != NULL) && (folder->mtime == dirStat.st_mtime))
+			{
+				known = true;
+				file = g_strdup(folder->file);
+				if (folder->hash != 0U)
+				{
+					image = LookupImage(folder->hash);
+					if (image != NULL)
+					{
+						*hash = folder->hash;
+					}
+				}
+			}
+		}
+		(void)pthread_mutex_unlock(&s_mutex);
+
+		if (known == false)
+		{
+			file = FindFolderImage(directory);
+		}
+
+		if ((image == NULL) && (file != NULL))
+		{
+			image = ReadFolderImage(file, hash);
+			read = true;
+		}
+
+		if ((known == false) || read)
+		{
+			FolderEntry *folder = g_new0(FolderEntry, 1);
+
+			folder->mtime = dirStat.st_mtime;
+			folder->file = g_strdup(file);
+			folder->hash = *hash;
+
+			(void)pthread_mutex_lock(&s_mutex);
+			if (s_folders != NULL)
+			{
+				(void)g_hash_table_replace(s_folders, g_strdup(directory), folder);
+				folder = NULL;
+			}
+			(void)pthread_mutex_unlock(&s_mutex);
+
+			if (folder != NULL)
+			{
+				FreeFolderEntry(folder);
+			}
+		}
+	}
+
+	g_free(file);
+	g_free(directory);
+
+	return image;
+}
+
+int32_t AlbumArtCacheGetFd(uint64_t hash)
+{
+	int32_t fd = -1;
+	CacheEntry *entry = NULL;
+	GstMapInfo mapInfo;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	if ((s_entries != NULL) && (hash != 0U))
+	{
+		entry = (CacheEntry *)g_hash_table_lookup(s_entries, &hash);
+	}
+
+	if (entry != NULL)
+	{
+		/* sealed once per image, every track with this cover shares it */
+		if ((entry->fd < 0) && gst_buffer_map(entry->buffer, &mapInfo, GST_MAP_READ))
+		{
+			entry->fd = AlbumArtSharedMemoryCreateFd(mapInfo.data, (uint32_t)mapInfo.size);
+			gst_buffer_unmap(entry->buffer, &mapInfo);
+		}
+
+		if (entry->fd >= 0)
+		{
+			fd = dup(entry->fd);
+		}
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return fd;
+}
+
+int32_t AlbumArtCacheLoadFile(uint64_t hash, const char *variant, uint8_t *data, uint32_t size)
+{
+	int32_t ret = -1;
+	char *name = GetCacheFileName(hash, variant);
+	struct stat fileStat;
+	uint32_t done = 0;
+	ssize_t result;
+	int32_t fd;
+
+	if (name != NULL)
+	{
+		fd = open(name, O_RDONLY | O_CLOEXEC);
+		if (fd >= 0)
+		{
+			/* a file of another size was written by another configuration */
+			if ((fstat(fd, &fileStat) == 0) && (fileStat.st_size == (off_t)size))
+			{
+				while (done < size)
+				{
+					result = read(fd, data + done, (size_t)(size - done));
+					if (result > 0)
+					{
+						done += (uint32_t)result;
+					}
+					else if ((result < 0) && (errno == EINTR))
+					{
+						;
+					}
+					else
+					{
+						break;
+					}
+				}
+
+				if (done == size)
+				{
+					/* pruning drops the least recently used files first */
+					(void)futimens(fd, NULL);
+					ret = 0;
+				}
+			}
+			(void)close(fd);
+		}
+
+		(void)pthread_mutex_lock(&s_mutex);
+		if (ret == 0)
+		{
+			s_statistics.diskHits++;
+		}
+		else
+		{
+			s_statistics.diskMisses++;
+		}
+		(void)pthread_mutex_unlock(&s_mutex);
+
+		g_free(name);
+	}
+
+	return ret;
+}
+
+void AlbumArtCacheStoreFile(uint64_t hash, const char *variant, const uint8_t *data, uint32_t size)
+{
+	char *name = GetCacheFileName(hash, variant);
+	GError *error = NULL;
+	bool prune = false;
+
+	if (name != NULL)
+	{
+		/* written to a temporary file and renamed, a reader never sees a partial file */
+		if (g_file_set_contents(name, (const gchar *)data, (gssize)size, &error))
+		{
+			(void)pthread_mutex_lock(&s_mutex);
+			s_diskBytes += (uint64_t)size;
+			prune = (s_diskBytes > ((uint64_t)ALBUMART_CACHE_DEFAULT_DISK_BUDGET * 1024U));
+			(void)pthread_mutex_unlock(&s_mutex);
+		}
+		else
+		{
+			ERROR_PRINTF("write %s failed: %s\n", name, (error != NULL) ? error->message : "unknown");
+			if (error != NULL)
+			{
+				g_error_free(error);
+			}
+		}
+		g_free(name);
+	}
+
+	if (prune)
+	{
+		PruneDirectory();
+	}
+}
+
+void AlbumArtCacheGetStatistics(AlbumArtCacheStatistics *statistics)
+{
+	(void)pthread_mutex_lock(&s_mutex);
+	(void)memcpy(statistics, &s_statistics, sizeof(AlbumArtCacheStatistics));
+	statistics->entries = (s_entries != NULL) ? g_hash_table_size(s_entries) : 0U;
+	statistics->bytes = s_bytes;
+	statistics->budget = s_budget;
+	(void)pthread_mutex_unlock(&s_mutex);
+}
+
+static uint64_t Rotate64(uint64_t value, uint32_t bits)
+{
+	return (value << bits) | (value >> (64U - bits));
+}
+
+static uint64_t Read64(const uint8_t *data)
+{
+	uint64_t value;
+	(void)memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static uint32_t Read32(const uint8_t *data)
+{
+	uint32_t value;
+	(void)memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static uint64_t HashRound(uint64_t acc, uint64_t input)
+{
+	acc += input * XXH_PRIME64_2;
+	acc = Rotate64(acc, 31U);
+	return acc * XXH_PRIME64_1;
+}
+
+static uint64_t HashMergeRound(uint64_t acc, uint64_t value)
+{
+	acc ^= HashRound(0, value);
+	return (acc * XXH_PRIME64_1) + XXH_PRIME64_4;
+}
+
+static GstBuffer *LookupImage(uint64_t hash)
+{
+	GstBuffer *image = NULL;
+	CacheEntry *entry;
+
+	/* called with s_mutex held */
+	entry = (CacheEntry *)g_hash_table_lookup(s_entries, &hash);
+	if (entry != NULL)
+	{
+		TouchEntry(entry);
+		s_statistics.hits++;
+		image = gst_buffer_ref(entry->buffer);
+	}
+
+	return image;
+}
+
+static GstBuffer *AddImage(uint64_t hash, GstBuffer *image)
+{
+	CacheEntry *entry = g_new0(CacheEntry, 1);
+
+	/* called with s_mutex held, the buffer is shared, not copied */
+	entry->hash = hash;
+	entry->buffer = gst_buffer_ref(image);
+	entry->length = (uint32_t)gst_buffer_get_size(image);
+	entry->fd = -1;
+	entry->link.data = entry;
+
+	g_queue_push_head_link(&s_lru, &entry->link);
+	g_hash_table_insert(s_entries, &entry->hash, entry);
+	s_bytes += entry->length;
+	s_statistics.misses++;
+
+	EvictEntries();
+
+	return gst_buffer_ref(image);
+}
+
+static void TouchEntry(CacheEntry *entry)
+{
+	g_queue_unlink(&s_lru, &entry->link);
+	g_queue_push_head_link(&s_lru, &entry->link);
+}
+
+static void EvictEntries(void)
+{
+	CacheEntry *entry;
+
+	/* the image just added stays even if it alone exceeds the budget */
+	while ((s_bytes > s_budget) && (s_lru.length > 1U))
+	{
+		entry = (CacheEntry *)g_queue_peek_tail_link(&s_lru)->data;
+		g_queue_unlink(&s_lru, &entry->link);
+		(void)g_hash_table_remove(s_entries, &entry->hash);
+		s_bytes -= entry->length;
+		s_statistics.evictions++;
+		DEBUG_PRINTF("evict(%016" G_GINT64_MODIFIER "x), %u bytes\n", entry->hash, entry->length);
+		FreeEntry(entry);
+	}
+}
+
+static void FreeEntry(CacheEntry *entry)
+{
+	gst_buffer_unref(entry->buffer);
+	if (entry->fd >= 0)
+	{
+		(void)close(entry->fd);
+	}
+	g_free(entry);
+}
+
+static void FreeFolderEntry(gpointer data)
+{
+	FolderEntry *folder = (FolderEntry *)data;
+
+	g_free(folder->file);
+	g_free(folder);
+}
+
+static char *FindFolderImage(const char *directory)
+{
+	char *file = NULL;
+	char *found = NULL;
+	uint32_t best = (uint32_t)(sizeof(s_folderImageNames) / sizeof(s_folderImageNames[0]));
+	uint32_t idx;
+	DIR *dir;
+	struct dirent *item;
+
+	dir = opendir(directory);
+	if (dir != NULL)
+	{
+		item = readdir(dir);
+		while ((item != NULL) && (best > 0U))
+		{
+			for (idx = 0; idx < best; idx++)
+			{
+				if (strcasecmp(item->d_name, s_folderImageNames[idx]) == 0)
+				{
+					g_free(found);
+					found = g_strdup(item->d_name);
+					best = idx;
+				}
+			}
+			item = readdir(dir);
+		}
+		(void)closedir(dir);
+	}
+
+	if (found != NULL)
+	{
+		file = g_build_filename(directory, found, NULL);
+		g_free(found);
+	}
+
+	return file;
+}
+
+static GstBuffer *ReadFolderImage(const char *file, uint64_t *hash)
+{
+	GstBuffer *image = NULL;
+	GstBuffer *buffer;
+	gchar *contents = NULL;
+	gsize length = 0;
+	struct stat fileStat;
+
+	if ((stat(file, &fileStat) == 0) && (fileStat.st_size > 0) &&
+		(fileStat.st_size <= (off_t)ALBUMART_CACHE_MAX_FOLDER_IMAGE) &&
+		g_file_get_contents(file, &contents, &length, NULL))
+	{
+		buffer = gst_buffer_new_wrapped(contents, length);
+		*hash = AlbumArtCacheHash((const uint8_t *)contents, (uint32_t)length);
+
+		(void)pthread_mutex_lock(&s_mutex);
+		if (s_entries != NULL)
+		{
+			image = LookupImage(*hash);
+			if (image == NULL)
+			{
+				image = AddImage(*hash, buffer);
+			}
+			s_statistics.folderImages++;
+		}
+		(void)pthread_mutex_unlock(&s_mutex);
+
+		gst_buffer_unref(buffer);
+		DEBUG_PRINTF("folder image(%s), %u bytes\n", file, (uint32_t)length);
+	}
+	else
+	{
+		WARN_PRINTF("folder image(%s) is not readable or too large\n", file);
+	}
+
+	if (image == NULL)
+	{
+		*hash = 0;
+	}
+
+	return image;
+}
+
+static char *GetCacheFileName(uint64_t hash, const char *variant)
+{
+	char *name = NULL;
+
+	if ((s_directory != NULL) && (hash != 0U) && (variant != NULL))
+	{
+		name = g_strdup_printf("%s/%016" G_GINT64_MODIFIER "x-%s" ALBUMART_CACHE_FILE_SUFFIX,
+								s_directory, hash, variant);
+	}
+
+	return name;
+}
+
+static void PruneDirectory(void)
+{
+	GPtrArray *files = g_ptr_array_new();
+	uint64_t total = 0;
+	uint64_t limit = ((uint64_t)ALBUMART_CACHE_DEFAULT_DISK_BUDGET * 1024U) / 2U;
+	uint32_t idx;
+	DIR *dir;
+	struct dirent *item;
+	struct stat fileStat;
+
+	dir = opendir(s_directory);
+	if (dir != NULL)
+	{
+		item = readdir(dir);
+		while (item != NULL)
+		{
+			if (g_str_has_suffix(item->d_name, ALBUMART_CACHE_FILE_SUFFIX))
+			{
+				CacheFile *file = g_new0(CacheFile, 1);
+
+				file->path = g_build_filename(s_directory, item->d_name, NULL);
+				if (stat(file->path, &fileStat) == 0)
+				{
+					file->mtime = fileStat.st_mtime;
+					file->size = (uint32_t)fileStat.st_size;
+					total += file->size;
+					g_ptr_array_add(files, file);
+				}
+				else
+				{
+					g_free(file->path);
+					g_free(file);
+				}
+			}
+			item = readdir(dir);
+		}
+		(void)closedir(dir);
+	}
+
+	/* over the budget, the least recently used files go until half of it is left */
+	if (total > (limit * 2U))
+	{
+		g_ptr_array_sort(files, CompareCacheFiles);
+		for (idx = 0; (idx < files->len) && (total > limit); idx++)
+		{
+			CacheFile *file = (CacheFile *)g_ptr_array_index(files, idx);
+
+			if (unlink(file->path) == 0)
+			{
+				total -= file->size;
+			}
+		}
+		INFO_PRINTF("pruned album art cache to %u bytes\n", (uint32_t)total);
+	}
+
+	for (idx = 0; idx < files->len; idx++)
+	{
+		CacheFile *file = (CacheFile *)g_ptr_array_index(files, idx);
+
+		g_free(file->path);
+		g_free(file);
+	}
+	(void)g_ptr_array_free(files, TRUE);
+
+	(void)pthread_mutex_lock(&s_mutex);
+	s_diskBytes = total;
+	(void)pthread_mutex_unlock(&s_mutex);
+}
+
+static gint CompareCacheFiles(gconstpointer a, gconstpointer b)
+{
+	const CacheFile *fileA = *(const CacheFile * const *)a;
+	const CacheFile *fileB = *(const CacheFile * const *)b;
+	gint ret = 0;
+
+	if (fileA->mtime < fileB->mtime)
+	{
+		ret = -1;
+	}
+	else if (fileA->mtime > fileB->mtime)
+	{
+		ret = 1;
+	}
+	else
+	{
+		;
+	}
+
+	return ret;
+}
@@ -0,0 +1,337 @@
+/****************************************************************************************
+ *   FileName    : AlbumArtScaler.c
+ *   Description : Telechips Album Art Scaler
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include "AlbumArtScaler.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define ALBUM_ART_SCALER_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define ALBUM_ART_SCALER_NEON
+#endif
+
+/*
+ * The source is reduced with a box filter: every destination pixel is the
+ * average of the source rectangle it covers. Source rows of one destination
+ * row are summed into a per channel accumulator first (vertical pass), then
+ * adjacent accumulator pixels are summed and normalized (horizontal pass).
+ * Both passes keep the four RGBA channels in the lanes of one vector.
+ */
+
+static void AccumulateRow(uint32_t *acc, const uint8_t *row, uint32_t bytes);
+static void ReduceRow(const uint32_t *acc, uint32_t srcWidth, uint8_t *out, uint32_t dstWidth, uint32_t rows);
+static void ConvertRow(const uint8_t *rgba, uint8_t *dst, uint32_t count, AlbumArtFormat format);
+static void ConvertRowARGB8888(const uint8_t *rgba, uint8_t *dst, uint32_t count);
+static void ConvertRowRGB565(const uint8_t *rgba, uint8_t *dst, uint32_t count);
+
+uint32_t AlbumArtGetBytesPerPixel(AlbumArtFormat format)
+{
+	uint32_t bpp;
+
+	if (format == AlbumArtFormatRGB565)
+	{
+		bpp = 2;
+	}
+	else
+	{
+		bpp = 4;
+	}
+
+	return bpp;
+}
+
+void AlbumArtFitSize(uint32_t srcWidth, uint32_t srcHeight, uint32_t maxWidth, uint32_t maxHeight,
+					uint32_t *width, uint32_t *height)
+{
+	uint32_t w = srcWidth;
+	uint32_t h = srcHeight;
+
+	/* keep the aspect ratio and never upscale */
+	if ((srcWidth > maxWidth) || (srcHeight > maxHeight))
+	{
+		if (((uint64_t)srcWidth * maxHeight) > ((uint64_t)srcHeight * maxWidth))
+		{
+			w = maxWidth;
+			h = (uint32_t)(((uint64_t)srcHeight * maxWidth) / srcWidth);
+		}
+		else
+		{
+			w = (uint32_t)(((uint64_t)srcWidth * maxHeight) / srcHeight);
+			h = maxHeight;
+		}
+	}
+
+	*width = (w > (uint32_t)0) ? w : (uint32_t)1;
+	*height = (h > (uint32_t)0) ? h : (uint32_t)1;
+}
+
+uint32_t AlbumArtGetWorkSize(uint32_t srcWidth, uint32_t dstWidth)
+{
+	return (srcWidth * 4U * (uint32_t)sizeof(uint32_t)) + (dstWidth * 4U);
+}
+
+void AlbumArtScale(const uint8_t *src, uint32_t srcWidth, uint32_t srcHeight, uint32_t srcStride,
+					uint8_t *dst, uint32_t dstWidth, uint32_t dstHeight, uint32_t dstStride,
+					AlbumArtFormat format, void *work)
+{
+	uint32_t *acc = (uint32_t *)work;
+	uint8_t *rgba = (uint8_t *)work + (srcWidth * 4U * (uint32_t)sizeof(uint32_t));
+	uint32_t y;
+
+	for (y = 0; y < dstHeight; y++)
+	{
+		uint32_t y0 = (uint32_t)(((uint64_t)y * srcHeight) / dstHeight);
+		uint32_t y1 = (uint32_t)(((uint64_t)(y + 1U) * srcHeight) / dstHeight);
+		uint32_t sy;
+
+		if (y1 <= y0)
+		{
+			y1 = y0 + 1U;
+		}
+
+		(void)memset(acc, 0, (size_t)srcWidth * 4U * sizeof(uint32_t));
+		for (sy = y0; sy < y1; sy++)
+		{
+			AccumulateRow(acc, src + ((size_t)sy * srcStride), srcWidth * 4U);
+		}
+
+		ReduceRow(acc, srcWidth, rgba, dstWidth, y1 - y0);
+		ConvertRow(rgba, dst + ((size_t)y * dstStride), dstWidth, format);
+	}
+}
+
+static void AccumulateRow(uint32_t *acc, const uint8_t *row, uint32_t bytes)
+{
+	uint32_t i = 0;
+
+#if defined(ALBUM_ART_SCALER_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; (i + 16U) <= bytes; i += 16U)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(row + i));
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		__m128i *a = (__m128i *)(acc + i);
+
+		_mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_unpacklo_epi16(lo, zero)));
+		_mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi16(lo, zero)));
+		_mm_storeu_si128(a + 2, _mm_add_epi32(_mm_loadu_si128(a + 2), _mm_unpacklo_epi16(hi, zero)));
+		_mm_storeu_si128(a + 3, _mm_add_epi32(_mm_loadu_si128(a + 3), _mm_unpackhi_epi16(hi, zero)));
+	}
+#elif defined(ALBUM_ART_SCALER_NEON)
+	for (; (i + 16U) <= bytes; i += 16U)
+	{
+		uint8x16_t v = vld1q_u8(row + i);
+		uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+		uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+
+		vst1q_u32(acc + i, vaddw_u16(vld1q_u32(acc + i), vget_low_u16(lo)));
+		vst1q_u32(acc + i + 4, vaddw_u16(vld1q_u32(acc + i + 4), vget_high_u16(lo)));
+		vst1q_u32(acc + i + 8, vaddw_u16(vld1q_u32(acc + i + 8), vget_low_u16(hi)));
+		vst1q_u32(acc + i + 12, vaddw_u16(vld1q_u32(acc + i + 12), vget_high_u16(hi)));
+	}
+#endif
+
+	for (; i < bytes; i++)
+	{
+		acc[i] += row[i];
+	}
+}
+
+static void ReduceRow(const uint32_t *acc, uint32_t srcWidth, uint8_t *out, uint32_t dstWidth, uint32_t rows)
+{
+	uint32_t x;
+
+	for (x = 0; x < dstWidth; x++)
+	{
+		uint32_t x0 = (uint32_t)(((uint64_t)x * srcWidth) / dstWidth);
+		uint32_t x1 = (uint32_t)(((uint64_t)(x + 1U) * srcWidth) / dstWidth);
+		float scale;
+		uint32_t p;
+
+		if (x1 <= x0)
+		{
+			x1 = x0 + 1U;
+		}
+		scale = 1.0f / (float)((x1 - x0) * rows);
+
+#if defined(ALBUM_ART_SCALER_SSE2)
+		{
+			__m128i sum = _mm_setzero_si128();
+			__m128i v;
+			uint32_t pixel;
+
+			for (p = x0; p < x1; p++)
+			{
+				sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i *)(acc + (p * 4U))));
+			}
+			v = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps(scale)));
+			v = _mm_packs_epi32(v, v);
+			v = _mm_packus_epi16(v, v);
+			pixel = (uint32_t)_mm_cvtsi128_si32(v);
+			(void)memcpy(out + (x * 4U), &pixel, sizeof(pixel));
+		}
+#elif defined(ALBUM_ART_SCALER_NEON)
+		{
+			uint32x4_t sum = vdupq_n_u32(0);
+			uint32x4_t v;
+			uint16x4_t n;
+
+			for (p = x0; p < x1; p++)
+			{
+				sum = vaddq_u32(sum, vld1q_u32(acc + (p * 4U)));
+			}
+			v = vcvtq_u32_f32(vmlaq_n_f32(vdupq_n_f32(0.5f), vcvtq_f32_u32(sum), scale));
+			n = vqmovn_u32(v);
+			vst1_lane_u32((uint32_t *)(void *)(out + (x * 4U)),
+						vreinterpret_u32_u8(vqmovn_u16(vcombine_u16(n, n))), 0);
+		}
+#else
+		{
+			uint32_t sum[4] = {0, 0, 0, 0};
+			uint32_t c;
+
+			for (p = x0; p < x1; p++)
+			{
+				for (c = 0; c < 4U; c++)
+				{
+					sum[c] += acc[(p * 4U) + c];
+				}
+			}
+			for (c = 0; c < 4U; c++)
+			{
+				out[(x * 4U) + c] = (uint8_t)(((float)sum[c] * scale) + 0.5f);
+			}
+		}
+#endif
+	}
+}
+
+static void ConvertRow(const uint8_t *rgba, uint8_t *dst, uint32_t count, AlbumArtFormat format)
+{
+	if (format == AlbumArtFormatRGB565)
+	{
+		ConvertRowRGB565(rgba, dst, count);
+	}
+	else
+	{
+		ConvertRowARGB8888(rgba, dst, count);
+	}
+}
+
+static void ConvertRowARGB8888(const uint8_t *rgba, uint8_t *dst, uint32_t count)
+{
+	uint32_t i = 0;
+
+#if defined(ALBUM_ART_SCALER_SSE2)
+	/* little endian: the loaded word is 0xAABBGGRR, swap R and B */
+	const __m128i maskAG = _mm_set1_epi32((int32_t)0xFF00FF00U);
+	const __m128i maskLow = _mm_set1_epi32(0xFF);
+
+	for (; (i + 4U) <= count; i += 4U)
+	{
+		__m128i p = _mm_loadu_si128((const __m128i *)(rgba + (i * 4U)));
+		__m128i ag = _mm_and_si128(p, maskAG);
+		__m128i r = _mm_slli_epi32(_mm_and_si128(p, maskLow), 16);
+		__m128i b = _mm_and_si128(_mm_srli_epi32(p, 16), maskLow);
+
+		_mm_storeu_si128((__m128i *)(dst + (i * 4U)), _mm_or_si128(ag, _mm_or_si128(r, b)));
+	}
+#elif defined(ALBUM_ART_SCALER_NEON)
+	for (; (i + 16U) <= count; i += 16U)
+	{
+		uint8x16x4_t p = vld4q_u8(rgba + (i * 4U));
+		uint8x16x4_t o;
+
+		o.val[0] = p.val[2];
+		o.val[1] = p.val[1];
+		o.val[2] = p.val[0];
+		o.val[3] = p.val[3];
+		vst4q_u8(dst + (i * 4U), o);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const uint8_t *s = rgba + (i * 4U);
+		uint32_t pixel = ((uint32_t)s[3] << 24) | ((uint32_t)s[0] << 16) | ((uint32_t)s[1] << 8) | (uint32_t)s[2];
+
+		(void)memcpy(dst + (i * 4U), &pixel, sizeof(pixel));
+	}
+}
+
+static void ConvertRowRGB565(const uint8_t *rgba, uint8_t *dst, uint32_t count)
+{
+	uint32_t i = 0;
+
+#if defined(ALBUM_ART_SCALER_SSE2)
+	const __m128i maskR = _mm_set1_epi32(0xF8);
+	const __m128i maskG = _mm_set1_epi32(0xFC);
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16((int16_t)0x8000);
+	__m128i v[2];
+	uint32_t k;
+
+	for (; (i + 8U) <= count; i += 8U)
+	{
+		for (k = 0; k < 2U; k++)
+		{
+			__m128i p = _mm_loadu_si128((const __m128i *)(rgba + ((i + (k * 4U)) * 4U)));
+			__m128i r = _mm_slli_epi32(_mm_and_si128(p, maskR), 8);
+			__m128i g = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(p, 8), maskG), 3);
+			__m128i b = _mm_srli_epi32(_mm_and_si128(_mm_srli_epi32(p, 16), maskR), 3);
+
+			/* bias into the signed range so packs does not saturate */
+			v[k] = _mm_sub_epi32(_mm_or_si128(r, _mm_or_si128(g, b)), bias32);
+		}
+		_mm_storeu_si128((__m128i *)(dst + (i * 2U)), _mm_xor_si128(_mm_packs_epi32(v[0], v[1]), bias16));
+	}
+#elif defined(ALBUM_ART_SCALER_NEON)
+	for (; (i + 16U) <= count; i += 16U)
+	{
+		uint8x16x4_t p = vld4q_u8(rgba + (i * 4U));
+		uint16x8_t lo = vshll_n_u8(vget_low_u8(p.val[0]), 8);
+		uint16x8_t hi = vshll_n_u8(vget_high_u8(p.val[0]), 8);
+
+		lo = vsriq_n_u16(lo, vshll_n_u8(vget_low_u8(p.val[1]), 8), 5);
+		lo = vsriq_n_u16(lo, vshll_n_u8(vget_low_u8(p.val[2]), 8), 11);
+		hi = vsriq_n_u16(hi, vshll_n_u8(vget_high_u8(p.val[1]), 8), 5);
+		hi = vsriq_n_u16(hi, vshll_n_u8(vget_high_u8(p.val[2]), 8), 11);
+		vst1q_u16((uint16_t *)(void *)(dst + (i * 2U)), lo);
+		vst1q_u16((uint16_t *)(void *)(dst + (i * 2U) + 16U), hi);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const uint8_t *s = rgba + (i * 4U);
+		uint16_t pixel = (uint16_t)((((uint32_t)s[0] & 0xF8U) << 8) | (((uint32_t)s[1] & 0xFCU) << 3) | ((uint32_t)s[2] >> 3));
+
+		(void)memcpy(dst + (i * 2U), &pixel, sizeof(pixel));
+	}
+}
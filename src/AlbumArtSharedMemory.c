@@ -0,0 +1,330 @@
+/****************************************************************************************
+ *   FileName    : AlbumArtSharedMemory.c
+ *   Description : Telechips Album Art Shared Memory
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		/* memfd_create, F_ADD_SEALS */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "TCLog.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "AlbumArtSharedMemory.h"
+
+#define ALBUMART_SHM_HEADER_SIZE		64U
+#define ALBUMART_MEMFD_SEALS			(F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL)
+
+static int32_t AttachSharedMemory(void);
+static AlbumArtShmSlot *GetSlot(uint32_t slot);
+static uint32_t SelectSlot(int32_t playID);
+static AlbumArtImageFormat GetImageFormat(const uint8_t *data, uint32_t length);
+
+static int32_t s_shm_id = -1;
+static uint8_t *s_shm_addr = NULL;
+static uint32_t s_slotSize = 0;
+static uint32_t s_slotCount = ALBUMART_SHM_DEFAULT_SLOTS;
+static uint32_t s_generation = 0;
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int32_t AlbumArtSharedMemorySetSlots(const char *count)
+{
+	int32_t ret = 0;
+	char *end = NULL;
+	unsigned long value;
+
+	if (count != NULL)
+	{
+		value = strtoul(count, &end, 10);
+		if ((end != count) && (*end == '\0') && (value >= 1UL) && (value <= (unsigned long)ALBUMART_SHM_MAX_SLOTS))
+		{
+			s_slotCount = (uint32_t)value;
+			ret = 1;
+		}
+	}
+
+	if (ret == 0)
+	{
+		ERROR_PRINTF("invalid album art slots(%s), 1 to %d\n", (count != NULL) ? count : "null", ALBUMART_SHM_MAX_SLOTS);
+	}
+
+	return ret;
+}
+
+int32_t AlbumArtSharedMemoryInitialize(void)
+{
+	int32_t ret = 0;
+
+	/* the segment is created by the first published image */
+	(void)pthread_mutex_lock(&s_mutex);
+	s_generation = 0;
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return ret;
+}
+
+static int32_t AttachSharedMemory(void)
+{
+	int32_t ret = 0;
+	int32_t shm_id;
+	void *shm_addr;
+	AlbumArtShmHeader *header;
+	uint32_t idx;
+
+	shm_id = shmget((key_t)KEY_NUM, (size_t)MEM_SIZE, 0666 |IPC_CREAT);
+
+	if(shm_id == -1)
+	{
+		ERROR_PRINTF("shmget failed\n");
+		ret = -1;
+	}
+	else
+	{
+		s_shm_id = shm_id;
+		shm_addr = shmat(shm_id, (void *)0, 0);
+		if(shm_addr == (void *)-1)
+		{
+			ERROR_PRINTF("shmat failed\n");
+			ret = -1;
+		}
+		else
+		{
+			s_shm_addr = (uint8_t *)shm_addr;
+			/* keep slots cache line aligned */
+			s_slotSize = (((uint32_t)MEM_SIZE - ALBUMART_SHM_HEADER_SIZE) / s_slotCount) & ~63U;
+
+			/* clear the headers only, image pages are not touched until used */
+			(void)memset(s_shm_addr, 0, (size_t)ALBUMART_SHM_HEADER_SIZE);
+			for (idx = 0; idx < s_slotCount; idx++)
+			{
+				(void)memset(GetSlot(idx), 0, sizeof(AlbumArtShmSlot));
+			}
+			header = (AlbumArtShmHeader *)shm_addr;
+			header->magic = ALBUMART_SHM_MAGIC;
+			header->version = ALBUMART_SHM_VERSION;
+			header->headerSize = ALBUMART_SHM_HEADER_SIZE;
+			header->slotCount = s_slotCount;
+			header->slotSize = s_slotSize;
+		}
+	}
+	return ret;
+}
+
+int32_t AlbumArtSharedMemoryRelease(void)
+{
+	int32_t ret = 0;
+	int32_t shm_dt, shm_ctl;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	if (s_shm_addr != NULL)
+	{
+		shm_dt = shmdt(s_shm_addr);
+		if(shm_dt == -1)
+		{
+			ERROR_PRINTF("failed distribute shared memory\n");
+			ret = -1;
+		}
+		else
+		{
+			shm_ctl = shmctl(s_shm_id, IPC_RMID, 0);
+			if(shm_ctl == -1)
+			{
+				ERROR_PRINTF("failed remove shared momory \n");
+				ret = -1;
+			}
+			else
+			{
+				s_shm_id = -1;
+				s_shm_addr = NULL;
+			}
+		}
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+	return ret;
+}
+
+int32_t AlbumArtSharedMemoryPublish(int32_t playID, const uint8_t *data, uint32_t length,
+									uint32_t *slot, uint32_t *generation)
+{
+	int32_t ret = -1;
+	AlbumArtShmHeader *header;
+	AlbumArtShmSlot *target;
+	uint32_t index;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	if ((s_shm_addr == NULL) && (AttachSharedMemory() != 0))
+	{
+		ERROR_PRINTF("shared memory is not attached\n");
+	}
+	else if ((data == NULL) || (length == 0U) || (length > (s_slotSize - (uint32_t)sizeof(AlbumArtShmSlot))))
+	{
+		WARN_PRINTF("album art(%u bytes) does not fit in a slot(%u bytes)\n",
+					length, s_slotSize - (uint32_t)sizeof(AlbumArtShmSlot));
+	}
+	else
+	{
+		header = (AlbumArtShmHeader *)(void *)s_shm_addr;
+		index = SelectSlot(playID);
+		target = GetSlot(index);
+		s_generation++;
+
+		/* odd sequence: readers discard what they copy until it is even again */
+		__atomic_store_n(&target->sequence, target->sequence + 1U, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		(void)memcpy((uint8_t *)target + sizeof(AlbumArtShmSlot), data, length);
+		target->generation = s_generation;
+		target->playID = playID;
+		target->length = length;
+		target->format = (uint32_t)GetImageFormat(data, length);
+
+		__atomic_store_n(&target->sequence, target->sequence + 1U, __ATOMIC_RELEASE);
+		__atomic_store_n(&header->latestSlot, index, __ATOMIC_RELEASE);
+
+		*slot = index;
+		*generation = s_generation;
+
+		DEBUG_PRINTF("slot(%u), generation(%u), playID(%d), length(%u)\n", index, *generation, playID, length);
+		ret = 0;
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return ret;
+}
+
+int32_t AlbumArtSharedMemoryCreateFd(const uint8_t *data, uint32_t length)
+{
+	int32_t fd;
+	uint32_t written = 0;
+	ssize_t result;
+
+	/* sized exactly to the image and sealed, so a client can mmap it read only and trust its size */
+	fd = memfd_create("albumart", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd >= 0)
+	{
+		while (written < length)
+		{
+			result = write(fd, data + written, (size_t)(length - written));
+			if (result > 0)
+			{
+				written += (uint32_t)result;
+			}
+			else if ((result < 0) && (errno == EINTR))
+			{
+				;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if ((written != length) || (fcntl(fd, F_ADD_SEALS, ALBUMART_MEMFD_SEALS) != 0))
+		{
+			ERROR_PRINTF("memfd write/seal failed: error(%d)\n", errno);
+			(void)close(fd);
+			fd = -1;
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("memfd_create failed: error(%d)\n", errno);
+	}
+
+	return fd;
+}
+
+static AlbumArtShmSlot *GetSlot(uint32_t slot)
+{
+	return (AlbumArtShmSlot *)(void *)(s_shm_addr + ALBUMART_SHM_HEADER_SIZE + ((size_t)slot * s_slotSize));
+}
+
+static uint32_t SelectSlot(int32_t playID)
+{
+	uint32_t selected = 0;
+	uint32_t oldest = UINT32_MAX;
+	uint32_t idx;
+	bool found = false;
+
+	/* art of the same track replaces itself, otherwise the oldest slot is reused */
+	for (idx = 0; (idx < s_slotCount) && (found == false); idx++)
+	{
+		const AlbumArtShmSlot *candidate = GetSlot(idx);
+
+		if ((candidate->generation != 0U) && (candidate->playID == playID))
+		{
+			selected = idx;
+			found = true;
+		}
+		else if (candidate->generation < oldest)
+		{
+			selected = idx;
+			oldest = candidate->generation;
+		}
+		else
+		{
+			;
+		}
+	}
+
+	return selected;
+}
+
+static AlbumArtImageFormat GetImageFormat(const uint8_t *data, uint32_t length)
+{
+	AlbumArtImageFormat format = AlbumArtImageUnknown;
+
+	if ((length >= 3U) && (data[0] == 0xFFU) && (data[1] == 0xD8U) && (data[2] == 0xFFU))
+	{
+		format = AlbumArtImageJPEG;
+	}
+	else if ((length >= 8U) && (memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0))
+	{
+		format = AlbumArtImagePNG;
+	}
+	else if ((length >= 4U) && (memcmp(data, "GIF8", 4) == 0))
+	{
+		format = AlbumArtImageGIF;
+	}
+	else if ((length >= 2U) && (data[0] == (uint8_t)'B') && (data[1] == (uint8_t)'M'))
+	{
+		format = AlbumArtImageBMP;
+	}
+	else
+	{
+		;
+	}
+
+	return format;
+}
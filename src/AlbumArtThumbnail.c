@@ -0,0 +1,649 @@
+/****************************************************************************************
+ *   FileName    : AlbumArtThumbnail.c
+ *   Description : Telechips Album Art Thumbnail
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <gst/gst.h>
+#include <glib.h>
+#include "TCLog.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "AlbumArtScaler.h"
+#include "AlbumArtThumbnail.h"
+#include "AlbumArtCache.h"
+
+#define ALBUMART_THUMBNAIL_DECODE_TIMEOUT	(2 * GST_SECOND)
+#define ALBUMART_THUMBNAIL_PIPELINE			"appsrc name=src ! decodebin ! videoconvert ! " \
+											"video/x-raw,format=RGBA ! appsink name=sink sync=false"
+
+typedef struct stDecodedImage {
+	GstSample *sample;
+	GstBuffer *buffer;
+	GstMapInfo mapInfo;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+} DecodedImage;
+
+static bool DecodeImage(GstSample *image, DecodedImage *decoded);
+static void ReleaseDecodedImage(DecodedImage *decoded);
+static void PublishThumbnails(const DecodedImage *decoded, int32_t playID);
+static void RestampThumbnails(int32_t playID);
+static bool LoadCachedThumbnails(uint64_t hash, int32_t playID);
+static void StoreCachedThumbnails(uint64_t hash);
+static uint32_t GetCachedSize(void);
+static void *ThumbnailThread(void *arg);
+static int32_t SharedMemoryInitialize(void);
+static void SharedMemoryRelease(void);
+
+static AlbumArtThumbnailInfo s_sizes[ALBUMART_THUMBNAIL_MAX_SIZES];
+static uint32_t s_sizeCount = 0;
+static AlbumArtFormat s_format = AlbumArtFormatARGB8888;
+
+static int32_t s_shmID = -1;
+static uint8_t *s_shmAddr = NULL;
+static uint32_t s_shmSize = 0;
+
+static pthread_mutex_t s_mutex;
+static pthread_cond_t s_cond;
+static pthread_t s_thread;
+static bool s_threadRun = false;
+static GstSample *s_pendingImage = NULL;
+static int32_t s_pendingPlayID = -1;
+static uint64_t s_pendingHash = 0;
+static uint64_t s_publishedHash = 0;			/* of the image in the segment, 0 if unknown */
+static char s_cacheVariant[64];				/* format and sizes, names the cached file */
+
+static AlbumArtThumbnailCompleted_cb		AlbumArtThumbnailCompletedCB = NULL;
+
+int32_t AlbumArtThumbnailAddSize(const char *size)
+{
+	int32_t ret = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+
+	if ((size != NULL) && (sscanf(size, "%ux%u", &width, &height) == 2) &&
+		(width > 0U) && (width <= (uint32_t)ALBUMART_THUMBNAIL_MAX_DIMENSION) &&
+		(height > 0U) && (height <= (uint32_t)ALBUMART_THUMBNAIL_MAX_DIMENSION))
+	{
+		if (s_sizeCount < (uint32_t)ALBUMART_THUMBNAIL_MAX_SIZES)
+		{
+			s_sizes[s_sizeCount].maxWidth = width;
+			s_sizes[s_sizeCount].maxHeight = height;
+			s_sizeCount++;
+			ret = 1;
+		}
+		else
+		{
+			ERROR_PRINTF("too many thumbnail sizes, max(%d)\n", ALBUMART_THUMBNAIL_MAX_SIZES);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("invalid thumbnail size(%s)\n", (size != NULL) ? size : "null");
+	}
+
+	return ret;
+}
+
+int32_t AlbumArtThumbnailSetFormat(const char *format)
+{
+	int32_t ret = 1;
+
+	if ((format != NULL) && (strcasecmp(format, "argb8888") == 0))
+	{
+		s_format = AlbumArtFormatARGB8888;
+	}
+	else if ((format != NULL) && (strcasecmp(format, "rgb565") == 0))
+	{
+		s_format = AlbumArtFormatRGB565;
+	}
+	else
+	{
+		ERROR_PRINTF("invalid thumbnail format(%s)\n", (format != NULL) ? format : "null");
+		ret = 0;
+	}
+
+	return ret;
+}
+
+int32_t AlbumArtThumbnailInitialize(void)
+{
+	int32_t ret = 1;
+	int32_t err;
+
+	if (s_sizeCount > 0U)
+	{
+		ret = 0;
+		if (SharedMemoryInitialize() == 0)
+		{
+			(void)pthread_mutex_init(&s_mutex, NULL);
+			(void)pthread_cond_init(&s_cond, NULL);
+
+			s_threadRun = true;
+			err = pthread_create(&s_thread, NULL, ThumbnailThread, NULL);
+			if (err == 0)
+			{
+				INFO_PRINTF("%u thumbnail size(s), format(%d), shared memory(%u bytes)\n",
+							s_sizeCount, s_format, s_shmSize);
+				ret = 1;
+			}
+			else
+			{
+				ERROR_PRINTF("pthread_create failed: error(%d)\n", err);
+				s_threadRun = false;
+				(void)pthread_cond_destroy(&s_cond);
+				(void)pthread_mutex_destroy(&s_mutex);
+				SharedMemoryRelease();
+			}
+		}
+	}
+
+	return ret;
+}
+
+void AlbumArtThumbnailRelease(void)
+{
+	if (s_threadRun)
+	{
+		(void)pthread_mutex_lock(&s_mutex);
+		s_threadRun = false;
+		(void)pthread_cond_signal(&s_cond);
+		(void)pthread_mutex_unlock(&s_mutex);
+		(void)pthread_join(s_thread, NULL);
+
+		if (s_pendingImage != NULL)
+		{
+			gst_sample_unref(s_pendingImage);
+			s_pendingImage = NULL;
+		}
+
+		(void)pthread_cond_destroy(&s_cond);
+		(void)pthread_mutex_destroy(&s_mutex);
+		SharedMemoryRelease();
+	}
+}
+
+void AlbumArtThumbnailSetEventCallBackFunctions(TcAlbumArtThumbnailEventCB *cb)
+{
+	if (cb != NULL)
+	{
+		AlbumArtThumbnailCompletedCB = cb->AlbumArtThumbnailCompletedCB;
+	}
+}
+
+int32_t AlbumArtThumbnailRequest(GstSample *image, int32_t playID, uint64_t hash)
+{
+	int32_t ret = 0;
+
+	if (s_threadRun && (image != NULL))
+	{
+		(void)pthread_mutex_lock(&s_mutex);
+		/* only the latest image matters, an older one still waiting is dropped */
+		if (s_pendingImage != NULL)
+		{
+			gst_sample_unref(s_pendingImage);
+		}
+		s_pendingImage = gst_sample_ref(image);
+		s_pendingPlayID = playID;
+		s_pendingHash = hash;
+		(void)pthread_cond_signal(&s_cond);
+		(void)pthread_mutex_unlock(&s_mutex);
+		ret = 1;
+	}
+
+	return ret;
+}
+
+int32_t AlbumArtThumbnailGetKey(int32_t *key, uint32_t *size)
+{
+	int32_t ret = 0;
+
+	if (s_shmAddr != NULL)
+	{
+		*key = ALBUMART_THUMBNAIL_KEY_NUM;
+		*size = s_shmSize;
+		ret = 1;
+	}
+	else
+	{
+		*key = -1;
+		*size = 0;
+	}
+
+	return ret;
+}
+
+static void *ThumbnailThread(void *arg)
+{
+	GstSample *image;
+	int32_t playID;
+	uint64_t hash;
+	DecodedImage decoded;
+
+	(void)arg;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	while (s_threadRun)
+	{
+		if (s_pendingImage == NULL)
+		{
+			(void)pthread_cond_wait(&s_cond, &s_mutex);
+		}
+		else
+		{
+			image = s_pendingImage;
+			playID = s_pendingPlayID;
+			hash = s_pendingHash;
+			s_pendingImage = NULL;
+			(void)pthread_mutex_unlock(&s_mutex);
+
+			/* the next track of the same album shows the thumbnails already published */
+			if ((hash != 0U) && (hash == s_publishedHash))
+			{
+				RestampThumbnails(playID);
+			}
+			else if (LoadCachedThumbnails(hash, playID))
+			{
+				s_publishedHash = hash;
+			}
+			else if (DecodeImage(image, &decoded))
+			{
+				/* skip publishing if the track already changed again */
+				(void)pthread_mutex_lock(&s_mutex);
+				if (s_pendingImage == NULL)
+				{
+					(void)pthread_mutex_unlock(&s_mutex);
+					PublishThumbnails(&decoded, playID);
+					s_publishedHash = hash;
+					StoreCachedThumbnails(hash);
+				}
+				else
+				{
+					(void)pthread_mutex_unlock(&s_mutex);
+				}
+				ReleaseDecodedImage(&decoded);
+			}
+			else
+			{
+				;
+			}
+			gst_sample_unref(image);
+
+			(void)pthread_mutex_lock(&s_mutex);
+		}
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return NULL;
+}
+
+static bool DecodeImage(GstSample *image, DecodedImage *decoded)
+{
+	bool ret = false;
+	GstElement *pipeline;
+	GError *error = NULL;
+
+	(void)memset(decoded, 0, sizeof(DecodedImage));
+
+	pipeline = gst_parse_launch(ALBUMART_THUMBNAIL_PIPELINE, &error);
+	if (pipeline != NULL)
+	{
+		GstElement *src = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+		GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+		GstBuffer *buffer = gst_sample_get_buffer(image);
+		GstFlowReturn flow = GST_FLOW_ERROR;
+
+		if ((src != NULL) && (sink != NULL) && (buffer != NULL))
+		{
+			if (gst_sample_get_caps(image) != NULL)
+			{
+				g_object_set(src, "caps", gst_sample_get_caps(image), NULL);
+			}
+
+			if (gst_element_set_state(pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE)
+			{
+				g_signal_emit_by_name(src, "push-buffer", buffer, &flow);
+				g_signal_emit_by_name(src, "end-of-stream", &flow);
+				g_signal_emit_by_name(sink, "try-pull-sample", (GstClockTime)ALBUMART_THUMBNAIL_DECODE_TIMEOUT, &decoded->sample);
+			}
+			(void)gst_element_set_state(pipeline, GST_STATE_NULL);
+		}
+
+		if (src != NULL)
+		{
+			gst_object_unref(src);
+		}
+		if (sink != NULL)
+		{
+			gst_object_unref(sink);
+		}
+		gst_object_unref(pipeline);
+	}
+	else
+	{
+		ERROR_PRINTF("gst_parse_launch failed: %s\n", (error != NULL) ? error->message : "unknown");
+	}
+
+	if (error != NULL)
+	{
+		g_error_free(error);
+	}
+
+	if (decoded->sample != NULL)
+	{
+		GstCaps *caps = gst_sample_get_caps(decoded->sample);
+		gint width = 0;
+		gint height = 0;
+
+		decoded->buffer = gst_sample_get_buffer(decoded->sample);
+		if ((caps != NULL) && (decoded->buffer != NULL) &&
+			gst_structure_get_int(gst_caps_get_structure(caps, 0), "width", &width) &&
+			gst_structure_get_int(gst_caps_get_structure(caps, 0), "height", &height) &&
+			(width > 0) && (height > 0) &&
+			gst_buffer_map(decoded->buffer, &decoded->mapInfo, GST_MAP_READ))
+		{
+			decoded->width = (uint32_t)width;
+			decoded->height = (uint32_t)height;
+			decoded->stride = (uint32_t)(decoded->mapInfo.size / (gsize)height);
+			if (decoded->stride >= (decoded->width * 4U))
+			{
+				ret = true;
+			}
+			else
+			{
+				gst_buffer_unmap(decoded->buffer, &decoded->mapInfo);
+			}
+		}
+
+		if (ret == false)
+		{
+			ERROR_PRINTF("invalid decoded album art\n");
+			gst_sample_unref(decoded->sample);
+			decoded->sample = NULL;
+		}
+	}
+	else
+	{
+		WARN_PRINTF("album art decode failed\n");
+	}
+
+	return ret;
+}
+
+static void ReleaseDecodedImage(DecodedImage *decoded)
+{
+	if (decoded->sample != NULL)
+	{
+		gst_buffer_unmap(decoded->buffer, &decoded->mapInfo);
+		gst_sample_unref(decoded->sample);
+		decoded->sample = NULL;
+	}
+}
+
+static void PublishThumbnails(const DecodedImage *decoded, int32_t playID)
+{
+	AlbumArtThumbnailHeader *header = (AlbumArtThumbnailHeader *)(void *)s_shmAddr;
+	uint32_t bpp = AlbumArtGetBytesPerPixel(s_format);
+	void *work;
+	uint32_t idx;
+
+	work = malloc(AlbumArtGetWorkSize(decoded->width, (uint32_t)ALBUMART_THUMBNAIL_MAX_DIMENSION));
+	if (work != NULL)
+	{
+		/* odd sequence: readers retry until the rewrite is done */
+		__atomic_store_n(&header->sequence, header->sequence + 1U, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		for (idx = 0; idx < s_sizeCount; idx++)
+		{
+			AlbumArtThumbnailInfo *info = &header->thumbnails[idx];
+
+			AlbumArtFitSize(decoded->width, decoded->height, info->maxWidth, info->maxHeight,
+							&info->width, &info->height);
+			info->stride = info->width * bpp;
+			AlbumArtScale(decoded->mapInfo.data, decoded->width, decoded->height, decoded->stride,
+						s_shmAddr + info->offset, info->width, info->height, info->stride,
+						s_format, work);
+		}
+		header->playID = playID;
+
+		__atomic_store_n(&header->sequence, header->sequence + 1U, __ATOMIC_RELEASE);
+		free(work);
+
+		DEBUG_PRINTF("album art(%ux%u) published, playID(%d)\n", decoded->width, decoded->height, playID);
+		if (AlbumArtThumbnailCompletedCB != NULL)
+		{
+			AlbumArtThumbnailCompletedCB(playID, s_sizeCount);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("out of memory\n");
+	}
+}
+
+static void RestampThumbnails(int32_t playID)
+{
+	AlbumArtThumbnailHeader *header = (AlbumArtThumbnailHeader *)(void *)s_shmAddr;
+
+	__atomic_store_n(&header->sequence, header->sequence + 1U, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	header->playID = playID;
+	__atomic_store_n(&header->sequence, header->sequence + 1U, __ATOMIC_RELEASE);
+
+	DEBUG_PRINTF("same album art, playID(%d)\n", playID);
+	if (AlbumArtThumbnailCompletedCB != NULL)
+	{
+		AlbumArtThumbnailCompletedCB(playID, s_sizeCount);
+	}
+}
+
+/*
+ * A cached file holds width and height of every size, then the pixels of
+ * the segment from the first thumbnail to its end.
+ */
+static uint32_t GetCachedSize(void)
+{
+	return (s_sizeCount * 2U * (uint32_t)sizeof(uint32_t)) + (s_shmSize - s_sizes[0].offset);
+}
+
+static bool LoadCachedThumbnails(uint64_t hash, int32_t playID)
+{
+	bool ret = false;
+	AlbumArtThumbnailHeader *header = (AlbumArtThumbnailHeader *)(void *)s_shmAddr;
+	uint32_t bpp = AlbumArtGetBytesPerPixel(s_format);
+	uint32_t size = GetCachedSize();
+	uint32_t *dimensions;
+	uint8_t *cached;
+	uint32_t idx;
+
+	cached = (hash != 0U) ? (uint8_t *)malloc(size) : NULL;
+	if ((cached != NULL) && (AlbumArtCacheLoadFile(hash, s_cacheVariant, cached, size) == 0))
+	{
+		dimensions = (uint32_t *)(void *)cached;
+		ret = true;
+		for (idx = 0; idx < s_sizeCount; idx++)
+		{
+			if ((dimensions[idx * 2U] > s_sizes[idx].maxWidth) || (dimensions[(idx * 2U) + 1U] > s_sizes[idx].maxHeight))
+			{
+				ret = false;
+			}
+		}
+
+		if (ret)
+		{
+			__atomic_store_n(&header->sequence, header->sequence + 1U, __ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_RELEASE);
+
+			for (idx = 0; idx < s_sizeCount; idx++)
+			{
+				header->thumbnails[idx].width = dimensions[idx * 2U];
+				header->thumbnails[idx].height = dimensions[(idx * 2U) + 1U];
+				header->thumbnails[idx].stride = header->thumbnails[idx].width * bpp;
+			}
+			(void)memcpy(s_shmAddr + s_sizes[0].offset, cached + (s_sizeCount * 2U * (uint32_t)sizeof(uint32_t)),
+						s_shmSize - s_sizes[0].offset);
+			header->playID = playID;
+
+			__atomic_store_n(&header->sequence, header->sequence + 1U, __ATOMIC_RELEASE);
+
+			DEBUG_PRINTF("cached album art published, playID(%d)\n", playID);
+			if (AlbumArtThumbnailCompletedCB != NULL)
+			{
+				AlbumArtThumbnailCompletedCB(playID, s_sizeCount);
+			}
+		}
+	}
+	free(cached);
+
+	return ret;
+}
+
+static void StoreCachedThumbnails(uint64_t hash)
+{
+	const AlbumArtThumbnailHeader *header = (const AlbumArtThumbnailHeader *)(void *)s_shmAddr;
+	uint32_t size = GetCachedSize();
+	uint32_t *dimensions;
+	uint8_t *cached;
+	uint32_t idx;
+
+	/* only this thread writes the segment, it is copied without the seqlock */
+	cached = (hash != 0U) ? (uint8_t *)malloc(size) : NULL;
+	if (cached != NULL)
+	{
+		dimensions = (uint32_t *)(void *)cached;
+		for (idx = 0; idx < s_sizeCount; idx++)
+		{
+			dimensions[idx * 2U] = header->thumbnails[idx].width;
+			dimensions[(idx * 2U) + 1U] = header->thumbnails[idx].height;
+		}
+		(void)memcpy(cached + (s_sizeCount * 2U * (uint32_t)sizeof(uint32_t)), s_shmAddr + s_sizes[0].offset,
+					s_shmSize - s_sizes[0].offset);
+		AlbumArtCacheStoreFile(hash, s_cacheVariant, cached, size);
+		free(cached);
+	}
+}
+
+static int32_t SharedMemoryInitialize(void)
+{
+	int32_t ret = -1;
+	AlbumArtThumbnailHeader *header;
+	uint32_t bpp = AlbumArtGetBytesPerPixel(s_format);
+	uint32_t offset = (uint32_t)sizeof(AlbumArtThumbnailHeader);
+	uint32_t idx;
+	void *addr;
+
+	(void)g_strlcpy(s_cacheVariant, (s_format == AlbumArtFormatRGB565) ? "rgb565" : "argb8888", sizeof(s_cacheVariant));
+	for (idx = 0; idx < s_sizeCount; idx++)
+	{
+		gchar size[24];
+
+		(void)g_snprintf(size, sizeof(size), "-%ux%u", s_sizes[idx].maxWidth, s_sizes[idx].maxHeight);
+		(void)g_strlcat(s_cacheVariant, size, sizeof(s_cacheVariant));
+
+		/* keep every image 16 byte aligned for the blitter */
+		offset = (offset + 15U) & ~15U;
+		s_sizes[idx].offset = offset;
+		s_sizes[idx].capacity = s_sizes[idx].maxWidth * s_sizes[idx].maxHeight * bpp;
+		offset += s_sizes[idx].capacity;
+	}
+
+	s_shmID = shmget((key_t)ALBUMART_THUMBNAIL_KEY_NUM, (size_t)offset, 0666 | IPC_CREAT);
+	if (s_shmID == -1)
+	{
+		/* a stale segment of another size is left from a previous configuration */
+		s_shmID = shmget((key_t)ALBUMART_THUMBNAIL_KEY_NUM, 0, 0666);
+		if ((s_shmID != -1) && (shmctl(s_shmID, IPC_RMID, 0) == 0))
+		{
+			s_shmID = shmget((key_t)ALBUMART_THUMBNAIL_KEY_NUM, (size_t)offset, 0666 | IPC_CREAT);
+		}
+		else
+		{
+			s_shmID = -1;
+		}
+	}
+
+	if (s_shmID != -1)
+	{
+		addr = shmat(s_shmID, (void *)0, 0);
+		if (addr != (void *)-1)
+		{
+			s_shmAddr = (uint8_t *)addr;
+			s_shmSize = offset;
+
+			header = (AlbumArtThumbnailHeader *)addr;
+			(void)memset(header, 0, sizeof(AlbumArtThumbnailHeader));
+			header->magic = ALBUMART_THUMBNAIL_MAGIC;
+			header->version = ALBUMART_THUMBNAIL_VERSION;
+			header->headerSize = (uint32_t)sizeof(AlbumArtThumbnailHeader);
+			header->format = (uint32_t)s_format;
+			header->count = s_sizeCount;
+			header->playID = -1;
+			(void)memcpy(header->thumbnails, s_sizes, sizeof(s_sizes));
+			ret = 0;
+		}
+		else
+		{
+			ERROR_PRINTF("shmat failed\n");
+			(void)shmctl(s_shmID, IPC_RMID, 0);
+			s_shmID = -1;
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("shmget(%u bytes) failed\n", offset);
+	}
+
+	return ret;
+}
+
+static void SharedMemoryRelease(void)
+{
+	if (s_shmAddr != NULL)
+	{
+		if (shmdt(s_shmAddr) == -1)
+		{
+			ERROR_PRINTF("failed detach shared memory\n");
+		}
+		s_shmAddr = NULL;
+		s_shmSize = 0;
+	}
+
+	if (s_shmID != -1)
+	{
+		if (shmctl(s_shmID, IPC_RMID, 0) == -1)
+		{
+			ERROR_PRINTF("failed remove shared memory\n");
+		}
+		s_shmID = -1;
+	}
+}
@@ -0,0 +1,851 @@
+/****************************************************************************************
+ *   FileName    : AudioCrossfade.c
+ *   Description : Telechips Audio Crossfade
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+#include "TCLog.h"
+#include "TCTime.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MultiMediaTaskPool.h"
+#include "AudioCrossfadeKernel.h"
+#include "AudioCrossfade.h"
+
+/*
+ * The tracks are mixed here and not by an audiomixer in front of the sink:
+ * an aggregator waits for data on every pad, so a track that is paused,
+ * prerolling or late would stall the device, and the fade would start where
+ * the aggregator happens to have data instead of on a known frame. The
+ * mixer takes whatever each track has, plays silence for the rest and
+ * counts every frame it sends.
+ *
+ * Each player converts into an appsink that holds a few buffers, so its
+ * decoder runs just ahead of the mixer. The mixer pushes into an appsrc that
+ * blocks once AUDIO_CROSSFADE_QUEUE_BLOCKS are queued, so the device paces
+ * it. The buffers carry no timestamps and the sink plays them one after the
+ * other.
+ */
+#define CROSSFADE_CAPS				"audio/x-raw,format=" GST_AUDIO_NE(F32) ",layout=interleaved," \
+									"rate=" G_STRINGIFY(AUDIO_CROSSFADE_RATE) ",channels=2"
+#define CROSSFADE_INPUT				"audioconvert ! audioresample ! " CROSSFADE_CAPS " ! " \
+									"appsink name=input sync=false max-buffers=2 wait-on-eos=true"
+#define CROSSFADE_OUTPUT			"appsrc name=src format=time block=true is-live=false caps=\"" CROSSFADE_CAPS "\" ! " \
+									"audioconvert ! audioresample name=resample"
+#define CROSSFADE_BRANCHES			4		/* current, tail and two the mixer did not free yet */
+#define CROSSFADE_PULL_TIMEOUT		(5 * GST_MSECOND)
+#define CROSSFADE_DURATION_INTERVAL	1000	/* ms between duration queries */
+#define CROSSFADE_PENDING_FRAMES	(5U * AUDIO_CROSSFADE_RATE)	/* the next track is not waited for longer */
+#define CROSSFADE_FRAME_SIZE		(AUDIO_CROSSFADE_CHANNELS * sizeof(float))
+#define CROSSFADE_BLOCK_SIZE		(AUDIO_CROSSFADE_BLOCK_FRAMES * CROSSFADE_FRAME_SIZE)
+
+typedef enum {
+	CrossfadeFree,
+	CrossfadeCurrent,						/* played by its player */
+	CrossfadeTail,							/* handed off, fading out */
+	CrossfadeRemoved						/* freed by the mixer */
+} CrossfadeRole;
+
+typedef struct stCrossfadeBranch {
+	uint32_t role;							/* CrossfadeRole, guarded by s_mutex */
+	GstElement *bin;						/* the audio sink of the player, only compared */
+	GstElement *sink;						/* the appsink in bin */
+	GstElement *pipeline;					/* the player of a tail */
+	int32_t playID;
+	/* the rest belongs to the mixer thread */
+	GstSample *sample;						/* read from offset on */
+	uint32_t offset;						/* frames */
+	int64_t position;						/* stream time of the next frame, -1 until known */
+	int64_t duration;
+	int64_t durationQueried;				/* ms */
+	int64_t endingPosted;					/* ms AUDIO_CROSSFADE_ENDING_MESSAGE was posted last */
+	bool eos;
+} CrossfadeBranch;
+
+typedef struct stCrossfadeFade {
+	bool active;							/* out fades into in */
+	bool pending;							/* out ended, the start of in, any in if NULL, is reported */
+	CrossfadeBranch *in;
+	CrossfadeBranch *out;
+	uint64_t position;						/* frames of the fade mixed */
+	uint64_t length;
+	AudioCrossfadeTransition transition;
+} CrossfadeFade;
+
+static void *MixerThread(void *arg);
+static void MixBlock(GstElement *src, CrossfadeBranch *current, CrossfadeBranch *tail, uint32_t length);
+static void MixFade(float *mix, CrossfadeBranch *current, CrossfadeBranch *tail);
+static uint32_t ReadBranch(CrossfadeBranch *branch, float *data, uint32_t frames, GstClockTime timeout);
+static bool HasData(CrossfadeBranch *branch);
+static void CheckEnding(CrossfadeBranch *branch, uint32_t length);
+static void StartTransition(CrossfadeBranch *current, CrossfadeBranch *tail, uint32_t length);
+static void EndTransition(uint64_t frame);
+static void ReportTransition(void);
+static CrossfadeBranch *FindBranch(CrossfadeRole role);
+static void FreeBranch(CrossfadeBranch *branch, bool idle);
+static gboolean OnReleasePipeline(gpointer data);
+static GstBusSyncReply OnOutputSyncMessage(GstBus *bus, GstMessage *msg, gpointer data);
+
+static uint32_t s_length = 0;				/* ms, atomic */
+static bool s_enabled = false;
+static AudioCrossfadeTransition_cb s_transitionCB = NULL;
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t s_thread;
+static bool s_threadRun = false;
+static GstElement *s_output = NULL;
+static GstElement *s_src = NULL;
+static CrossfadeBranch s_branches[CROSSFADE_BRANCHES];
+
+/* the mixer thread's */
+static uint64_t s_frames = 0;				/* sent since the output was opened */
+static CrossfadeFade s_fade;
+static float s_in[AUDIO_CROSSFADE_BLOCK_FRAMES * AUDIO_CROSSFADE_CHANNELS];
+static float s_out[AUDIO_CROSSFADE_BLOCK_FRAMES * AUDIO_CROSSFADE_CHANNELS];
+
+int32_t AudioCrossfadeSetLength(const char *seconds)
+{
+	int32_t ret = 0;
+	char *end = NULL;
+	float value = (seconds != NULL) ? strtof(seconds, &end) : 0.0f;
+
+	if ((end != NULL) && (end != seconds) && (*end == '\0') &&
+		(value >= 0.0f) && (value <= ((float)AUDIO_CROSSFADE_MAX_LENGTH / 1000.0f)))
+	{
+		(void)AudioCrossfadeSetLengthMs((uint32_t)((value * 1000.0f) + 0.5f));
+		ret = 1;
+	}
+	else
+	{
+		ERROR_PRINTF("invalid crossfade(%s), range(0 ~ %d seconds)\n", (seconds != NULL) ? seconds : "null",
+					 AUDIO_CROSSFADE_MAX_LENGTH / 1000);
+	}
+
+	return ret;
+}
+
+uint32_t AudioCrossfadeSetLengthMs(uint32_t length)
+{
+	if (length > (uint32_t)AUDIO_CROSSFADE_MAX_LENGTH)
+	{
+		length = AUDIO_CROSSFADE_MAX_LENGTH;
+	}
+
+	INFO_PRINTF("crossfade(%u ms)\n", length);
+	__atomic_store_n(&s_length, length, __ATOMIC_RELAXED);
+	__atomic_store_n(&s_enabled, true, __ATOMIC_RELAXED);
+
+	return length;
+}
+
+uint32_t AudioCrossfadeGetLength(void)
+{
+	return __atomic_load_n(&s_length, __ATOMIC_RELAXED);
+}
+
+bool AudioCrossfadeIsEnabled(void)
+{
+	return __atomic_load_n(&s_enabled, __ATOMIC_RELAXED);
+}
+
+void AudioCrossfadeSetEventCallBack(AudioCrossfadeTransition_cb cb)
+{
+	s_transitionCB = cb;
+}
+
+int32_t AudioCrossfadeOpen(GstElement *sink)
+{
+	int32_t ret = 0;
+
+	if (s_output != NULL)
+	{
+		if (sink != NULL)
+		{
+			gst_object_unref(gst_object_ref_sink(sink));
+		}
+		ret = 1;
+	}
+	else if (sink != NULL)
+	{
+		GError *error = NULL;
+		GstElement *pipeline = gst_parse_launch(CROSSFADE_OUTPUT, &error);
+
+		if (pipeline != NULL)
+		{
+			GstElement *src = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+			GstElement *resample = gst_bin_get_by_name(GST_BIN(pipeline), "resample");
+			GstBus *bus = gst_element_get_bus(pipeline);
+
+			(void)gst_bin_add(GST_BIN(pipeline), sink);
+			if ((src != NULL) && (resample != NULL) && (bus != NULL) && gst_element_link(resample, sink))
+			{
+				int32_t err;
+
+				g_object_set(src, "max-bytes", (guint64)(CROSSFADE_BLOCK_SIZE * AUDIO_CROSSFADE_QUEUE_BLOCKS), NULL);
+				gst_bus_set_sync_handler(bus, OnOutputSyncMessage, NULL, NULL);
+				(void)gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+				(void)pthread_mutex_lock(&s_mutex);
+				s_output = pipeline;
+				s_src = src;
+				s_frames = 0;
+				(void)memset(&s_fade, 0, sizeof(s_fade));
+				s_threadRun = true;
+				(void)pthread_mutex_unlock(&s_mutex);
+
+				err = pthread_create(&s_thread, NULL, MixerThread, NULL);
+				if (err == 0)
+				{
+					INFO_PRINTF("output open, %d Hz, kernel(%s)\n", AUDIO_CROSSFADE_RATE, AudioCrossfadeGetKernelName());
+					pipeline = NULL;
+					src = NULL;
+					ret = 1;
+				}
+				else
+				{
+					ERROR_PRINTF("pthread_create failed: error(%d)\n", err);
+					(void)pthread_mutex_lock(&s_mutex);
+					s_output = NULL;
+					s_src = NULL;
+					s_threadRun = false;
+					(void)pthread_mutex_unlock(&s_mutex);
+					(void)gst_element_set_state(pipeline, GST_STATE_NULL);
+				}
+			}
+			else
+			{
+				ERROR_PRINTF("output cannot be linked to the audio sink\n");
+			}
+
+			if (bus != NULL)
+			{
+				gst_object_unref(bus);
+			}
+			if (resample != NULL)
+			{
+				gst_object_unref(resample);
+			}
+			if (src != NULL)
+			{
+				gst_object_unref(src);
+			}
+			if (pipeline != NULL)
+			{
+				gst_object_unref(pipeline);
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("gst_parse_launch failed: %s\n", (error != NULL) ? error->message : "unknown");
+			gst_object_unref(gst_object_ref_sink(sink));
+		}
+
+		if (error != NULL)
+		{
+			g_error_free(error);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("no audio sink for the output\n");
+	}
+
+	return ret;
+}
+
+bool AudioCrossfadeIsOpen(void)
+{
+	return (s_output != NULL);
+}
+
+void AudioCrossfadeClose(void)
+{
+	if (s_output != NULL)
+	{
+		uint32_t idx;
+
+		(void)pthread_mutex_lock(&s_mutex);
+		s_threadRun = false;
+		(void)pthread_mutex_unlock(&s_mutex);
+
+		/* flushing, a push blocked in the appsrc returns */
+		(void)gst_element_set_state(s_output, GST_STATE_NULL);
+		(void)pthread_join(s_thread, NULL);
+
+		(void)pthread_mutex_lock(&s_mutex);
+		for (idx = 0; idx < (uint32_t)CROSSFADE_BRANCHES; idx++)
+		{
+			if (s_branches[idx].role != (uint32_t)CrossfadeFree)
+			{
+				FreeBranch(&s_branches[idx], false);
+			}
+		}
+		gst_object_unref(s_src);
+		gst_object_unref(s_output);
+		s_src = NULL;
+		s_output = NULL;
+		(void)pthread_mutex_unlock(&s_mutex);
+
+		INFO_PRINTF("output closed after %" G_GUINT64_FORMAT " frames\n", s_frames);
+	}
+}
+
+void AudioCrossfadeRelease(void)
+{
+	AudioCrossfadeClose();
+}
+
+GstElement *AudioCrossfadeCreateSink(int32_t playID)
+{
+	GError *error = NULL;
+	GstElement *bin = gst_parse_bin_from_description(CROSSFADE_INPUT, TRUE, &error);
+
+	if (bin != NULL)
+	{
+		GstElement *sink = gst_bin_get_by_name(GST_BIN(bin), "input");
+		CrossfadeBranch *branch = NULL;
+		uint32_t idx;
+
+		(void)pthread_mutex_lock(&s_mutex);
+		for (idx = 0; idx < (uint32_t)CROSSFADE_BRANCHES; idx++)
+		{
+			if (s_branches[idx].role == (uint32_t)CrossfadeCurrent)
+			{
+				/* its player did not say it stopped */
+				s_branches[idx].role = CrossfadeRemoved;
+			}
+			else if ((branch == NULL) && (s_branches[idx].role == (uint32_t)CrossfadeFree))
+			{
+				branch = &s_branches[idx];
+			}
+			else
+			{
+				;
+			}
+		}
+
+		if ((branch != NULL) && (sink != NULL))
+		{
+			(void)memset(branch, 0, sizeof(*branch));
+			branch->bin = bin;
+			branch->sink = sink;
+			branch->playID = playID;
+			branch->position = -1;
+			branch->duration = -1;
+			branch->role = CrossfadeCurrent;
+			sink = NULL;
+		}
+		else
+		{
+			ERROR_PRINTF("no input left for playID(%d)\n", playID);
+			gst_object_unref(gst_object_ref_sink(bin));
+			bin = NULL;
+		}
+		(void)pthread_mutex_unlock(&s_mutex);
+
+		if (sink != NULL)
+		{
+			gst_object_unref(sink);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("gst_parse_bin_from_description failed: %s\n", (error != NULL) ? error->message : "unknown");
+	}
+
+	if (error != NULL)
+	{
+		g_error_free(error);
+	}
+
+	return bin;
+}
+
+int32_t AudioCrossfadeHandOff(GstElement *sink, GstElement *pipeline)
+{
+	int32_t ret = 0;
+	uint32_t idx;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	for (idx = 0; (idx < (uint32_t)CROSSFADE_BRANCHES) && (ret == 0); idx++)
+	{
+		CrossfadeBranch *branch = &s_branches[idx];
+
+		if ((sink != NULL) && (branch->bin == sink) && (branch->role == (uint32_t)CrossfadeCurrent) &&
+			(pipeline != NULL))
+		{
+			CrossfadeBranch *tail = FindBranch(CrossfadeTail);
+			GstBus *bus = gst_element_get_bus(pipeline);
+
+			/* no more than two tracks are decoded at once */
+			if (tail != NULL)
+			{
+				tail->role = CrossfadeRemoved;
+			}
+
+			/* nobody watches the bus of a tail any more */
+			if (bus != NULL)
+			{
+				gst_bus_set_flushing(bus, TRUE);
+				gst_object_unref(bus);
+			}
+
+			branch->pipeline = (GstElement *)gst_object_ref(pipeline);
+			branch->role = CrossfadeTail;
+			ret = 1;
+		}
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return ret;
+}
+
+void AudioCrossfadeRemoveSink(GstElement *sink)
+{
+	uint32_t idx;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	for (idx = 0; idx < (uint32_t)CROSSFADE_BRANCHES; idx++)
+	{
+		if ((sink != NULL) && (s_branches[idx].bin == sink) && (s_branches[idx].role == (uint32_t)CrossfadeCurrent))
+		{
+			CrossfadeBranch *tail = FindBranch(CrossfadeTail);
+
+			/* a stop also ends the fade of the track before */
+			s_branches[idx].role = CrossfadeRemoved;
+			if (tail != NULL)
+			{
+				tail->role = CrossfadeRemoved;
+			}
+		}
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+}
+
+static void *MixerThread(void *arg)
+{
+	(void)arg;
+	/* it feeds the device, as the audio sink threads */
+	MultiMediaTaskPoolApplyClass(MultiMediaThreadAudio);
+
+	(void)pthread_mutex_lock(&s_mutex);
+	while (s_threadRun)
+	{
+		GstElement *src = (GstElement *)gst_object_ref(s_src);
+		CrossfadeBranch *current;
+		CrossfadeBranch *tail;
+		uint32_t idx;
+
+		for (idx = 0; idx < (uint32_t)CROSSFADE_BRANCHES; idx++)
+		{
+			if (s_branches[idx].role == (uint32_t)CrossfadeRemoved)
+			{
+				FreeBranch(&s_branches[idx], true);
+			}
+		}
+		current = FindBranch(CrossfadeCurrent);
+		tail = FindBranch(CrossfadeTail);
+		(void)pthread_mutex_unlock(&s_mutex);
+
+		MixBlock(src, current, tail, AudioCrossfadeGetLength());
+		gst_object_unref(src);
+
+		(void)pthread_mutex_lock(&s_mutex);
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return NULL;
+}
+
+/* one block of the current track, of the tail or of both fading, silence where they have nothing */
+static void MixBlock(GstElement *src, CrossfadeBranch *current, CrossfadeBranch *tail, uint32_t length)
+{
+	GstBuffer *buffer = gst_buffer_new_allocate(NULL, CROSSFADE_BLOCK_SIZE, NULL);
+	GstMapInfo map;
+
+	/* a handoff or stop during the fade changed the tracks, or the next track never came */
+	if ((s_fade.active && ((s_fade.in != current) || (s_fade.out != tail))) ||
+		(s_fade.pending && (s_fade.in != NULL) && (s_fade.in != current)) ||
+		(s_fade.pending && ((s_frames - s_fade.transition.end) > CROSSFADE_PENDING_FRAMES)))
+	{
+		s_fade.active = false;
+		s_fade.pending = false;
+	}
+
+	if ((buffer != NULL) && gst_buffer_map(buffer, &map, GST_MAP_WRITE))
+	{
+		float *mix = (float *)map.data;
+		uint32_t frames = AUDIO_CROSSFADE_BLOCK_FRAMES;
+		uint32_t read = 0;
+		GstFlowReturn flow = GST_FLOW_OK;
+
+		/* a tail that ran out before the next track came ends without a fade */
+		if ((tail != NULL) && (current != NULL) && (!s_fade.active) && (!tail->eos) && (length > 0U) && HasData(current))
+		{
+			StartTransition(current, tail, length);
+		}
+
+		if (s_fade.active)
+		{
+			MixFade(mix, current, tail);
+			read = frames;
+		}
+		else if (tail != NULL)
+		{
+			read = ReadBranch(tail, mix, frames, CROSSFADE_PULL_TIMEOUT);
+			if ((read < frames) && tail->eos)
+			{
+				uint32_t next;
+
+				/* without a fade the next track follows at once, or as soon as it has data */
+				StartTransition(current, tail, 0U);
+				EndTransition(s_frames + read);
+				s_fade.pending = true;
+
+				(void)pthread_mutex_lock(&s_mutex);
+				tail->role = CrossfadeRemoved;
+				(void)pthread_mutex_unlock(&s_mutex);
+
+				next = ReadBranch(current, &mix[read * AUDIO_CROSSFADE_CHANNELS], frames - read, 0);
+				if (next > 0U)
+				{
+					s_fade.transition.start = s_fade.transition.end;
+					s_fade.transition.startTime = s_fade.transition.endTime;
+					ReportTransition();
+					s_fade.pending = false;
+				}
+				read += next;
+			}
+		}
+		else
+		{
+			read = ReadBranch(current, mix, frames, CROSSFADE_PULL_TIMEOUT);
+			if (s_fade.pending && (read > 0U))
+			{
+				s_fade.transition.toID = current->playID;
+				s_fade.transition.start = s_frames;
+				s_fade.transition.startTime = TCTimeGetMonotonicNs();
+				ReportTransition();
+				s_fade.pending = false;
+			}
+		}
+
+		if (read < frames)
+		{
+			(void)memset(&mix[read * AUDIO_CROSSFADE_CHANNELS], 0, (size_t)(frames - read) * CROSSFADE_FRAME_SIZE);
+		}
+
+		if (current != NULL)
+		{
+			CheckEnding(current, length);
+		}
+
+		gst_buffer_unmap(buffer, &map);
+		g_signal_emit_by_name(src, "push-buffer", buffer, &flow);
+		s_frames += frames;
+		if (flow != GST_FLOW_OK)
+		{
+			DEBUG_PRINTF("push-buffer: flow(%d)\n", flow);
+		}
+	}
+
+	if (buffer != NULL)
+	{
+		gst_buffer_unref(buffer);
+	}
+}
+
+static void MixFade(float *mix, CrossfadeBranch *current, CrossfadeBranch *tail)
+{
+	uint32_t frames = AUDIO_CROSSFADE_BLOCK_FRAMES;
+	uint32_t read;
+	uint32_t frame;
+
+	read = ReadBranch(current, s_in, frames, CROSSFADE_PULL_TIMEOUT);
+	(void)memset(&s_in[read * AUDIO_CROSSFADE_CHANNELS], 0, (size_t)(frames - read) * CROSSFADE_FRAME_SIZE);
+	read = ReadBranch(tail, s_out, frames, CROSSFADE_PULL_TIMEOUT);
+	(void)memset(&s_out[read * AUDIO_CROSSFADE_CHANNELS], 0, (size_t)(frames - read) * CROSSFADE_FRAME_SIZE);
+
+	if (s_fade.position == 0U)
+	{
+		s_fade.transition.startTime = TCTimeGetMonotonicNs();
+	}
+
+	for (frame = 0; frame < frames; frame += AUDIO_CROSSFADE_SEGMENT)
+	{
+		uint32_t sample = frame * (uint32_t)AUDIO_CROSSFADE_CHANNELS;
+		AudioCrossfadeRamp ramp;
+
+		AudioCrossfadeRampInit(&ramp, s_fade.position, s_fade.length, AUDIO_CROSSFADE_SEGMENT);
+		AudioCrossfadeMix(&mix[sample], &s_in[sample], &s_out[sample], AUDIO_CROSSFADE_SEGMENT, &ramp);
+		s_fade.position += AUDIO_CROSSFADE_SEGMENT;
+	}
+
+	if (s_fade.position >= s_fade.length)
+	{
+		EndTransition(s_fade.transition.start + s_fade.length);
+		ReportTransition();
+		s_fade.active = false;
+
+		(void)pthread_mutex_lock(&s_mutex);
+		tail->role = CrossfadeRemoved;
+		(void)pthread_mutex_unlock(&s_mutex);
+	}
+}
+
+/* frames the branch had, waiting up to timeout for each buffer */
+static uint32_t ReadBranch(CrossfadeBranch *branch, float *data, uint32_t frames, GstClockTime timeout)
+{
+	uint32_t read = 0;
+
+	while ((branch != NULL) && (read < frames))
+	{
+		GstBuffer *buffer;
+		GstMapInfo map;
+
+		if (branch->sample == NULL)
+		{
+			gboolean eos = FALSE;
+
+			g_signal_emit_by_name(branch->sink, "try-pull-sample", timeout, &branch->sample);
+			branch->offset = 0;
+			if (branch->sample == NULL)
+			{
+				g_object_get(branch->sink, "eos", &eos, NULL);
+				branch->eos = (eos != FALSE);
+				break;
+			}
+		}
+
+		buffer = gst_sample_get_buffer(branch->sample);
+		if ((buffer != NULL) && gst_buffer_map(buffer, &map, GST_MAP_READ))
+		{
+			uint32_t available = (uint32_t)(map.size / CROSSFADE_FRAME_SIZE);
+			uint32_t count = ((available - branch->offset) < (frames - read)) ?
+							 (available - branch->offset) : (frames - read);
+			GstClockTime pts = GST_BUFFER_PTS(buffer);
+
+			(void)memcpy(&data[read * AUDIO_CROSSFADE_CHANNELS],
+						 &map.data[(size_t)branch->offset * CROSSFADE_FRAME_SIZE], (size_t)count * CROSSFADE_FRAME_SIZE);
+			read += count;
+			branch->offset += count;
+
+			if (GST_CLOCK_TIME_IS_VALID(pts))
+			{
+				guint64 position = gst_segment_to_stream_time(gst_sample_get_segment(branch->sample),
+															  GST_FORMAT_TIME, pts);
+				if (GST_CLOCK_TIME_IS_VALID(position))
+				{
+					branch->position = (int64_t)position +
+									   (int64_t)gst_util_uint64_scale_int(branch->offset, GST_SECOND, AUDIO_CROSSFADE_RATE);
+				}
+			}
+
+			gst_buffer_unmap(buffer, &map);
+			if (branch->offset >= available)
+			{
+				gst_sample_unref(branch->sample);
+				branch->sample = NULL;
+			}
+		}
+		else
+		{
+			gst_sample_unref(branch->sample);
+			branch->sample = NULL;
+		}
+	}
+
+	return read;
+}
+
+static bool HasData(CrossfadeBranch *branch)
+{
+	if (branch->sample == NULL)
+	{
+		g_signal_emit_by_name(branch->sink, "try-pull-sample", (GstClockTime)0, &branch->sample);
+		branch->offset = 0;
+	}
+
+	return (branch->sample != NULL);
+}
+
+/* tells the player its track ends soon, every interval until it is handed off */
+static void CheckEnding(CrossfadeBranch *branch, uint32_t length)
+{
+	int64_t now = TCTimeGetMonotonicMs();
+
+	if ((branch->duration <= 0) && ((now - branch->durationQueried) >= CROSSFADE_DURATION_INTERVAL))
+	{
+		gint64 duration = -1;
+
+		if (gst_element_query_duration(branch->sink, GST_FORMAT_TIME, &duration))
+		{
+			branch->duration = duration;
+		}
+		branch->durationQueried = now;
+	}
+
+	if ((branch->duration > 0) && (branch->position >= 0))
+	{
+		int64_t point = branch->duration - ((int64_t)(length + (uint32_t)AUDIO_CROSSFADE_LEAD_TIME) * (int64_t)GST_MSECOND);
+
+		/* a next track set late is still found */
+		if ((branch->position >= point) && ((now - branch->endingPosted) >= CROSSFADE_DURATION_INTERVAL))
+		{
+			GstMessage *msg = gst_message_new_application(GST_OBJECT(branch->sink),
+														  gst_structure_new_empty(AUDIO_CROSSFADE_ENDING_MESSAGE));
+
+			DEBUG_PRINTF("playID(%d) ends in %" G_GINT64_FORMAT " ms\n", branch->playID,
+						 (branch->duration - branch->position) / (int64_t)GST_MSECOND);
+			(void)gst_element_post_message(branch->sink, msg);
+			branch->endingPosted = now;
+		}
+	}
+}
+
+/* the fade starts with the next block, current is NULL while the next track has no sink yet */
+static void StartTransition(CrossfadeBranch *current, CrossfadeBranch *tail, uint32_t length)
+{
+	(void)memset(&s_fade, 0, sizeof(s_fade));
+	s_fade.in = current;
+	s_fade.out = tail;
+	s_fade.length = ((uint64_t)length * (uint64_t)AUDIO_CROSSFADE_RATE) / 1000U;
+	s_fade.active = (s_fade.length > 0U);
+	s_fade.transition.fromID = tail->playID;
+	s_fade.transition.toID = (current != NULL) ? current->playID : -1;
+	s_fade.transition.start = s_frames;
+	s_fade.transition.fromPosition = tail->position;
+}
+
+static void EndTransition(uint64_t frame)
+{
+	s_fade.transition.end = frame;
+	s_fade.transition.endTime = TCTimeGetMonotonicNs();
+}
+
+static void ReportTransition(void)
+{
+	AudioCrossfadeTransition *transition = &s_fade.transition;
+
+	INFO_PRINTF("playID(%d) -> playID(%d), frames %" G_GUINT64_FORMAT " ~ %" G_GUINT64_FORMAT ", left at %" G_GINT64_FORMAT " ms\n",
+				transition->fromID, transition->toID, transition->start, transition->end,
+				transition->fromPosition / (int64_t)GST_MSECOND);
+	if (s_transitionCB != NULL)
+	{
+		s_transitionCB(transition);
+	}
+}
+
+/* under s_mutex */
+static CrossfadeBranch *FindBranch(CrossfadeRole role)
+{
+	CrossfadeBranch *branch = NULL;
+	uint32_t idx;
+
+	for (idx = 0; (idx < (uint32_t)CROSSFADE_BRANCHES) && (branch == NULL); idx++)
+	{
+		if (s_branches[idx].role == (uint32_t)role)
+		{
+			branch = &s_branches[idx];
+		}
+	}
+
+	return branch;
+}
+
+/* under s_mutex, the player of a tail is stopped by the main loop, away from the mixer */
+static void FreeBranch(CrossfadeBranch *branch, bool idle)
+{
+	if (branch->sample != NULL)
+	{
+		gst_sample_unref(branch->sample);
+	}
+
+	if (branch->sink != NULL)
+	{
+		gst_object_unref(branch->sink);
+	}
+
+	if (branch->pipeline != NULL)
+	{
+		if (idle)
+		{
+			(void)g_idle_add(OnReleasePipeline, branch->pipeline);
+		}
+		else
+		{
+			(void)OnReleasePipeline(branch->pipeline);
+		}
+	}
+
+	(void)memset(branch, 0, sizeof(*branch));
+	branch->role = CrossfadeFree;
+}
+
+static gboolean OnReleasePipeline(gpointer data)
+{
+	GstElement *pipeline = (GstElement *)data;
+
+	(void)gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_object_unref(pipeline);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* nothing watches the output bus, its messages are handled here and dropped */
+static GstBusSyncReply OnOutputSyncMessage(GstBus *bus, GstMessage *msg, gpointer data)
+{
+	(void)bus;
+	(void)data;
+
+	if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_STREAM_STATUS)
+	{
+		MultiMediaTaskPoolStreamStatus(msg);
+	}
+	else if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR)
+	{
+		GError *error = NULL;
+		gchar *debug = NULL;
+
+		gst_message_parse_error(msg, &error, &debug);
+		ERROR_PRINTF("output: %s\n", (error != NULL) ? error->message : "unknown");
+		if (error != NULL)
+		{
+			g_error_free(error);
+		}
+		g_free(debug);
+	}
+	else
+	{
+		;
+	}
+
+	return GST_BUS_DROP;
+}
@@ -0,0 +1,178 @@
+/****************************************************************************************
+ *   FileName    : AudioCrossfadeKernel.c
+ *   Description : Telechips Audio Crossfade Kernel
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdint.h>
+#include <math.h>
+#include "AudioCrossfadeKernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AUDIO_CROSSFADE_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define AUDIO_CROSSFADE_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define AUDIO_CROSSFADE_NEON
+#endif
+
+/*
+ * Both channels of a frame share its gains, so a vector holds whole frames
+ * and its lanes take the frame index of their frame, e.g. 0, 0, 1, 1. The
+ * index is a float counted up by the frames of a vector, exact as long as a
+ * call mixes fewer than 2^24 frames, and the gain is start + (step * index)
+ * in every lane, as in the reference.
+ */
+static void MixFrames(float *mix, const float *in, const float *out, uint32_t first, uint32_t frames,
+					  const AudioCrossfadeRamp *ramp);
+
+void AudioCrossfadeRampInit(AudioCrossfadeRamp *ramp, uint64_t position, uint64_t length, uint32_t frames)
+{
+	if ((length == 0U) || (position >= length))
+	{
+		ramp->inStart = 1.0f;
+		ramp->inStep = 0.0f;
+		ramp->outStart = 0.0f;
+		ramp->outStep = 0.0f;
+	}
+	else
+	{
+		uint64_t end = ((position + frames) < length) ? (position + frames) : length;
+		double start = ((double)position / (double)length) * (M_PI / 2.0);
+		double stop = ((double)end / (double)length) * (M_PI / 2.0);
+		double count = (frames > 0U) ? (double)frames : 1.0;
+
+		/* the next ramp starts where this one would end, at stop */
+		ramp->inStart = (float)sin(start);
+		ramp->inStep = (float)((sin(stop) - sin(start)) / count);
+		ramp->outStart = (float)cos(start);
+		ramp->outStep = (float)((cos(stop) - cos(start)) / count);
+	}
+}
+
+void AudioCrossfadeMix(float *mix, const float *in, const float *out, uint32_t frames, const AudioCrossfadeRamp *ramp)
+{
+	uint32_t frame = 0;
+
+#if defined(AUDIO_CROSSFADE_AVX2)
+	const __m256 inStart = _mm256_set1_ps(ramp->inStart);
+	const __m256 inStep = _mm256_set1_ps(ramp->inStep);
+	const __m256 outStart = _mm256_set1_ps(ramp->outStart);
+	const __m256 outStep = _mm256_set1_ps(ramp->outStep);
+	const __m256 advance = _mm256_set1_ps(4.0f);
+	__m256 index = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+
+	for (; (frame + 4U) <= frames; frame += 4U)
+	{
+		uint32_t sample = frame * (uint32_t)AUDIO_CROSSFADE_CHANNELS;
+		__m256 inGain = _mm256_add_ps(inStart, _mm256_mul_ps(inStep, index));
+		__m256 outGain = _mm256_add_ps(outStart, _mm256_mul_ps(outStep, index));
+
+		_mm256_storeu_ps(&mix[sample], _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&in[sample]), inGain),
+													 _mm256_mul_ps(_mm256_loadu_ps(&out[sample]), outGain)));
+		index = _mm256_add_ps(index, advance);
+	}
+#elif defined(AUDIO_CROSSFADE_SSE2)
+	const __m128 inStart = _mm_set1_ps(ramp->inStart);
+	const __m128 inStep = _mm_set1_ps(ramp->inStep);
+	const __m128 outStart = _mm_set1_ps(ramp->outStart);
+	const __m128 outStep = _mm_set1_ps(ramp->outStep);
+	const __m128 advance = _mm_set1_ps(2.0f);
+	__m128 index = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+
+	for (; (frame + 2U) <= frames; frame += 2U)
+	{
+		uint32_t sample = frame * (uint32_t)AUDIO_CROSSFADE_CHANNELS;
+		__m128 inGain = _mm_add_ps(inStart, _mm_mul_ps(inStep, index));
+		__m128 outGain = _mm_add_ps(outStart, _mm_mul_ps(outStep, index));
+
+		_mm_storeu_ps(&mix[sample], _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&in[sample]), inGain),
+											   _mm_mul_ps(_mm_loadu_ps(&out[sample]), outGain)));
+		index = _mm_add_ps(index, advance);
+	}
+#elif defined(AUDIO_CROSSFADE_NEON)
+	const float32x4_t inStart = vdupq_n_f32(ramp->inStart);
+	const float32x4_t inStep = vdupq_n_f32(ramp->inStep);
+	const float32x4_t outStart = vdupq_n_f32(ramp->outStart);
+	const float32x4_t outStep = vdupq_n_f32(ramp->outStep);
+	const float32x4_t advance = vdupq_n_f32(2.0f);
+	static const float s_index[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+	float32x4_t index = vld1q_f32(s_index);
+
+	for (; (frame + 2U) <= frames; frame += 2U)
+	{
+		uint32_t sample = frame * (uint32_t)AUDIO_CROSSFADE_CHANNELS;
+		/* separate multiply and add, as the reference */
+		float32x4_t inGain = vaddq_f32(inStart, vmulq_f32(inStep, index));
+		float32x4_t outGain = vaddq_f32(outStart, vmulq_f32(outStep, index));
+
+		vst1q_f32(&mix[sample], vaddq_f32(vmulq_f32(vld1q_f32(&in[sample]), inGain),
+										  vmulq_f32(vld1q_f32(&out[sample]), outGain)));
+		index = vaddq_f32(index, advance);
+	}
+#endif
+
+	MixFrames(mix, in, out, frame, frames, ramp);
+}
+
+void AudioCrossfadeMixReference(float *mix, const float *in, const float *out, uint32_t frames,
+								const AudioCrossfadeRamp *ramp)
+{
+	MixFrames(mix, in, out, 0U, frames, ramp);
+}
+
+const char *AudioCrossfadeGetKernelName(void)
+{
+#if defined(AUDIO_CROSSFADE_AVX2)
+	return "avx2";
+#elif defined(AUDIO_CROSSFADE_SSE2)
+	return "sse2";
+#elif defined(AUDIO_CROSSFADE_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+/* frames first to frames - 1, the rest a vector does not fill */
+static void MixFrames(float *mix, const float *in, const float *out, uint32_t first, uint32_t frames,
+					  const AudioCrossfadeRamp *ramp)
+{
+	uint32_t frame;
+	uint32_t channel;
+
+	for (frame = first; frame < frames; frame++)
+	{
+		float index = (float)frame;
+		float inGain = ramp->inStart + (ramp->inStep * index);
+		float outGain = ramp->outStart + (ramp->outStep * index);
+
+		for (channel = 0; channel < (uint32_t)AUDIO_CROSSFADE_CHANNELS; channel++)
+		{
+			uint32_t sample = (frame * (uint32_t)AUDIO_CROSSFADE_CHANNELS) + channel;
+
+			mix[sample] = (in[sample] * inGain) + (out[sample] * outGain);
+		}
+	}
+}
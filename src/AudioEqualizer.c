@@ -0,0 +1,426 @@
+/****************************************************************************************
+ *   FileName    : AudioEqualizer.c
+ *   Description : Telechips Audio Equalizer
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+#include <gst/audio/gstaudiofilter.h>
+#include "TCLog.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "AudioEqualizerKernel.h"
+#include "AudioEqualizer.h"
+#include "AudioLoudness.h"
+
+#define EQUALIZER_RAMP_BLOCK		64		/* frames between two designs of the bands while ramping */
+#define EQUALIZER_CAPS \
+	"audio/x-raw, " \
+	"format = (string) { " GST_AUDIO_NE(F32) ", " GST_AUDIO_NE(S16) ", " GST_AUDIO_NE(S32) " }, " \
+	"rate = (int) [ 1, MAX ], " \
+	"channels = (int) [ 1, 8 ], " \
+	"layout = (string) interleaved"
+
+typedef struct stAudioEqualizer {
+	GstAudioFilter parent;
+	AudioEqualizerCoefficients coefficients;
+	AudioEqualizerState state;
+	AudioEqualizerBand bands[AUDIO_EQUALIZER_BANDS];	/* designed now */
+	AudioEqualizerBand from[AUDIO_EQUALIZER_BANDS];		/* where the ramp started */
+	uint32_t preset;					/* the ramp goes to */
+	float gain;							/* dB, designed now */
+	float fromGain;						/* where the ramp started */
+	float targetGain;					/* the ramp goes to */
+	float requestedGain;				/* of the track, or of its ReplayGain tags */
+	uint32_t rampFrames;
+	uint32_t rampDone;
+	uint32_t rate;
+	uint32_t channels;
+	AudioEqualizerFormat format;
+} AudioEqualizer;
+
+typedef struct stAudioEqualizerClass {
+	GstAudioFilterClass parent;
+} AudioEqualizerClass;
+
+static GType GetEqualizerType(void);
+static void EqualizerClassInit(gpointer klass, gpointer data);
+static void EqualizerInit(GTypeInstance *instance, gpointer klass);
+static gboolean EqualizerSetup(GstAudioFilter *filter, const GstAudioInfo *info);
+static gboolean EqualizerSinkEvent(GstBaseTransform *base, GstEvent *event);
+static GstFlowReturn EqualizerTransformIp(GstBaseTransform *base, GstBuffer *buffer);
+static void StartRamp(AudioEqualizer *equalizer, uint32_t preset, float gain);
+static void StepRamp(AudioEqualizer *equalizer, uint32_t frames);
+static void DesignBands(AudioEqualizer *equalizer);
+static uint32_t GetActivePreset(void);
+static void GetPresetBands(uint32_t preset, AudioEqualizerBand *bands);
+
+#define AUDIO_EQUALIZER_PRESET_NAME(name, text)		text,
+const char *g_audioEqualizerPresetNames[TotalAudioEqualizerPresets] = {
+	AUDIO_EQUALIZER_PRESET_LIST(AUDIO_EQUALIZER_PRESET_NAME)
+};
+
+/*
+ * Every preset uses the same bands and only sets their gains in dB, so a
+ * ramp between two presets moves the gains and keeps the type of each band.
+ */
+static const AudioEqualizerBand s_layout[AUDIO_EQUALIZER_BANDS] = {
+	{ AudioEqualizerLowShelf,	60.0f,		0.7f,	0.0f },
+	{ AudioEqualizerPeak,		150.0f,		1.0f,	0.0f },
+	{ AudioEqualizerPeak,		400.0f,		1.0f,	0.0f },
+	{ AudioEqualizerPeak,		1000.0f,	1.0f,	0.0f },
+	{ AudioEqualizerPeak,		2400.0f,	1.0f,	0.0f },
+	{ AudioEqualizerPeak,		6000.0f,	1.0f,	0.0f },
+	{ AudioEqualizerPeak,		10000.0f,	1.4f,	0.0f },
+	{ AudioEqualizerHighShelf,	12000.0f,	0.7f,	0.0f }
+};
+
+static const float s_presetGains[TotalAudioEqualizerPresets][AUDIO_EQUALIZER_BANDS] = {
+	{ 0.0f,		0.0f,	0.0f,	0.0f,	0.0f,	0.0f,	0.0f,	0.0f },		/* flat */
+	{ 6.0f,		3.0f,	0.0f,	0.0f,	0.0f,	0.0f,	0.0f,	0.0f },		/* bass */
+	{ 0.0f,		0.0f,	0.0f,	0.0f,	0.0f,	2.0f,	3.0f,	6.0f },		/* treble */
+	{ -2.0f,	0.0f,	-1.0f,	2.0f,	3.0f,	1.0f,	0.0f,	0.0f },		/* vocal */
+	{ 4.0f,		2.0f,	-1.0f,	-2.0f,	1.0f,	3.0f,	2.0f,	3.0f },		/* rock */
+	{ 2.0f,		0.0f,	0.0f,	0.0f,	-1.0f,	0.0f,	1.0f,	2.0f },		/* classical */
+	{ 6.0f,		2.0f,	0.0f,	-1.0f,	0.0f,	1.0f,	2.0f,	4.0f }		/* loudness */
+};
+
+static uint32_t s_preset = (uint32_t)AudioEqualizerPresetFlat;	/* selected, read by the streaming thread */
+static float s_gain = 0.0f;					/* of the next stream */
+static bool s_enabled = true;
+static GstBaseTransformClass *s_parentClass = NULL;
+
+void AudioEqualizerDisable(void)
+{
+	s_enabled = false;
+}
+
+int32_t AudioEqualizerSetPreset(const char *name)
+{
+	int32_t ret = 0;
+	uint32_t idx;
+
+	for (idx = 0; (idx < (uint32_t)TotalAudioEqualizerPresets) && (ret == 0); idx++)
+	{
+		if ((name != NULL) && (strcmp(name, g_audioEqualizerPresetNames[idx]) == 0))
+		{
+			__atomic_store_n(&s_preset, idx, __ATOMIC_RELAXED);
+			INFO_PRINTF("equalizer preset(%s)\n", name);
+			ret = 1;
+		}
+	}
+
+	if (ret == 0)
+	{
+		ERROR_PRINTF("unknown equalizer preset(%s)\n", (name != NULL) ? name : "null");
+	}
+
+	return ret;
+}
+
+uint32_t AudioEqualizerGetPreset(void)
+{
+	return __atomic_load_n(&s_preset, __ATOMIC_RELAXED);
+}
+
+void AudioEqualizerSetGain(float gain)
+{
+	__atomic_store(&s_gain, &gain, __ATOMIC_RELAXED);
+}
+
+/* without the equalizer the element is still needed for the loudness gain */
+GstElement *AudioEqualizerCreate(void)
+{
+	GstElement *element = NULL;
+
+	if (s_enabled || AudioLoudnessIsEnabled())
+	{
+		element = GST_ELEMENT(g_object_new(GetEqualizerType(), "name", "equalizer", NULL));
+	}
+
+	return element;
+}
+
+static GType GetEqualizerType(void)
+{
+	static gsize s_type = 0;
+
+	if (g_once_init_enter(&s_type) != FALSE)
+	{
+		GType type = g_type_register_static_simple(GST_TYPE_AUDIO_FILTER, "TcAudioEqualizer",
+												   (guint)sizeof(AudioEqualizerClass), EqualizerClassInit,
+												   (guint)sizeof(AudioEqualizer), EqualizerInit, (GTypeFlags)0);
+		g_once_init_leave(&s_type, type);
+	}
+
+	return (GType)s_type;
+}
+
+static void EqualizerClassInit(gpointer klass, gpointer data)
+{
+	GstElementClass *elementClass = GST_ELEMENT_CLASS(klass);
+	GstBaseTransformClass *transformClass = GST_BASE_TRANSFORM_CLASS(klass);
+	GstAudioFilterClass *filterClass = GST_AUDIO_FILTER_CLASS(klass);
+	GstCaps *caps = gst_caps_from_string(EQUALIZER_CAPS);
+
+	(void)data;
+	gst_audio_filter_class_add_pad_templates(filterClass, caps);
+	gst_caps_unref(caps);
+	gst_element_class_set_static_metadata(elementClass, "Telechips equalizer", "Filter/Effect/Audio",
+										  "Parametric equalizer with presets", "Telechips");
+
+	/* in passthrough a buffer is only looked at for a new preset, it is not made writable */
+	s_parentClass = (GstBaseTransformClass *)g_type_class_peek_parent(klass);
+	transformClass->sink_event = EqualizerSinkEvent;
+	transformClass->transform_ip = EqualizerTransformIp;
+	transformClass->transform_ip_on_passthrough = TRUE;
+	filterClass->setup = EqualizerSetup;
+}
+
+static void EqualizerInit(GTypeInstance *instance, gpointer klass)
+{
+	AudioEqualizer *equalizer = (AudioEqualizer *)instance;
+
+	(void)klass;
+	equalizer->preset = (uint32_t)AudioEqualizerPresetFlat;
+	__atomic_load(&s_gain, &equalizer->requestedGain, __ATOMIC_RELAXED);
+	equalizer->gain = 0.0f;
+	equalizer->fromGain = 0.0f;
+	equalizer->targetGain = 0.0f;
+	equalizer->rampFrames = 0;
+	equalizer->rampDone = 0;
+	equalizer->rate = 0;
+	equalizer->channels = 0;
+	equalizer->format = AudioEqualizerF32;
+	GetPresetBands(equalizer->preset, equalizer->bands);
+	AudioEqualizerReset(&equalizer->state);
+	gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(equalizer), TRUE);
+}
+
+static gboolean EqualizerSetup(GstAudioFilter *filter, const GstAudioInfo *info)
+{
+	AudioEqualizer *equalizer = (AudioEqualizer *)filter;
+	GstAudioFormat format = GST_AUDIO_INFO_FORMAT(info);
+	gboolean ret = TRUE;
+
+	if (format == GST_AUDIO_FORMAT_S16)
+	{
+		equalizer->format = AudioEqualizerS16;
+	}
+	else if (format == GST_AUDIO_FORMAT_S32)
+	{
+		equalizer->format = AudioEqualizerS32;
+	}
+	else if (format == GST_AUDIO_FORMAT_F32)
+	{
+		equalizer->format = AudioEqualizerF32;
+	}
+	else
+	{
+		ERROR_PRINTF("unsupported format(%s)\n", gst_audio_format_to_string(format));
+		ret = FALSE;
+	}
+
+	if (ret == TRUE)
+	{
+		/* a new stream starts on the selected preset and gain, there is nothing to ramp from */
+		equalizer->rate = (uint32_t)GST_AUDIO_INFO_RATE(info);
+		equalizer->channels = (uint32_t)GST_AUDIO_INFO_CHANNELS(info);
+		equalizer->preset = GetActivePreset();
+		equalizer->gain = equalizer->requestedGain;
+		equalizer->targetGain = equalizer->requestedGain;
+		equalizer->rampFrames = 0;
+		equalizer->rampDone = 0;
+		GetPresetBands(equalizer->preset, equalizer->bands);
+		DesignBands(equalizer);
+		AudioEqualizerReset(&equalizer->state);
+		gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(filter),
+										   ((equalizer->preset == (uint32_t)AudioEqualizerPresetFlat) &&
+											(equalizer->gain == 0.0f)) ? TRUE : FALSE);
+		DEBUG_PRINTF("rate(%u), channels(%u), format(%d), preset(%s), gain(%.1f dB)\n", equalizer->rate,
+					 equalizer->channels, equalizer->format, g_audioEqualizerPresetNames[equalizer->preset],
+					 equalizer->gain);
+	}
+
+	return ret;
+}
+
+/* ReplayGain tags of the stream take over from the gain the track started with */
+static gboolean EqualizerSinkEvent(GstBaseTransform *base, GstEvent *event)
+{
+	AudioEqualizer *equalizer = (AudioEqualizer *)base;
+
+	if (GST_EVENT_TYPE(event) == GST_EVENT_TAG)
+	{
+		GstTagList *tags = NULL;
+		float gain;
+
+		gst_event_parse_tag(event, &tags);
+		if (AudioLoudnessGetTagGain(tags, &gain) == 1)
+		{
+			DEBUG_PRINTF("replaygain(%.1f dB)\n", gain);
+			equalizer->requestedGain = gain;
+		}
+	}
+
+	return s_parentClass->sink_event(base, event);
+}
+
+static GstFlowReturn EqualizerTransformIp(GstBaseTransform *base, GstBuffer *buffer)
+{
+	AudioEqualizer *equalizer = (AudioEqualizer *)base;
+	uint32_t preset = GetActivePreset();
+	bool ramping;
+
+	if (((preset != equalizer->preset) || (equalizer->requestedGain != equalizer->targetGain)) &&
+		(equalizer->rate > 0U))
+	{
+		StartRamp(equalizer, preset, equalizer->requestedGain);
+	}
+	ramping = (equalizer->rampDone < equalizer->rampFrames);
+
+	if (gst_base_transform_is_passthrough(base) != FALSE)
+	{
+		if (ramping)
+		{
+			/* this buffer is not writable, the ramp starts with the next one from silent delays */
+			AudioEqualizerReset(&equalizer->state);
+			gst_base_transform_set_passthrough(base, FALSE);
+		}
+	}
+	else if ((!ramping) && (equalizer->preset == (uint32_t)AudioEqualizerPresetFlat) && (equalizer->gain == 0.0f))
+	{
+		gst_base_transform_set_passthrough(base, TRUE);
+	}
+	else
+	{
+		GstMapInfo map;
+
+		if (gst_buffer_map(buffer, &map, GST_MAP_READWRITE) != FALSE)
+		{
+			uint32_t bytesPerFrame = (uint32_t)GST_AUDIO_FILTER_BPF(&equalizer->parent);
+			uint32_t frames = (bytesPerFrame > 0U) ? (uint32_t)(map.size / bytesPerFrame) : 0U;
+			uint8_t *data = map.data;
+
+			while (frames > 0U)
+			{
+				uint32_t block = frames;
+
+				if (equalizer->rampDone < equalizer->rampFrames)
+				{
+					block = (frames < (uint32_t)EQUALIZER_RAMP_BLOCK) ? frames : (uint32_t)EQUALIZER_RAMP_BLOCK;
+					StepRamp(equalizer, block);
+				}
+
+				AudioEqualizerProcess(&equalizer->coefficients, &equalizer->state, data, block,
+									  equalizer->channels, equalizer->format);
+				data += (size_t)block * bytesPerFrame;
+				frames -= block;
+			}
+
+			gst_buffer_unmap(buffer, &map);
+		}
+		else
+		{
+			ERROR_PRINTF("gst_buffer_map failed\n");
+		}
+	}
+
+	return GST_FLOW_OK;
+}
+
+/* from the bands designed now, also when the last ramp did not end yet */
+static void StartRamp(AudioEqualizer *equalizer, uint32_t preset, float gain)
+{
+	DEBUG_PRINTF("preset(%s -> %s), gain(%.1f -> %.1f dB)\n", g_audioEqualizerPresetNames[equalizer->preset],
+				 g_audioEqualizerPresetNames[preset], equalizer->gain, gain);
+
+	(void)memcpy(equalizer->from, equalizer->bands, sizeof(equalizer->from));
+	equalizer->fromGain = equalizer->gain;
+	equalizer->preset = preset;
+	equalizer->targetGain = gain;
+	equalizer->rampFrames = (equalizer->rate * (uint32_t)AUDIO_EQUALIZER_RAMP) / 1000U;
+	equalizer->rampDone = 0;
+	if (equalizer->rampFrames == 0U)
+	{
+		equalizer->rampFrames = 1;
+	}
+}
+
+/* design the bands for the end of the next block, the last block reaches the preset */
+static void StepRamp(AudioEqualizer *equalizer, uint32_t frames)
+{
+	AudioEqualizerBand to[AUDIO_EQUALIZER_BANDS];
+	float position;
+	uint32_t idx;
+
+	equalizer->rampDone += frames;
+	if (equalizer->rampDone > equalizer->rampFrames)
+	{
+		equalizer->rampDone = equalizer->rampFrames;
+	}
+	position = (float)equalizer->rampDone / (float)equalizer->rampFrames;
+
+	GetPresetBands(equalizer->preset, to);
+	for (idx = 0; idx < (uint32_t)AUDIO_EQUALIZER_BANDS; idx++)
+	{
+		equalizer->bands[idx].gain = equalizer->from[idx].gain + ((to[idx].gain - equalizer->from[idx].gain) * position);
+	}
+	equalizer->gain = equalizer->fromGain + ((equalizer->targetGain - equalizer->fromGain) * position);
+
+	DesignBands(equalizer);
+}
+
+/* the gain scales the numerator of the first band, the cascade is linear so it costs nothing more */
+static void DesignBands(AudioEqualizer *equalizer)
+{
+	float scale = powf(10.0f, equalizer->gain / 20.0f);
+
+	AudioEqualizerDesign(equalizer->bands, AUDIO_EQUALIZER_BANDS, equalizer->rate, &equalizer->coefficients);
+	equalizer->coefficients.b0[0] *= scale;
+	equalizer->coefficients.b1[0] *= scale;
+	equalizer->coefficients.b2[0] *= scale;
+}
+
+/* --no-equalizer keeps the bands flat, the element then only applies the gain */
+static uint32_t GetActivePreset(void)
+{
+	return s_enabled ? AudioEqualizerGetPreset() : (uint32_t)AudioEqualizerPresetFlat;
+}
+
+static void GetPresetBands(uint32_t preset, AudioEqualizerBand *bands)
+{
+	uint32_t idx;
+
+	(void)memcpy(bands, s_layout, sizeof(s_layout));
+	for (idx = 0; idx < (uint32_t)AUDIO_EQUALIZER_BANDS; idx++)
+	{
+		bands[idx].gain = s_presetGains[preset][idx];
+	}
+}
@@ -0,0 +1,439 @@
+/****************************************************************************************
+ *   FileName    : AudioEqualizerKernel.c
+ *   Description : Telechips Audio Equalizer Kernel
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "AudioEqualizerKernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AUDIO_EQUALIZER_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define AUDIO_EQUALIZER_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define AUDIO_EQUALIZER_NEON
+#endif
+
+/*
+ * The bands are a cascade of biquads, so band b needs the output of band
+ * b - 1 for the same sample and no two bands of one sample can run together.
+ * The vector kernels skew the cascade instead: lane b filters sample t - b
+ * while lane 0 takes sample t, and the output of every lane moves one lane
+ * up for the next step. Sample t leaves lane 7 at step t + 7 and is written
+ * back, behind the samples still being read.
+ *
+ * The first and last 7 steps of a buffer have lanes without a sample; they
+ * run lane by lane, so every band filters exactly the samples of the buffer
+ * and only the delays carry over to the next one.
+ */
+#define EQUALIZER_SKEW				(AUDIO_EQUALIZER_BANDS - 1)
+#define EQUALIZER_DENORMAL			1e-20f
+
+static void ProcessChannel(const AudioEqualizerCoefficients *coefficients, float *z1, float *z2,
+						   void *data, uint32_t frames, uint32_t channels, AudioEqualizerFormat format);
+static void StepLanes(const AudioEqualizerCoefficients *coefficients, float *z1, float *z2, float *y,
+					  float in, uint32_t first, uint32_t last);
+static void StepVector(const AudioEqualizerCoefficients *coefficients, float *z1, float *z2, float *y,
+					   void *data, uint32_t start, uint32_t end, uint32_t channels, AudioEqualizerFormat format);
+static void FlushDenormals(float *z, uint32_t count);
+static void *GetChannel(void *data, uint32_t channel, AudioEqualizerFormat format);
+static inline float LoadSample(const void *data, uint32_t index, AudioEqualizerFormat format);
+static inline void StoreSample(void *data, uint32_t index, AudioEqualizerFormat format, float sample);
+
+void AudioEqualizerDesign(const AudioEqualizerBand *bands, uint32_t count, uint32_t rate,
+						  AudioEqualizerCoefficients *coefficients)
+{
+	uint32_t idx;
+
+	for (idx = 0; idx < (uint32_t)AUDIO_EQUALIZER_BANDS; idx++)
+	{
+		double b0 = 1.0;
+		double b1 = 0.0;
+		double b2 = 0.0;
+		double a0 = 1.0;
+		double a1 = 0.0;
+		double a2 = 0.0;
+
+		/* Audio EQ Cookbook, R. Bristow-Johnson. At 0 dB b equals a, so the band passes the signal unchanged */
+		if ((idx < count) && (rate > 0U) && (bands[idx].q > 0.0f))
+		{
+			const AudioEqualizerBand *band = &bands[idx];
+			double nyquist = (double)rate * 0.49;
+			double frequency = ((double)band->frequency < nyquist) ? (double)band->frequency : nyquist;
+			double w0 = (2.0 * M_PI * frequency) / (double)rate;
+			double cosW0 = cos(w0);
+			double alpha = sin(w0) / (2.0 * (double)band->q);
+			double A = pow(10.0, (double)band->gain / 40.0);
+			double beta = 2.0 * sqrt(A) * alpha;
+
+			if (band->type == (uint32_t)AudioEqualizerLowShelf)
+			{
+				b0 = A * ((A + 1.0) - ((A - 1.0) * cosW0) + beta);
+				b1 = 2.0 * A * ((A - 1.0) - ((A + 1.0) * cosW0));
+				b2 = A * ((A + 1.0) - ((A - 1.0) * cosW0) - beta);
+				a0 = (A + 1.0) + ((A - 1.0) * cosW0) + beta;
+				a1 = -2.0 * ((A - 1.0) + ((A + 1.0) * cosW0));
+				a2 = (A + 1.0) + ((A - 1.0) * cosW0) - beta;
+			}
+			else if (band->type == (uint32_t)AudioEqualizerHighShelf)
+			{
+				b0 = A * ((A + 1.0) + ((A - 1.0) * cosW0) + beta);
+				b1 = -2.0 * A * ((A - 1.0) + ((A + 1.0) * cosW0));
+				b2 = A * ((A + 1.0) + ((A - 1.0) * cosW0) - beta);
+				a0 = (A + 1.0) - ((A - 1.0) * cosW0) + beta;
+				a1 = 2.0 * ((A - 1.0) - ((A + 1.0) * cosW0));
+				a2 = (A + 1.0) - ((A - 1.0) * cosW0) - beta;
+			}
+			else
+			{
+				b0 = 1.0 + (alpha * A);
+				b1 = -2.0 * cosW0;
+				b2 = 1.0 - (alpha * A);
+				a0 = 1.0 + (alpha / A);
+				a1 = -2.0 * cosW0;
+				a2 = 1.0 - (alpha / A);
+			}
+		}
+
+		coefficients->b0[idx] = (float)(b0 / a0);
+		coefficients->b1[idx] = (float)(b1 / a0);
+		coefficients->b2[idx] = (float)(b2 / a0);
+		coefficients->a1[idx] = (float)(a1 / a0);
+		coefficients->a2[idx] = (float)(a2 / a0);
+	}
+}
+
+void AudioEqualizerReset(AudioEqualizerState *state)
+{
+	(void)memset(state, 0, sizeof(*state));
+}
+
+void AudioEqualizerProcess(const AudioEqualizerCoefficients *coefficients, AudioEqualizerState *state,
+						   void *data, uint32_t frames, uint32_t channels, AudioEqualizerFormat format)
+{
+	uint32_t channel;
+
+	for (channel = 0; (channel < channels) && (channel < (uint32_t)AUDIO_EQUALIZER_CHANNELS); channel++)
+	{
+		ProcessChannel(coefficients, state->z1[channel], state->z2[channel], GetChannel(data, channel, format),
+					   frames, channels, format);
+		FlushDenormals(state->z1[channel], AUDIO_EQUALIZER_BANDS);
+		FlushDenormals(state->z2[channel], AUDIO_EQUALIZER_BANDS);
+	}
+}
+
+void AudioEqualizerProcessReference(const AudioEqualizerCoefficients *coefficients, AudioEqualizerState *state,
+									void *data, uint32_t frames, uint32_t channels, AudioEqualizerFormat format)
+{
+	uint32_t channel;
+	uint32_t frame;
+	uint32_t band;
+
+	for (channel = 0; (channel < channels) && (channel < (uint32_t)AUDIO_EQUALIZER_CHANNELS); channel++)
+	{
+		float *z1 = state->z1[channel];
+		float *z2 = state->z2[channel];
+
+		for (frame = 0; frame < frames; frame++)
+		{
+			uint32_t index = (frame * channels) + channel;
+			float x = LoadSample(data, index, format);
+
+			for (band = 0; band < (uint32_t)AUDIO_EQUALIZER_BANDS; band++)
+			{
+				float y = (coefficients->b0[band] * x) + z1[band];
+				z1[band] = ((coefficients->b1[band] * x) - (coefficients->a1[band] * y)) + z2[band];
+				z2[band] = (coefficients->b2[band] * x) - (coefficients->a2[band] * y);
+				x = y;
+			}
+
+			StoreSample(data, index, format, x);
+		}
+
+		FlushDenormals(z1, AUDIO_EQUALIZER_BANDS);
+		FlushDenormals(z2, AUDIO_EQUALIZER_BANDS);
+	}
+}
+
+const char *AudioEqualizerGetKernelName(void)
+{
+#if defined(AUDIO_EQUALIZER_AVX2)
+	return "avx2";
+#elif defined(AUDIO_EQUALIZER_SSE2)
+	return "sse2";
+#elif defined(AUDIO_EQUALIZER_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+static void ProcessChannel(const AudioEqualizerCoefficients *coefficients, float *z1, float *z2,
+						   void *data, uint32_t frames, uint32_t channels, AudioEqualizerFormat format)
+{
+	float y[AUDIO_EQUALIZER_BANDS];
+	uint32_t steps = frames + (uint32_t)EQUALIZER_SKEW;
+	uint32_t full = (frames > (uint32_t)EQUALIZER_SKEW) ? frames : (uint32_t)EQUALIZER_SKEW;
+	uint32_t step;
+
+	(void)memset(y, 0, sizeof(y));
+
+	/* lane b has a sample at step t while b <= t < frames + b */
+	for (step = 0; step < steps; step++)
+	{
+		if (step == (uint32_t)EQUALIZER_SKEW)
+		{
+			StepVector(coefficients, z1, z2, y, data, step, full, channels, format);
+			step = full;
+		}
+
+		if (step < steps)
+		{
+			uint32_t first = (step >= frames) ? ((step - frames) + 1U) : 0U;
+			uint32_t last = (step < (uint32_t)EQUALIZER_SKEW) ? step : (uint32_t)EQUALIZER_SKEW;
+			float in = (step < frames) ? LoadSample(data, (step * channels), format) : 0.0f;
+
+			StepLanes(coefficients, z1, z2, y, in, first, last);
+			if ((step >= (uint32_t)EQUALIZER_SKEW) && (first <= (uint32_t)EQUALIZER_SKEW))
+			{
+				StoreSample(data, ((step - (uint32_t)EQUALIZER_SKEW) * channels), format, y[EQUALIZER_SKEW]);
+			}
+		}
+	}
+}
+
+/* one step of lanes first to last, which take the output of the lane below from the last step */
+static void StepLanes(const AudioEqualizerCoefficients *coefficients, float *z1, float *z2, float *y,
+					  float in, uint32_t first, uint32_t last)
+{
+	uint32_t lane = last + 1U;
+
+	while (lane > first)
+	{
+		float x;
+		float out;
+
+		lane--;
+		x = (lane == 0U) ? in : y[lane - 1U];
+		out = (coefficients->b0[lane] * x) + z1[lane];
+		z1[lane] = ((coefficients->b1[lane] * x) - (coefficients->a1[lane] * out)) + z2[lane];
+		z2[lane] = (coefficients->b2[lane] * x) - (coefficients->a2[lane] * out);
+		y[lane] = out;
+	}
+}
+
+/* steps start to end - 1, where every lane has a sample */
+static void StepVector(const AudioEqualizerCoefficients *coefficients, float *z1, float *z2, float *y,
+					   void *data, uint32_t start, uint32_t end, uint32_t channels, AudioEqualizerFormat format)
+{
+	uint32_t step = start;
+
+#if defined(AUDIO_EQUALIZER_AVX2)
+	const __m256i up = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+	const __m256 b0 = _mm256_loadu_ps(coefficients->b0);
+	const __m256 b1 = _mm256_loadu_ps(coefficients->b1);
+	const __m256 b2 = _mm256_loadu_ps(coefficients->b2);
+	const __m256 a1 = _mm256_loadu_ps(coefficients->a1);
+	const __m256 a2 = _mm256_loadu_ps(coefficients->a2);
+	__m256 s1 = _mm256_loadu_ps(z1);
+	__m256 s2 = _mm256_loadu_ps(z2);
+	__m256 out = _mm256_loadu_ps(y);
+
+	for (; step < end; step++)
+	{
+		__m256 in = _mm256_set1_ps(LoadSample(data, (step * channels), format));
+		__m256 x = _mm256_blend_ps(_mm256_permutevar8x32_ps(out, up), in, 0x01);
+		__m128 top;
+
+		out = _mm256_add_ps(_mm256_mul_ps(b0, x), s1);
+		s1 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(b1, x), _mm256_mul_ps(a1, out)), s2);
+		s2 = _mm256_sub_ps(_mm256_mul_ps(b2, x), _mm256_mul_ps(a2, out));
+
+		top = _mm256_extractf128_ps(out, 1);
+		StoreSample(data, ((step - (uint32_t)EQUALIZER_SKEW) * channels), format,
+					_mm_cvtss_f32(_mm_shuffle_ps(top, top, _MM_SHUFFLE(3, 3, 3, 3))));
+	}
+
+	_mm256_storeu_ps(z1, s1);
+	_mm256_storeu_ps(z2, s2);
+	_mm256_storeu_ps(y, out);
+#elif defined(AUDIO_EQUALIZER_SSE2)
+	/* lanes 0-3 in lo, 4-7 in hi */
+	const __m128 b0lo = _mm_loadu_ps(&coefficients->b0[0]);
+	const __m128 b0hi = _mm_loadu_ps(&coefficients->b0[4]);
+	const __m128 b1lo = _mm_loadu_ps(&coefficients->b1[0]);
+	const __m128 b1hi = _mm_loadu_ps(&coefficients->b1[4]);
+	const __m128 b2lo = _mm_loadu_ps(&coefficients->b2[0]);
+	const __m128 b2hi = _mm_loadu_ps(&coefficients->b2[4]);
+	const __m128 a1lo = _mm_loadu_ps(&coefficients->a1[0]);
+	const __m128 a1hi = _mm_loadu_ps(&coefficients->a1[4]);
+	const __m128 a2lo = _mm_loadu_ps(&coefficients->a2[0]);
+	const __m128 a2hi = _mm_loadu_ps(&coefficients->a2[4]);
+	__m128 s1lo = _mm_loadu_ps(&z1[0]);
+	__m128 s1hi = _mm_loadu_ps(&z1[4]);
+	__m128 s2lo = _mm_loadu_ps(&z2[0]);
+	__m128 s2hi = _mm_loadu_ps(&z2[4]);
+	__m128 outlo = _mm_loadu_ps(&y[0]);
+	__m128 outhi = _mm_loadu_ps(&y[4]);
+
+	for (; step < end; step++)
+	{
+		__m128 in = _mm_set_ss(LoadSample(data, (step * channels), format));
+		__m128 carry = _mm_shuffle_ps(outlo, outlo, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 xlo = _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(outlo), 4)), in);
+		__m128 xhi = _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(outhi), 4)), carry);
+
+		outlo = _mm_add_ps(_mm_mul_ps(b0lo, xlo), s1lo);
+		outhi = _mm_add_ps(_mm_mul_ps(b0hi, xhi), s1hi);
+		s1lo = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1lo, xlo), _mm_mul_ps(a1lo, outlo)), s2lo);
+		s1hi = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1hi, xhi), _mm_mul_ps(a1hi, outhi)), s2hi);
+		s2lo = _mm_sub_ps(_mm_mul_ps(b2lo, xlo), _mm_mul_ps(a2lo, outlo));
+		s2hi = _mm_sub_ps(_mm_mul_ps(b2hi, xhi), _mm_mul_ps(a2hi, outhi));
+
+		StoreSample(data, ((step - (uint32_t)EQUALIZER_SKEW) * channels), format,
+					_mm_cvtss_f32(_mm_shuffle_ps(outhi, outhi, _MM_SHUFFLE(3, 3, 3, 3))));
+	}
+
+	_mm_storeu_ps(&z1[0], s1lo);
+	_mm_storeu_ps(&z1[4], s1hi);
+	_mm_storeu_ps(&z2[0], s2lo);
+	_mm_storeu_ps(&z2[4], s2hi);
+	_mm_storeu_ps(&y[0], outlo);
+	_mm_storeu_ps(&y[4], outhi);
+#elif defined(AUDIO_EQUALIZER_NEON)
+	const float32x4_t b0lo = vld1q_f32(&coefficients->b0[0]);
+	const float32x4_t b0hi = vld1q_f32(&coefficients->b0[4]);
+	const float32x4_t b1lo = vld1q_f32(&coefficients->b1[0]);
+	const float32x4_t b1hi = vld1q_f32(&coefficients->b1[4]);
+	const float32x4_t b2lo = vld1q_f32(&coefficients->b2[0]);
+	const float32x4_t b2hi = vld1q_f32(&coefficients->b2[4]);
+	const float32x4_t a1lo = vld1q_f32(&coefficients->a1[0]);
+	const float32x4_t a1hi = vld1q_f32(&coefficients->a1[4]);
+	const float32x4_t a2lo = vld1q_f32(&coefficients->a2[0]);
+	const float32x4_t a2hi = vld1q_f32(&coefficients->a2[4]);
+	float32x4_t s1lo = vld1q_f32(&z1[0]);
+	float32x4_t s1hi = vld1q_f32(&z1[4]);
+	float32x4_t s2lo = vld1q_f32(&z2[0]);
+	float32x4_t s2hi = vld1q_f32(&z2[4]);
+	float32x4_t outlo = vld1q_f32(&y[0]);
+	float32x4_t outhi = vld1q_f32(&y[4]);
+
+	for (; step < end; step++)
+	{
+		float32x4_t in = vdupq_n_f32(LoadSample(data, (step * channels), format));
+		float32x4_t xlo = vextq_f32(in, outlo, 3);
+		float32x4_t xhi = vextq_f32(outlo, outhi, 3);
+
+		/* separate multiply and add, as the reference */
+		outlo = vaddq_f32(vmulq_f32(b0lo, xlo), s1lo);
+		outhi = vaddq_f32(vmulq_f32(b0hi, xhi), s1hi);
+		s1lo = vaddq_f32(vsubq_f32(vmulq_f32(b1lo, xlo), vmulq_f32(a1lo, outlo)), s2lo);
+		s1hi = vaddq_f32(vsubq_f32(vmulq_f32(b1hi, xhi), vmulq_f32(a1hi, outhi)), s2hi);
+		s2lo = vsubq_f32(vmulq_f32(b2lo, xlo), vmulq_f32(a2lo, outlo));
+		s2hi = vsubq_f32(vmulq_f32(b2hi, xhi), vmulq_f32(a2hi, outhi));
+
+		StoreSample(data, ((step - (uint32_t)EQUALIZER_SKEW) * channels), format, vgetq_lane_f32(outhi, 3));
+	}
+
+	vst1q_f32(&z1[0], s1lo);
+	vst1q_f32(&z1[4], s1hi);
+	vst1q_f32(&z2[0], s2lo);
+	vst1q_f32(&z2[4], s2hi);
+	vst1q_f32(&y[0], outlo);
+	vst1q_f32(&y[4], outhi);
+#endif
+
+	for (; step < end; step++)
+	{
+		StepLanes(coefficients, z1, z2, y, LoadSample(data, (step * channels), format), 0U, (uint32_t)EQUALIZER_SKEW);
+		StoreSample(data, ((step - (uint32_t)EQUALIZER_SKEW) * channels), format, y[EQUALIZER_SKEW]);
+	}
+}
+
+/* first sample of the channel, the kernels step over the frames from there */
+static void *GetChannel(void *data, uint32_t channel, AudioEqualizerFormat format)
+{
+	size_t size = (format == AudioEqualizerS16) ? sizeof(int16_t) :
+				  ((format == AudioEqualizerS32) ? sizeof(int32_t) : sizeof(float));
+
+	return (uint8_t *)data + ((size_t)channel * size);
+}
+
+/* a decaying filter fed with silence would otherwise run on denormals */
+static void FlushDenormals(float *z, uint32_t count)
+{
+	uint32_t idx;
+
+	for (idx = 0; idx < count; idx++)
+	{
+		if (fabsf(z[idx]) < EQUALIZER_DENORMAL)
+		{
+			z[idx] = 0.0f;
+		}
+	}
+}
+
+static inline float LoadSample(const void *data, uint32_t index, AudioEqualizerFormat format)
+{
+	float sample;
+
+	if (format == AudioEqualizerS16)
+	{
+		sample = (float)((const int16_t *)data)[index] * (1.0f / 32768.0f);
+	}
+	else if (format == AudioEqualizerS32)
+	{
+		sample = (float)((const int32_t *)data)[index] * (1.0f / 2147483648.0f);
+	}
+	else
+	{
+		sample = ((const float *)data)[index];
+	}
+
+	return sample;
+}
+
+static inline void StoreSample(void *data, uint32_t index, AudioEqualizerFormat format, float sample)
+{
+	if (format == AudioEqualizerS16)
+	{
+		float scaled = sample * 32768.0f;
+		((int16_t *)data)[index] = (scaled >= 32767.0f) ? (int16_t)32767 :
+								   ((scaled <= -32768.0f) ? (int16_t)-32768 : (int16_t)lrintf(scaled));
+	}
+	else if (format == AudioEqualizerS32)
+	{
+		/* 2^31 is not exact in float, clip a little below it */
+		float scaled = sample * 2147483648.0f;
+		((int32_t *)data)[index] = (scaled >= 2147483520.0f) ? (int32_t)2147483520 :
+								   ((scaled <= -2147483648.0f) ? INT32_MIN : (int32_t)lrintf(scaled));
+	}
+	else
+	{
+		((float *)data)[index] = sample;
+	}
+}
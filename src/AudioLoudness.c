@@ -0,0 +1,839 @@
+/****************************************************************************************
+ *   FileName    : AudioLoudness.c
+ *   Description : Telechips Audio Loudness Normalization
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+#include "TCLog.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MultiMediaState.h"
+#include "MediaLibrary.h"
+#include "TCTime.h"
+#include "AudioLoudnessKernel.h"
+#include "AudioLoudness.h"
+
+#define LOUDNESS_PIPELINE			"uridecodebin name=src caps=audio/x-raw ! audioconvert ! " \
+									"audio/x-raw,format=" GST_AUDIO_NE(F32) ",layout=interleaved,channels=[1,2] ! " \
+									"fakesink name=sink sync=false signal-handoffs=true"
+#define LOUDNESS_POLL_INTERVAL		(100 * GST_MSECOND)		/* how soon a release stops an analysis */
+#define LOUDNESS_REFERENCE_LEVEL	(89.0)					/* dB SPL of ReplayGain without a reference tag */
+#define LOUDNESS_SPL_TO_LUFS		(-107.0)				/* 89 dB SPL is -18 LUFS */
+#define LOUDNESS_MIN_TARGET			(-40.0f)
+#define LOUDNESS_MAX_TARGET			(0.0f)
+#define LOUDNESS_PATH_SIZE			4096
+
+/* not in glibc, from linux/ioprio.h */
+#define LOUDNESS_IOPRIO_WHO_PROCESS	1
+#define LOUDNESS_IOPRIO_CLASS_NONE	0
+#define LOUDNESS_IOPRIO_CLASS_IDLE	3
+#define LOUDNESS_IOPRIO_CLASS_SHIFT	13
+
+typedef struct stLoudnessAnalysis {
+	AudioLoudnessMeter meter;
+	bool started;							/* the meter knows rate and channels */
+	uint32_t paceFrames;					/* measured since paceStart */
+	int64_t paceStart;
+	MultiMediaState state;
+} LoudnessAnalysis;
+
+static float GetGain(float loudness, float peak);
+static bool GetTagLoudness(const GstTagList *tags, float *loudness, float *peak);
+static bool GetFileKey(const char *path, AudioLoudnessRecord *record);
+static uint64_t HashPath(const char *path);
+static bool FindRecord(AudioLoudnessRecord *record);
+static void StoreRecord(const AudioLoudnessRecord *record);
+static void LoadCache(void);
+static int32_t WriteCache(void);
+static bool WriteAll(int32_t fd, const void *buffer, size_t length);
+static void QueueFile(const char *path);
+static void *AnalysisThread(void *arg);
+static void AnalyzeFile(const char *path);
+static void MeasureFile(const char *path, LoudnessAnalysis *analysis, AudioLoudnessRecord *record);
+static GstBusSyncReply OnAnalysisSyncMessage(GstBus *bus, GstMessage *msg, gpointer data);
+static void OnAnalysisHandoff(GstElement *sink, GstBuffer *buffer, GstPad *pad, gpointer data);
+static void PaceAnalysis(LoudnessAnalysis *analysis, uint32_t frames);
+static void SetIdlePriority(bool idle);
+
+static bool s_enabled = true;
+static float s_target = AUDIO_LOUDNESS_DEFAULT_TARGET;
+
+static char *s_cacheFile = NULL;
+static int32_t s_cacheFd = -1;					/* appended by the worker */
+static GHashTable *s_cache = NULL;				/* pathHash to AudioLoudnessRecord, guarded by s_mutex */
+
+static pthread_mutex_t s_mutex;
+static pthread_cond_t s_cond;
+static pthread_t s_thread;
+static bool s_threadRun = false;
+static char *s_queue[AUDIO_LOUDNESS_QUEUE_SIZE];	/* played tracks, measured before the library */
+static uint32_t s_queueHead = 0;
+static uint32_t s_queueCount = 0;
+static bool s_libraryPass = false;
+static uint32_t s_libraryPosition = 0;
+
+void AudioLoudnessDisable(void)
+{
+	s_enabled = false;
+}
+
+bool AudioLoudnessIsEnabled(void)
+{
+	return s_enabled;
+}
+
+int32_t AudioLoudnessSetTarget(const char *target)
+{
+	int32_t ret = 0;
+	char *end = NULL;
+	float value = (target != NULL) ? strtof(target, &end) : 0.0f;
+
+	if ((end != NULL) && (end != target) && (*end == '\0') &&
+		(value >= LOUDNESS_MIN_TARGET) && (value <= LOUDNESS_MAX_TARGET))
+	{
+		s_target = value;
+		ret = 1;
+	}
+	else
+	{
+		ERROR_PRINTF("invalid loudness target(%s), range(%.0f ~ %.0f LUFS)\n", (target != NULL) ? target : "null",
+					 LOUDNESS_MIN_TARGET, LOUDNESS_MAX_TARGET);
+	}
+
+	return ret;
+}
+
+int32_t AudioLoudnessInitialize(const char *cacheDir)
+{
+	int32_t ret = 1;
+	int32_t err;
+
+	if (s_enabled)
+	{
+		ret = 0;
+		if (cacheDir == NULL)
+		{
+			cacheDir = MEDIA_LIBRARY_DEFAULT_INDEX_DIR;
+		}
+
+		if ((mkdir(cacheDir, 0755) != 0) && (errno != EEXIST))
+		{
+			WARN_PRINTF("mkdir(%s) failed: error(%d)\n", cacheDir, errno);
+		}
+
+		s_cacheFile = g_strdup_printf("%s/%s", cacheDir, AUDIO_LOUDNESS_CACHE_FILE);
+		s_cache = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, free);
+		LoadCache();
+
+		(void)pthread_mutex_init(&s_mutex, NULL);
+		(void)pthread_cond_init(&s_cond, NULL);
+		s_threadRun = true;
+		err = pthread_create(&s_thread, NULL, AnalysisThread, NULL);
+		if (err == 0)
+		{
+			INFO_PRINTF("target(%.1f LUFS), %u cached track(s), kernel(%s)\n", s_target,
+						g_hash_table_size(s_cache), AudioLoudnessGetKernelName());
+			ret = 1;
+		}
+		else
+		{
+			ERROR_PRINTF("pthread_create failed: error(%d)\n", err);
+			s_threadRun = false;
+			(void)pthread_cond_destroy(&s_cond);
+			(void)pthread_mutex_destroy(&s_mutex);
+		}
+	}
+
+	return ret;
+}
+
+void AudioLoudnessRelease(void)
+{
+	if (s_threadRun)
+	{
+		(void)pthread_mutex_lock(&s_mutex);
+		__atomic_store_n(&s_threadRun, false, __ATOMIC_RELAXED);
+		(void)pthread_cond_signal(&s_cond);
+		(void)pthread_mutex_unlock(&s_mutex);
+		(void)pthread_join(s_thread, NULL);
+
+		while (s_queueCount > 0U)
+		{
+			free(s_queue[s_queueHead]);
+			s_queueHead = (s_queueHead + 1U) % (uint32_t)AUDIO_LOUDNESS_QUEUE_SIZE;
+			s_queueCount--;
+		}
+
+		(void)pthread_cond_destroy(&s_cond);
+		(void)pthread_mutex_destroy(&s_mutex);
+	}
+
+	if (s_cacheFd >= 0)
+	{
+		(void)close(s_cacheFd);
+		s_cacheFd = -1;
+	}
+
+	if (s_cache != NULL)
+	{
+		g_hash_table_destroy(s_cache);
+		s_cache = NULL;
+	}
+
+	g_free(s_cacheFile);
+	s_cacheFile = NULL;
+}
+
+float AudioLoudnessGetGain(const char *path)
+{
+	float gain = 0.0f;
+	AudioLoudnessRecord record;
+
+	if (s_threadRun && (path != NULL))
+	{
+		if (strncmp(path, "file://", 7) == 0)
+		{
+			path = &path[7];
+		}
+
+		if (GetFileKey(path, &record))
+		{
+			if (FindRecord(&record))
+			{
+				if (record.source != (uint32_t)AudioLoudnessFailed)
+				{
+					gain = GetGain(record.loudness, record.peak);
+				}
+				DEBUG_PRINTF("%s: loudness(%.1f LUFS), peak(%.3f), gain(%.1f dB)\n", path, record.loudness,
+							 record.peak, gain);
+			}
+			else
+			{
+				QueueFile(path);
+			}
+		}
+	}
+
+	return gain;
+}
+
+int32_t AudioLoudnessGetTagGain(const GstTagList *tags, float *gain)
+{
+	int32_t ret = 0;
+	float loudness;
+	float peak;
+
+	if (s_enabled && (tags != NULL) && GetTagLoudness(tags, &loudness, &peak))
+	{
+		*gain = GetGain(loudness, peak);
+		ret = 1;
+	}
+
+	return ret;
+}
+
+void AudioLoudnessAnalyzeLibrary(void)
+{
+	if (s_threadRun)
+	{
+		(void)pthread_mutex_lock(&s_mutex);
+		s_libraryPass = true;
+		s_libraryPosition = 0;
+		(void)pthread_cond_signal(&s_cond);
+		(void)pthread_mutex_unlock(&s_mutex);
+	}
+}
+
+/* to the target, and no louder than the peak allows */
+static float GetGain(float loudness, float peak)
+{
+	float gain = s_target - loudness;
+
+	if (gain > AUDIO_LOUDNESS_MAX_BOOST)
+	{
+		gain = AUDIO_LOUDNESS_MAX_BOOST;
+	}
+	else if (gain < AUDIO_LOUDNESS_MAX_CUT)
+	{
+		gain = AUDIO_LOUDNESS_MAX_CUT;
+	}
+	else
+	{
+		;
+	}
+
+	if ((gain > 0.0f) && (peak > 0.0f))
+	{
+		float headroom = -20.0f * log10f(peak);
+
+		if (gain > headroom)
+		{
+			gain = (headroom > 0.0f) ? headroom : 0.0f;
+		}
+	}
+
+	return gain;
+}
+
+static bool GetTagLoudness(const GstTagList *tags, float *loudness, float *peak)
+{
+	bool ret = false;
+	gdouble trackGain = 0.0;
+	gdouble trackPeak = 0.0;
+	gdouble reference = LOUDNESS_REFERENCE_LEVEL;
+
+	if (gst_tag_list_get_double(tags, GST_TAG_TRACK_GAIN, &trackGain))
+	{
+		(void)gst_tag_list_get_double(tags, GST_TAG_REFERENCE_LEVEL, &reference);
+		(void)gst_tag_list_get_double(tags, GST_TAG_TRACK_PEAK, &trackPeak);
+		*loudness = (float)((reference + LOUDNESS_SPL_TO_LUFS) - trackGain);
+		*peak = (float)trackPeak;
+		ret = true;
+	}
+
+	return ret;
+}
+
+static bool GetFileKey(const char *path, AudioLoudnessRecord *record)
+{
+	bool ret = false;
+	struct stat st;
+
+	(void)memset(record, 0, sizeof(AudioLoudnessRecord));
+	if (stat(path, &st) == 0)
+	{
+		record->pathHash = HashPath(path);
+		record->size = (uint64_t)st.st_size;
+		record->mtime = (int64_t)st.st_mtime;
+		ret = true;
+	}
+
+	return ret;
+}
+
+static uint64_t HashPath(const char *path)
+{
+	/* FNV-1a, 64 bit so the hash alone names the path */
+	uint64_t hash = 14695981039346656037ULL;
+
+	while (*path != '\0')
+	{
+		hash ^= (uint8_t)*path;
+		hash *= 1099511628211ULL;
+		path++;
+	}
+
+	return hash;
+}
+
+/* fills the record whose key matches, a changed file does not match */
+static bool FindRecord(AudioLoudnessRecord *record)
+{
+	bool ret = false;
+	const AudioLoudnessRecord *cached;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	cached = (const AudioLoudnessRecord *)g_hash_table_lookup(s_cache, &record->pathHash);
+	if ((cached != NULL) && (cached->size == record->size) && (cached->mtime == record->mtime))
+	{
+		(void)memcpy(record, cached, sizeof(AudioLoudnessRecord));
+		ret = true;
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return ret;
+}
+
+static void StoreRecord(const AudioLoudnessRecord *record)
+{
+	AudioLoudnessRecord *cached = (AudioLoudnessRecord *)malloc(sizeof(AudioLoudnessRecord));
+
+	if (cached != NULL)
+	{
+		(void)memcpy(cached, record, sizeof(AudioLoudnessRecord));
+		(void)pthread_mutex_lock(&s_mutex);
+		g_hash_table_replace(s_cache, &cached->pathHash, cached);
+		(void)pthread_mutex_unlock(&s_mutex);
+	}
+
+	if ((s_cacheFd >= 0) && (!WriteAll(s_cacheFd, record, sizeof(AudioLoudnessRecord))))
+	{
+		ERROR_PRINTF("write(%s) failed: error(%d)\n", s_cacheFile, errno);
+	}
+}
+
+/* called before the worker runs, so the table needs no lock */
+static void LoadCache(void)
+{
+	AudioLoudnessCacheHeader header;
+	AudioLoudnessRecord record;
+	uint32_t count = 0;
+	bool compact = true;
+	int32_t fd = open(s_cacheFile, O_RDONLY | O_CLOEXEC);
+
+	if (fd >= 0)
+	{
+		if ((read(fd, &header, sizeof(header)) == (ssize_t)sizeof(header)) &&
+			(memcmp(header.magic, AUDIO_LOUDNESS_CACHE_MAGIC, sizeof(header.magic)) == 0) &&
+			(header.recordSize == (uint32_t)sizeof(AudioLoudnessRecord)))
+		{
+			ssize_t length;
+
+			while ((length = read(fd, &record, sizeof(record))) == (ssize_t)sizeof(record))
+			{
+				AudioLoudnessRecord *cached = (AudioLoudnessRecord *)malloc(sizeof(AudioLoudnessRecord));
+
+				if (cached != NULL)
+				{
+					(void)memcpy(cached, &record, sizeof(AudioLoudnessRecord));
+					g_hash_table_replace(s_cache, &cached->pathHash, cached);
+				}
+				count++;
+			}
+
+			/* records of the same path again, or a record cut short by a crash */
+			compact = (length != 0) || (count != g_hash_table_size(s_cache));
+		}
+		else
+		{
+			WARN_PRINTF("%s is not a loudness cache, it is rewritten\n", s_cacheFile);
+		}
+		(void)close(fd);
+	}
+
+	if ((!compact) || (WriteCache() == 0))
+	{
+		s_cacheFd = open(s_cacheFile, O_WRONLY | O_APPEND | O_CLOEXEC);
+		if (s_cacheFd < 0)
+		{
+			ERROR_PRINTF("open(%s) failed: error(%d)\n", s_cacheFile, errno);
+		}
+	}
+}
+
+/* written to a temporary file and renamed, a crash leaves the old or the new cache */
+static int32_t WriteCache(void)
+{
+	int32_t ret = -1;
+	char *tempFile = g_strdup_printf("%s.tmp", s_cacheFile);
+	int32_t fd = open(tempFile, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+	if (fd >= 0)
+	{
+		AudioLoudnessCacheHeader header;
+		GHashTableIter iter;
+		gpointer value;
+		bool written;
+
+		(void)memset(&header, 0, sizeof(header));
+		(void)memcpy(header.magic, AUDIO_LOUDNESS_CACHE_MAGIC, sizeof(header.magic));
+		header.recordSize = (uint32_t)sizeof(AudioLoudnessRecord);
+		written = WriteAll(fd, &header, sizeof(header));
+
+		g_hash_table_iter_init(&iter, s_cache);
+		while (written && (g_hash_table_iter_next(&iter, NULL, &value) != FALSE))
+		{
+			written = WriteAll(fd, value, sizeof(AudioLoudnessRecord));
+		}
+		(void)close(fd);
+
+		if (written && (rename(tempFile, s_cacheFile) == 0))
+		{
+			ret = 0;
+		}
+		else
+		{
+			ERROR_PRINTF("write(%s) failed: error(%d)\n", tempFile, errno);
+			(void)unlink(tempFile);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("open(%s) failed: error(%d)\n", tempFile, errno);
+	}
+	g_free(tempFile);
+
+	return ret;
+}
+
+static bool WriteAll(int32_t fd, const void *buffer, size_t length)
+{
+	const uint8_t *data = (const uint8_t *)buffer;
+	bool ret = true;
+
+	while ((length > 0U) && ret)
+	{
+		ssize_t written = write(fd, data, length);
+
+		if (written > 0)
+		{
+			data += written;
+			length -= (size_t)written;
+		}
+		else if ((written < 0) && (errno == EINTR))
+		{
+			;
+		}
+		else
+		{
+			ret = false;
+		}
+	}
+
+	return ret;
+}
+
+/* the oldest request is dropped when the queue is full, the track is queued again when played again */
+static void QueueFile(const char *path)
+{
+	char *copy = strdup(path);
+
+	if (copy != NULL)
+	{
+		(void)pthread_mutex_lock(&s_mutex);
+		if (s_queueCount == (uint32_t)AUDIO_LOUDNESS_QUEUE_SIZE)
+		{
+			free(s_queue[s_queueHead]);
+			s_queueHead = (s_queueHead + 1U) % (uint32_t)AUDIO_LOUDNESS_QUEUE_SIZE;
+			s_queueCount--;
+		}
+		s_queue[(s_queueHead + s_queueCount) % (uint32_t)AUDIO_LOUDNESS_QUEUE_SIZE] = copy;
+		s_queueCount++;
+		(void)pthread_cond_signal(&s_cond);
+		(void)pthread_mutex_unlock(&s_mutex);
+	}
+}
+
+static void *AnalysisThread(void *arg)
+{
+	char *library = (char *)malloc(LOUDNESS_PATH_SIZE);
+
+	(void)arg;
+	SetIdlePriority(true);
+
+	(void)pthread_mutex_lock(&s_mutex);
+	while (s_threadRun)
+	{
+		char *path = NULL;
+		uint32_t flags = 0;
+
+		if (s_queueCount > 0U)
+		{
+			path = s_queue[s_queueHead];
+			s_queueHead = (s_queueHead + 1U) % (uint32_t)AUDIO_LOUDNESS_QUEUE_SIZE;
+			s_queueCount--;
+		}
+		else if (s_libraryPass && (library != NULL))
+		{
+			if (MediaLibraryGetPath(s_libraryPosition, library, LOUDNESS_PATH_SIZE, &flags) == 0)
+			{
+				s_libraryPosition++;
+				if ((flags & MEDIA_LIBRARY_FLAG_VIDEO) == 0U)
+				{
+					path = strdup(library);
+				}
+			}
+			else
+			{
+				INFO_PRINTF("library pass done, %u track(s)\n", s_libraryPosition);
+				s_libraryPass = false;
+			}
+		}
+		else
+		{
+			(void)pthread_cond_wait(&s_cond, &s_mutex);
+		}
+
+		if (path != NULL)
+		{
+			(void)pthread_mutex_unlock(&s_mutex);
+			AnalyzeFile(path);
+			free(path);
+			(void)pthread_mutex_lock(&s_mutex);
+		}
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	free(library);
+
+	return NULL;
+}
+
+static void AnalyzeFile(const char *path)
+{
+	AudioLoudnessRecord record;
+	LoudnessAnalysis *analysis;
+
+	/* a track played twice before its turn, or a library track already measured */
+	if (GetFileKey(path, &record) && (!FindRecord(&record)))
+	{
+		analysis = (LoudnessAnalysis *)malloc(sizeof(LoudnessAnalysis));
+		if (analysis != NULL)
+		{
+			int64_t start = TCTimeGetMonotonicMs();
+
+			MeasureFile(path, analysis, &record);
+			if (__atomic_load_n(&s_threadRun, __ATOMIC_RELAXED))
+			{
+				StoreRecord(&record);
+				DEBUG_PRINTF("%s: loudness(%.1f LUFS), peak(%.3f), source(%u), %lld ms\n", path, record.loudness,
+							 record.peak, record.source, (long long)(TCTimeGetMonotonicMs() - start));
+			}
+			free(analysis);
+		}
+	}
+}
+
+/* stops early at ReplayGain tags, they are as good as a measurement */
+static void MeasureFile(const char *path, LoudnessAnalysis *analysis, AudioLoudnessRecord *record)
+{
+	GstElement *pipeline;
+	GError *error = NULL;
+
+	analysis->started = false;
+	record->loudness = AUDIO_LOUDNESS_SILENCE;
+	record->peak = 0.0f;
+	record->source = (uint32_t)AudioLoudnessFailed;
+
+	pipeline = gst_parse_launch(LOUDNESS_PIPELINE, &error);
+	if (pipeline != NULL)
+	{
+		GstElement *src = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+		GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+		GstBus *bus = gst_element_get_bus(pipeline);
+		gchar *uri = gst_filename_to_uri(path, NULL);
+
+		if ((src != NULL) && (sink != NULL) && (bus != NULL) && (uri != NULL))
+		{
+			g_object_set(src, "uri", uri, NULL);
+			(void)g_signal_connect(sink, "handoff", G_CALLBACK(OnAnalysisHandoff), analysis);
+			gst_bus_set_sync_handler(bus, OnAnalysisSyncMessage, NULL, NULL);
+
+			if (gst_element_set_state(pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE)
+			{
+				bool done = false;
+
+				while ((!done) && __atomic_load_n(&s_threadRun, __ATOMIC_RELAXED))
+				{
+					GstMessage *msg = gst_bus_timed_pop_filtered(bus, LOUDNESS_POLL_INTERVAL, (GstMessageType)
+																 (GST_MESSAGE_EOS | GST_MESSAGE_ERROR | GST_MESSAGE_TAG));
+					if (msg != NULL)
+					{
+						if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_TAG)
+						{
+							GstTagList *tags = NULL;
+
+							gst_message_parse_tag(msg, &tags);
+							if ((tags != NULL) && GetTagLoudness(tags, &record->loudness, &record->peak))
+							{
+								record->source = (uint32_t)AudioLoudnessTagged;
+								done = true;
+							}
+							if (tags != NULL)
+							{
+								gst_tag_list_unref(tags);
+							}
+						}
+						else if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS)
+						{
+							/* the streaming thread is done with the meter */
+							if (analysis->started && (analysis->meter.frames > 0U))
+							{
+								record->loudness = AudioLoudnessMeterGetIntegrated(&analysis->meter);
+								record->peak = analysis->meter.peak;
+								record->source = (uint32_t)AudioLoudnessMeasured;
+							}
+							done = true;
+						}
+						else
+						{
+							WARN_PRINTF("%s cannot be measured\n", path);
+							done = true;
+						}
+						gst_message_unref(msg);
+					}
+				}
+			}
+			(void)gst_element_set_state(pipeline, GST_STATE_NULL);
+		}
+
+		g_free(uri);
+		if (bus != NULL)
+		{
+			gst_object_unref(bus);
+		}
+		if (src != NULL)
+		{
+			gst_object_unref(src);
+		}
+		if (sink != NULL)
+		{
+			gst_object_unref(sink);
+		}
+		gst_object_unref(pipeline);
+	}
+	else
+	{
+		ERROR_PRINTF("gst_parse_launch failed: %s\n", (error != NULL) ? error->message : "unknown");
+	}
+
+	if (error != NULL)
+	{
+		g_error_free(error);
+	}
+}
+
+/*
+ * the streaming threads of the analysis are made idle as they start and
+ * normal again as they stop, they come from and go back to the GStreamer
+ * task pool the player pipelines share.
+ */
+static GstBusSyncReply OnAnalysisSyncMessage(GstBus *bus, GstMessage *msg, gpointer data)
+{
+	(void)bus;
+	(void)data;
+
+	if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_STREAM_STATUS)
+	{
+		GstStreamStatusType type;
+		GstElement *owner = NULL;
+
+		gst_message_parse_stream_status(msg, &type, &owner);
+		if (type == GST_STREAM_STATUS_TYPE_ENTER)
+		{
+			SetIdlePriority(true);
+		}
+		else if (type == GST_STREAM_STATUS_TYPE_LEAVE)
+		{
+			SetIdlePriority(false);
+		}
+		else
+		{
+			;
+		}
+	}
+
+	return GST_BUS_PASS;
+}
+
+static void OnAnalysisHandoff(GstElement *sink, GstBuffer *buffer, GstPad *pad, gpointer data)
+{
+	LoudnessAnalysis *analysis = (LoudnessAnalysis *)data;
+	GstMapInfo map;
+
+	(void)sink;
+	if (!analysis->started)
+	{
+		GstCaps *caps = gst_pad_get_current_caps(pad);
+		GstAudioInfo info;
+
+		if ((caps != NULL) && (gst_audio_info_from_caps(&info, caps) != FALSE))
+		{
+			AudioLoudnessMeterInit(&analysis->meter, (uint32_t)GST_AUDIO_INFO_RATE(&info),
+								   (uint32_t)GST_AUDIO_INFO_CHANNELS(&info));
+			analysis->paceFrames = 0;
+			analysis->paceStart = TCTimeGetMonotonicNs();
+			analysis->started = true;
+		}
+
+		if (caps != NULL)
+		{
+			gst_caps_unref(caps);
+		}
+	}
+
+	if (analysis->started && (gst_buffer_map(buffer, &map, GST_MAP_READ) != FALSE))
+	{
+		uint32_t frames = (uint32_t)(map.size / (analysis->meter.channels * sizeof(float)));
+
+		AudioLoudnessMeterProcess(&analysis->meter, (const float *)(const void *)map.data, frames);
+		gst_buffer_unmap(buffer, &map);
+		PaceAnalysis(analysis, frames);
+	}
+}
+
+/*
+ * Every 100 ms of measured audio, hold the streaming thread while the player
+ * plays so the analysis stays under AUDIO_LOUDNESS_PLAYING_SPEED times real
+ * time. Idle priority alone still lets a fast decoder take the disk.
+ */
+static void PaceAnalysis(LoudnessAnalysis *analysis, uint32_t frames)
+{
+	analysis->paceFrames += frames;
+	if (analysis->paceFrames >= analysis->meter.subBlockFrames)
+	{
+		int64_t now = TCTimeGetMonotonicNs();
+
+		MultiMediaStateGet(&analysis->state);
+		if ((analysis->state.playback == (uint32_t)MultiMediaPlaybackPlaying) ||
+			(analysis->state.playback == (uint32_t)MultiMediaPlaybackTrick))
+		{
+			int64_t due = analysis->paceStart +
+						  (int64_t)(((uint64_t)analysis->paceFrames * 1000000000ULL) /
+									((uint64_t)analysis->meter.rate * (uint64_t)AUDIO_LOUDNESS_PLAYING_SPEED));
+
+			if (due > now)
+			{
+				(void)usleep((useconds_t)((due - now) / 1000));
+				now = due;
+			}
+		}
+
+		analysis->paceFrames = 0;
+		analysis->paceStart = now;
+	}
+}
+
+/* not idle is SCHED_OTHER and the I/O priority that follows the nice value */
+static void SetIdlePriority(bool idle)
+{
+	struct sched_param param;
+	int32_t ioClass = idle ? LOUDNESS_IOPRIO_CLASS_IDLE : LOUDNESS_IOPRIO_CLASS_NONE;
+
+	(void)memset(&param, 0, sizeof(param));
+	if (pthread_setschedparam(pthread_self(), idle ? SCHED_IDLE : SCHED_OTHER, &param) != 0)
+	{
+		WARN_PRINTF("%s refused\n", idle ? "SCHED_IDLE" : "SCHED_OTHER");
+	}
+
+	/* 0 is the calling thread */
+	if (syscall(SYS_ioprio_set, LOUDNESS_IOPRIO_WHO_PROCESS, 0, ioClass << LOUDNESS_IOPRIO_CLASS_SHIFT) != 0)
+	{
+		WARN_PRINTF("%s I/O priority refused: error(%d)\n", idle ? "idle" : "default", errno);
+	}
+}
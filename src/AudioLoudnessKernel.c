@@ -0,0 +1,408 @@
+/****************************************************************************************
+ *   FileName    : AudioLoudnessKernel.c
+ *   Description : Telechips Audio Loudness Kernel
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "AudioLoudnessKernel.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define AUDIO_LOUDNESS_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define AUDIO_LOUDNESS_NEON
+#endif
+
+/*
+ * The high pass of a channel filters the output of its shelf, so the two
+ * cannot run on the same frame together. Like the equalizer kernel, the
+ * vector kernel skews them instead: the shelf lanes take frame t while the
+ * high pass lanes take the shelf output of frame t - 1 from the step before.
+ * The K-weighted signal therefore lags the input by one frame, which moves
+ * every block by one frame and does not change the loudness of anything
+ * longer than a block. Four lanes fill one SSE2 or NEON vector, an AVX2
+ * build uses the SSE2 kernel.
+ */
+#define LOUDNESS_ENERGY_OFFSET			(-0.691)	/* BS.1770, cancels the K-weighting gain at 1 kHz */
+#define LOUDNESS_RELATIVE_GATE			(-10.0)		/* LU under the mean of the blocks above the absolute gate */
+#define LOUDNESS_SUB_BLOCKS				4			/* 100 ms sub-blocks of a 400 ms block */
+#define LOUDNESS_DENORMAL				1e-20f
+
+typedef void (*LoudnessSteps)(AudioLoudnessMeter *meter, const float *data, uint32_t frames);
+
+static void DesignFilters(AudioLoudnessMeter *meter, uint32_t rate);
+static void Measure(AudioLoudnessMeter *meter, const float *data, uint32_t frames, LoudnessSteps steps);
+static void StepLanes(AudioLoudnessMeter *meter, const float *data, uint32_t frames);
+static void StepVector(AudioLoudnessMeter *meter, const float *data, uint32_t frames);
+static void EndSubBlock(AudioLoudnessMeter *meter);
+static void AddBlock(AudioLoudnessMeter *meter, double energy);
+static double GetLoudness(double energy);
+static void FlushDenormals(float *z, uint32_t count);
+
+void AudioLoudnessMeterInit(AudioLoudnessMeter *meter, uint32_t rate, uint32_t channels)
+{
+	(void)memset(meter, 0, sizeof(*meter));
+	meter->rate = (rate > 0U) ? rate : 1U;
+	meter->channels = ((channels > 0U) && (channels <= (uint32_t)AUDIO_LOUDNESS_CHANNELS)) ?
+					  channels : (uint32_t)AUDIO_LOUDNESS_CHANNELS;
+	meter->subBlockFrames = (meter->rate >= 10U) ? (meter->rate / 10U) : 1U;
+	DesignFilters(meter, meter->rate);
+}
+
+void AudioLoudnessMeterProcess(AudioLoudnessMeter *meter, const float *data, uint32_t frames)
+{
+	Measure(meter, data, frames, StepVector);
+}
+
+void AudioLoudnessMeterProcessReference(AudioLoudnessMeter *meter, const float *data, uint32_t frames)
+{
+	Measure(meter, data, frames, StepLanes);
+}
+
+float AudioLoudnessMeterGetIntegrated(const AudioLoudnessMeter *meter)
+{
+	float ret = AUDIO_LOUDNESS_SILENCE;
+	double energy = 0.0;
+	uint64_t count = 0;
+	uint32_t bin;
+
+	for (bin = 0; bin < (uint32_t)AUDIO_LOUDNESS_HISTOGRAM_BINS; bin++)
+	{
+		energy += meter->energy[bin];
+		count += meter->histogram[bin];
+	}
+
+	if (count > 0U)
+	{
+		double gate = GetLoudness(energy / (double)count) + LOUDNESS_RELATIVE_GATE;
+		double first = ceil(((gate - (double)AUDIO_LOUDNESS_SILENCE) / (double)AUDIO_LOUDNESS_HISTOGRAM_STEP) - 0.5);
+
+		/* the blocks of the bins whose centre is not under the relative gate */
+		energy = 0.0;
+		count = 0;
+		for (bin = (first > 0.0) ? (uint32_t)first : 0U; bin < (uint32_t)AUDIO_LOUDNESS_HISTOGRAM_BINS; bin++)
+		{
+			energy += meter->energy[bin];
+			count += meter->histogram[bin];
+		}
+
+		if (count > 0U)
+		{
+			ret = (float)GetLoudness(energy / (double)count);
+		}
+	}
+
+	return ret;
+}
+
+const char *AudioLoudnessGetKernelName(void)
+{
+#if defined(AUDIO_LOUDNESS_SSE2)
+	return "sse2";
+#elif defined(AUDIO_LOUDNESS_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+/*
+ * The K-weighting filters of BS.1770 for any rate, from the analog
+ * prototypes the 48 kHz coefficients of the recommendation were made from.
+ * The high pass keeps b = (1, -2, 1) unnormalized as the recommendation does.
+ */
+static void DesignFilters(AudioLoudnessMeter *meter, uint32_t rate)
+{
+	double K = tan((M_PI * 1681.974450955533) / (double)rate);
+	double Q = 0.7071752369554196;
+	double Vh = pow(10.0, 3.999843853973347 / 20.0);
+	double Vb = pow(Vh, 0.4996667741545416);
+	double a0 = 1.0 + (K / Q) + (K * K);
+	float shelf[5];
+	float highPass[5];
+	uint32_t channel;
+
+	shelf[0] = (float)((Vh + ((Vb * K) / Q) + (K * K)) / a0);
+	shelf[1] = (float)((2.0 * ((K * K) - Vh)) / a0);
+	shelf[2] = (float)((Vh - ((Vb * K) / Q) + (K * K)) / a0);
+	shelf[3] = (float)((2.0 * ((K * K) - 1.0)) / a0);
+	shelf[4] = (float)((1.0 - (K / Q) + (K * K)) / a0);
+
+	K = tan((M_PI * 38.13547087602444) / (double)rate);
+	Q = 0.5003270373238773;
+	a0 = 1.0 + (K / Q) + (K * K);
+	highPass[0] = 1.0f;
+	highPass[1] = -2.0f;
+	highPass[2] = 1.0f;
+	highPass[3] = (float)((2.0 * ((K * K) - 1.0)) / a0);
+	highPass[4] = (float)((1.0 - (K / Q) + (K * K)) / a0);
+
+	for (channel = 0; channel < (uint32_t)AUDIO_LOUDNESS_CHANNELS; channel++)
+	{
+		uint32_t lane = channel * 2U;
+
+		meter->b0[lane] = shelf[0];
+		meter->b1[lane] = shelf[1];
+		meter->b2[lane] = shelf[2];
+		meter->a1[lane] = shelf[3];
+		meter->a2[lane] = shelf[4];
+		meter->b0[lane + 1U] = highPass[0];
+		meter->b1[lane + 1U] = highPass[1];
+		meter->b2[lane + 1U] = highPass[2];
+		meter->a1[lane + 1U] = highPass[3];
+		meter->a2[lane + 1U] = highPass[4];
+	}
+}
+
+/* in pieces that end on the 100 ms sub-blocks */
+static void Measure(AudioLoudnessMeter *meter, const float *data, uint32_t frames, LoudnessSteps steps)
+{
+	while (frames > 0U)
+	{
+		uint32_t block = meter->subBlockFrames - meter->subBlockDone;
+
+		if (block > frames)
+		{
+			block = frames;
+		}
+
+		steps(meter, data, block);
+		FlushDenormals(meter->z1, AUDIO_LOUDNESS_LANES);
+		FlushDenormals(meter->z2, AUDIO_LOUDNESS_LANES);
+		FlushDenormals(meter->y, AUDIO_LOUDNESS_LANES);
+
+		data += (size_t)block * meter->channels;
+		frames -= block;
+		meter->frames += block;
+		meter->subBlockDone += block;
+		if (meter->subBlockDone == meter->subBlockFrames)
+		{
+			EndSubBlock(meter);
+		}
+	}
+}
+
+/* lane by lane, from the top so a high pass lane still sees the shelf output of the last frame */
+static void StepLanes(AudioLoudnessMeter *meter, const float *data, uint32_t frames)
+{
+	uint32_t frame;
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		uint32_t lane = (uint32_t)AUDIO_LOUDNESS_LANES;
+
+		while (lane > 0U)
+		{
+			uint32_t channel;
+			float x;
+			float out;
+
+			lane--;
+			channel = lane / 2U;
+			if ((lane & 1U) != 0U)
+			{
+				x = meter->y[lane - 1U];
+			}
+			else if (channel < meter->channels)
+			{
+				x = data[(frame * meter->channels) + channel];
+				meter->peak = fmaxf(meter->peak, fabsf(x));
+			}
+			else
+			{
+				x = 0.0f;
+			}
+
+			out = (meter->b0[lane] * x) + meter->z1[lane];
+			meter->z1[lane] = ((meter->b1[lane] * x) - (meter->a1[lane] * out)) + meter->z2[lane];
+			meter->z2[lane] = (meter->b2[lane] * x) - (meter->a2[lane] * out);
+			meter->y[lane] = out;
+			meter->sum[lane] += out * out;
+		}
+	}
+}
+
+static void StepVector(AudioLoudnessMeter *meter, const float *data, uint32_t frames)
+{
+#if defined(AUDIO_LOUDNESS_SSE2)
+	const __m128 b0 = _mm_loadu_ps(meter->b0);
+	const __m128 b1 = _mm_loadu_ps(meter->b1);
+	const __m128 b2 = _mm_loadu_ps(meter->b2);
+	const __m128 a1 = _mm_loadu_ps(meter->a1);
+	const __m128 a2 = _mm_loadu_ps(meter->a2);
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 z1 = _mm_loadu_ps(meter->z1);
+	__m128 z2 = _mm_loadu_ps(meter->z2);
+	__m128 y = _mm_loadu_ps(meter->y);
+	__m128 sum = _mm_loadu_ps(meter->sum);
+	__m128 peak = _mm_set1_ps(meter->peak);
+	float peaks[4];
+	uint32_t frame;
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		__m128 x;
+		__m128 in;
+		__m128 out;
+
+		if (meter->channels == 2U)
+		{
+			x = _mm_castpd_ps(_mm_load_sd((const double *)(const void *)&data[frame * 2U]));
+		}
+		else
+		{
+			x = _mm_load_ss(&data[frame]);
+		}
+		peak = _mm_max_ps(peak, _mm_andnot_ps(sign, x));
+
+		/* x0, shelf 0 of the last frame, x1, shelf 1 of the last frame */
+		in = _mm_unpacklo_ps(x, _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 0, 2, 0)));
+		out = _mm_add_ps(_mm_mul_ps(b0, in), z1);
+		z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, in), _mm_mul_ps(a1, out)), z2);
+		z2 = _mm_sub_ps(_mm_mul_ps(b2, in), _mm_mul_ps(a2, out));
+		y = out;
+		sum = _mm_add_ps(sum, _mm_mul_ps(out, out));
+	}
+
+	_mm_storeu_ps(meter->z1, z1);
+	_mm_storeu_ps(meter->z2, z2);
+	_mm_storeu_ps(meter->y, y);
+	_mm_storeu_ps(meter->sum, sum);
+	_mm_storeu_ps(peaks, peak);
+	meter->peak = fmaxf(fmaxf(peaks[0], peaks[1]), fmaxf(peaks[2], peaks[3]));
+#elif defined(AUDIO_LOUDNESS_NEON)
+	const float32x4_t b0 = vld1q_f32(meter->b0);
+	const float32x4_t b1 = vld1q_f32(meter->b1);
+	const float32x4_t b2 = vld1q_f32(meter->b2);
+	const float32x4_t a1 = vld1q_f32(meter->a1);
+	const float32x4_t a2 = vld1q_f32(meter->a2);
+	float32x4_t z1 = vld1q_f32(meter->z1);
+	float32x4_t z2 = vld1q_f32(meter->z2);
+	float32x4_t y = vld1q_f32(meter->y);
+	float32x4_t sum = vld1q_f32(meter->sum);
+	float32x2_t peak = vdup_n_f32(meter->peak);
+	uint32_t frame;
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		float32x2_t x;
+		float32x2x2_t pairs;
+		float32x4_t in;
+		float32x4_t out;
+
+		if (meter->channels == 2U)
+		{
+			x = vld1_f32(&data[frame * 2U]);
+		}
+		else
+		{
+			x = vset_lane_f32(data[frame], vdup_n_f32(0.0f), 0);
+		}
+		peak = vmax_f32(peak, vabs_f32(x));
+
+		/* x0, shelf 0 of the last frame, x1, shelf 1 of the last frame */
+		pairs = vzip_f32(x, vget_low_f32(vuzpq_f32(y, y).val[0]));
+		in = vcombine_f32(pairs.val[0], pairs.val[1]);
+		out = vaddq_f32(vmulq_f32(b0, in), z1);
+		z1 = vaddq_f32(vsubq_f32(vmulq_f32(b1, in), vmulq_f32(a1, out)), z2);
+		z2 = vsubq_f32(vmulq_f32(b2, in), vmulq_f32(a2, out));
+		y = out;
+		sum = vaddq_f32(sum, vmulq_f32(out, out));
+	}
+
+	vst1q_f32(meter->z1, z1);
+	vst1q_f32(meter->z2, z2);
+	vst1q_f32(meter->y, y);
+	vst1q_f32(meter->sum, sum);
+	meter->peak = fmaxf(vget_lane_f32(peak, 0), vget_lane_f32(peak, 1));
+#else
+	StepLanes(meter, data, frames);
+#endif
+}
+
+/* the mean square of the channels over the last 100 ms, and a block with the three before */
+static void EndSubBlock(AudioLoudnessMeter *meter)
+{
+	double energy = 0.0;
+	uint32_t channel;
+
+	for (channel = 0; channel < meter->channels; channel++)
+	{
+		energy += (double)meter->sum[(channel * 2U) + 1U];
+	}
+	energy /= (double)meter->subBlockFrames;
+	(void)memset(meter->sum, 0, sizeof(meter->sum));
+	meter->subBlockDone = 0;
+
+	if (meter->subBlockCount >= (uint32_t)(LOUDNESS_SUB_BLOCKS - 1))
+	{
+		AddBlock(meter, (meter->subBlocks[0] + meter->subBlocks[1] + meter->subBlocks[2] + energy) /
+						(double)LOUDNESS_SUB_BLOCKS);
+	}
+	else
+	{
+		meter->subBlockCount++;
+	}
+
+	meter->subBlocks[0] = meter->subBlocks[1];
+	meter->subBlocks[1] = meter->subBlocks[2];
+	meter->subBlocks[2] = energy;
+}
+
+static void AddBlock(AudioLoudnessMeter *meter, double energy)
+{
+	if (energy > 0.0)
+	{
+		double loudness = GetLoudness(energy);
+
+		if (loudness >= (double)AUDIO_LOUDNESS_SILENCE)
+		{
+			double position = (loudness - (double)AUDIO_LOUDNESS_SILENCE) / (double)AUDIO_LOUDNESS_HISTOGRAM_STEP;
+			uint32_t bin = (position < (double)(AUDIO_LOUDNESS_HISTOGRAM_BINS - 1)) ?
+						   (uint32_t)position : (uint32_t)(AUDIO_LOUDNESS_HISTOGRAM_BINS - 1);
+
+			meter->histogram[bin]++;
+			meter->energy[bin] += energy;
+		}
+	}
+}
+
+static double GetLoudness(double energy)
+{
+	return LOUDNESS_ENERGY_OFFSET + (10.0 * log10(energy));
+}
+
+static void FlushDenormals(float *z, uint32_t count)
+{
+	uint32_t idx;
+
+	for (idx = 0; idx < count; idx++)
+	{
+		if (fabsf(z[idx]) < LOUDNESS_DENORMAL)
+		{
+			z[idx] = 0.0f;
+		}
+	}
+}
@@ -0,0 +1,112 @@
+/****************************************************************************************
+ *   FileName    : DBusMethodTable.c
+ *   Description : Telechips DBus Method Table
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "DBusMethodTable.h"
+
+#define DBUS_METHOD_TABLE_MASK			((uint32_t)DBUS_METHOD_TABLE_SLOTS - 1U)
+
+static uint32_t GetNameHash(const char *name);
+
+int32_t DBusMethodTableInitialize(DBusMethodTable *table, const char * const *names, uint32_t count)
+{
+	int32_t ret = 0;
+	uint32_t idx;
+	uint32_t hash;
+	uint32_t slot;
+
+	if ((table == NULL) || (names == NULL) || ((count * 2U) > (uint32_t)DBUS_METHOD_TABLE_SLOTS))
+	{
+		ret = -1;
+	}
+	else
+	{
+		(void)memset(table, 0, sizeof(DBusMethodTable));
+		table->names = names;
+		table->count = count;
+
+		for (idx = 0; (idx < count) && (ret == 0); idx++)
+		{
+			hash = GetNameHash(names[idx]);
+			slot = hash & DBUS_METHOD_TABLE_MASK;
+			while (table->slots[slot] != 0U)
+			{
+				if ((table->hashes[slot] == hash) && (strcmp(names[table->slots[slot] - 1U], names[idx]) == 0))
+				{
+					/* the same member listed twice */
+					ret = -1;
+					break;
+				}
+				slot = (slot + 1U) & DBUS_METHOD_TABLE_MASK;
+			}
+			if (ret == 0)
+			{
+				table->hashes[slot] = hash;
+				table->slots[slot] = (uint16_t)(idx + 1U);
+			}
+		}
+	}
+
+	return ret;
+}
+
+int32_t DBusMethodTableLookup(const DBusMethodTable *table, const char *name)
+{
+	int32_t found = -1;
+	uint32_t hash;
+	uint32_t slot;
+
+	if ((table != NULL) && (name != NULL) && (table->names != NULL))
+	{
+		hash = GetNameHash(name);
+		slot = hash & DBUS_METHOD_TABLE_MASK;
+		while ((table->slots[slot] != 0U) && (found < 0))
+		{
+			if ((table->hashes[slot] == hash) && (strcmp(table->names[table->slots[slot] - 1U], name) == 0))
+			{
+				found = (int32_t)table->slots[slot] - 1;
+			}
+			slot = (slot + 1U) & DBUS_METHOD_TABLE_MASK;
+		}
+	}
+
+	return found;
+}
+
+static uint32_t GetNameHash(const char *name)
+{
+	uint32_t hash = 2166136261U;
+	const uint8_t *ch;
+
+	/* FNV-1a, member names are short */
+	for (ch = (const uint8_t *)name; *ch != 0U; ch++)
+	{
+		hash ^= (uint32_t)*ch;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
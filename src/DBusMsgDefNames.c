@@ -24,33 +24,14 @@ between Telechips and Company.
 ****************************************************************************************/
 #include "DBusMsgDef.h"
 
+#define MEDIAPLAYBACK_NAME_ENTRY(name, member)		member,
+
 const char *g_signalMediaPlaybackEventNames[TotalSignalMediaPlaybackEvents] = {
-	SIGNAL_MEDIAPLAYBACK_PLAYING,
-	SIGNAL_MEDIAPLAYBACK_STOPPED,
-	SIGNAL_MEDIAPLAYBACK_PAUSED,
-	SIGNAL_MEDIAPLAYBACK_DURATION,
-	SIGNAL_MEDIAPLAYBACK_PLAYPOSITION,
-	SIGNAL_MEDIAPLAYBACK_TAGINFO,
-	SIGNAL_MEDIAPLAYBACK_ALBUMART_KEY,
-	SIGNAL_MEDIAPLAYBACK_ALBUMART_COMPLETED,
-	SIGNAL_MEDIAPLAYBACK_PLAY_ENDED,
-	SIGNAL_MEDIAPLAYBACK_SEEK_COMPLETED,
-	SIGNAL_MEDIAPLAYBACK_ERROR,
-	SIGNAL_MEDIAPLAYBACK_SAMPLERATE,
+	MEDIAPLAYBACK_SIGNAL_LIST(MEDIAPLAYBACK_NAME_ENTRY)
 };
 
 const char *g_methodMediaPlaybackEventNames[TotalMethodMediaPlaybackEvents] = {
-	METHOD_MEDIAPLAYBACK_PLAY_START,
-	METHOD_MEDIAPLAYBACK_PLAY_STOP,
-	METHOD_MEDIAPLAYBACK_PLAY_PAUSE,
-	METHOD_MEDIAPLAYBACK_PLAY_RESUME,
-	METHOD_MEDIAPLAYBACK_PLAY_SEEK,
-	METHOD_MEDIAPLAYBACK_SET_DISPLAY,
-	METHOD_MEDIAPLAYBACK_SET_DUAL_DISPLAY,
-	METHOD_MEDIAPLAYBACK_SET_DEBUG,
-	METHOD_MEDIAPLAYBACK_GET_STATUS,
-	METHOD_MEDIAPLAYBACK_GET_ALBUMART_KEY,
-	METHOD_MEDIAPLAYBACK_GET_PLAY_ID,
+	MEDIAPLAYBACK_METHOD_LIST(MEDIAPLAYBACK_NAME_ENTRY)
 };
 
 /* End of file */
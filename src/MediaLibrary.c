@@ -0,0 +1,1871 @@
+/****************************************************************************************
+ *   FileName    : MediaLibrary.c
+ *   Description : Telechips Media Library Scanner
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <mntent.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <gst/gst.h>
+#include <gst/pbutils/pbutils.h>
+#include <glib.h>
+#include "TCLog.h"
+#include "TCTime.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MediaLibrary.h"
+
+#define MEDIA_LIBRARY_DISCOVER_TIMEOUT		(5 * GST_SECOND)
+#define MEDIA_LIBRARY_JOB_QUEUE_SIZE		256
+#define MEDIA_LIBRARY_CHECKPOINT_COUNT		1000
+#define MEDIA_LIBRARY_PROGRESS_INTERVAL		500		/* ms */
+#define MEDIA_LIBRARY_MAX_DEPTH				16
+#define MEDIA_LIBRARY_MAX_PATH				4096
+#define MEDIA_LIBRARY_MOUNTS_FILE			"/proc/self/mounts"
+
+#define SCAN_CANCEL_USER					1
+#define SCAN_CANCEL_INTERRUPT				2		/* unmounted or released, resumed later */
+
+typedef struct stMediaLibraryIndex {
+	char *root;
+	char *file;
+	uint8_t *map;
+	size_t mapSize;
+	const MediaLibraryIndexHeader *header;
+	const MediaLibraryRecord *records;
+	const char *pool;
+	struct stMediaLibraryIndex *next;
+} MediaLibraryIndex;
+
+typedef struct stMediaLibraryEntry {
+	char *path;
+	char *title;
+	char *artist;
+	char *album;
+	char *genre;
+	uint32_t pathHash;
+	uint32_t durationMs;
+	uint32_t flags;
+	uint64_t size;
+	int64_t mtime;
+} MediaLibraryEntry;
+
+typedef struct stMediaLibraryScan {
+	char *root;
+	char *mountPoint;
+	char *indexFile;
+	MediaLibraryIndex *previous;
+
+	char *jobs[MEDIA_LIBRARY_JOB_QUEUE_SIZE];
+	uint32_t jobHead;
+	uint32_t jobCount;
+	bool walkDone;
+	pthread_mutex_t jobMutex;
+	pthread_cond_t jobAvailable;
+	pthread_cond_t jobSpace;
+
+	MediaLibraryEntry *entries;
+	uint32_t entryCount;
+	uint32_t entryCapacity;
+	uint32_t uncheckpointed;
+	bool checkpointing;				/* a worker writes a checkpoint outside resultMutex */
+	uint32_t found;
+	int64_t lastProgress;
+	uint32_t mountsGeneration;		/* checked by the first walker or worker that sees a new one */
+	pthread_mutex_t resultMutex;
+} MediaLibraryScan;
+
+typedef struct stStringPool {
+	char *data;
+	uint32_t size;
+	uint32_t capacity;
+	GHashTable *offsets;
+	bool failed;
+} StringPool;
+
+static uint32_t HashPath(const char *path);
+static MediaLibraryIndex *LoadIndex(const char *file);
+static void UnloadIndex(MediaLibraryIndex *index);
+static const char *IndexString(const MediaLibraryIndex *index, uint32_t offset);
+static const MediaLibraryRecord *FindRecord(const MediaLibraryIndex *index, const char *path, uint32_t hash);
+static void PublishIndex(const char *file);
+static char *GetIndexFileName(const char *root);
+static char *FindMountPoint(const char *path);
+static bool IsRootMounted(const char *root, const char *mountPoint);
+static void LoadIndexDirectory(void);
+static void ResumeInterruptedScans(void);
+static int32_t QueueScan(const char *root, bool resume);
+static int32_t StartScanThread(void);
+static void RequestMountCheck(void);
+static void CheckScanMounted(MediaLibraryScan *scan);
+static gboolean OnMountsChanged(GIOChannel *source, GIOCondition condition, gpointer data);
+static void StartMountsWatch(void);
+static void StopMountsWatch(void);
+static void *ScanThread(void *arg);
+static void RunScan(const char *root);
+static void RunScanWorkers(MediaLibraryScan *scan, const char *root);
+static bool WalkDirectory(MediaLibraryScan *scan, const char *dir, uint32_t depth);
+static bool IsMediaFile(const char *name);
+static bool PushJob(MediaLibraryScan *scan, char *path);
+static char *PopJob(MediaLibraryScan *scan);
+static void *ScanWorker(void *arg);
+static void ScanFile(MediaLibraryScan *scan, GstDiscoverer *discoverer, const char *path);
+static void DiscoverFile(GstDiscoverer *discoverer, const char *path, MediaLibraryEntry *entry);
+static char *GetTagString(const GstTagList *tags, const gchar *tag);
+static void AddEntry(MediaLibraryScan *scan, const MediaLibraryEntry *entry);
+static void ReportProgress(MediaLibraryScan *scan, bool force);
+static void MergePreviousEntries(MediaLibraryScan *scan);
+static void WriteCheckpoint(MediaLibraryScan *scan);
+static int32_t WriteIndex(MediaLibraryScan *scan, MediaLibraryEntry *entries, uint32_t count, bool complete);
+static int CompareEntries(const void *a, const void *b);
+static void StringPoolInitialize(StringPool *pool);
+static void StringPoolRelease(StringPool *pool);
+static uint32_t StringPoolAdd(StringPool *pool, const char *string, bool dedup);
+static bool WriteAll(int32_t fd, const void *buffer, size_t length);
+static void ReleaseEntry(MediaLibraryEntry *entry);
+static uint32_t GetWorkerCount(void);
+
+static const char *s_mediaExtensions[] = {
+	"mp3", "m4a", "aac", "flac", "ogg", "oga", "opus", "wav", "wma", "ape",
+	"mp4", "m4v", "mkv", "avi", "mov", "wmv", "ts", "mpg", "mpeg", "webm",
+	NULL
+};
+
+static char *s_indexDir = NULL;
+static MediaLibraryIndex *s_indexes = NULL;
+static pthread_rwlock_t s_indexLock;
+
+static pthread_mutex_t s_scanMutex;
+static pthread_t s_scanThread;
+static bool s_scanThreadRun = false;
+static bool s_scanThreadJoinable = false;
+static GQueue s_scanQueue = G_QUEUE_INIT;
+static char *s_activeRoot = NULL;
+static int32_t s_scanCancel = 0;			/* SCAN_CANCEL_USER or SCAN_CANCEL_INTERRUPT, 0 while a scan runs */
+static GHashTable *s_cancelledRoots = NULL;	/* cancelled by the user, not resumed until started again */
+static bool s_scanQuit = false;
+static uint32_t s_mountsGeneration = 0;		/* s_scanMutex, counts mount table changes */
+static uint32_t s_mountsChecked = 0;		/* generation the scan thread resumed scans for */
+
+static GIOChannel *s_mountsChannel = NULL;
+static guint s_mountsWatchID = 0;
+
+static MediaLibraryScanProgress_cb			MediaLibraryScanProgressCB = NULL;
+static MediaLibraryScanCompleted_cb			MediaLibraryScanCompletedCB = NULL;
+
+int32_t MediaLibraryInitialize(const char *indexDir)
+{
+	int32_t ret = 0;
+	int32_t err;
+
+	if (indexDir == NULL)
+	{
+		indexDir = MEDIA_LIBRARY_DEFAULT_INDEX_DIR;
+	}
+
+	s_indexDir = strdup(indexDir);
+	if (s_indexDir != NULL)
+	{
+		if ((mkdir(s_indexDir, 0755) != 0) && (errno != EEXIST))
+		{
+			WARN_PRINTF("mkdir(%s) failed: error(%d)\n", s_indexDir, errno);
+		}
+
+		err = pthread_rwlock_init(&s_indexLock, NULL);
+		if (err == 0)
+		{
+			err = pthread_mutex_init(&s_scanMutex, NULL);
+			if (err == 0)
+			{
+				ret = 1;
+			}
+			else
+			{
+				ERROR_PRINTF("scan mutex pthread_mutex_init failed: error(%d)\n", err);
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("index pthread_rwlock_init failed: error(%d)\n", err);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("strdup failed\n");
+	}
+
+	if (ret == 1)
+	{
+		s_cancelledRoots = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+		s_scanQuit = false;
+		LoadIndexDirectory();
+		StartMountsWatch();
+		/* the scan thread resumes interrupted scans, their mounts are not checked on the main loop */
+		RequestMountCheck();
+	}
+
+	return ret;
+}
+
+void MediaLibraryRelease(void)
+{
+	MediaLibraryIndex *index;
+	char *root;
+	int32_t err;
+
+	StopMountsWatch();
+
+	/* not a user cancel, the scan is resumed after the next start */
+	(void)pthread_mutex_lock(&s_scanMutex);
+	s_scanQuit = true;
+	while ((root = (char *)g_queue_pop_head(&s_scanQueue)) != NULL)
+	{
+		free(root);
+	}
+	if (s_activeRoot != NULL)
+	{
+		int32_t running = 0;
+		(void)__atomic_compare_exchange_n(&s_scanCancel, &running, SCAN_CANCEL_INTERRUPT, false,
+										  __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+	}
+	if (s_scanThreadJoinable)
+	{
+		s_scanThreadJoinable = false;
+		(void)pthread_mutex_unlock(&s_scanMutex);
+		err = pthread_join(s_scanThread, NULL);
+		if (err != 0)
+		{
+			ERROR_PRINTF("scan thread join failed: error(%d)\n", err);
+		}
+	}
+	else
+	{
+		(void)pthread_mutex_unlock(&s_scanMutex);
+	}
+
+	(void)pthread_rwlock_wrlock(&s_indexLock);
+	index = s_indexes;
+	while (index != NULL)
+	{
+		MediaLibraryIndex *next = index->next;
+		UnloadIndex(index);
+		index = next;
+	}
+	s_indexes = NULL;
+	(void)pthread_rwlock_unlock(&s_indexLock);
+
+	if (s_cancelledRoots != NULL)
+	{
+		g_hash_table_destroy(s_cancelledRoots);
+		s_cancelledRoots = NULL;
+	}
+
+	err = pthread_mutex_destroy(&s_scanMutex);
+	if (err != 0)
+	{
+		ERROR_PRINTF("s_scanMutex destroy faild: error(%d)\n", err);
+	}
+
+	err = pthread_rwlock_destroy(&s_indexLock);
+	if (err != 0)
+	{
+		ERROR_PRINTF("s_indexLock destroy faild: error(%d)\n", err);
+	}
+
+	free(s_indexDir);
+	s_indexDir = NULL;
+}
+
+void MediaLibrarySetEventCallBackFunctions(TcMediaLibraryEventCB *cb)
+{
+	if (cb != NULL)
+	{
+		MediaLibraryScanProgressCB = cb->MediaLibraryScanProgressCB;
+		MediaLibraryScanCompletedCB = cb->MediaLibraryScanCompletedCB;
+	}
+}
+
+int32_t MediaLibraryStartScan(const char *root)
+{
+	return QueueScan(root, false);
+}
+
+/* a scan the user starts clears its cancel, one resumed after a mount change skips a cancelled root */
+static int32_t QueueScan(const char *root, bool resume)
+{
+	int32_t ret = 0;
+	char *clone;
+	GList *item;
+
+	if ((root == NULL) || (root[0] != '/'))
+	{
+		ERROR_PRINTF("invalid root(%s)\n", (root != NULL) ? root : "");
+		ret = -1;
+	}
+
+	(void)pthread_mutex_lock(&s_scanMutex);
+
+	if ((ret == 0) && s_scanQuit)
+	{
+		ret = -1;
+	}
+	else if ((ret == 0) && resume && g_hash_table_contains(s_cancelledRoots, root))
+	{
+		INFO_PRINTF("scan of %s was cancelled, not resumed\n", root);
+		ret = 1;
+	}
+	else if (ret == 0)
+	{
+		(void)g_hash_table_remove(s_cancelledRoots, root);
+	}
+	else
+	{
+		;
+	}
+
+	if ((ret == 0) && (s_activeRoot != NULL) && (strcmp(s_activeRoot, root) == 0))
+	{
+		INFO_PRINTF("scan of %s is already running\n", root);
+		ret = 1;
+	}
+
+	for (item = s_scanQueue.head; (item != NULL) && (ret == 0); item = item->next)
+	{
+		if (strcmp((const char *)item->data, root) == 0)
+		{
+			INFO_PRINTF("scan of %s is already queued\n", root);
+			ret = 1;
+		}
+	}
+
+	if (ret == 0)
+	{
+		clone = strdup(root);
+		if (clone != NULL)
+		{
+			g_queue_push_tail(&s_scanQueue, clone);
+			if (StartScanThread() != 0)
+			{
+				free(g_queue_pop_tail(&s_scanQueue));
+				ret = -1;
+			}
+		}
+		else
+		{
+			ret = -1;
+		}
+	}
+
+	(void)pthread_mutex_unlock(&s_scanMutex);
+
+	return ret;
+}
+
+int32_t MediaLibraryCancelScan(void)
+{
+	int32_t ret = -1;
+	char *root;
+
+	(void)pthread_mutex_lock(&s_scanMutex);
+
+	/* a later mount change must not undo the cancel */
+	while ((root = (char *)g_queue_pop_head(&s_scanQueue)) != NULL)
+	{
+		g_hash_table_add(s_cancelledRoots, root);
+	}
+
+	if (s_activeRoot != NULL)
+	{
+		INFO_PRINTF("cancel scan of %s\n", s_activeRoot);
+		__atomic_store_n(&s_scanCancel, SCAN_CANCEL_USER, __ATOMIC_RELEASE);
+		g_hash_table_add(s_cancelledRoots, strdup(s_activeRoot));
+		ret = 0;
+	}
+
+	(void)pthread_mutex_unlock(&s_scanMutex);
+
+	return ret;
+}
+
+int32_t MediaLibraryLookup(const char *path, MediaLibraryTrack *track)
+{
+	int32_t ret = -1;
+
+	if ((path != NULL) && (track != NULL))
+	{
+		const MediaLibraryIndex *index;
+		uint32_t hash;
+
+		if (strncmp(path, "file://", 7) == 0)
+		{
+			path = &path[7];
+		}
+		hash = HashPath(path);
+
+		(void)pthread_rwlock_rdlock(&s_indexLock);
+		for (index = s_indexes; (index != NULL) && (ret != 0); index = index->next)
+		{
+			size_t rootLength = strlen(index->root);
+
+			if ((rootLength > 0U) &&
+				(strncmp(path, index->root, rootLength) == 0) &&
+				((path[rootLength] == '/') || (path[rootLength] == '\0') || (index->root[rootLength - 1U] == '/')))
+			{
+				const MediaLibraryRecord *record = FindRecord(index, path, hash);
+				if (record != NULL)
+				{
+					(void)g_strlcpy(track->title, IndexString(index, record->title), MEDIA_LIBRARY_MAX_TAG_SIZE);
+					(void)g_strlcpy(track->artist, IndexString(index, record->artist), MEDIA_LIBRARY_MAX_TAG_SIZE);
+					(void)g_strlcpy(track->album, IndexString(index, record->album), MEDIA_LIBRARY_MAX_TAG_SIZE);
+					(void)g_strlcpy(track->genre, IndexString(index, record->genre), MEDIA_LIBRARY_MAX_TAG_SIZE);
+					track->durationMs = record->durationMs;
+					track->flags = record->flags;
+					ret = 0;
+				}
+			}
+		}
+		(void)pthread_rwlock_unlock(&s_indexLock);
+	}
+
+	return ret;
+}
+
+int32_t MediaLibraryGetPath(uint32_t position, char *path, size_t size, uint32_t *flags)
+{
+	int32_t ret = -1;
+	const MediaLibraryIndex *index;
+
+	(void)pthread_rwlock_rdlock(&s_indexLock);
+	for (index = s_indexes; (index != NULL) && (ret != 0); index = index->next)
+	{
+		if (position < index->header->recordCount)
+		{
+			const MediaLibraryRecord *record = &index->records[position];
+
+			(void)g_strlcpy(path, IndexString(index, record->path), size);
+			*flags = record->flags;
+			ret = 0;
+		}
+		else
+		{
+			position -= index->header->recordCount;
+		}
+	}
+	(void)pthread_rwlock_unlock(&s_indexLock);
+
+	return ret;
+}
+
+static uint32_t HashPath(const char *path)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261U;
+
+	while (*path != '\0')
+	{
+		hash ^= (uint8_t)*path;
+		hash *= 16777619U;
+		path++;
+	}
+
+	return hash;
+}
+
+static MediaLibraryIndex *LoadIndex(const char *file)
+{
+	MediaLibraryIndex *index = NULL;
+	int32_t fd;
+
+	fd = open(file, O_RDONLY | O_CLOEXEC);
+	if (fd >= 0)
+	{
+		struct stat st;
+
+		if ((fstat(fd, &st) == 0) && ((size_t)st.st_size >= sizeof(MediaLibraryIndexHeader)))
+		{
+			uint8_t *map = (uint8_t *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			if (map != MAP_FAILED)
+			{
+				const MediaLibraryIndexHeader *header = (const MediaLibraryIndexHeader *)map;
+				size_t recordsEnd = sizeof(MediaLibraryIndexHeader) + ((size_t)header->recordCount * sizeof(MediaLibraryRecord));
+
+				if ((memcmp(header->magic, MEDIA_LIBRARY_INDEX_MAGIC, sizeof(header->magic)) == 0) &&
+					(header->version == (uint32_t)MEDIA_LIBRARY_INDEX_VERSION) &&
+					(header->headerSize == (uint32_t)sizeof(MediaLibraryIndexHeader)) &&
+					(header->recordSize == (uint32_t)sizeof(MediaLibraryRecord)) &&
+					(header->stringPoolOffset == recordsEnd) &&
+					(header->stringPoolSize > 0U) &&
+					(((size_t)header->stringPoolOffset + header->stringPoolSize) == (size_t)st.st_size) &&
+					(map[st.st_size - 1] == '\0'))
+				{
+					index = (MediaLibraryIndex *)calloc(1, sizeof(MediaLibraryIndex));
+					if (index != NULL)
+					{
+						index->map = map;
+						index->mapSize = (size_t)st.st_size;
+						index->header = header;
+						index->records = (const MediaLibraryRecord *)&map[sizeof(MediaLibraryIndexHeader)];
+						index->pool = (const char *)&map[header->stringPoolOffset];
+						index->root = strdup(IndexString(index, header->root));
+						index->file = strdup(file);
+						if ((index->root == NULL) || (index->file == NULL))
+						{
+							UnloadIndex(index);
+							index = NULL;
+						}
+					}
+					else
+					{
+						(void)munmap(map, (size_t)st.st_size);
+					}
+				}
+				else
+				{
+					WARN_PRINTF("invalid index file(%s)\n", file);
+					(void)munmap(map, (size_t)st.st_size);
+				}
+			}
+			else
+			{
+				ERROR_PRINTF("mmap(%s) failed: error(%d)\n", file, errno);
+			}
+		}
+		(void)close(fd);
+	}
+
+	return index;
+}
+
+static void UnloadIndex(MediaLibraryIndex *index)
+{
+	if (index != NULL)
+	{
+		if (index->map != NULL)
+		{
+			(void)munmap(index->map, index->mapSize);
+		}
+		free(index->root);
+		free(index->file);
+		free(index);
+	}
+}
+
+static const char *IndexString(const MediaLibraryIndex *index, uint32_t offset)
+{
+	const char *string = "";
+
+	if (offset < index->header->stringPoolSize)
+	{
+		string = &index->pool[offset];
+	}
+
+	return string;
+}
+
+static const MediaLibraryRecord *FindRecord(const MediaLibraryIndex *index, const char *path, uint32_t hash)
+{
+	const MediaLibraryRecord *found = NULL;
+
+	if (index != NULL)
+	{
+		uint32_t low = 0;
+		uint32_t high = index->header->recordCount;
+
+		/* lower bound of hash */
+		while (low < high)
+		{
+			uint32_t mid = low + ((high - low) / 2U);
+			if (index->records[mid].pathHash < hash)
+			{
+				low = mid + 1U;
+			}
+			else
+			{
+				high = mid;
+			}
+		}
+
+		while ((low < index->header->recordCount) &&
+			(index->records[low].pathHash == hash) &&
+			(found == NULL))
+		{
+			if (strcmp(IndexString(index, index->records[low].path), path) == 0)
+			{
+				found = &index->records[low];
+			}
+			low++;
+		}
+	}
+
+	return found;
+}
+
+static void PublishIndex(const char *file)
+{
+	MediaLibraryIndex *index = LoadIndex(file);
+
+	if (index != NULL)
+	{
+		MediaLibraryIndex **link;
+		MediaLibraryIndex *old = NULL;
+
+		(void)pthread_rwlock_wrlock(&s_indexLock);
+		for (link = &s_indexes; *link != NULL; link = &(*link)->next)
+		{
+			if (strcmp((*link)->file, file) == 0)
+			{
+				old = *link;
+				index->next = old->next;
+				*link = index;
+				break;
+			}
+		}
+		if (old == NULL)
+		{
+			index->next = s_indexes;
+			s_indexes = index;
+		}
+		(void)pthread_rwlock_unlock(&s_indexLock);
+
+		UnloadIndex(old);
+		INFO_PRINTF("index(%s) published, root(%s), records(%u)\n",
+					file, index->root, index->header->recordCount);
+	}
+}
+
+static char *GetIndexFileName(const char *root)
+{
+	return g_strdup_printf("%s/library-%08x.idx", s_indexDir, HashPath(root));
+}
+
+static char *FindMountPoint(const char *path)
+{
+	char *mountPoint = NULL;
+	size_t bestLength = 0;
+	FILE *fp;
+
+	fp = setmntent(MEDIA_LIBRARY_MOUNTS_FILE, "r");
+	if (fp != NULL)
+	{
+		struct mntent entry;
+		char buffer[MEDIA_LIBRARY_MAX_PATH];
+
+		while (getmntent_r(fp, &entry, buffer, sizeof(buffer)) != NULL)
+		{
+			size_t length = strlen(entry.mnt_dir);
+
+			if ((length >= bestLength) &&
+				(strncmp(path, entry.mnt_dir, length) == 0) &&
+				((path[length] == '/') || (path[length] == '\0') || (strcmp(entry.mnt_dir, "/") == 0)))
+			{
+				char *clone = strdup(entry.mnt_dir);
+				if (clone != NULL)
+				{
+					free(mountPoint);
+					mountPoint = clone;
+					bestLength = length;
+				}
+			}
+		}
+		(void)endmntent(fp);
+	}
+
+	if (mountPoint == NULL)
+	{
+		mountPoint = strdup("/");
+	}
+
+	return mountPoint;
+}
+
+static bool IsRootMounted(const char *root, const char *mountPoint)
+{
+	bool mounted = false;
+
+	if (access(root, R_OK | X_OK) == 0)
+	{
+		char *current = FindMountPoint(root);
+		if (current != NULL)
+		{
+			mounted = (strcmp(current, mountPoint) == 0);
+			free(current);
+		}
+	}
+
+	return mounted;
+}
+
+static void LoadIndexDirectory(void)
+{
+	DIR *dir = opendir(s_indexDir);
+
+	if (dir != NULL)
+	{
+		struct dirent *dent;
+
+		while ((dent = readdir(dir)) != NULL)
+		{
+			size_t length = strlen(dent->d_name);
+
+			if ((strncmp(dent->d_name, "library-", 8) == 0) &&
+				(length > 4U) &&
+				(strcmp(&dent->d_name[length - 4U], ".idx") == 0))
+			{
+				char *file = g_strdup_printf("%s/%s", s_indexDir, dent->d_name);
+				PublishIndex(file);
+				g_free(file);
+			}
+		}
+		(void)closedir(dir);
+	}
+	else
+	{
+		WARN_PRINTF("opendir(%s) failed: error(%d)\n", s_indexDir, errno);
+	}
+}
+
+/* scan thread, access() and the mount table may block on a dead mount */
+static void ResumeInterruptedScans(void)
+{
+	GQueue roots = G_QUEUE_INIT;
+	GQueue mountPoints = G_QUEUE_INIT;
+	const MediaLibraryIndex *index;
+	char *root;
+	char *mountPoint;
+
+	(void)pthread_rwlock_rdlock(&s_indexLock);
+	for (index = s_indexes; index != NULL; index = index->next)
+	{
+		if ((index->header->complete == 0U) && (index->header->cancelled == 0U))
+		{
+			g_queue_push_tail(&roots, g_strdup(index->root));
+			g_queue_push_tail(&mountPoints, g_strdup(IndexString(index, index->header->mountPoint)));
+		}
+	}
+	(void)pthread_rwlock_unlock(&s_indexLock);
+
+	while ((root = (char *)g_queue_pop_head(&roots)) != NULL)
+	{
+		mountPoint = (char *)g_queue_pop_head(&mountPoints);
+		if (IsRootMounted(root, mountPoint) && (QueueScan(root, true) == 0))
+		{
+			INFO_PRINTF("resume interrupted scan of %s\n", root);
+		}
+		g_free(mountPoint);
+		g_free(root);
+	}
+}
+
+static int32_t StartScanThread(void)
+{
+	int32_t err = 0;
+
+	/* with s_scanMutex held */
+	if (!s_scanThreadRun)
+	{
+		if (s_scanThreadJoinable)
+		{
+			(void)pthread_join(s_scanThread, NULL);
+			s_scanThreadJoinable = false;
+		}
+
+		s_scanThreadRun = true;
+		err = pthread_create(&s_scanThread, NULL, ScanThread, NULL);
+		if (err == 0)
+		{
+			s_scanThreadJoinable = true;
+		}
+		else
+		{
+			s_scanThreadRun = false;
+			ERROR_PRINTF("create scan thread failed: error(%d)\n", err);
+		}
+	}
+
+	return err;
+}
+
+static void RequestMountCheck(void)
+{
+	(void)pthread_mutex_lock(&s_scanMutex);
+	if (!s_scanQuit)
+	{
+		s_mountsGeneration++;
+		(void)StartScanThread();
+	}
+	(void)pthread_mutex_unlock(&s_scanMutex);
+}
+
+/* walker or worker of a running scan, only one of them checks each mount change */
+static void CheckScanMounted(MediaLibraryScan *scan)
+{
+	uint32_t checked = __atomic_load_n(&scan->mountsGeneration, __ATOMIC_RELAXED);
+	uint32_t generation = __atomic_load_n(&s_mountsGeneration, __ATOMIC_RELAXED);
+	int32_t running = 0;
+
+	if ((checked != generation) &&
+		__atomic_compare_exchange_n(&scan->mountsGeneration, &checked, generation, false,
+									__ATOMIC_RELAXED, __ATOMIC_RELAXED) &&
+		!IsRootMounted(scan->root, scan->mountPoint))
+	{
+		INFO_PRINTF("%s was unmounted, interrupt scan\n", scan->root);
+		/* a user cancel stays a user cancel */
+		(void)__atomic_compare_exchange_n(&s_scanCancel, &running, SCAN_CANCEL_INTERRUPT, false,
+										  __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+	}
+}
+
+static gboolean OnMountsChanged(GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	int32_t fd = g_io_channel_unix_get_fd(source);
+	char buffer[1024];
+
+	/* the mount table must be read again to re-arm the poll event */
+	(void)lseek(fd, 0, SEEK_SET);
+	while (read(fd, buffer, sizeof(buffer)) > 0)
+	{
+		;
+	}
+
+	DEBUG_PRINTF("mount table changed\n");
+
+	/* a running scan checks its root, the scan thread resumes the interrupted ones */
+	RequestMountCheck();
+
+	(void)condition;
+	(void)data;
+	return (gboolean)TRUE;
+}
+
+static void StartMountsWatch(void)
+{
+	int32_t fd = open(MEDIA_LIBRARY_MOUNTS_FILE, O_RDONLY | O_CLOEXEC);
+
+	if (fd >= 0)
+	{
+		s_mountsChannel = g_io_channel_unix_new(fd);
+		if (s_mountsChannel != NULL)
+		{
+			s_mountsWatchID = g_io_add_watch(s_mountsChannel, (GIOCondition)(G_IO_PRI | G_IO_ERR), OnMountsChanged, NULL);
+		}
+		else
+		{
+			(void)close(fd);
+		}
+	}
+	else
+	{
+		WARN_PRINTF("open(%s) failed: error(%d)\n", MEDIA_LIBRARY_MOUNTS_FILE, errno);
+	}
+}
+
+static void StopMountsWatch(void)
+{
+	if (s_mountsWatchID != 0U)
+	{
+		(void)g_source_remove(s_mountsWatchID);
+		s_mountsWatchID = 0;
+	}
+
+	if (s_mountsChannel != NULL)
+	{
+		int32_t fd = g_io_channel_unix_get_fd(s_mountsChannel);
+		g_io_channel_unref(s_mountsChannel);
+		s_mountsChannel = NULL;
+		(void)close(fd);
+	}
+}
+
+static void *ScanThread(void *arg)
+{
+	bool run = true;
+
+	gst_init(NULL, NULL);
+
+	while (run)
+	{
+		char *root = NULL;
+		bool mountsChanged = false;
+
+		(void)pthread_mutex_lock(&s_scanMutex);
+		if ((s_mountsChecked != s_mountsGeneration) && !s_scanQuit)
+		{
+			s_mountsChecked = s_mountsGeneration;
+			mountsChanged = true;
+		}
+		else
+		{
+			root = (char *)g_queue_pop_head(&s_scanQueue);
+			if (root != NULL)
+			{
+				s_activeRoot = root;
+				__atomic_store_n(&s_scanCancel, 0, __ATOMIC_RELEASE);
+			}
+			else
+			{
+				s_scanThreadRun = false;
+				run = false;
+			}
+		}
+		(void)pthread_mutex_unlock(&s_scanMutex);
+
+		if (mountsChanged)
+		{
+			ResumeInterruptedScans();
+		}
+		else if (root != NULL)
+		{
+			RunScan(root);
+
+			(void)pthread_mutex_lock(&s_scanMutex);
+			s_activeRoot = NULL;
+			(void)pthread_mutex_unlock(&s_scanMutex);
+			free(root);
+		}
+	}
+
+	(void)arg;
+	pthread_exit((void *)"media library scan thread exit\n");
+}
+
+static void RunScan(const char *root)
+{
+	MediaLibraryScan *scan;
+
+	scan = (MediaLibraryScan *)calloc(1, sizeof(MediaLibraryScan));
+	if (scan == NULL)
+	{
+		ERROR_PRINTF("calloc failed\n");
+		if (MediaLibraryScanCompletedCB != NULL)
+		{
+			MediaLibraryScanCompletedCB(root, 0, (int32_t)MediaLibraryScanFailed);
+		}
+	}
+	else
+	{
+		RunScanWorkers(scan, root);
+	}
+}
+
+static void RunScanWorkers(MediaLibraryScan *scan, const char *root)
+{
+	pthread_t workers[MEDIA_LIBRARY_MAX_WORKERS];
+	uint32_t workerCount = 0;
+	uint32_t maxWorkers;
+	uint32_t idx;
+	MediaLibraryScanResult result = MediaLibraryScanFailed;
+	int64_t startTime = TCTimeGetMonotonicMs();
+
+	scan->root = strdup(root);
+	scan->mountPoint = FindMountPoint(root);
+	scan->indexFile = GetIndexFileName(root);
+	(void)pthread_mutex_lock(&s_scanMutex);
+	scan->mountsGeneration = s_mountsGeneration;
+	(void)pthread_mutex_unlock(&s_scanMutex);
+	(void)pthread_mutex_init(&scan->jobMutex, NULL);
+	(void)pthread_mutex_init(&scan->resultMutex, NULL);
+	(void)pthread_cond_init(&scan->jobAvailable, NULL);
+	(void)pthread_cond_init(&scan->jobSpace, NULL);
+
+	if ((scan->root != NULL) && (scan->mountPoint != NULL) && (scan->indexFile != NULL))
+	{
+		/* a private mapping of the last index, used to skip files that did not change */
+		scan->previous = LoadIndex(scan->indexFile);
+		if ((scan->previous != NULL) && (strcmp(scan->previous->root, root) != 0))
+		{
+			UnloadIndex(scan->previous);
+			scan->previous = NULL;
+		}
+
+		maxWorkers = GetWorkerCount();
+		for (idx = 0; idx < maxWorkers; idx++)
+		{
+			if (pthread_create(&workers[workerCount], NULL, ScanWorker, scan) == 0)
+			{
+				workerCount++;
+			}
+		}
+
+		INFO_PRINTF("scan %s with %u workers, resume(%s), index(%s)\n",
+					root, workerCount, (scan->previous != NULL) ? "yes" : "no", scan->indexFile);
+
+		if (workerCount > 0U)
+		{
+			bool walked = WalkDirectory(scan, root, 0);
+
+			(void)pthread_mutex_lock(&scan->jobMutex);
+			scan->walkDone = true;
+			(void)pthread_cond_broadcast(&scan->jobAvailable);
+			(void)pthread_mutex_unlock(&scan->jobMutex);
+
+			for (idx = 0; idx < workerCount; idx++)
+			{
+				(void)pthread_join(workers[idx], NULL);
+			}
+
+			if (__atomic_load_n(&s_scanCancel, __ATOMIC_ACQUIRE) != 0)
+			{
+				result = MediaLibraryScanInterrupted;
+			}
+			else if (walked)
+			{
+				result = MediaLibraryScanCompleted;
+			}
+			else
+			{
+				result = MediaLibraryScanFailed;
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("no scan worker could be created\n");
+		}
+
+		if (result != MediaLibraryScanFailed)
+		{
+			(void)pthread_mutex_lock(&scan->resultMutex);
+			if (result == MediaLibraryScanInterrupted)
+			{
+				MergePreviousEntries(scan);
+			}
+			if (WriteIndex(scan, scan->entries, scan->entryCount, (result == MediaLibraryScanCompleted)) != 0)
+			{
+				result = MediaLibraryScanFailed;
+			}
+			(void)pthread_mutex_unlock(&scan->resultMutex);
+		}
+
+		/* the private mapping must be gone before the new index is published */
+		UnloadIndex(scan->previous);
+		scan->previous = NULL;
+
+		if (result != MediaLibraryScanFailed)
+		{
+			PublishIndex(scan->indexFile);
+		}
+
+		ReportProgress(scan, true);
+	}
+
+	INFO_PRINTF("scan %s finished, result(%d), records(%u), elapsed(%lld ms)\n",
+				root, result, scan->entryCount, (long long)(TCTimeGetMonotonicMs() - startTime));
+
+	if (MediaLibraryScanCompletedCB != NULL)
+	{
+		MediaLibraryScanCompletedCB(root, scan->entryCount, (int32_t)result);
+	}
+
+	for (idx = 0; idx < scan->entryCount; idx++)
+	{
+		ReleaseEntry(&scan->entries[idx]);
+	}
+	for (idx = 0; idx < scan->jobCount; idx++)
+	{
+		free(scan->jobs[(scan->jobHead + idx) % MEDIA_LIBRARY_JOB_QUEUE_SIZE]);
+	}
+	free(scan->entries);
+	free(scan->root);
+	free(scan->mountPoint);
+	g_free(scan->indexFile);
+	(void)pthread_cond_destroy(&scan->jobAvailable);
+	(void)pthread_cond_destroy(&scan->jobSpace);
+	(void)pthread_mutex_destroy(&scan->jobMutex);
+	(void)pthread_mutex_destroy(&scan->resultMutex);
+	free(scan);
+}
+
+static bool WalkDirectory(MediaLibraryScan *scan, const char *dir, uint32_t depth)
+{
+	bool opened = false;
+	DIR *dp;
+
+	dp = opendir(dir);
+	if (dp != NULL)
+	{
+		struct dirent *dent;
+		bool run = true;
+
+		opened = true;
+		while (run && ((dent = readdir(dp)) != NULL))
+		{
+			/* skip hidden entries, "." and ".." */
+			if (dent->d_name[0] != '.')
+			{
+				unsigned char type = dent->d_type;
+				char *path = g_strdup_printf("%s/%s", dir, dent->d_name);
+
+				if (type == DT_UNKNOWN)
+				{
+					struct stat st;
+					if (lstat(path, &st) == 0)
+					{
+						if (S_ISDIR(st.st_mode))
+						{
+							type = DT_DIR;
+						}
+						else if (S_ISREG(st.st_mode))
+						{
+							type = DT_REG;
+						}
+						else
+						{
+							;
+						}
+					}
+				}
+
+				if ((type == DT_DIR) && (depth < (uint32_t)MEDIA_LIBRARY_MAX_DEPTH))
+				{
+					(void)WalkDirectory(scan, path, depth + 1U);
+				}
+				else if ((type == DT_REG) && IsMediaFile(dent->d_name))
+				{
+					char *job = strdup(path);
+					if ((job == NULL) || !PushJob(scan, job))
+					{
+						free(job);
+						run = false;
+					}
+				}
+				else
+				{
+					;
+				}
+				g_free(path);
+			}
+
+			CheckScanMounted(scan);
+			if (__atomic_load_n(&s_scanCancel, __ATOMIC_ACQUIRE) != 0)
+			{
+				run = false;
+			}
+		}
+		(void)closedir(dp);
+	}
+	else
+	{
+		WARN_PRINTF("opendir(%s) failed: error(%d)\n", dir, errno);
+	}
+
+	return opened;
+}
+
+static bool IsMediaFile(const char *name)
+{
+	bool media = false;
+	const char *ext = strrchr(name, '.');
+
+	if (ext != NULL)
+	{
+		uint32_t idx;
+		ext++;
+		for (idx = 0; (s_mediaExtensions[idx] != NULL) && !media; idx++)
+		{
+			media = (strcasecmp(ext, s_mediaExtensions[idx]) == 0);
+		}
+	}
+
+	return media;
+}
+
+static bool PushJob(MediaLibraryScan *scan, char *path)
+{
+	bool pushed = false;
+
+	(void)pthread_mutex_lock(&scan->jobMutex);
+	while ((scan->jobCount == (uint32_t)MEDIA_LIBRARY_JOB_QUEUE_SIZE) &&
+		(__atomic_load_n(&s_scanCancel, __ATOMIC_ACQUIRE) == 0))
+	{
+		(void)pthread_cond_wait(&scan->jobSpace, &scan->jobMutex);
+	}
+
+	if (scan->jobCount < (uint32_t)MEDIA_LIBRARY_JOB_QUEUE_SIZE)
+	{
+		scan->jobs[(scan->jobHead + scan->jobCount) % MEDIA_LIBRARY_JOB_QUEUE_SIZE] = path;
+		scan->jobCount++;
+		(void)__atomic_add_fetch(&scan->found, 1U, __ATOMIC_RELAXED);
+		(void)pthread_cond_signal(&scan->jobAvailable);
+		pushed = true;
+	}
+	(void)pthread_mutex_unlock(&scan->jobMutex);
+
+	return pushed;
+}
+
+static char *PopJob(MediaLibraryScan *scan)
+{
+	char *path = NULL;
+
+	(void)pthread_mutex_lock(&scan->jobMutex);
+	while ((scan->jobCount == 0U) && !scan->walkDone)
+	{
+		(void)pthread_cond_wait(&scan->jobAvailable, &scan->jobMutex);
+	}
+
+	if (scan->jobCount > 0U)
+	{
+		path = scan->jobs[scan->jobHead];
+		scan->jobHead = (scan->jobHead + 1U) % MEDIA_LIBRARY_JOB_QUEUE_SIZE;
+		scan->jobCount--;
+		(void)pthread_cond_signal(&scan->jobSpace);
+	}
+	(void)pthread_mutex_unlock(&scan->jobMutex);
+
+	return path;
+}
+
+static void *ScanWorker(void *arg)
+{
+	MediaLibraryScan *scan = (MediaLibraryScan *)arg;
+	GstDiscoverer *discoverer;
+	GError *error = NULL;
+	char *path;
+
+	discoverer = gst_discoverer_new(MEDIA_LIBRARY_DISCOVER_TIMEOUT, &error);
+	if (discoverer == NULL)
+	{
+		ERROR_PRINTF("gst_discoverer_new failed(%s)\n", (error != NULL) ? error->message : "");
+	}
+	if (error != NULL)
+	{
+		g_error_free(error);
+	}
+
+	while ((path = PopJob(scan)) != NULL)
+	{
+		CheckScanMounted(scan);
+		if (__atomic_load_n(&s_scanCancel, __ATOMIC_ACQUIRE) == 0)
+		{
+			ScanFile(scan, discoverer, path);
+		}
+		else
+		{
+			/* wake the walker if it waits for space */
+			(void)pthread_mutex_lock(&scan->jobMutex);
+			(void)pthread_cond_broadcast(&scan->jobSpace);
+			(void)pthread_mutex_unlock(&scan->jobMutex);
+		}
+		free(path);
+	}
+
+	if (discoverer != NULL)
+	{
+		g_object_unref(discoverer);
+	}
+
+	return NULL;
+}
+
+static void ScanFile(MediaLibraryScan *scan, GstDiscoverer *discoverer, const char *path)
+{
+	struct stat st;
+
+	if ((stat(path, &st) == 0) && S_ISREG(st.st_mode))
+	{
+		MediaLibraryEntry entry;
+		const MediaLibraryRecord *record;
+
+		(void)memset(&entry, 0x00, sizeof(entry));
+		entry.path = strdup(path);
+		entry.pathHash = HashPath(path);
+		entry.size = (uint64_t)st.st_size;
+		entry.mtime = (int64_t)st.st_mtime;
+
+		record = FindRecord(scan->previous, path, entry.pathHash);
+		if ((record != NULL) && (record->size == entry.size) && (record->mtime == entry.mtime))
+		{
+			entry.title = strdup(IndexString(scan->previous, record->title));
+			entry.artist = strdup(IndexString(scan->previous, record->artist));
+			entry.album = strdup(IndexString(scan->previous, record->album));
+			entry.genre = strdup(IndexString(scan->previous, record->genre));
+			entry.durationMs = record->durationMs;
+			entry.flags = record->flags;
+		}
+		else if (discoverer != NULL)
+		{
+			DiscoverFile(discoverer, path, &entry);
+		}
+		else
+		{
+			entry.flags = MEDIA_LIBRARY_FLAG_NO_TAG;
+		}
+
+		if (entry.path != NULL)
+		{
+			AddEntry(scan, &entry);
+		}
+		else
+		{
+			ReleaseEntry(&entry);
+		}
+	}
+}
+
+static void DiscoverFile(GstDiscoverer *discoverer, const char *path, MediaLibraryEntry *entry)
+{
+	gchar *uri;
+	GError *error = NULL;
+
+	entry->flags = MEDIA_LIBRARY_FLAG_NO_TAG;
+
+	uri = gst_filename_to_uri(path, NULL);
+	if (uri != NULL)
+	{
+		GstDiscovererInfo *info = gst_discoverer_discover_uri(discoverer, uri, &error);
+		if (info != NULL)
+		{
+			if (gst_discoverer_info_get_result(info) == GST_DISCOVERER_OK)
+			{
+				GstClockTime duration = gst_discoverer_info_get_duration(info);
+				const GstTagList *tags = gst_discoverer_info_get_tags(info);
+				GList *streams;
+				GList *item;
+
+				if (GST_CLOCK_TIME_IS_VALID(duration))
+				{
+					entry->durationMs = (uint32_t)GST_TIME_AS_MSECONDS(duration);
+				}
+
+				streams = gst_discoverer_info_get_video_streams(info);
+				for (item = streams; item != NULL; item = item->next)
+				{
+					if (!gst_discoverer_video_info_is_image(GST_DISCOVERER_VIDEO_INFO(item->data)))
+					{
+						entry->flags |= MEDIA_LIBRARY_FLAG_VIDEO;
+					}
+				}
+				gst_discoverer_stream_info_list_free(streams);
+
+				if (tags != NULL)
+				{
+					entry->flags &= ~MEDIA_LIBRARY_FLAG_NO_TAG;
+					entry->title = GetTagString(tags, GST_TAG_TITLE);
+					entry->artist = GetTagString(tags, GST_TAG_ARTIST);
+					entry->album = GetTagString(tags, GST_TAG_ALBUM);
+					entry->genre = GetTagString(tags, GST_TAG_GENRE);
+					if ((gst_tag_list_get_tag_size(tags, GST_TAG_IMAGE) > 0U) ||
+						(gst_tag_list_get_tag_size(tags, GST_TAG_PREVIEW_IMAGE) > 0U))
+					{
+						entry->flags |= MEDIA_LIBRARY_FLAG_COVER_ART;
+					}
+				}
+			}
+			else
+			{
+				DEBUG_PRINTF("discover(%s) result(%d)\n", path, gst_discoverer_info_get_result(info));
+			}
+			gst_discoverer_info_unref(info);
+		}
+		else
+		{
+			WARN_PRINTF("discover(%s) failed(%s)\n", path, (error != NULL) ? error->message : "");
+		}
+		g_free(uri);
+	}
+
+	if (error != NULL)
+	{
+		g_error_free(error);
+	}
+}
+
+static char *GetTagString(const GstTagList *tags, const gchar *tag)
+{
+	char *string = NULL;
+	gchar *value = NULL;
+
+	if (gst_tag_list_get_string(tags, tag, &value))
+	{
+		string = strdup(value);
+		g_free(value);
+	}
+
+	return string;
+}
+
+static void AddEntry(MediaLibraryScan *scan, const MediaLibraryEntry *entry)
+{
+	bool checkpoint = false;
+
+	(void)pthread_mutex_lock(&scan->resultMutex);
+
+	if (scan->entryCount == scan->entryCapacity)
+	{
+		uint32_t capacity = (scan->entryCapacity == 0U) ? 1024U : (scan->entryCapacity * 2U);
+		MediaLibraryEntry *entries = (MediaLibraryEntry *)realloc(scan->entries, capacity * sizeof(MediaLibraryEntry));
+		if (entries != NULL)
+		{
+			scan->entries = entries;
+			scan->entryCapacity = capacity;
+		}
+	}
+
+	if (scan->entryCount < scan->entryCapacity)
+	{
+		scan->entries[scan->entryCount] = *entry;
+		scan->entryCount++;
+		scan->uncheckpointed++;
+
+		if ((scan->uncheckpointed >= (uint32_t)MEDIA_LIBRARY_CHECKPOINT_COUNT) && !scan->checkpointing)
+		{
+			scan->uncheckpointed = 0;
+			scan->checkpointing = true;
+			checkpoint = true;
+		}
+	}
+	else
+	{
+		MediaLibraryEntry dropped = *entry;
+		ERROR_PRINTF("realloc failed, drop %s\n", entry->path);
+		ReleaseEntry(&dropped);
+	}
+
+	(void)pthread_mutex_unlock(&scan->resultMutex);
+
+	if (checkpoint)
+	{
+		WriteCheckpoint(scan);
+	}
+
+	ReportProgress(scan, false);
+}
+
+static void ReportProgress(MediaLibraryScan *scan, bool force)
+{
+	bool report = false;
+	uint32_t scanned = 0;
+	uint32_t found;
+	int64_t now = TCTimeGetMonotonicMs();
+
+	(void)pthread_mutex_lock(&scan->resultMutex);
+	if (force || ((now - scan->lastProgress) >= MEDIA_LIBRARY_PROGRESS_INTERVAL))
+	{
+		scan->lastProgress = now;
+		scanned = scan->entryCount;
+		report = true;
+	}
+	(void)pthread_mutex_unlock(&scan->resultMutex);
+
+	found = __atomic_load_n(&scan->found, __ATOMIC_RELAXED);
+
+	if (report && (MediaLibraryScanProgressCB != NULL))
+	{
+		MediaLibraryScanProgressCB(scan->root, scanned, found);
+	}
+}
+
+static void MergePreviousEntries(MediaLibraryScan *scan)
+{
+	/* keep what an earlier interrupted run already knew but this run did not reach */
+	if ((scan->previous != NULL) && (scan->previous->header->recordCount > 0U))
+	{
+		GHashTable *visited = g_hash_table_new(g_str_hash, g_str_equal);
+		const MediaLibraryIndex *previous = scan->previous;
+		uint32_t idx;
+		bool run = true;
+
+		for (idx = 0; idx < scan->entryCount; idx++)
+		{
+			(void)g_hash_table_insert(visited, scan->entries[idx].path, scan->entries[idx].path);
+		}
+
+		for (idx = 0; (idx < previous->header->recordCount) && run; idx++)
+		{
+			const MediaLibraryRecord *record = &previous->records[idx];
+			const char *path = IndexString(previous, record->path);
+
+			if (g_hash_table_contains(visited, path) == FALSE)
+			{
+				if (scan->entryCount == scan->entryCapacity)
+				{
+					uint32_t capacity = (scan->entryCapacity == 0U) ? 1024U : (scan->entryCapacity * 2U);
+					MediaLibraryEntry *entries = (MediaLibraryEntry *)realloc(scan->entries, capacity * sizeof(MediaLibraryEntry));
+					if (entries != NULL)
+					{
+						scan->entries = entries;
+						scan->entryCapacity = capacity;
+					}
+					else
+					{
+						ERROR_PRINTF("realloc failed\n");
+						run = false;
+					}
+				}
+
+				if (run)
+				{
+					MediaLibraryEntry *entry = &scan->entries[scan->entryCount];
+
+					entry->path = strdup(path);
+					entry->title = strdup(IndexString(previous, record->title));
+					entry->artist = strdup(IndexString(previous, record->artist));
+					entry->album = strdup(IndexString(previous, record->album));
+					entry->genre = strdup(IndexString(previous, record->genre));
+					entry->pathHash = record->pathHash;
+					entry->durationMs = record->durationMs;
+					entry->flags = record->flags;
+					entry->size = record->size;
+					entry->mtime = record->mtime;
+					scan->entryCount++;
+				}
+			}
+		}
+
+		g_hash_table_destroy(visited);
+	}
+}
+
+/*
+ * The other workers go on adding entries while the checkpoint is sorted and
+ * written from a copy. The copy borrows the strings of the entries, which
+ * stay until the scan ends, and of the mapping of the previous index, whose
+ * records this run did not reach yet, so a resumed scan that is interrupted
+ * again still has them.
+ */
+static void WriteCheckpoint(MediaLibraryScan *scan)
+{
+	const MediaLibraryIndex *previous = scan->previous;
+	uint32_t previousCount = (previous != NULL) ? previous->header->recordCount : 0U;
+	MediaLibraryEntry *entries = NULL;
+	uint32_t visited = 0;
+	uint32_t count = 0;
+	uint32_t idx;
+	uint32_t pos = 0;
+
+	(void)pthread_mutex_lock(&scan->resultMutex);
+	visited = scan->entryCount;
+	entries = (MediaLibraryEntry *)malloc(((size_t)visited + previousCount) * sizeof(MediaLibraryEntry));
+	if (entries != NULL)
+	{
+		(void)memcpy(entries, scan->entries, (size_t)visited * sizeof(MediaLibraryEntry));
+	}
+	(void)pthread_mutex_unlock(&scan->resultMutex);
+
+	if (entries != NULL)
+	{
+		qsort(entries, visited, sizeof(MediaLibraryEntry), CompareEntries);
+		count = visited;
+
+		/* both are in CompareEntries order, so one pass finds the records not visited */
+		for (idx = 0; idx < previousCount; idx++)
+		{
+			const MediaLibraryRecord *record = &previous->records[idx];
+			MediaLibraryEntry *entry = &entries[count];
+			int compare = 1;
+
+			(void)memset(entry, 0x00, sizeof(MediaLibraryEntry));
+			entry->path = (char *)IndexString(previous, record->path);
+			entry->pathHash = record->pathHash;
+			while ((pos < visited) && ((compare = CompareEntries(&entries[pos], entry)) < 0))
+			{
+				pos++;
+			}
+
+			if ((pos >= visited) || (compare != 0))
+			{
+				entry->title = (char *)IndexString(previous, record->title);
+				entry->artist = (char *)IndexString(previous, record->artist);
+				entry->album = (char *)IndexString(previous, record->album);
+				entry->genre = (char *)IndexString(previous, record->genre);
+				entry->durationMs = record->durationMs;
+				entry->flags = record->flags;
+				entry->size = record->size;
+				entry->mtime = record->mtime;
+				count++;
+			}
+		}
+
+		(void)WriteIndex(scan, entries, count, false);
+		free(entries);
+	}
+	else
+	{
+		ERROR_PRINTF("out of memory for checkpoint\n");
+	}
+
+	(void)pthread_mutex_lock(&scan->resultMutex);
+	scan->checkpointing = false;
+	(void)pthread_mutex_unlock(&scan->resultMutex);
+}
+
+static int32_t WriteIndex(MediaLibraryScan *scan, MediaLibraryEntry *entries, uint32_t count, bool complete)
+{
+	int32_t ret = -1;
+	MediaLibraryIndexHeader header;
+	MediaLibraryRecord *records = NULL;
+	StringPool pool;
+	uint32_t idx;
+
+	qsort(entries, count, sizeof(MediaLibraryEntry), CompareEntries);
+
+	StringPoolInitialize(&pool);
+
+	if (count > 0U)
+	{
+		records = (MediaLibraryRecord *)calloc(count, sizeof(MediaLibraryRecord));
+		pool.failed = (records == NULL);
+	}
+
+	(void)memset(&header, 0x00, sizeof(header));
+	(void)memcpy(header.magic, MEDIA_LIBRARY_INDEX_MAGIC, sizeof(header.magic));
+	header.version = MEDIA_LIBRARY_INDEX_VERSION;
+	header.headerSize = sizeof(MediaLibraryIndexHeader);
+	header.recordSize = sizeof(MediaLibraryRecord);
+	header.recordCount = count;
+	header.complete = complete ? 1U : 0U;
+	header.cancelled = (!complete && (__atomic_load_n(&s_scanCancel, __ATOMIC_ACQUIRE) == SCAN_CANCEL_USER)) ? 1U : 0U;
+	header.root = StringPoolAdd(&pool, scan->root, false);
+	header.mountPoint = StringPoolAdd(&pool, scan->mountPoint, false);
+	header.scanTime = (int64_t)time(NULL);
+
+	for (idx = 0; (idx < count) && !pool.failed; idx++)
+	{
+		const MediaLibraryEntry *entry = &entries[idx];
+		MediaLibraryRecord *record = &records[idx];
+
+		record->pathHash = entry->pathHash;
+		record->path = StringPoolAdd(&pool, entry->path, false);
+		record->title = StringPoolAdd(&pool, entry->title, true);
+		record->artist = StringPoolAdd(&pool, entry->artist, true);
+		record->album = StringPoolAdd(&pool, entry->album, true);
+		record->genre = StringPoolAdd(&pool, entry->genre, true);
+		record->durationMs = entry->durationMs;
+		record->flags = entry->flags;
+		record->size = entry->size;
+		record->mtime = entry->mtime;
+	}
+
+	header.stringPoolOffset = (uint32_t)(sizeof(MediaLibraryIndexHeader) + ((size_t)count * sizeof(MediaLibraryRecord)));
+	header.stringPoolSize = pool.size;
+
+	if (!pool.failed)
+	{
+		char *tempFile = g_strdup_printf("%s.tmp", scan->indexFile);
+		int32_t fd = open(tempFile, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+		if (fd >= 0)
+		{
+			bool written = WriteAll(fd, &header, sizeof(header)) &&
+							WriteAll(fd, records, (size_t)count * sizeof(MediaLibraryRecord)) &&
+							WriteAll(fd, pool.data, pool.size) &&
+							(fdatasync(fd) == 0);
+
+			(void)close(fd);
+			if (written && (rename(tempFile, scan->indexFile) == 0))
+			{
+				DEBUG_PRINTF("index(%s) written, records(%u), pool(%u), complete(%d)\n",
+							scan->indexFile, count, pool.size, complete);
+				ret = 0;
+			}
+			else
+			{
+				ERROR_PRINTF("write index(%s) failed: error(%d)\n", tempFile, errno);
+				(void)unlink(tempFile);
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("open(%s) failed: error(%d)\n", tempFile, errno);
+		}
+		g_free(tempFile);
+	}
+	else
+	{
+		ERROR_PRINTF("out of memory while building index\n");
+	}
+
+	StringPoolRelease(&pool);
+	free(records);
+
+	return ret;
+}
+
+static int CompareEntries(const void *a, const void *b)
+{
+	const MediaLibraryEntry *left = (const MediaLibraryEntry *)a;
+	const MediaLibraryEntry *right = (const MediaLibraryEntry *)b;
+	int ret;
+
+	if (left->pathHash < right->pathHash)
+	{
+		ret = -1;
+	}
+	else if (left->pathHash > right->pathHash)
+	{
+		ret = 1;
+	}
+	else
+	{
+		ret = strcmp(left->path, right->path);
+	}
+
+	return ret;
+}
+
+static void StringPoolInitialize(StringPool *pool)
+{
+	pool->capacity = 64 * 1024;
+	pool->data = (char *)malloc(pool->capacity);
+	pool->size = 1;
+	pool->offsets = g_hash_table_new(g_str_hash, g_str_equal);
+	pool->failed = (pool->data == NULL);
+	if (!pool->failed)
+	{
+		pool->data[0] = '\0';
+	}
+}
+
+static void StringPoolRelease(StringPool *pool)
+{
+	g_hash_table_destroy(pool->offsets);
+	free(pool->data);
+	pool->data = NULL;
+}
+
+static uint32_t StringPoolAdd(StringPool *pool, const char *string, bool dedup)
+{
+	uint32_t offset = 0;
+
+	if ((string != NULL) && (string[0] != '\0') && !pool->failed)
+	{
+		gpointer found = NULL;
+
+		if (dedup)
+		{
+			found = g_hash_table_lookup(pool->offsets, string);
+		}
+
+		if (found != NULL)
+		{
+			offset = GPOINTER_TO_UINT(found);
+		}
+		else
+		{
+			size_t length = strlen(string) + 1U;
+
+			if (((size_t)pool->size + length) > pool->capacity)
+			{
+				size_t capacity = (size_t)pool->capacity * 2U;
+				char *data;
+
+				while (capacity < ((size_t)pool->size + length))
+				{
+					capacity *= 2U;
+				}
+				data = (capacity <= UINT32_MAX) ? (char *)realloc(pool->data, capacity) : NULL;
+				if (data != NULL)
+				{
+					pool->data = data;
+					pool->capacity = (uint32_t)capacity;
+				}
+				else
+				{
+					pool->failed = true;
+				}
+			}
+
+			if (!pool->failed)
+			{
+				offset = pool->size;
+				(void)memcpy(&pool->data[offset], string, length);
+				pool->size += (uint32_t)length;
+				if (dedup)
+				{
+					/* keys are the entry strings, which outlive the pool */
+					(void)g_hash_table_insert(pool->offsets, (gpointer)string, GUINT_TO_POINTER(offset));
+				}
+			}
+		}
+	}
+
+	return offset;
+}
+
+static bool WriteAll(int32_t fd, const void *buffer, size_t length)
+{
+	const uint8_t *data = (const uint8_t *)buffer;
+	bool ret = true;
+
+	while ((length > 0U) && ret)
+	{
+		ssize_t written = write(fd, data, length);
+		if (written > 0)
+		{
+			data += written;
+			length -= (size_t)written;
+		}
+		else if ((written < 0) && (errno == EINTR))
+		{
+			;
+		}
+		else
+		{
+			ret = false;
+		}
+	}
+
+	return ret;
+}
+
+static void ReleaseEntry(MediaLibraryEntry *entry)
+{
+	free(entry->path);
+	free(entry->title);
+	free(entry->artist);
+	free(entry->album);
+	free(entry->genre);
+	(void)memset(entry, 0x00, sizeof(MediaLibraryEntry));
+}
+
+static uint32_t GetWorkerCount(void)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	uint32_t count;
+
+	if (cpus < 1)
+	{
+		count = 1;
+	}
+	else if (cpus > MEDIA_LIBRARY_MAX_WORKERS)
+	{
+		count = MEDIA_LIBRARY_MAX_WORKERS;
+	}
+	else
+	{
+		count = (uint32_t)cpus;
+	}
+
+	return count;
+}
@@ -0,0 +1,380 @@
+/****************************************************************************************
+ *   FileName    : MediaPlaybackChannel.c
+ *   Description : Telechips Media Playback Peer Channel
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <dbus/dbus.h>
+#include "TCLog.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MediaPlaybackChannel.h"
+
+#define CHANNEL_PEER_NAME_SIZE			32
+#define CHANNEL_LISTEN_BACKLOG			4
+
+typedef struct stChannelClient {
+	int32_t fd;							/* -1 if the entry is free */
+	GIOChannel *channel;
+	guint watchID;
+	uint32_t dropped;
+	char name[CHANNEL_PEER_NAME_SIZE];
+} ChannelClient;
+
+static gboolean OnChannelAccept(GIOChannel *source, GIOCondition condition, gpointer data);
+static gboolean OnChannelReadable(GIOChannel *source, GIOCondition condition, gpointer data);
+static void CloseClient(ChannelClient *client);
+static int32_t SendToClient(ChannelClient *client, const char *data, int32_t length);
+
+static char *s_channelPath = NULL;
+static int32_t s_listenFd = -1;
+static GIOChannel *s_listenChannel = NULL;
+static guint s_listenWatchID = 0;
+static uint32_t s_peerSerial = 0;
+static uint32_t s_messageSerial = 0;		/* of the replies and signals only sent here */
+static MediaPlaybackChannelEventCB s_channelCB = {NULL, NULL};
+
+/* clients are added and removed in the main loop, s_channelMutex serializes them with senders */
+static ChannelClient s_clients[MEDIAPLAYBACK_CHANNEL_MAX_CLIENTS];
+static pthread_mutex_t s_channelMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* packets are read in the main loop only */
+static char s_receiveBuffer[MEDIAPLAYBACK_CHANNEL_MAX_MESSAGE];
+
+int32_t MediaPlaybackChannelSetPath(const char *path)
+{
+	int32_t ret = 0;
+
+	if ((path != NULL) && (path[0] != '\0') &&
+		(strlen(path) < sizeof(((struct sockaddr_un *)NULL)->sun_path)))
+	{
+		g_free(s_channelPath);
+		s_channelPath = g_strdup(path);
+		ret = 1;
+	}
+	else
+	{
+		ERROR_PRINTF("invalid socket path(%s)\n", (path != NULL) ? path : "");
+	}
+
+	return ret;
+}
+
+int32_t MediaPlaybackChannelInitialize(const MediaPlaybackChannelEventCB *cb)
+{
+	int32_t ret = 0;
+	struct sockaddr_un address;
+	uint32_t idx;
+
+	for (idx = 0; idx < (uint32_t)MEDIAPLAYBACK_CHANNEL_MAX_CLIENTS; idx++)
+	{
+		s_clients[idx].fd = -1;
+	}
+
+	if ((s_channelPath != NULL) && (cb != NULL))
+	{
+		s_channelCB = *cb;
+
+		s_listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+		if (s_listenFd >= 0)
+		{
+			(void)memset(&address, 0, sizeof(address));
+			address.sun_family = AF_UNIX;
+			(void)g_strlcpy(address.sun_path, s_channelPath, sizeof(address.sun_path));
+
+			/* a socket left by a daemon that did not exit cleanly */
+			(void)unlink(s_channelPath);
+
+			if ((bind(s_listenFd, (struct sockaddr *)&address, sizeof(address)) == 0) &&
+				(chmod(s_channelPath, 0660) == 0) &&
+				(listen(s_listenFd, CHANNEL_LISTEN_BACKLOG) == 0))
+			{
+				s_listenChannel = g_io_channel_unix_new(s_listenFd);
+				if (s_listenChannel != NULL)
+				{
+					s_listenWatchID = g_io_add_watch(s_listenChannel, G_IO_IN, OnChannelAccept, NULL);
+					INFO_PRINTF("control channel on %s\n", s_channelPath);
+					ret = 1;
+				}
+			}
+			else
+			{
+				ERROR_PRINTF("listen on %s failed: error(%d)\n", s_channelPath, errno);
+			}
+
+			if (ret != 1)
+			{
+				(void)close(s_listenFd);
+				s_listenFd = -1;
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("socket failed: error(%d)\n", errno);
+		}
+	}
+
+	return ret;
+}
+
+void MediaPlaybackChannelRelease(void)
+{
+	uint32_t idx;
+
+	if (s_listenWatchID != 0U)
+	{
+		(void)g_source_remove(s_listenWatchID);
+		s_listenWatchID = 0;
+	}
+	if (s_listenChannel != NULL)
+	{
+		g_io_channel_unref(s_listenChannel);
+		s_listenChannel = NULL;
+	}
+	if (s_listenFd >= 0)
+	{
+		(void)close(s_listenFd);
+		s_listenFd = -1;
+		(void)unlink(s_channelPath);
+	}
+
+	for (idx = 0; idx < (uint32_t)MEDIAPLAYBACK_CHANNEL_MAX_CLIENTS; idx++)
+	{
+		if (s_clients[idx].fd >= 0)
+		{
+			if (s_clients[idx].watchID != 0U)
+			{
+				(void)g_source_remove(s_clients[idx].watchID);
+			}
+			CloseClient(&s_clients[idx]);
+		}
+	}
+
+	g_free(s_channelPath);
+	s_channelPath = NULL;
+}
+
+bool MediaPlaybackChannelIsPeer(const char *name)
+{
+	return ((name != NULL) &&
+			(strncmp(name, MEDIAPLAYBACK_CHANNEL_PEER_PREFIX, sizeof(MEDIAPLAYBACK_CHANNEL_PEER_PREFIX) - 1U) == 0));
+}
+
+int32_t MediaPlaybackChannelSend(DBusMessage *message)
+{
+	int32_t ret = -1;
+	const char *destination = dbus_message_get_destination(message);
+	char *data = NULL;
+	int length = 0;
+	uint32_t idx;
+
+	(void)pthread_mutex_lock(&s_channelMutex);
+	for (idx = 0; idx < (uint32_t)MEDIAPLAYBACK_CHANNEL_MAX_CLIENTS; idx++)
+	{
+		ChannelClient *client = &s_clients[idx];
+
+		if ((client->fd >= 0) &&
+			((destination == NULL) || (strcmp(destination, client->name) == 0)))
+		{
+			/* a message that never went through a connection has serial 0, which a client cannot demarshal */
+			if ((data == NULL) && (dbus_message_get_serial(message) == 0U))
+			{
+				s_messageSerial++;
+				if (s_messageSerial == 0U)
+				{
+					s_messageSerial = 1;
+				}
+				dbus_message_set_serial(message, s_messageSerial);
+			}
+
+			/* marshalled once for all clients, and not at all without one */
+			if ((data == NULL) && (dbus_message_marshal(message, &data, &length) == FALSE))
+			{
+				ERROR_PRINTF("dbus_message_marshal failed\n");
+				break;
+			}
+			if (SendToClient(client, data, (int32_t)length) == 0)
+			{
+				ret = 0;
+			}
+		}
+	}
+	(void)pthread_mutex_unlock(&s_channelMutex);
+
+	if (data != NULL)
+	{
+		dbus_free(data);
+	}
+
+	return ret;
+}
+
+static int32_t SendToClient(ChannelClient *client, const char *data, int32_t length)
+{
+	int32_t ret = 0;
+	ssize_t sent;
+
+	do
+	{
+		sent = send(client->fd, data, (size_t)length, MSG_NOSIGNAL | MSG_DONTWAIT);
+	} while ((sent < 0) && (errno == EINTR));
+
+	if (sent != (ssize_t)length)
+	{
+		/* never block a player thread on a client, a closed one is removed by its watch */
+		if ((client->dropped % 100U) == 0U)
+		{
+			WARN_PRINTF("%s does not read, %u messages dropped: error(%d)\n", client->name, client->dropped + 1U, errno);
+		}
+		client->dropped++;
+		ret = -1;
+	}
+
+	return ret;
+}
+
+static gboolean OnChannelAccept(GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	int32_t fd;
+	uint32_t idx;
+	ChannelClient *client = NULL;
+
+	fd = accept4(g_io_channel_unix_get_fd(source), NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+	if (fd >= 0)
+	{
+		(void)pthread_mutex_lock(&s_channelMutex);
+		for (idx = 0; (idx < (uint32_t)MEDIAPLAYBACK_CHANNEL_MAX_CLIENTS) && (client == NULL); idx++)
+		{
+			if (s_clients[idx].fd < 0)
+			{
+				client = &s_clients[idx];
+				client->fd = fd;
+				client->dropped = 0;
+				s_peerSerial++;
+				(void)g_snprintf(client->name, sizeof(client->name), "%s%u", MEDIAPLAYBACK_CHANNEL_PEER_PREFIX, s_peerSerial);
+			}
+		}
+		(void)pthread_mutex_unlock(&s_channelMutex);
+
+		if (client != NULL)
+		{
+			client->channel = g_io_channel_unix_new(fd);
+			client->watchID = g_io_add_watch(client->channel, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR),
+											 OnChannelReadable, client);
+			INFO_PRINTF("%s connected\n", client->name);
+		}
+		else
+		{
+			WARN_PRINTF("too many clients\n");
+			(void)close(fd);
+		}
+	}
+
+	(void)condition;
+	(void)data;
+	return (gboolean)TRUE;
+}
+
+static gboolean OnChannelReadable(GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	ChannelClient *client = (ChannelClient *)data;
+	gboolean keep = TRUE;
+	ssize_t length;
+
+	do
+	{
+		length = recv(g_io_channel_unix_get_fd(source), s_receiveBuffer, sizeof(s_receiveBuffer), MSG_TRUNC);
+	} while ((length < 0) && (errno == EINTR));
+
+	if (length > (ssize_t)sizeof(s_receiveBuffer))
+	{
+		WARN_PRINTF("%s sent %d bytes, dropped\n", client->name, (int32_t)length);
+	}
+	else if (length > 0)
+	{
+		DBusError error;
+		DBusMessage *message;
+
+		dbus_error_init(&error);
+		message = dbus_message_demarshal(s_receiveBuffer, (int)length, &error);
+		if (message != NULL)
+		{
+			if ((dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_METHOD_CALL) &&
+				(dbus_message_set_sender(message, client->name) == TRUE) &&
+				(s_channelCB.MediaPlaybackChannelMethodCallCB != NULL))
+			{
+				s_channelCB.MediaPlaybackChannelMethodCallCB(message);
+			}
+			dbus_message_unref(message);
+		}
+		else
+		{
+			WARN_PRINTF("%s sent an invalid message: %s\n", client->name, error.message);
+			dbus_error_free(&error);
+		}
+	}
+	else if ((length < 0) && (errno == EAGAIN))
+	{
+		;
+	}
+	else
+	{
+		/* end of file, or an error the client will not recover from */
+		INFO_PRINTF("%s disconnected\n", client->name);
+		if (s_channelCB.MediaPlaybackChannelDisconnectedCB != NULL)
+		{
+			s_channelCB.MediaPlaybackChannelDisconnectedCB(client->name);
+		}
+		CloseClient(client);
+		keep = FALSE;
+	}
+
+	(void)condition;
+	return keep;
+}
+
+static void CloseClient(ChannelClient *client)
+{
+	(void)pthread_mutex_lock(&s_channelMutex);
+	if (client->channel != NULL)
+	{
+		g_io_channel_unref(client->channel);
+		client->channel = NULL;
+	}
+	(void)close(client->fd);
+	client->fd = -1;
+	client->watchID = 0;
+	client->name[0] = '\0';
+	(void)pthread_mutex_unlock(&s_channelMutex);
+}
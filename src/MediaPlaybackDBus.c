@@ -26,80 +26,450 @@ between Telechips and Company.
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <glib.h>
 #include <sys/shm.h>
 #include "DBusMsgDef.h"
 #include "TCDBusRawAPI.h"
 #include "TCLog.h"
+#include "TCTime.h"
 #include "TCMultiMediaType.h"
-#include "MediaPlaybackDBus.h"
 #include "MultiMediaManager.h"
+#include "MediaPlaybackDBus.h"
+#include "MediaLibrary.h"
+#include "AlbumArtThumbnail.h"
+#include "AlbumArtCache.h"
+#include "DBusMethodTable.h"
+#include "MultiMediaState.h"
+#include "MultiMediaLatency.h"
+#include "MultiMediaPipelineStats.h"
+#include "AudioEqualizer.h"
+#include "AudioCrossfade.h"
+#include "MediaPlaybackChannel.h"
+#include "MediaPlaybackSender.h"
+#include "MediaPlaybackTrace.h"
+
+/* MediaPlaybackEvent.type, the player threads only post these to the sender thread */
+typedef enum {
+	SenderEventPlayID,
+	SenderEventValue,
+	SenderEventTime,
+	SenderEventMem,
+	SenderEventPlayPosition,
+	SenderEventPosition,
+	SenderEventTagInfo,
+	SenderEventAlbumArt,
+	SenderEventError,
+	SenderEventMetadata,
+	SenderEventLibraryProgress,
+	SenderEventLibraryCompleted,
+	SenderEventCrossfade,
+	TotalSenderEvents
+} SenderEventType;
+
+/* only the newest position matters, an older one not sent yet is replaced */
+#define SENDER_SLOT_PLAY_POSITION		0U
+#define SENDER_SLOT_POSITION			1U
 
 typedef void (*DBusMethodCallFunction)(DBusMessage *message);
 static DBusMsgErrorCode OnReceivedMethodCall(DBusMessage *message, const char *interface);
+static void OnReceivedSignal(DBusMessage *message, const char *interface);
+static void OnReceivedPeerMethodCall(DBusMessage *message);
+static int SendMediaPlaybackMessage(DBusMessage *message);
 static void MediaPlaybackDBusEmitSignal(uint32_t signalID,int32_t value, int32_t playID);
 //static void MediaPlaybackDBusEmitSignal_NoValueType(uint32_t signalID);
 static void MediaPlaybackDBusEmitSignal_time(uint32_t signalID, uint8_t hour, uint8_t min, uint8_t sec, int32_t playID);
 static void MediaPlaybackDBusEmitSignal_Mem(uint32_t signalID, int32_t key, uint32_t size);
 static void MediaPlaybackDBusEmitSignal_playID(uint32_t signalID, int32_t playID);
-static void DBusMethodPlayStart(DBusMessage *message);
-static void DBusMethodPlayStop(DBusMessage *message);
-static void DBusMethodPlayPause(DBusMessage *message);
-static void DBusMethodPlayResume(DBusMessage *message);
-static void DBusMethodPlaySeek(DBusMessage *message);
-static void DBusMethodSetDisplay(DBusMessage *message);
-static void DBusMethodSetDualDisplay(DBusMessage *message);
-static void DBusMethodSetDebug(DBusMessage *message);
-static void DBusMethodGetStatus(DBusMessage *message);
-static void DBusMethodGetAlbumArtKey(DBusMessage *message);
-static void DBusMethodGetPlayID(DBusMessage *message);
+static void SendPlayPosition(uint8_t hour, uint8_t min, uint8_t sec, int32_t playID);
+static void SendPosition(uint32_t position, int32_t playID);
+static DBusMessage *CreatePositionSignal(uint32_t signalID, DBusMessageIter *iter);
+static void SendTagInfo(MetaCategory category, const char *info, int32_t playID);
+static void SendAlbumArt(int32_t playID, uint32_t length, uint32_t slot, uint32_t generation);
+static void SendError(int32_t errCode, int32_t playID);
+static void SendMetadata(const MultiMediaMetadata *metadata, int32_t playID);
+static void SendLibraryProgress(const char *root, uint32_t scanned, uint32_t found);
+static void SendLibraryCompleted(const char *root, uint32_t count, int32_t result);
+static void SendCrossfade(const AudioCrossfadeTransition *transition);
+static void PostSignal(SenderEventType type, uint32_t signalID, int32_t playID);
+static void OnSendEvent(MediaPlaybackEvent *event);
+#define MEDIAPLAYBACK_METHOD_PROTOTYPE(name, member)	static void DBusMethod##name(DBusMessage *message);
+MEDIAPLAYBACK_METHOD_LIST(MEDIAPLAYBACK_METHOD_PROTOTYPE)
+static void AppendMetadata(DBusMessage *message, const MultiMediaMetadata *metadata);
+static void AppendMetadataDict(DBusMessageIter *iter, const MultiMediaMetadata *metadata);
+static dbus_bool_t AppendLatencyEvents(DBusMessageIter *iter);
+static dbus_bool_t AppendLatencyHistograms(DBusMessageIter *iter);
+static dbus_bool_t AppendPipelineElements(DBusMessageIter *iter, const MultiMediaElementStats *elements, uint32_t count);
+static dbus_bool_t AppendEqualizerPresets(DBusMessageIter *iter);
+static dbus_bool_t AppendSpans(DBusMessageIter *iter);
+static void DBusPropertiesProcess(DBusMessage *message);
+static void AppendProperty(DBusMessageIter *dict, uint32_t property, const MultiMediaState *state);
+static int32_t FindProperty(const char *name);
+static gboolean OnPropertiesChanged(gpointer data);
+static uint32_t GetPropertiesMask(void);
+static void AppendDictEntry(DBusMessageIter *dict, const char *key, int type, const void *value);
+static const char *GetChannelLayout(uint32_t channels);
+static void RemovePositionSubscriber(const char *name);
+static void UpdatePositionInterval(void);
 
+#define MEDIAPLAYBACK_METHOD_HANDLER(name, member)		DBusMethod##name,
 static DBusMethodCallFunction s_DBusMethodProcess[TotalMethodMediaPlaybackEvents] = {
-	DBusMethodPlayStart,
-	DBusMethodPlayStop,
-	DBusMethodPlayPause,
-	DBusMethodPlayResume,
-	DBusMethodPlaySeek,
-	DBusMethodSetDisplay,
-	DBusMethodSetDualDisplay,
-	DBusMethodSetDebug,
-	DBusMethodGetStatus,
-	DBusMethodGetAlbumArtKey,
-	DBusMethodGetPlayID
+	MEDIAPLAYBACK_METHOD_LIST(MEDIAPLAYBACK_METHOD_HANDLER)
+};
+static DBusMethodTable s_methodTable;
+
+#define SPAN_STATS_RECORDS				(TCTIME_SPAN_RECORDS * 16)	/* of all threads */
+
+/* libdbus cannot demarshal a message carrying a file descriptor */
+#define CHANNEL_NO_FD_ERROR				"file descriptors are not passed on the control socket"
+
+#define POSITION_SUBSCRIBER_MAX			8
+#define POSITION_SUBSCRIBER_NAME_SIZE	64
+#define POSITION_INTERVAL_MIN			50
+#define POSITION_INTERVAL_MAX			10000
+
+typedef struct stPositionSubscriber {
+	char name[POSITION_SUBSCRIBER_NAME_SIZE];	/* unique bus name, empty if the entry is free */
+	uint32_t interval;
+	uint64_t lastSent;
+} PositionSubscriber;
+
+/*
+ * signal_mediaplayback_playpostion is broadcast for clients that predate
+ * subscriptions unless --no-position-broadcast is given. The position is
+ * only queried as often as the fastest subscriber (or the broadcast) needs.
+ */
+static PositionSubscriber s_positionSubscribers[POSITION_SUBSCRIBER_MAX];
+static bool s_positionBroadcast = true;
+static pthread_mutex_t s_positionMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Read only properties of MEDIAPLAYBACK_EVENT_INTERFACE on
+ * org.freedesktop.DBus.Properties, answered from MultiMediaState. Changes
+ * made within one main loop iteration are sent in one PropertiesChanged.
+ * Position moves all the time and is not signalled, like in MPRIS.
+ */
+typedef enum {
+	PropertyPlaybackStatus,				/* s: Stopped, Playing or Paused */
+	PropertyPosition,					/* u: ms */
+	PropertyDuration,					/* u: ms, 0 until known */
+	PropertyMetadata,					/* a{sv}: as signal_mediaplayback_metadata */
+	PropertyRate,						/* d: negative while rewinding */
+	PropertyPlayID,						/* i */
+	PropertySampleRate,					/* i: Hz, 0 until known */
+	TotalProperties
+} MediaPlaybackProperty;
+
+static const struct {
+	const char *name;
+	uint32_t changedBy;					/* MULTIMEDIA_STATE_* */
+} s_properties[TotalProperties] = {
+	{ "PlaybackStatus", MULTIMEDIA_STATE_PLAYBACK },
+	{ "Position", 0U },
+	{ "Duration", MULTIMEDIA_STATE_DURATION },
+	{ "Metadata", MULTIMEDIA_STATE_METADATA },
+	{ "Rate", MULTIMEDIA_STATE_RATE },
+	{ "PlayID", MULTIMEDIA_STATE_PLAYID },
+	{ "SampleRate", MULTIMEDIA_STATE_SAMPLERATE },
 };
+
+static uint32_t s_propertiesChanged = 0;	/* MULTIMEDIA_STATE_* not signalled yet, atomic */
+
 void MediaPlaybackDBusInitialize(void)
 {
 	INFO_PRINTF("\n");
+	if (DBusMethodTableInitialize(&s_methodTable, g_methodMediaPlaybackEventNames,
+								  (uint32_t)TotalMethodMediaPlaybackEvents) != 0)
+	{
+		ERROR_PRINTF("method table initialize failed\n");
+	}
 	SetDBusPrimaryOwner(MEDIAPLAYBACK_PROCESS_DBUS_NAME);
-	SetCallBackFunctions(NULL, OnReceivedMethodCall);
+	SetCallBackFunctions(OnReceivedSignal, OnReceivedMethodCall);
 	(void)AddMethodInterface(MEDIAPLAYBACK_EVENT_INTERFACE);
+	(void)AddMethodInterface(DBUS_INTERFACE_PROPERTIES);
+	/* NameOwnerChanged tells when a position subscriber left the bus */
+	(void)AddSignalInterface(DBUS_INTERFACE_DBUS);
 	InitializeRawDBusConnection("MEDIAPLABYBACK DBUS");
+	(void)MediaPlaybackSenderInitialize(OnSendEvent);
+
+	{
+		MediaPlaybackChannelEventCB cb;
+
+		/* does nothing unless a socket path was given */
+		cb.MediaPlaybackChannelMethodCallCB = OnReceivedPeerMethodCall;
+		cb.MediaPlaybackChannelDisconnectedCB = RemovePositionSubscriber;
+		(void)MediaPlaybackChannelInitialize(&cb);
+	}
 }
 void MediaPlaybackDBusRelease(void)
 {
+	MediaPlaybackSenderRelease();
+	MediaPlaybackChannelRelease();
 	ReleaseRawDBusConnection();
 }
+void MediaPlaybackSetPositionBroadcast(int32_t enable)
+{
+	(void)pthread_mutex_lock(&s_positionMutex);
+	s_positionBroadcast = (enable != 0);
+	(void)pthread_mutex_unlock(&s_positionMutex);
+	UpdatePositionInterval();
+}
+void MediaPlaybackPropertiesChanged(uint32_t changed)
+{
+	/* resource, seekable or content alone change no property, they schedule nothing */
+	changed &= GetPropertiesMask();
+
+	/* the first change of an iteration schedules the signal, later ones join it */
+	if ((changed != 0U) && (__atomic_fetch_or(&s_propertiesChanged, changed, __ATOMIC_ACQ_REL) == 0U))
+	{
+		(void)g_idle_add(OnPropertiesChanged, NULL);
+	}
+}
 void MediaPlaybackEmitPlaying(int32_t playID)
 {
-	MediaPlaybackDBusEmitSignal_playID((uint32_t)SignalMediaPlaybackPlaying, playID);
+	PostSignal(SenderEventPlayID, (uint32_t)SignalMediaPlaybackPlaying, playID);
 }
 void MediaPlaybackEmitStopped(int32_t playID)
 {
-	MediaPlaybackDBusEmitSignal_playID((uint32_t)SignalMediaPlaybackStopped, playID);
+	PostSignal(SenderEventPlayID, (uint32_t)SignalMediaPlaybackStopped, playID);
 }
 void MediaPlaybackEmitPaused(int32_t playID)
 {
-	MediaPlaybackDBusEmitSignal_playID((uint32_t)SignalMediaPlaybackPaused,playID);
+	PostSignal(SenderEventPlayID, (uint32_t)SignalMediaPlaybackPaused, playID);
 }
 void MediaPlaybackEmitDuration(uint32_t hour, uint32_t min, uint32_t sec,int32_t playID)
 {
-	MediaPlaybackDBusEmitSignal_time((uint32_t)SignalMediaPlaybackDuration, (uint8_t)hour, (uint8_t)min, (uint8_t)sec, playID);
+	MediaPlaybackEvent event = {SenderEventTime, (uint32_t)SignalMediaPlaybackDuration, playID, 0, {hour, min, sec}, NULL};
+	MediaPlaybackSenderPost(&event);
 }
 void MediaPlaybackEmitPlayPosition(uint32_t hour, uint32_t min, uint32_t sec,int32_t playID)
 {
-	MediaPlaybackDBusEmitSignal_time((uint32_t)SignalMediaPlaybackPlayPostion, (uint8_t)hour, (uint8_t)min, (uint8_t)sec, playID);
+	if (s_positionBroadcast)
+	{
+		MediaPlaybackEvent event = {SenderEventPlayPosition, (uint32_t)SignalMediaPlaybackPlayPostion, playID, 0, {hour, min, sec}, NULL};
+		MediaPlaybackSenderPostLatest(SENDER_SLOT_PLAY_POSITION, &event);
+	}
+}
+void MediaPlaybackEmitPosition(uint32_t position, int32_t playID)
+{
+	MediaPlaybackEvent event = {SenderEventPosition, (uint32_t)SignalMediaPlaybackPosition, playID, 0, {position, 0, 0}, NULL};
+	MediaPlaybackSenderPostLatest(SENDER_SLOT_POSITION, &event);
 }
 void MediaPlaybackEmitPlayTaginfo(MetaCategory category, const char *info,int32_t playID)
+{
+	if ((category < TotalMetaCategories) && (info != NULL))
+	{
+		MediaPlaybackEvent event = {SenderEventTagInfo, (uint32_t)SignalMediaPlaybackTagInfo, playID, (int32_t)category, {0, 0, 0}, NULL};
+		event.data = g_strdup(info);
+		MediaPlaybackSenderPost(&event);
+	}
+}
+void MediaPlaybackEmitAlbumart(int32_t playID, uint32_t length, uint32_t slot, uint32_t generation)
+{
+	MediaPlaybackEvent event = {SenderEventAlbumArt, (uint32_t)SignalMediaPlaybackAlbumArtCompleted, playID, 0, {length, slot, generation}, NULL};
+	MediaPlaybackSenderPost(&event);
+}
+void MediaPlaybackEmitPlayEnded(int32_t playID)
+{
+	PostSignal(SenderEventPlayID, (uint32_t)SignalMediaPlaybackPlayEnded, playID);
+}
+void MediaPlaybackEmitSeekCompleted(uint8_t hour, uint8_t min, uint8_t sec, int32_t playID)
+{
+	MediaPlaybackEvent event = {SenderEventTime, (uint32_t)SignalMediaPlaybackSeekCompleted, playID, 0, {hour, min, sec}, NULL};
+	MediaPlaybackSenderPost(&event);
+}
+void MediaPlaybackEmitError(int32_t errCode,int32_t playID)
+{
+	MediaPlaybackEvent event = {SenderEventError, (uint32_t)SignalMediaPlaybackError, playID, errCode, {0, 0, 0}, NULL};
+	MediaPlaybackSenderPost(&event);
+}
+void MediaPlaybackEmitSamplerate(int32_t samplerate, int32_t playID)
+{
+	MediaPlaybackEvent event = {SenderEventValue, (uint32_t)SignalMediaPlaybackSamplerate, playID, samplerate, {0, 0, 0}, NULL};
+	MediaPlaybackSenderPost(&event);
+}
+void MediaPlaybackEmitAlbumArtThumbnail(int32_t playID, uint32_t count)
+{
+	MediaPlaybackEvent event = {SenderEventMem, (uint32_t)SignalMediaPlaybackAlbumArtThumbnail, playID, 0, {count, 0, 0}, NULL};
+	MediaPlaybackSenderPost(&event);
+}
+void MediaPlaybackEmitMetadata(const MultiMediaMetadata *metadata, int32_t playID)
+{
+	if (metadata != NULL)
+	{
+		MediaPlaybackEvent event = {SenderEventMetadata, (uint32_t)SignalMediaPlaybackMetadata, playID, 0, {0, 0, 0}, NULL};
+		event.data = g_malloc(sizeof(MultiMediaMetadata));
+		(void)memcpy(event.data, metadata, sizeof(MultiMediaMetadata));
+		MediaPlaybackSenderPost(&event);
+	}
+}
+void MediaPlaybackEmitLibraryProgress(const char *root, uint32_t scanned, uint32_t found)
+{
+	if (root != NULL)
+	{
+		MediaPlaybackEvent event = {SenderEventLibraryProgress, (uint32_t)SignalMediaPlaybackLibraryProgress, 0, 0, {scanned, found, 0}, NULL};
+		event.data = g_strdup(root);
+		MediaPlaybackSenderPost(&event);
+	}
+}
+void MediaPlaybackEmitLibraryCompleted(const char *root, uint32_t count, int32_t result)
+{
+	if (root != NULL)
+	{
+		MediaPlaybackEvent event = {SenderEventLibraryCompleted, (uint32_t)SignalMediaPlaybackLibraryCompleted, 0, result, {count, 0, 0}, NULL};
+		event.data = g_strdup(root);
+		MediaPlaybackSenderPost(&event);
+	}
+}
+
+void MediaPlaybackEmitCrossfade(const AudioCrossfadeTransition *transition)
+{
+	if (transition != NULL)
+	{
+		MediaPlaybackEvent event = {SenderEventCrossfade, (uint32_t)SignalMediaPlaybackCrossfade, transition->toID, 0, {0, 0, 0}, NULL};
+		event.data = g_malloc(sizeof(AudioCrossfadeTransition));
+		(void)memcpy(event.data, transition, sizeof(AudioCrossfadeTransition));
+		MediaPlaybackSenderPost(&event);
+	}
+}
+
+static void PostSignal(SenderEventType type, uint32_t signalID, int32_t playID)
+{
+	MediaPlaybackEvent event = {(uint32_t)type, signalID, playID, 0, {0, 0, 0}, NULL};
+	MediaPlaybackSenderPost(&event);
+}
+
+/* the sender thread, every message of a player event is built and sent here */
+static void OnSendEvent(MediaPlaybackEvent *event)
+{
+	TCTimeSpan span;
+
+	MEDIAPLAYBACK_TRACE(Signal, event->signal, event->playID, event->args[0], event->value);
+	TCTimeSpanBegin(&span, TCTimeSpanEmit, event->playID);
+
+	switch ((SenderEventType)event->type)
+	{
+		case SenderEventPlayID:
+			MediaPlaybackDBusEmitSignal_playID(event->signal, event->playID);
+			break;
+		case SenderEventValue:
+			MediaPlaybackDBusEmitSignal(event->signal, event->value, event->playID);
+			break;
+		case SenderEventTime:
+			MediaPlaybackDBusEmitSignal_time(event->signal, (uint8_t)event->args[0], (uint8_t)event->args[1],
+											 (uint8_t)event->args[2], event->playID);
+			break;
+		case SenderEventMem:
+			MediaPlaybackDBusEmitSignal_Mem(event->signal, event->playID, event->args[0]);
+			break;
+		case SenderEventPlayPosition:
+			SendPlayPosition((uint8_t)event->args[0], (uint8_t)event->args[1], (uint8_t)event->args[2], event->playID);
+			break;
+		case SenderEventPosition:
+			SendPosition(event->args[0], event->playID);
+			break;
+		case SenderEventTagInfo:
+			SendTagInfo((MetaCategory)event->value, (const char *)event->data, event->playID);
+			break;
+		case SenderEventAlbumArt:
+			SendAlbumArt(event->playID, event->args[0], event->args[1], event->args[2]);
+			break;
+		case SenderEventError:
+			SendError(event->value, event->playID);
+			break;
+		case SenderEventMetadata:
+			SendMetadata((const MultiMediaMetadata *)event->data, event->playID);
+			break;
+		case SenderEventLibraryProgress:
+			SendLibraryProgress((const char *)event->data, event->args[0], event->args[1]);
+			break;
+		case SenderEventLibraryCompleted:
+			SendLibraryCompleted((const char *)event->data, event->args[0], event->value);
+			break;
+		case SenderEventCrossfade:
+			SendCrossfade((const AudioCrossfadeTransition *)event->data);
+			break;
+		default:
+			ERROR_PRINTF("unknown event(%u)\n", event->type);
+			break;
+	}
+
+	g_free(event->data);
+	event->data = NULL;
+	(void)TCTimeSpanEnd(&span);
+}
+static void SendPlayPosition(uint8_t hour, uint8_t min, uint8_t sec, int32_t playID)
+{
+	DBusMessageIter iter;
+	DBusMessage *message = CreatePositionSignal((uint32_t)SignalMediaPlaybackPlayPostion, &iter);
+
+	/* sent several times a second, so no log line for it */
+	if (message != NULL)
+	{
+		if ((dbus_message_iter_append_basic(&iter, DBUS_TYPE_BYTE, &hour) == FALSE) ||
+			(dbus_message_iter_append_basic(&iter, DBUS_TYPE_BYTE, &min) == FALSE) ||
+			(dbus_message_iter_append_basic(&iter, DBUS_TYPE_BYTE, &sec) == FALSE) ||
+			(dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &playID) == FALSE) ||
+			(!SendMediaPlaybackMessage(message)))
+		{
+			ERROR_PRINTF("SendDBusMessage failed\n");
+		}
+		dbus_message_unref(message);
+	}
+	else
+	{
+		ERROR_PRINTF("dbus_message_new_signal failed\n");
+	}
+}
+static void SendPosition(uint32_t position, int32_t playID)
+{
+	uint64_t now = (uint64_t)TCTimeGetMonotonicMs();
+	uint32_t idx;
+
+	(void)pthread_mutex_lock(&s_positionMutex);
+	for (idx = 0; idx < (uint32_t)POSITION_SUBSCRIBER_MAX; idx++)
+	{
+		PositionSubscriber *subscriber = &s_positionSubscribers[idx];
+
+		/* a tenth of the interval early is still on time, the poll is not exact */
+		if ((subscriber->name[0] != '\0') &&
+			((now - subscriber->lastSent) >= (uint64_t)(subscriber->interval - (subscriber->interval / 10U))))
+		{
+			DBusMessageIter iter;
+			DBusMessage *message = CreatePositionSignal((uint32_t)SignalMediaPlaybackPosition, &iter);
+
+			if (message != NULL)
+			{
+				if ((dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &position) == FALSE) ||
+					(dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &playID) == FALSE) ||
+					(dbus_message_set_destination(message, subscriber->name) == FALSE) ||
+					(!SendMediaPlaybackMessage(message)))
+				{
+					ERROR_PRINTF("position to %s failed\n", subscriber->name);
+				}
+				dbus_message_unref(message);
+			}
+			subscriber->lastSent = now;
+		}
+	}
+	(void)pthread_mutex_unlock(&s_positionMutex);
+}
+/* libdbus allocates as much as for CreateDBusMsgSignal(), only its varargs are saved, see bench/PositionSignalBench */
+static DBusMessage *CreatePositionSignal(uint32_t signalID, DBusMessageIter *iter)
+{
+	DBusMessage *message = dbus_message_new_signal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, MEDIAPLAYBACK_EVENT_INTERFACE,
+												   g_signalMediaPlaybackEventNames[signalID]);
+
+	if (message != NULL)
+	{
+		dbus_message_iter_init_append(message, iter);
+	}
+
+	return message;
+}
+static void SendTagInfo(MetaCategory category, const char *info,int32_t playID)
 {
 	INFO_PRINTF(" \n");
 	if ((category < TotalMetaCategories)&&(info!= NULL))
@@ -114,7 +484,7 @@ void MediaPlaybackEmitPlayTaginfo(MetaCategory category, const char *info,int32_
 		
 		if (message != NULL)
 		{
-			if (SendDBusMessage(message, NULL))
+			if (SendMediaPlaybackMessage(message))
 			{
 				INFO_PRINTF("EMIT SIGNAL(%s), category (%d), info(%s), playID(%d)\n",
 											 SIGNAL_MEDIAPLAYBACK_TAGINFO, category,info, playID);
@@ -132,19 +502,38 @@ void MediaPlaybackEmitPlayTaginfo(MetaCategory category, const char *info,int32_
 		}
 	}
 }
-void MediaPlaybackEmitAlbumart(int32_t playID, uint32_t length)
+static void SendAlbumArt(int32_t playID, uint32_t length, uint32_t slot, uint32_t generation)
 {
-	MediaPlaybackDBusEmitSignal_Mem((uint32_t)SignalMediaPlaybackAlbumArtCompleted, playID,  length);
-}
-void MediaPlaybackEmitPlayEnded(int32_t playID)
-{
-	MediaPlaybackDBusEmitSignal_playID((uint32_t)SignalMediaPlaybackPlayEnded, playID);
-}
-void MediaPlaybackEmitSeekCompleted(uint8_t hour, uint8_t min, uint8_t sec, int32_t playID)
-{
-	MediaPlaybackDBusEmitSignal_time((uint32_t)SignalMediaPlaybackSeekCompleted, hour, min, sec, playID);
+	DEBUG_PRINTF("\n");
+
+	DBusMessage *message;
+	/* slot and generation follow the legacy (playID, length) arguments */
+	message = CreateDBusMsgSignal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, MEDIAPLAYBACK_EVENT_INTERFACE,
+								  SIGNAL_MEDIAPLAYBACK_ALBUMART_COMPLETED,
+								  DBUS_TYPE_INT32, &playID,
+								  DBUS_TYPE_UINT32, &length,
+								  DBUS_TYPE_UINT32, &slot,
+								  DBUS_TYPE_UINT32, &generation,
+								  DBUS_TYPE_INVALID);
+	if (message != NULL)
+	{
+		if (SendMediaPlaybackMessage(message))
+		{
+			INFO_PRINTF("EMIT SIGNAL(%s), playID(%d), length(%u), slot(%u), generation(%u)\n",
+										 SIGNAL_MEDIAPLAYBACK_ALBUMART_COMPLETED, playID, length, slot, generation);
+		}
+		else
+		{
+			ERROR_PRINTF("SendDBusMessage failed\n");
+		}
+		dbus_message_unref(message);
+	}
+	else
+	{
+		ERROR_PRINTF("CreateDBusMsgSignal failed\n");
+	}
 }
-void MediaPlaybackEmitError(int32_t errCode,int32_t playID)
+static void SendError(int32_t errCode,int32_t playID)
 {
 	DEBUG_PRINTF("\n");
 
@@ -156,7 +545,7 @@ void MediaPlaybackEmitError(int32_t errCode,int32_t playID)
 								  DBUS_TYPE_INVALID);
 	if (message != NULL)
 	{
-		if (SendDBusMessage(message, NULL))
+		if (SendMediaPlaybackMessage(message))
 		{
 			INFO_PRINTF("EMIT SIGNAL(%s), errCode(%d), playID(%d)\n",
 										 MEDIAPLAYBACK_PROCESS_OBJECT_PATH, errCode, playID);
@@ -173,9 +562,143 @@ void MediaPlaybackEmitError(int32_t errCode,int32_t playID)
 	}
 }
 
-void MediaPlaybackEmitSamplerate(int32_t samplerate, int32_t playID)
+static void SendMetadata(const MultiMediaMetadata *metadata, int32_t playID)
+{
+	DEBUG_PRINTF("\n");
+
+	DBusMessage *message;
+	message = CreateDBusMsgSignal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, MEDIAPLAYBACK_EVENT_INTERFACE,
+								  SIGNAL_MEDIAPLAYBACK_METADATA,
+								  DBUS_TYPE_INT32, &playID,
+								  DBUS_TYPE_INVALID);
+	if (message != NULL)
+	{
+		AppendMetadata(message, metadata);
+		if (SendMediaPlaybackMessage(message))
+		{
+			INFO_PRINTF("EMIT SIGNAL(%s), title(%s), playID(%d)\n",
+										 SIGNAL_MEDIAPLAYBACK_METADATA, metadata->title, playID);
+		}
+		else
+		{
+			ERROR_PRINTF("SendDBusMessage failed\n");
+		}
+		dbus_message_unref(message);
+	}
+	else
+	{
+		ERROR_PRINTF("CreateDBusMsgSignal failed\n");
+	}
+}
+
+static void SendLibraryProgress(const char *root, uint32_t scanned, uint32_t found)
+{
+	DEBUG_PRINTF("\n");
+
+	if (root != NULL)
+	{
+		DBusMessage *message;
+		message = CreateDBusMsgSignal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, MEDIAPLAYBACK_EVENT_INTERFACE,
+									  SIGNAL_MEDIAPLAYBACK_LIBRARY_PROGRESS,
+									  DBUS_TYPE_STRING, &root,
+									  DBUS_TYPE_UINT32, &scanned,
+									  DBUS_TYPE_UINT32, &found,
+									  DBUS_TYPE_INVALID);
+		if (message != NULL)
+		{
+			if (SendMediaPlaybackMessage(message))
+			{
+				DEBUG_PRINTF("EMIT SIGNAL(%s), root(%s), scanned(%u), found(%u)\n",
+											 SIGNAL_MEDIAPLAYBACK_LIBRARY_PROGRESS, root, scanned, found);
+			}
+			else
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(message);
+		}
+		else
+		{
+			ERROR_PRINTF("CreateDBusMsgSignal failed\n");
+		}
+	}
+}
+
+static void SendCrossfade(const AudioCrossfadeTransition *transition)
+{
+	DEBUG_PRINTF("\n");
+
+	if (transition != NULL)
+	{
+		DBusMessage *message;
+		dbus_uint64_t start = transition->start;
+		dbus_uint64_t end = transition->end;
+		dbus_int64_t startTime = transition->startTime;
+		dbus_int64_t endTime = transition->endTime;
+		dbus_int64_t fromPosition = transition->fromPosition;
+
+		message = CreateDBusMsgSignal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, MEDIAPLAYBACK_EVENT_INTERFACE,
+									  SIGNAL_MEDIAPLAYBACK_CROSSFADE,
+									  DBUS_TYPE_INT32, &transition->fromID,
+									  DBUS_TYPE_INT32, &transition->toID,
+									  DBUS_TYPE_UINT64, &start,
+									  DBUS_TYPE_UINT64, &end,
+									  DBUS_TYPE_INT64, &startTime,
+									  DBUS_TYPE_INT64, &endTime,
+									  DBUS_TYPE_INT64, &fromPosition,
+									  DBUS_TYPE_INVALID);
+		if (message != NULL)
+		{
+			if (SendMediaPlaybackMessage(message))
+			{
+				INFO_PRINTF("EMIT SIGNAL(%s), playID(%d -> %d), frames(%" G_GUINT64_FORMAT " ~ %" G_GUINT64_FORMAT ")\n",
+											 SIGNAL_MEDIAPLAYBACK_CROSSFADE, transition->fromID, transition->toID,
+											 transition->start, transition->end);
+			}
+			else
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(message);
+		}
+		else
+		{
+			ERROR_PRINTF("CreateDBusMsgSignal failed\n");
+		}
+	}
+}
+
+static void SendLibraryCompleted(const char *root, uint32_t count, int32_t result)
 {
-	MediaPlaybackDBusEmitSignal((uint32_t)SignalMediaPlaybackSamplerate, samplerate, playID);
+	DEBUG_PRINTF("\n");
+
+	if (root != NULL)
+	{
+		DBusMessage *message;
+		message = CreateDBusMsgSignal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, MEDIAPLAYBACK_EVENT_INTERFACE,
+									  SIGNAL_MEDIAPLAYBACK_LIBRARY_COMPLETED,
+									  DBUS_TYPE_STRING, &root,
+									  DBUS_TYPE_UINT32, &count,
+									  DBUS_TYPE_INT32, &result,
+									  DBUS_TYPE_INVALID);
+		if (message != NULL)
+		{
+			if (SendMediaPlaybackMessage(message))
+			{
+				INFO_PRINTF("EMIT SIGNAL(%s), root(%s), count(%u), result(%d)\n",
+											 SIGNAL_MEDIAPLAYBACK_LIBRARY_COMPLETED, root, count, result);
+			}
+			else
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(message);
+		}
+		else
+		{
+			ERROR_PRINTF("CreateDBusMsgSignal failed\n");
+		}
+	}
 }
 
 
@@ -192,7 +715,7 @@ static void MediaPlaybackDBusEmitSignal(uint32_t signalID,int32_t value, int32_t
 									  DBUS_TYPE_INVALID);
 		if (message != NULL)
 		{
-			if (SendDBusMessage(message, NULL))
+			if (SendMediaPlaybackMessage(message))
 			{
 				INFO_PRINTF("EMIT SIGNAL([%d]%s), value(%d)\n",
 											 signalID, g_signalMediaPlaybackEventNames[signalID], value);
@@ -228,7 +751,7 @@ static void MediaPlaybackDBusEmitSignal_NoValueType(uint32_t signalID)
 		
 		if (message != NULL)
 		{
-			if (SendDBusMessage(message, NULL))
+			if (SendMediaPlaybackMessage(message))
 			{
 				INFO_PRINTF("EMIT SIGNAL([%d]%s)\n",
 										 signalID, g_signalMediaPlaybackEventNames[signalID]);
@@ -267,7 +790,7 @@ static void MediaPlaybackDBusEmitSignal_time(uint32_t signalID, uint8_t hour, ui
 		
 		if (message != NULL)
 		{
-			if (SendDBusMessage(message, NULL))
+			if (SendMediaPlaybackMessage(message))
 			{
 				INFO_PRINTF("EMIT SIGNAL([%d]%s), hour(%d), min(%d), sec(%d)\n",
 											 signalID, g_signalMediaPlaybackEventNames[signalID], hour, min, sec);
@@ -302,7 +825,7 @@ static void MediaPlaybackDBusEmitSignal_Mem(uint32_t signalID, int32_t playID, u
 									  DBUS_TYPE_INVALID);
 		if (message != NULL)
 		{
-			if (SendDBusMessage(message, NULL))
+			if (SendMediaPlaybackMessage(message))
 			{
 				INFO_PRINTF("EMIT SIGNAL([%d]%s), key(%d), size(%d)\n",
 											 signalID, g_signalMediaPlaybackEventNames[signalID], playID, size);
@@ -336,7 +859,7 @@ static void MediaPlaybackDBusEmitSignal_playID(uint32_t signalID, int32_t playID
 									  DBUS_TYPE_INVALID);
 		if (message != NULL)
 		{
-			if (SendDBusMessage(message, NULL))
+			if (SendMediaPlaybackMessage(message))
 			{
 				INFO_PRINTF("EMIT SIGNAL([%d]%s), playID(%d)\n",
 											 signalID, g_signalMediaPlaybackEventNames[signalID], playID);
@@ -365,33 +888,98 @@ static DBusMsgErrorCode OnReceivedMethodCall(DBusMessage *message, const char *i
 	DEBUG_PRINTF("\n");
 	
 	if ((interface != NULL) &&
-		(strcmp(interface, MEDIAPLAYBACK_EVENT_INTERFACE) == 0))
+		(strcmp(interface, MEDIAPLAYBACK_EVENT_INTERFACE) == 0) &&
+		(dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_METHOD_CALL))
 	{
-		uint32_t idx;
-		uint32_t stop = 0;
-		for (idx = (uint32_t)MethodMediaPlaybackPlayStart; (idx < (uint32_t)TotalMethodMediaPlaybackEvents) && (stop == 0); idx++)
+		const char *member = dbus_message_get_member(message);
+		int32_t idx = DBusMethodTableLookup(&s_methodTable, member);
+
+		if (idx >= 0)
 		{
-			if (dbus_message_is_method_call(message, 
-											MEDIAPLAYBACK_EVENT_INTERFACE, 
-											g_methodMediaPlaybackEventNames[idx]))
-			{
-				s_DBusMethodProcess[idx](message);
-				stop = 1;
-			}
+			TCTimeSpan span;
+
+			TCTimeSpanBegin(&span, TCTimeSpanMethod, idx);
+			s_DBusMethodProcess[idx](message);
+			(void)TCTimeSpanEnd(&span);
+		}
+		else
+		{
+			WARN_PRINTF("unknown method(%s)\n", (member != NULL) ? member : "");
 		}
 	}
+	else if ((interface != NULL) &&
+			 (strcmp(interface, DBUS_INTERFACE_PROPERTIES) == 0) &&
+			 (dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_METHOD_CALL))
+	{
+		DBusPropertiesProcess(message);
+	}
+	else
+	{
+		;
+	}
 	
 	return error;
 }
 
-static void DBusMethodPlayStart(DBusMessage *message)
+static void OnReceivedPeerMethodCall(DBusMessage *message)
 {
-	DEBUG_PRINTF("\n");
-	
-	if (message != NULL)
+	/* a call from the peer channel takes the same way as one from the bus */
+	(void)OnReceivedMethodCall(message, dbus_message_get_interface(message));
+}
+
+static int SendMediaPlaybackMessage(DBusMessage *message)
+{
+	int sent;
+	const char *destination = dbus_message_get_destination(message);
+
+	if (MediaPlaybackChannelIsPeer(destination))
 	{
-		char * path=NULL;
-		uint8_t hour, min, sec;
+		/* a reply or a position update for a client of the peer channel */
+		sent = (MediaPlaybackChannelSend(message) == 0) ? 1 : 0;
+	}
+	else
+	{
+		sent = SendDBusMessage(message, NULL);
+		if ((destination == NULL) && (dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_SIGNAL))
+		{
+			(void)MediaPlaybackChannelSend(message);
+		}
+	}
+
+	return sent;
+}
+
+static void OnReceivedSignal(DBusMessage *message, const char *interface)
+{
+	if ((interface != NULL) && (strcmp(interface, DBUS_INTERFACE_DBUS) == 0) &&
+		(dbus_message_is_signal(message, DBUS_INTERFACE_DBUS, "NameOwnerChanged") == TRUE))
+	{
+		const char *name = NULL;
+		const char *oldOwner = NULL;
+		const char *newOwner = NULL;
+
+		if (GetArgumentFromDBusMessage(message,
+										DBUS_TYPE_STRING, &name,
+										DBUS_TYPE_STRING, &oldOwner,
+										DBUS_TYPE_STRING, &newOwner,
+										DBUS_TYPE_INVALID))
+		{
+			if ((newOwner != NULL) && (newOwner[0] == '\0'))
+			{
+				RemovePositionSubscriber(name);
+			}
+		}
+	}
+}
+
+static void DBusMethodPlayStart(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+	
+	if (message != NULL)
+	{
+		char * path=NULL;
+		uint8_t hour, min, sec;
 		uint8_t isVideo;
 		uint8_t keepPause;
 		int32_t id;
@@ -435,7 +1023,7 @@ static void DBusMethodPlayStart(DBusMessage *message)
 														DBUS_TYPE_INVALID);
 			if (returnMessage != NULL)
 			{
-				if (SendDBusMessage(returnMessage, NULL) == 0)
+				if (SendMediaPlaybackMessage(returnMessage) == 0)
 				{
 					ERROR_PRINTF("SendDBusMessage failed\n");
 				}
@@ -473,7 +1061,7 @@ static void DBusMethodPlayStop(DBusMessage *message)
 				DBUS_TYPE_INVALID);
 			if (returnMessage != NULL)
 			{
-				if (!SendDBusMessage(returnMessage, NULL))
+				if (!SendMediaPlaybackMessage(returnMessage))
 				{
 					ERROR_PRINTF("SendDBusMessage failed\n");
 				}
@@ -510,7 +1098,7 @@ static void DBusMethodPlayPause(DBusMessage *message)
 														DBUS_TYPE_INVALID);
 			if (returnMessage != NULL)
 			{
-				if (!SendDBusMessage(returnMessage, NULL))
+				if (!SendMediaPlaybackMessage(returnMessage))
 				{
 					ERROR_PRINTF("SendDBusMessage failed\n");
 				}
@@ -548,7 +1136,7 @@ static void DBusMethodPlayResume(DBusMessage *message)
 														DBUS_TYPE_INVALID);
 			if (returnMessage != NULL)
 			{
-				if (!SendDBusMessage(returnMessage, NULL))
+				if (!SendMediaPlaybackMessage(returnMessage))
 				{
 					ERROR_PRINTF("SendDBusMessage failed\n");
 				}
@@ -585,7 +1173,7 @@ static void DBusMethodPlaySeek(DBusMessage *message)
 														DBUS_TYPE_INVALID);
 			if (returnMessage != NULL)
 			{
-				if (!SendDBusMessage(returnMessage, NULL))
+				if (!SendMediaPlaybackMessage(returnMessage))
 				{
 					ERROR_PRINTF("SendDBusMessage failed\n");
 				}
@@ -685,7 +1273,7 @@ static void DBusMethodGetStatus(DBusMessage *message)
 													DBUS_TYPE_INVALID);
 		if (returnMessage != NULL)
 		{
-			if (SendDBusMessage(returnMessage, NULL) == 0)
+			if (SendMediaPlaybackMessage(returnMessage) == 0)
 			{
 				ERROR_PRINTF("SendDBusMessage failed\n");
 			}
@@ -707,6 +1295,15 @@ static void DBusMethodGetAlbumArtKey(DBusMessage *message)
 		DBusMessage *returnMessage;
 		int32_t key = KEY_NUM;
 		uint32_t size = MEM_SIZE;
+		int32_t playID;
+		uint32_t slot;
+		uint32_t generation;
+
+		/* with --albumart-shm-on-request the image is copied into the segment only now */
+		if (MultiMediaPublishAlbumArt(&playID, &slot, &generation) == 0)
+		{
+			DEBUG_PRINTF("playID(%d) in slot(%u), generation(%u)\n", playID, slot, generation);
+		}
 
 		returnMessage = CreateDBusMsgMethodReturn(message,
 													DBUS_TYPE_INT32, &key,
@@ -714,7 +1311,7 @@ static void DBusMethodGetAlbumArtKey(DBusMessage *message)
 													DBUS_TYPE_INVALID);
 		if (returnMessage != NULL)
 		{
-			if (!SendDBusMessage(returnMessage, NULL))
+			if (!SendMediaPlaybackMessage(returnMessage))
 			{
 				ERROR_PRINTF("SendDBusMessage failed\n");
 			}
@@ -742,7 +1339,306 @@ static void DBusMethodGetPlayID(DBusMessage *message)
 		DEBUG_PRINTF("Current Play ID is %d\n", playingID);
 		if (returnMessage != NULL)
 		{
-			if (!SendDBusMessage(returnMessage, NULL))
+			if (!SendMediaPlaybackMessage(returnMessage))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+
+
+static void DBusMethodLibraryScan(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		char *root = NULL;
+		int32_t ret;
+		DBusMessage *returnMessage;
+
+		if (GetArgumentFromDBusMessage(message,
+										DBUS_TYPE_STRING, &root,
+										DBUS_TYPE_INVALID))
+		{
+			INFO_PRINTF("root(%s)\n", root);
+
+			ret = MediaLibraryStartScan(root);
+
+			returnMessage = CreateDBusMsgMethodReturn(message,
+														DBUS_TYPE_INT32, &ret,
+														DBUS_TYPE_INVALID);
+			if (returnMessage != NULL)
+			{
+				if (!SendMediaPlaybackMessage(returnMessage))
+				{
+					ERROR_PRINTF("SendDBusMessage failed\n");
+				}
+				dbus_message_unref(returnMessage);
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("GetArgumentFromDBusMessage failed\n");
+		}
+	}
+}
+
+static void DBusMethodLibraryCancel(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		int32_t ret;
+		DBusMessage *returnMessage;
+
+		ret = MediaLibraryCancelScan();
+
+		returnMessage = CreateDBusMsgMethodReturn(message,
+													DBUS_TYPE_INT32, &ret,
+													DBUS_TYPE_INVALID);
+		if (returnMessage != NULL)
+		{
+			if (!SendMediaPlaybackMessage(returnMessage))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetAlbumArtThumbnailKey(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		int32_t key;
+		uint32_t size;
+
+		(void)AlbumArtThumbnailGetKey(&key, &size);
+
+		returnMessage = CreateDBusMsgMethodReturn(message,
+													DBUS_TYPE_INT32, &key,
+													DBUS_TYPE_UINT32, &size,
+													DBUS_TYPE_INVALID);
+		if (returnMessage != NULL)
+		{
+			if (!SendMediaPlaybackMessage(returnMessage))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetAlbumArtFd(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		int32_t playID = -1;
+		uint32_t length = 0;
+		int32_t fd = -1;
+		bool peer = MediaPlaybackChannelIsPeer(dbus_message_get_sender(message));
+
+		if (!peer)
+		{
+			fd = MultiMediaGetAlbumArtFd(&playID, &length);
+		}
+
+		if (peer)
+		{
+			returnMessage = dbus_message_new_error(message, DBUS_ERROR_NOT_SUPPORTED, CHANNEL_NO_FD_ERROR);
+		}
+		else if (fd >= 0)
+		{
+			returnMessage = CreateDBusMsgMethodReturn(message,
+														DBUS_TYPE_INT32, &playID,
+														DBUS_TYPE_UINT32, &length,
+														DBUS_TYPE_UNIX_FD, &fd,
+														DBUS_TYPE_INVALID);
+		}
+		else
+		{
+			returnMessage = dbus_message_new_error(message, DBUS_ERROR_FAILED, "no album art");
+		}
+
+		if (returnMessage != NULL)
+		{
+			if (!SendMediaPlaybackMessage(returnMessage))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+
+		/* the message holds its own duplicate */
+		if (fd >= 0)
+		{
+			(void)close(fd);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetMetadata(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		MultiMediaMetadata *metadata = (MultiMediaMetadata *)calloc(1, sizeof(MultiMediaMetadata));
+		int32_t playID = -1;
+
+		if (metadata != NULL)
+		{
+			/* answered from the cache, an empty dictionary before the first tag */
+			(void)MultiMediaGetMetadata(metadata, &playID);
+
+			returnMessage = CreateDBusMsgMethodReturn(message,
+														DBUS_TYPE_INT32, &playID,
+														DBUS_TYPE_INVALID);
+			if (returnMessage != NULL)
+			{
+				AppendMetadata(returnMessage, metadata);
+				if (!SendMediaPlaybackMessage(returnMessage))
+				{
+					ERROR_PRINTF("SendDBusMessage failed\n");
+				}
+				dbus_message_unref(returnMessage);
+			}
+			free(metadata);
+		}
+		else
+		{
+			ERROR_PRINTF("out of memory\n");
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetTagStats(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		MultiMediaTagStatistics statistics;
+
+		MultiMediaGetTagStatistics(&statistics);
+
+		returnMessage = CreateDBusMsgMethodReturn(message,
+													DBUS_TYPE_UINT32, &statistics.received,
+													DBUS_TYPE_UINT32, &statistics.ignored,
+													DBUS_TYPE_UINT32, &statistics.changed,
+													DBUS_TYPE_UINT32, &statistics.emitted,
+													DBUS_TYPE_UINT32, &statistics.deferred,
+													DBUS_TYPE_INVALID);
+		if (returnMessage != NULL)
+		{
+			if (!SendMediaPlaybackMessage(returnMessage))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetCommandStats(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		MultiMediaCommandStatistics statistics;
+		dbus_uint64_t lockWaitSum;
+
+		MultiMediaGetCommandStatistics(&statistics);
+		lockWaitSum = (dbus_uint64_t)statistics.lockWaitSum;
+
+		returnMessage = CreateDBusMsgMethodReturn(message,
+													DBUS_TYPE_UINT32, &statistics.posted,
+													DBUS_TYPE_UINT32, &statistics.overwritten,
+													DBUS_TYPE_UINT32, &statistics.refused,
+													DBUS_TYPE_UINT32, &statistics.lockWaitMax,
+													DBUS_TYPE_UINT64, &lockWaitSum,
+													DBUS_TYPE_INVALID);
+		if (returnMessage != NULL)
+		{
+			if (!SendMediaPlaybackMessage(returnMessage))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetAlbumArtCacheStats(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		AlbumArtCacheStatistics statistics;
+
+		AlbumArtCacheGetStatistics(&statistics);
+
+		returnMessage = CreateDBusMsgMethodReturn(message,
+													DBUS_TYPE_UINT32, &statistics.hits,
+													DBUS_TYPE_UINT32, &statistics.misses,
+													DBUS_TYPE_UINT32, &statistics.folderImages,
+													DBUS_TYPE_UINT32, &statistics.diskHits,
+													DBUS_TYPE_UINT32, &statistics.diskMisses,
+													DBUS_TYPE_UINT32, &statistics.evictions,
+													DBUS_TYPE_UINT32, &statistics.entries,
+													DBUS_TYPE_UINT32, &statistics.bytes,
+													DBUS_TYPE_UINT32, &statistics.budget,
+													DBUS_TYPE_INVALID);
+		if (returnMessage != NULL)
+		{
+			if (!SendMediaPlaybackMessage(returnMessage))
 			{
 				ERROR_PRINTF("SendDBusMessage failed\n");
 			}
@@ -755,4 +1651,1049 @@ static void DBusMethodGetPlayID(DBusMessage *message)
 	}
 }
 
+static void DBusMethodSubscribePosition(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
 
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage = NULL;
+		const char *sender = dbus_message_get_sender(message);
+		uint32_t interval;
+		uint32_t idx;
+		int32_t slot = -1;
+
+		if ((sender != NULL) && (strlen(sender) < (size_t)POSITION_SUBSCRIBER_NAME_SIZE) &&
+			GetArgumentFromDBusMessage(message,
+										DBUS_TYPE_UINT32, &interval,
+										DBUS_TYPE_INVALID))
+		{
+			if (interval < (uint32_t)POSITION_INTERVAL_MIN)
+			{
+				interval = POSITION_INTERVAL_MIN;
+			}
+			else if (interval > (uint32_t)POSITION_INTERVAL_MAX)
+			{
+				interval = POSITION_INTERVAL_MAX;
+			}
+			else
+			{
+				;
+			}
+
+			(void)pthread_mutex_lock(&s_positionMutex);
+			/* a second subscription of the same peer changes its interval */
+			for (idx = 0; (idx < (uint32_t)POSITION_SUBSCRIBER_MAX) && (slot < 0); idx++)
+			{
+				if (strcmp(s_positionSubscribers[idx].name, sender) == 0)
+				{
+					slot = (int32_t)idx;
+				}
+			}
+			for (idx = 0; (idx < (uint32_t)POSITION_SUBSCRIBER_MAX) && (slot < 0); idx++)
+			{
+				if (s_positionSubscribers[idx].name[0] == '\0')
+				{
+					slot = (int32_t)idx;
+					(void)g_strlcpy(s_positionSubscribers[idx].name, sender, sizeof(s_positionSubscribers[idx].name));
+					s_positionSubscribers[idx].lastSent = 0;
+				}
+			}
+			if (slot >= 0)
+			{
+				s_positionSubscribers[slot].interval = interval;
+			}
+			(void)pthread_mutex_unlock(&s_positionMutex);
+
+			if (slot >= 0)
+			{
+				INFO_PRINTF("%s follows the position every %u ms\n", sender, interval);
+				UpdatePositionInterval();
+				returnMessage = CreateDBusMsgMethodReturn(message,
+															DBUS_TYPE_UINT32, &interval,
+															DBUS_TYPE_INVALID);
+			}
+			else
+			{
+				returnMessage = dbus_message_new_error(message, DBUS_ERROR_LIMITS_EXCEEDED, "too many position subscribers");
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("GetArgumentFromDBusMessage failed\n");
+			returnMessage = dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "interval expected");
+		}
+
+		if (returnMessage != NULL)
+		{
+			if (!SendMediaPlaybackMessage(returnMessage))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodUnsubscribePosition(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+
+		RemovePositionSubscriber(dbus_message_get_sender(message));
+
+		returnMessage = CreateDBusMsgMethodReturn(message, DBUS_TYPE_INVALID);
+		if (returnMessage != NULL)
+		{
+			if (!SendMediaPlaybackMessage(returnMessage))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetState(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		MultiMediaState *state = (MultiMediaState *)calloc(1, sizeof(MultiMediaState));
+
+		if (state != NULL)
+		{
+			dbus_bool_t seekable;
+
+			/* everything a client needs to draw its screen, without waiting for signals */
+			MultiMediaStateGet(state);
+			seekable = state->seekable ? TRUE : FALSE;
+
+			returnMessage = CreateDBusMsgMethodReturn(message,
+														DBUS_TYPE_INT32, &state->resourceStatus,
+														DBUS_TYPE_INT32, &state->playID,
+														DBUS_TYPE_UINT32, &state->playback,
+														DBUS_TYPE_UINT32, &state->position,
+														DBUS_TYPE_UINT32, &state->duration,
+														DBUS_TYPE_DOUBLE, &state->rate,
+														DBUS_TYPE_BOOLEAN, &seekable,
+														DBUS_TYPE_BYTE, &state->content,
+														DBUS_TYPE_INT32, &state->samplerate,
+														DBUS_TYPE_INVALID);
+			if (returnMessage != NULL)
+			{
+				/* an empty dictionary before the first tag */
+				AppendMetadata(returnMessage, &state->metadata);
+				if (!SendMediaPlaybackMessage(returnMessage))
+				{
+					ERROR_PRINTF("SendDBusMessage failed\n");
+				}
+				dbus_message_unref(returnMessage);
+			}
+			free(state);
+		}
+		else
+		{
+			ERROR_PRINTF("out of memory\n");
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetStatusPage(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		uint32_t size = (uint32_t)MULTIMEDIA_STATUS_PAGE_SIZE;
+		int32_t fd = -1;
+		bool peer = MediaPlaybackChannelIsPeer(dbus_message_get_sender(message));
+
+		if (!peer)
+		{
+			fd = MultiMediaStateGetStatusPageFd();
+		}
+
+		if (peer)
+		{
+			returnMessage = dbus_message_new_error(message, DBUS_ERROR_NOT_SUPPORTED, CHANNEL_NO_FD_ERROR);
+		}
+		else if (fd >= 0)
+		{
+			returnMessage = CreateDBusMsgMethodReturn(message,
+														DBUS_TYPE_UNIX_FD, &fd,
+														DBUS_TYPE_UINT32, &size,
+														DBUS_TYPE_INVALID);
+		}
+		else
+		{
+			returnMessage = dbus_message_new_error(message, DBUS_ERROR_FAILED, "no status page");
+		}
+
+		if (returnMessage != NULL)
+		{
+			if (!SendMediaPlaybackMessage(returnMessage))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+
+		/* the message holds its own duplicate */
+		if (fd >= 0)
+		{
+			(void)close(fd);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetLatencyStats(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage = CreateDBusMsgMethodReturn(message, DBUS_TYPE_INVALID);
+		DBusMessageIter iter;
+
+		if (returnMessage != NULL)
+		{
+			dbus_message_iter_init_append(returnMessage, &iter);
+			if ((AppendLatencyEvents(&iter) == FALSE) || (AppendLatencyHistograms(&iter) == FALSE) ||
+				(!SendMediaPlaybackMessage(returnMessage)))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetPipelineStats(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		DBusMessageIter iter;
+		MultiMediaPipelineStats pipeline;
+		MultiMediaElementStats elements[MULTIMEDIA_PIPELINE_STATS_ELEMENTS];
+		uint32_t count;
+
+		count = MultiMediaPipelineStatsGet(&pipeline, elements, (uint32_t)MULTIMEDIA_PIPELINE_STATS_ELEMENTS);
+		returnMessage = CreateDBusMsgMethodReturn(message,
+													DBUS_TYPE_INT32, &pipeline.playID,
+													DBUS_TYPE_UINT32, &pipeline.elapsed,
+													DBUS_TYPE_UINT32, &pipeline.elements,
+													DBUS_TYPE_UINT32, &pipeline.warnings,
+													DBUS_TYPE_UINT32, &pipeline.clockLost,
+													DBUS_TYPE_UINT32, &pipeline.buffering,
+													DBUS_TYPE_INVALID);
+		if (returnMessage != NULL)
+		{
+			dbus_message_iter_init_append(returnMessage, &iter);
+			if ((AppendPipelineElements(&iter, elements, count) == FALSE) ||
+				(!SendMediaPlaybackMessage(returnMessage)))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodSetEqualizerPreset(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		char *preset = NULL;
+		int32_t ret;
+		DBusMessage *returnMessage;
+
+		if (GetArgumentFromDBusMessage(message,
+										DBUS_TYPE_STRING, &preset,
+										DBUS_TYPE_INVALID))
+		{
+			ret = AudioEqualizerSetPreset(preset);
+
+			returnMessage = CreateDBusMsgMethodReturn(message,
+														DBUS_TYPE_INT32, &ret,
+														DBUS_TYPE_INVALID);
+			if (returnMessage != NULL)
+			{
+				if (!SendMediaPlaybackMessage(returnMessage))
+				{
+					ERROR_PRINTF("SendDBusMessage failed\n");
+				}
+				dbus_message_unref(returnMessage);
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("GetArgumentFromDBusMessage failed\n");
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetEqualizerPreset(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		DBusMessageIter iter;
+		const char *preset = g_audioEqualizerPresetNames[AudioEqualizerGetPreset()];
+
+		returnMessage = CreateDBusMsgMethodReturn(message,
+													DBUS_TYPE_STRING, &preset,
+													DBUS_TYPE_INVALID);
+		if (returnMessage != NULL)
+		{
+			dbus_message_iter_init_append(returnMessage, &iter);
+			if ((AppendEqualizerPresets(&iter) == FALSE) ||
+				(!SendMediaPlaybackMessage(returnMessage)))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodSetNextTrack(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		char *path = NULL;
+		uint8_t content = 0;
+		int32_t playID = 0;
+		int32_t ret;
+		DBusMessage *returnMessage;
+
+		if (GetArgumentFromDBusMessage(message,
+										DBUS_TYPE_STRING, &path,
+										DBUS_TYPE_BYTE, &content,
+										DBUS_TYPE_INT32, &playID,
+										DBUS_TYPE_INVALID))
+		{
+			ret = MultiMediaSetNextTrack(content, path, playID);
+
+			returnMessage = CreateDBusMsgMethodReturn(message,
+														DBUS_TYPE_INT32, &ret,
+														DBUS_TYPE_INVALID);
+			if (returnMessage != NULL)
+			{
+				if (!SendMediaPlaybackMessage(returnMessage))
+				{
+					ERROR_PRINTF("SendDBusMessage failed\n");
+				}
+				dbus_message_unref(returnMessage);
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("GetArgumentFromDBusMessage failed\n");
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodSetCrossfade(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		uint32_t length = 0;
+		DBusMessage *returnMessage;
+
+		if (GetArgumentFromDBusMessage(message,
+										DBUS_TYPE_UINT32, &length,
+										DBUS_TYPE_INVALID))
+		{
+			length = AudioCrossfadeSetLengthMs(length);
+
+			returnMessage = CreateDBusMsgMethodReturn(message,
+														DBUS_TYPE_UINT32, &length,
+														DBUS_TYPE_INVALID);
+			if (returnMessage != NULL)
+			{
+				if (!SendMediaPlaybackMessage(returnMessage))
+				{
+					ERROR_PRINTF("SendDBusMessage failed\n");
+				}
+				dbus_message_unref(returnMessage);
+			}
+		}
+		else
+		{
+			ERROR_PRINTF("GetArgumentFromDBusMessage failed\n");
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void DBusMethodGetSpanStats(DBusMessage *message)
+{
+	DEBUG_PRINTF("\n");
+
+	if (message != NULL)
+	{
+		DBusMessage *returnMessage;
+		DBusMessageIter iter;
+		int64_t monotonic = TCTimeGetMonotonicNs();
+		int64_t boottime = TCTimeGetBoottimeNs();
+
+		returnMessage = CreateDBusMsgMethodReturn(message,
+													DBUS_TYPE_INT64, &monotonic,
+													DBUS_TYPE_INT64, &boottime,
+													DBUS_TYPE_INVALID);
+		if (returnMessage != NULL)
+		{
+			dbus_message_iter_init_append(returnMessage, &iter);
+			if ((AppendSpans(&iter) == FALSE) ||
+				(!SendMediaPlaybackMessage(returnMessage)))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(returnMessage);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("mesage is NULL\n");
+	}
+}
+
+static void RemovePositionSubscriber(const char *name)
+{
+	uint32_t idx;
+	bool removed = false;
+
+	if (name != NULL)
+	{
+		(void)pthread_mutex_lock(&s_positionMutex);
+		for (idx = 0; idx < (uint32_t)POSITION_SUBSCRIBER_MAX; idx++)
+		{
+			if ((s_positionSubscribers[idx].name[0] != '\0') &&
+				(strcmp(s_positionSubscribers[idx].name, name) == 0))
+			{
+				s_positionSubscribers[idx].name[0] = '\0';
+				removed = true;
+			}
+		}
+		(void)pthread_mutex_unlock(&s_positionMutex);
+	}
+
+	if (removed)
+	{
+		INFO_PRINTF("%s stopped following the position\n", name);
+		UpdatePositionInterval();
+	}
+}
+
+static void UpdatePositionInterval(void)
+{
+	uint32_t interval = 0;
+	uint32_t idx;
+
+	(void)pthread_mutex_lock(&s_positionMutex);
+	if (s_positionBroadcast)
+	{
+		interval = MULTIMEDIA_POSITION_INTERVAL_DEFAULT;
+	}
+	for (idx = 0; idx < (uint32_t)POSITION_SUBSCRIBER_MAX; idx++)
+	{
+		if ((s_positionSubscribers[idx].name[0] != '\0') &&
+			((interval == 0U) || (s_positionSubscribers[idx].interval < interval)))
+		{
+			interval = s_positionSubscribers[idx].interval;
+		}
+	}
+	/* 0 stops the position query as long as nobody listens */
+	MultiMediaSetPositionInterval(interval);
+	(void)pthread_mutex_unlock(&s_positionMutex);
+}
+
+static void DBusPropertiesProcess(DBusMessage *message)
+{
+	DBusMessage *returnMessage = NULL;
+	const char *interface = NULL;
+	const char *name = NULL;
+	MultiMediaState *state = (MultiMediaState *)calloc(1, sizeof(MultiMediaState));
+	DBusMessageIter iter;
+	DBusMessageIter dict;
+	uint32_t idx;
+	int32_t property = -1;
+
+	if (state == NULL)
+	{
+		ERROR_PRINTF("out of memory\n");
+		returnMessage = dbus_message_new_error(message, DBUS_ERROR_NO_MEMORY, "out of memory");
+	}
+	else if (dbus_message_is_method_call(message, DBUS_INTERFACE_PROPERTIES, "Get") == TRUE)
+	{
+		if (GetArgumentFromDBusMessage(message,
+										DBUS_TYPE_STRING, &interface,
+										DBUS_TYPE_STRING, &name,
+										DBUS_TYPE_INVALID) &&
+			(strcmp(interface, MEDIAPLAYBACK_EVENT_INTERFACE) == 0))
+		{
+			property = FindProperty(name);
+		}
+
+		if (property >= 0)
+		{
+			MultiMediaStateGet(state);
+			returnMessage = dbus_message_new_method_return(message);
+			if (returnMessage != NULL)
+			{
+				dbus_message_iter_init_append(returnMessage, &iter);
+				AppendProperty(&iter, (uint32_t)property, state);
+			}
+		}
+		else
+		{
+			returnMessage = dbus_message_new_error(message, DBUS_ERROR_UNKNOWN_PROPERTY, "unknown property");
+		}
+	}
+	else if (dbus_message_is_method_call(message, DBUS_INTERFACE_PROPERTIES, "GetAll") == TRUE)
+	{
+		if (GetArgumentFromDBusMessage(message,
+										DBUS_TYPE_STRING, &interface,
+										DBUS_TYPE_INVALID) &&
+			(strcmp(interface, MEDIAPLAYBACK_EVENT_INTERFACE) == 0))
+		{
+			MultiMediaStateGet(state);
+			returnMessage = dbus_message_new_method_return(message);
+			if (returnMessage != NULL)
+			{
+				dbus_message_iter_init_append(returnMessage, &iter);
+				if (dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &dict))
+				{
+					for (idx = 0; idx < (uint32_t)TotalProperties; idx++)
+					{
+						DBusMessageIter entry;
+
+						if (dbus_message_iter_open_container(&dict, DBUS_TYPE_DICT_ENTRY, NULL, &entry))
+						{
+							(void)dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &s_properties[idx].name);
+							AppendProperty(&entry, idx, state);
+							(void)dbus_message_iter_close_container(&dict, &entry);
+						}
+					}
+					(void)dbus_message_iter_close_container(&iter, &dict);
+				}
+			}
+		}
+		else
+		{
+			returnMessage = dbus_message_new_error(message, DBUS_ERROR_UNKNOWN_INTERFACE, "unknown interface");
+		}
+	}
+	else if (dbus_message_is_method_call(message, DBUS_INTERFACE_PROPERTIES, "Set") == TRUE)
+	{
+		returnMessage = dbus_message_new_error(message, DBUS_ERROR_PROPERTY_READ_ONLY, "properties are read only");
+	}
+	else
+	{
+		returnMessage = dbus_message_new_error(message, DBUS_ERROR_UNKNOWN_METHOD, "unknown method");
+	}
+
+	if (returnMessage != NULL)
+	{
+		if (!SendMediaPlaybackMessage(returnMessage))
+		{
+			ERROR_PRINTF("SendDBusMessage failed\n");
+		}
+		dbus_message_unref(returnMessage);
+	}
+	free(state);
+}
+
+static void AppendProperty(DBusMessageIter *iter, uint32_t property, const MultiMediaState *state)
+{
+	DBusMessageIter variant;
+	const char *status;
+
+	switch (property)
+	{
+		case PropertyPlaybackStatus:
+			if (state->playback == (uint32_t)MultiMediaPlaybackStopped)
+			{
+				status = "Stopped";
+			}
+			else if (state->playback == (uint32_t)MultiMediaPlaybackPaused)
+			{
+				status = "Paused";
+			}
+			else
+			{
+				/* trick play is playing at a rate other than 1 */
+				status = "Playing";
+			}
+			if (dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT, DBUS_TYPE_STRING_AS_STRING, &variant))
+			{
+				(void)dbus_message_iter_append_basic(&variant, DBUS_TYPE_STRING, &status);
+				(void)dbus_message_iter_close_container(iter, &variant);
+			}
+			break;
+		case PropertyPosition:
+		case PropertyDuration:
+			if (dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT, DBUS_TYPE_UINT32_AS_STRING, &variant))
+			{
+				(void)dbus_message_iter_append_basic(&variant, DBUS_TYPE_UINT32,
+													 (property == (uint32_t)PropertyPosition) ? &state->position : &state->duration);
+				(void)dbus_message_iter_close_container(iter, &variant);
+			}
+			break;
+		case PropertyMetadata:
+			if (dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT, "a{sv}", &variant))
+			{
+				AppendMetadataDict(&variant, &state->metadata);
+				(void)dbus_message_iter_close_container(iter, &variant);
+			}
+			break;
+		case PropertyRate:
+			if (dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT, DBUS_TYPE_DOUBLE_AS_STRING, &variant))
+			{
+				(void)dbus_message_iter_append_basic(&variant, DBUS_TYPE_DOUBLE, &state->rate);
+				(void)dbus_message_iter_close_container(iter, &variant);
+			}
+			break;
+		case PropertyPlayID:
+		case PropertySampleRate:
+			if (dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT, DBUS_TYPE_INT32_AS_STRING, &variant))
+			{
+				(void)dbus_message_iter_append_basic(&variant, DBUS_TYPE_INT32,
+													 (property == (uint32_t)PropertyPlayID) ? &state->playID : &state->samplerate);
+				(void)dbus_message_iter_close_container(iter, &variant);
+			}
+			break;
+		default:
+			ERROR_PRINTF("unknown property(%u)\n", property);
+			break;
+	}
+}
+
+static int32_t FindProperty(const char *name)
+{
+	int32_t found = -1;
+	uint32_t idx;
+
+	for (idx = 0; (idx < (uint32_t)TotalProperties) && (found < 0); idx++)
+	{
+		if ((name != NULL) && (strcmp(s_properties[idx].name, name) == 0))
+		{
+			found = (int32_t)idx;
+		}
+	}
+
+	return found;
+}
+
+static gboolean OnPropertiesChanged(gpointer data)
+{
+	uint32_t changed = __atomic_exchange_n(&s_propertiesChanged, 0U, __ATOMIC_ACQ_REL);
+	const char *interface = MEDIAPLAYBACK_EVENT_INTERFACE;
+	MultiMediaState *state = (MultiMediaState *)calloc(1, sizeof(MultiMediaState));
+	DBusMessage *message;
+	DBusMessageIter iter;
+	DBusMessageIter dict;
+	DBusMessageIter invalidated;
+	uint32_t idx;
+
+	(void)data;
+
+	if (((changed & GetPropertiesMask()) != 0U) && (state != NULL))
+	{
+		/* values are read now, so a property that changed twice is sent once with its latest value */
+		MultiMediaStateGet(state);
+		message = CreateDBusMsgSignal(MEDIAPLAYBACK_PROCESS_OBJECT_PATH, DBUS_INTERFACE_PROPERTIES,
+									  "PropertiesChanged",
+									  DBUS_TYPE_STRING, &interface,
+									  DBUS_TYPE_INVALID);
+		if (message != NULL)
+		{
+			dbus_message_iter_init_append(message, &iter);
+			if (dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &dict))
+			{
+				for (idx = 0; idx < (uint32_t)TotalProperties; idx++)
+				{
+					DBusMessageIter entry;
+
+					if (((changed & s_properties[idx].changedBy) != 0U) &&
+						dbus_message_iter_open_container(&dict, DBUS_TYPE_DICT_ENTRY, NULL, &entry))
+					{
+						(void)dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &s_properties[idx].name);
+						AppendProperty(&entry, idx, state);
+						(void)dbus_message_iter_close_container(&dict, &entry);
+					}
+				}
+				(void)dbus_message_iter_close_container(&iter, &dict);
+			}
+			if (dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, DBUS_TYPE_STRING_AS_STRING, &invalidated))
+			{
+				(void)dbus_message_iter_close_container(&iter, &invalidated);
+			}
+
+			if (!SendMediaPlaybackMessage(message))
+			{
+				ERROR_PRINTF("SendDBusMessage failed\n");
+			}
+			dbus_message_unref(message);
+		}
+	}
+	free(state);
+
+	return FALSE;
+}
+
+static uint32_t GetPropertiesMask(void)
+{
+	uint32_t mask = 0;
+	uint32_t idx;
+
+	for (idx = 0; idx < (uint32_t)TotalProperties; idx++)
+	{
+		mask |= s_properties[idx].changedBy;
+	}
+
+	return mask;
+}
+
+static void AppendMetadata(DBusMessage *message, const MultiMediaMetadata *metadata)
+{
+	DBusMessageIter iter;
+
+	dbus_message_iter_init_append(message, &iter);
+	AppendMetadataDict(&iter, metadata);
+}
+
+static dbus_bool_t AppendLatencyEvents(DBusMessageIter *iter)
+{
+	MultiMediaLatencyEvent events[MULTIMEDIA_LATENCY_EVENTS];
+	DBusMessageIter array;
+	DBusMessageIter entry;
+	dbus_bool_t ret = FALSE;
+	uint32_t count;
+	uint32_t idx;
+
+	count = MultiMediaLatencyGetEvents(events, (uint32_t)MULTIMEDIA_LATENCY_EVENTS);
+	if (dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, "(uuiux)", &array))
+	{
+		ret = TRUE;
+		for (idx = 0; (idx < count) && (ret == TRUE); idx++)
+		{
+			ret = dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL, &entry) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &events[idx].request) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &events[idx].sink) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT32, &events[idx].playID) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &events[idx].latency) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT64, &events[idx].received) &&
+				  dbus_message_iter_close_container(&array, &entry);
+		}
+		ret = dbus_message_iter_close_container(iter, &array) && ret;
+	}
+
+	return ret;
+}
+
+static dbus_bool_t AppendLatencyHistograms(DBusMessageIter *iter)
+{
+	MultiMediaLatencyHistogram histogram;
+	DBusMessageIter array;
+	DBusMessageIter entry;
+	DBusMessageIter buckets;
+	const uint32_t *bucketCounts = histogram.buckets;
+	dbus_bool_t ret = FALSE;
+	uint32_t request;
+	uint32_t sink;
+
+	if (dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, "(uuuuutau)", &array))
+	{
+		ret = TRUE;
+		for (request = 0; (request < (uint32_t)TotalMultiMediaLatencyRequests) && (ret == TRUE); request++)
+		{
+			for (sink = 0; (sink < (uint32_t)TotalMultiMediaLatencySinks) && (ret == TRUE); sink++)
+			{
+				MultiMediaLatencyGetHistogram((MultiMediaLatencyRequest)request, (MultiMediaLatencySink)sink, &histogram);
+				ret = dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL, &entry) &&
+					  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &request) &&
+					  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &sink) &&
+					  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &histogram.count) &&
+					  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &histogram.min) &&
+					  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &histogram.max) &&
+					  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &histogram.sum) &&
+					  dbus_message_iter_open_container(&entry, DBUS_TYPE_ARRAY, DBUS_TYPE_UINT32_AS_STRING, &buckets) &&
+					  dbus_message_iter_append_fixed_array(&buckets, DBUS_TYPE_UINT32, &bucketCounts,
+														  MULTIMEDIA_LATENCY_BUCKETS) &&
+					  dbus_message_iter_close_container(&entry, &buckets) &&
+					  dbus_message_iter_close_container(&array, &entry);
+			}
+		}
+		ret = dbus_message_iter_close_container(iter, &array) && ret;
+	}
+
+	return ret;
+}
+
+static dbus_bool_t AppendPipelineElements(DBusMessageIter *iter, const MultiMediaElementStats *elements, uint32_t count)
+{
+	DBusMessageIter array;
+	DBusMessageIter entry;
+	dbus_bool_t ret = FALSE;
+	uint32_t idx;
+
+	if (dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, "(ssuuttuuuuuuuuu)", &array))
+	{
+		ret = TRUE;
+		for (idx = 0; (idx < count) && (ret == TRUE); idx++)
+		{
+			const MultiMediaElementStats *stats = &elements[idx];
+			const char *name = stats->name;
+			const char *factory = stats->factory;
+
+			ret = dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL, &entry) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &factory) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->kind) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->buffers) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &stats->bytes) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &stats->processSum) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->processMax) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->level) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->levelMax) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->overruns) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->underruns) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->late) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->dropped) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->discontinuities) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->warnings) &&
+				  dbus_message_iter_close_container(&array, &entry);
+		}
+		ret = dbus_message_iter_close_container(iter, &array) && ret;
+	}
+
+	return ret;
+}
+
+static dbus_bool_t AppendEqualizerPresets(DBusMessageIter *iter)
+{
+	DBusMessageIter array;
+	dbus_bool_t ret = FALSE;
+	uint32_t idx;
+
+	if (dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, DBUS_TYPE_STRING_AS_STRING, &array))
+	{
+		ret = TRUE;
+		for (idx = 0; (idx < (uint32_t)TotalAudioEqualizerPresets) && (ret == TRUE); idx++)
+		{
+			ret = dbus_message_iter_append_basic(&array, DBUS_TYPE_STRING, &g_audioEqualizerPresetNames[idx]);
+		}
+		ret = dbus_message_iter_close_container(iter, &array) && ret;
+	}
+
+	return ret;
+}
+
+static dbus_bool_t AppendSpans(DBusMessageIter *iter)
+{
+	TCTimeSpanRecord *records = (TCTimeSpanRecord *)malloc(SPAN_STATS_RECORDS * sizeof(TCTimeSpanRecord));
+	DBusMessageIter array;
+	DBusMessageIter entry;
+	dbus_bool_t ret = FALSE;
+	uint32_t count = 0;
+	uint32_t idx;
+
+	if (records != NULL)
+	{
+		count = TCTimeSpanCollect(records, (uint32_t)SPAN_STATS_RECORDS);
+	}
+
+	if (dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, "(siixx)", &array))
+	{
+		ret = TRUE;
+		for (idx = 0; (idx < count) && (ret == TRUE); idx++)
+		{
+			const char *name = (records[idx].name < (uint32_t)TotalTCTimeSpanNames) ?
+							   g_tcTimeSpanNames[records[idx].name] : "";
+
+			ret = dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL, &entry) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT32, &records[idx].playID) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT32, &records[idx].thread) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT64, &records[idx].begin) &&
+				  dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT64, &records[idx].duration) &&
+				  dbus_message_iter_close_container(&array, &entry);
+		}
+		ret = dbus_message_iter_close_container(iter, &array) && ret;
+	}
+	free(records);
+
+	return ret;
+}
+
+static void AppendMetadataDict(DBusMessageIter *iter, const MultiMediaMetadata *metadata)
+{
+	DBusMessageIter dict;
+	uint32_t idx;
+	const struct {
+		const char *key;
+		const char *value;
+	} strings[] = {
+		{ "title", metadata->title },
+		{ "artist", metadata->artist },
+		{ "album", metadata->album },
+		{ "genre", metadata->genre },
+		{ "composer", metadata->composer },
+		{ "codec", metadata->codec },
+	};
+	const struct {
+		const char *key;
+		uint32_t value;
+	} numbers[] = {
+		{ "track-number", metadata->trackNumber },
+		{ "track-count", metadata->trackCount },
+		{ "disc-number", metadata->discNumber },
+		{ "disc-count", metadata->discCount },
+		{ "year", metadata->year },
+		{ "bitrate", metadata->bitrate },
+		{ "channels", metadata->channels },
+	};
+
+	/* a{sv}, tags that are not known are left out */
+	if (dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, "{sv}", &dict))
+	{
+		for (idx = 0; idx < (uint32_t)(sizeof(strings) / sizeof(strings[0])); idx++)
+		{
+			if (strings[idx].value[0] != '\0')
+			{
+				AppendDictEntry(&dict, strings[idx].key, DBUS_TYPE_STRING, &strings[idx].value);
+			}
+		}
+
+		for (idx = 0; idx < (uint32_t)(sizeof(numbers) / sizeof(numbers[0])); idx++)
+		{
+			if (numbers[idx].value != 0U)
+			{
+				AppendDictEntry(&dict, numbers[idx].key, DBUS_TYPE_UINT32, &numbers[idx].value);
+			}
+		}
+
+		if (metadata->channels != 0U)
+		{
+			const char *layout = GetChannelLayout(metadata->channels);
+			AppendDictEntry(&dict, "channel-layout", DBUS_TYPE_STRING, &layout);
+		}
+
+		(void)dbus_message_iter_close_container(iter, &dict);
+	}
+	else
+	{
+		ERROR_PRINTF("dbus_message_iter_open_container failed\n");
+	}
+}
+
+static void AppendDictEntry(DBusMessageIter *dict, const char *key, int type, const void *value)
+{
+	DBusMessageIter entry;
+	DBusMessageIter variant;
+	char signature[2];
+
+	signature[0] = (char)type;
+	signature[1] = '\0';
+
+	if (dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY, NULL, &entry))
+	{
+		(void)dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+		if (dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT, signature, &variant))
+		{
+			(void)dbus_message_iter_append_basic(&variant, type, value);
+			(void)dbus_message_iter_close_container(&entry, &variant);
+		}
+		(void)dbus_message_iter_close_container(dict, &entry);
+	}
+}
+
+static const char *GetChannelLayout(uint32_t channels)
+{
+	const char *layout;
+
+	switch (channels)
+	{
+		case 1:
+			layout = "mono";
+			break;
+		case 2:
+			layout = "stereo";
+			break;
+		case 3:
+			layout = "2.1";
+			break;
+		case 4:
+			layout = "quad";
+			break;
+		case 6:
+			layout = "5.1";
+			break;
+		case 8:
+			layout = "7.1";
+			break;
+		default:
+			layout = "multichannel";
+			break;
+	}
+
+	return layout;
+}
@@ -0,0 +1,342 @@
+/****************************************************************************************
+ *   FileName    : MediaPlaybackSender.c
+ *   Description : Telechips Media Playback Event Sender
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <glib.h>
+#include "TCLog.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MediaPlaybackSender.h"
+
+#define SENDER_QUEUE_MASK				((uint32_t)MEDIAPLAYBACK_SENDER_QUEUE_SIZE - 1U)
+
+/* a cell is free for the producer at position p when sequence == p, filled when p + 1 */
+typedef struct stSenderCell {
+	volatile uint32_t sequence;
+	MediaPlaybackEvent event;
+} SenderCell;
+
+/* seqlock, odd while a producer writes the event */
+typedef struct stSenderLatest {
+	volatile uint32_t sequence;
+	volatile uint32_t pending;
+	MediaPlaybackEvent event;
+} SenderLatest;
+
+static bool QueuePush(const MediaPlaybackEvent *event);
+static bool QueuePop(MediaPlaybackEvent *event);
+static void SendLatest(void);
+static void SendQueued(void);
+static void *SenderThread(void *arg);
+
+static SenderCell s_queue[MEDIAPLAYBACK_SENDER_QUEUE_SIZE];
+static uint32_t s_queueTail = 0;			/* producers, atomic */
+static uint32_t s_queueHead = 0;			/* the sender thread only */
+static SenderLatest s_latest[MEDIAPLAYBACK_SENDER_LATEST_SLOTS];
+
+static GQueue s_overflow = G_QUEUE_INIT;
+static uint32_t s_overflowing = 0;			/* events wait in s_overflow, atomic */
+static pthread_mutex_t s_overflowMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static sem_t s_wakeup;
+static pthread_t s_thread;
+static uint32_t s_threadRun = 0;			/* atomic */
+static MediaPlaybackSenderStatistics s_statistics;
+
+static MediaPlaybackSenderSend_cb MediaPlaybackSenderSendCB = NULL;
+
+int32_t MediaPlaybackSenderInitialize(MediaPlaybackSenderSend_cb cb)
+{
+	int32_t ret = -1;
+	int32_t err;
+	uint32_t idx;
+
+	MediaPlaybackSenderSendCB = cb;
+	for (idx = 0; idx < (uint32_t)MEDIAPLAYBACK_SENDER_QUEUE_SIZE; idx++)
+	{
+		s_queue[idx].sequence = idx;
+	}
+	s_queueTail = 0;
+	s_queueHead = 0;
+	(void)memset(s_latest, 0, sizeof(s_latest));
+	(void)memset(&s_statistics, 0, sizeof(s_statistics));
+
+	if (sem_init(&s_wakeup, 0, 0) != 0)
+	{
+		ERROR_PRINTF("sem_init failed: error(%d)\n", errno);
+	}
+	else
+	{
+		__atomic_store_n(&s_threadRun, 1U, __ATOMIC_RELEASE);
+		err = pthread_create(&s_thread, NULL, SenderThread, NULL);
+		if (err == 0)
+		{
+			ret = 0;
+		}
+		else
+		{
+			/* events are then sent by the thread that posts them */
+			ERROR_PRINTF("pthread_create failed: error(%d)\n", err);
+			__atomic_store_n(&s_threadRun, 0U, __ATOMIC_RELEASE);
+			(void)sem_destroy(&s_wakeup);
+		}
+	}
+
+	return ret;
+}
+
+void MediaPlaybackSenderRelease(void)
+{
+	if (__atomic_load_n(&s_threadRun, __ATOMIC_ACQUIRE) != 0U)
+	{
+		/* the thread sends what is still queued before it ends */
+		__atomic_store_n(&s_threadRun, 0U, __ATOMIC_RELEASE);
+		(void)sem_post(&s_wakeup);
+		(void)pthread_join(s_thread, NULL);
+		(void)sem_destroy(&s_wakeup);
+
+		INFO_PRINTF("posted(%u), overflowed(%u), replaced(%u)\n",
+					s_statistics.posted, s_statistics.overflowed, s_statistics.replaced);
+	}
+}
+
+void MediaPlaybackSenderPost(const MediaPlaybackEvent *event)
+{
+	MediaPlaybackEvent *waiting;
+
+	if (__atomic_load_n(&s_threadRun, __ATOMIC_ACQUIRE) == 0U)
+	{
+		MediaPlaybackEvent copy = *event;
+		if (MediaPlaybackSenderSendCB != NULL)
+		{
+			MediaPlaybackSenderSendCB(&copy);
+		}
+	}
+	else
+	{
+		(void)__atomic_fetch_add(&s_statistics.posted, 1U, __ATOMIC_RELAXED);
+
+		/* once one event waits in the overflow list, the later ones queue behind it */
+		if ((__atomic_load_n(&s_overflowing, __ATOMIC_ACQUIRE) != 0U) || (!QueuePush(event)))
+		{
+			waiting = (MediaPlaybackEvent *)g_malloc(sizeof(MediaPlaybackEvent));
+			*waiting = *event;
+
+			(void)pthread_mutex_lock(&s_overflowMutex);
+			__atomic_store_n(&s_overflowing, 1U, __ATOMIC_RELEASE);
+			g_queue_push_tail(&s_overflow, waiting);
+			(void)pthread_mutex_unlock(&s_overflowMutex);
+
+			(void)__atomic_fetch_add(&s_statistics.overflowed, 1U, __ATOMIC_RELAXED);
+		}
+		(void)sem_post(&s_wakeup);
+	}
+}
+
+void MediaPlaybackSenderPostLatest(uint32_t slot, const MediaPlaybackEvent *event)
+{
+	SenderLatest *latest;
+	uint32_t sequence;
+
+	if (slot >= (uint32_t)MEDIAPLAYBACK_SENDER_LATEST_SLOTS)
+	{
+		ERROR_PRINTF("invalid slot(%u)\n", slot);
+	}
+	else if (__atomic_load_n(&s_threadRun, __ATOMIC_ACQUIRE) == 0U)
+	{
+		MediaPlaybackEvent copy = *event;
+		if (MediaPlaybackSenderSendCB != NULL)
+		{
+			MediaPlaybackSenderSendCB(&copy);
+		}
+	}
+	else
+	{
+		latest = &s_latest[slot];
+
+		/* an even sequence taken to odd locks the slot against other producers */
+		do
+		{
+			sequence = __atomic_load_n(&latest->sequence, __ATOMIC_RELAXED) & ~1U;
+		} while (!__atomic_compare_exchange_n(&latest->sequence, &sequence, sequence + 1U, false,
+											  __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		latest->event = *event;
+		__atomic_store_n(&latest->sequence, sequence + 2U, __ATOMIC_RELEASE);
+
+		if (__atomic_exchange_n(&latest->pending, 1U, __ATOMIC_ACQ_REL) != 0U)
+		{
+			(void)__atomic_fetch_add(&s_statistics.replaced, 1U, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			(void)sem_post(&s_wakeup);
+		}
+	}
+}
+
+void MediaPlaybackSenderGetStatistics(MediaPlaybackSenderStatistics *statistics)
+{
+	statistics->posted = __atomic_load_n(&s_statistics.posted, __ATOMIC_RELAXED);
+	statistics->overflowed = __atomic_load_n(&s_statistics.overflowed, __ATOMIC_RELAXED);
+	statistics->replaced = __atomic_load_n(&s_statistics.replaced, __ATOMIC_RELAXED);
+}
+
+static bool QueuePush(const MediaPlaybackEvent *event)
+{
+	bool pushed = false;
+	bool full = false;
+	uint32_t position = __atomic_load_n(&s_queueTail, __ATOMIC_RELAXED);
+	SenderCell *cell = NULL;
+
+	while ((!pushed) && (!full))
+	{
+		int32_t diff;
+
+		cell = &s_queue[position & SENDER_QUEUE_MASK];
+		diff = (int32_t)(__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - position);
+		if (diff == 0)
+		{
+			/* on failure position is reloaded with the current tail */
+			pushed = __atomic_compare_exchange_n(&s_queueTail, &position, position + 1U, false,
+												 __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+		}
+		else if (diff < 0)
+		{
+			full = true;
+		}
+		else
+		{
+			position = __atomic_load_n(&s_queueTail, __ATOMIC_RELAXED);
+		}
+	}
+
+	if (pushed)
+	{
+		cell->event = *event;
+		__atomic_store_n(&cell->sequence, position + 1U, __ATOMIC_RELEASE);
+	}
+
+	return pushed;
+}
+
+static bool QueuePop(MediaPlaybackEvent *event)
+{
+	bool popped = false;
+	SenderCell *cell = &s_queue[s_queueHead & SENDER_QUEUE_MASK];
+
+	if (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) == (s_queueHead + 1U))
+	{
+		*event = cell->event;
+		__atomic_store_n(&cell->sequence, s_queueHead + (uint32_t)MEDIAPLAYBACK_SENDER_QUEUE_SIZE, __ATOMIC_RELEASE);
+		s_queueHead++;
+		popped = true;
+	}
+
+	return popped;
+}
+
+static void SendLatest(void)
+{
+	MediaPlaybackEvent event;
+	uint32_t slot;
+	uint32_t before;
+	uint32_t after;
+
+	for (slot = 0; slot < (uint32_t)MEDIAPLAYBACK_SENDER_LATEST_SLOTS; slot++)
+	{
+		SenderLatest *latest = &s_latest[slot];
+
+		if (__atomic_exchange_n(&latest->pending, 0U, __ATOMIC_ACQ_REL) != 0U)
+		{
+			do
+			{
+				before = __atomic_load_n(&latest->sequence, __ATOMIC_ACQUIRE);
+				event = latest->event;
+				__atomic_thread_fence(__ATOMIC_ACQUIRE);
+				after = __atomic_load_n(&latest->sequence, __ATOMIC_RELAXED);
+			} while (((before & 1U) != 0U) || (before != after));
+
+			MediaPlaybackSenderSendCB(&event);
+		}
+	}
+}
+
+static void SendQueued(void)
+{
+	MediaPlaybackEvent event;
+	GQueue waiting = G_QUEUE_INIT;
+	MediaPlaybackEvent *next;
+
+	while (QueuePop(&event))
+	{
+		MediaPlaybackSenderSendCB(&event);
+	}
+
+	if (__atomic_load_n(&s_overflowing, __ATOMIC_ACQUIRE) != 0U)
+	{
+		/* the queue is empty now, new events may use it again */
+		(void)pthread_mutex_lock(&s_overflowMutex);
+		waiting = s_overflow;
+		g_queue_init(&s_overflow);
+		__atomic_store_n(&s_overflowing, 0U, __ATOMIC_RELEASE);
+		(void)pthread_mutex_unlock(&s_overflowMutex);
+
+		next = (MediaPlaybackEvent *)g_queue_pop_head(&waiting);
+		while (next != NULL)
+		{
+			MediaPlaybackSenderSendCB(next);
+			g_free(next);
+			next = (MediaPlaybackEvent *)g_queue_pop_head(&waiting);
+		}
+	}
+}
+
+static void *SenderThread(void *arg)
+{
+	(void)arg;
+
+	while (__atomic_load_n(&s_threadRun, __ATOMIC_ACQUIRE) != 0U)
+	{
+		if ((sem_wait(&s_wakeup) == 0) || (errno == EINTR))
+		{
+			/* queued events first, a position must not overtake the track change it belongs to */
+			SendQueued();
+			SendLatest();
+		}
+	}
+
+	/* whatever was posted before the release */
+	SendQueued();
+	SendLatest();
+
+	return NULL;
+}
@@ -0,0 +1,179 @@
+/****************************************************************************************
+ *   FileName    : MediaPlaybackTrace.c
+ *   Description : Telechips Media Playback Trace Ring
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "TCLog.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MediaPlaybackTrace.h"
+#include "TCTime.h"
+
+static uint32_t s_entryCount = 0;			/* 0 while the ring is off */
+static size_t s_traceSize = 0;
+static MediaPlaybackTraceEntry *s_entries = NULL;
+
+static void OnSpanEnded(const TCTimeSpanRecord *record);
+
+MediaPlaybackTraceHeader *g_mediaPlaybackTrace = NULL;
+
+int32_t MediaPlaybackTraceSetSize(const char *entries)
+{
+	int32_t ret = 0;
+	unsigned long count = 0;
+	uint32_t size = (uint32_t)MEDIAPLAYBACK_TRACE_MIN_ENTRIES;
+
+	if (entries != NULL)
+	{
+		count = strtoul(entries, NULL, 10);
+	}
+
+	if ((count >= (unsigned long)MEDIAPLAYBACK_TRACE_MIN_ENTRIES) && (count <= (unsigned long)MEDIAPLAYBACK_TRACE_MAX_ENTRIES))
+	{
+		/* rounded up so a record index maps to its entry with a mask */
+		while ((unsigned long)size < count)
+		{
+			size <<= 1;
+		}
+		s_entryCount = size;
+		ret = 1;
+	}
+	else
+	{
+		ERROR_PRINTF("invalid trace ring size(%s), %d to %d entries\n", (entries != NULL) ? entries : "null",
+					 MEDIAPLAYBACK_TRACE_MIN_ENTRIES, MEDIAPLAYBACK_TRACE_MAX_ENTRIES);
+	}
+
+	return ret;
+}
+
+int32_t MediaPlaybackTraceInitialize(void)
+{
+	int32_t ret = 1;
+	int32_t fd;
+	void *addr;
+	MediaPlaybackTraceHeader *header;
+
+	if (s_entryCount != 0U)
+	{
+		ret = 0;
+		s_traceSize = sizeof(MediaPlaybackTraceHeader) + ((size_t)s_entryCount * sizeof(MediaPlaybackTraceEntry));
+
+		/* a ring left by a daemon that died is replaced */
+		fd = shm_open(MEDIAPLAYBACK_TRACE_NAME, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0)
+		{
+			ERROR_PRINTF("shm_open(%s) failed: error(%d)\n", MEDIAPLAYBACK_TRACE_NAME, errno);
+		}
+		else
+		{
+			if (ftruncate(fd, (off_t)s_traceSize) != 0)
+			{
+				ERROR_PRINTF("ftruncate failed: error(%d)\n", errno);
+			}
+			else
+			{
+				addr = mmap(NULL, s_traceSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				if (addr == MAP_FAILED)
+				{
+					ERROR_PRINTF("mmap failed: error(%d)\n", errno);
+				}
+				else
+				{
+					header = (MediaPlaybackTraceHeader *)addr;
+					header->magic = MEDIAPLAYBACK_TRACE_MAGIC;
+					header->version = MEDIAPLAYBACK_TRACE_VERSION;
+					header->headerSize = (uint32_t)sizeof(MediaPlaybackTraceHeader);
+					header->entrySize = (uint32_t)sizeof(MediaPlaybackTraceEntry);
+					header->entryCount = s_entryCount;
+					header->head = 0;
+					s_entries = (MediaPlaybackTraceEntry *)(void *)((uint8_t *)addr + sizeof(MediaPlaybackTraceHeader));
+					__atomic_store_n(&g_mediaPlaybackTrace, header, __ATOMIC_RELEASE);
+					TCTimeSpanSetEndedCallBack(OnSpanEnded);
+
+					INFO_PRINTF("trace ring %s, %u entries\n", MEDIAPLAYBACK_TRACE_NAME, s_entryCount);
+					ret = 1;
+				}
+			}
+			(void)close(fd);
+		}
+	}
+
+	return ret;
+}
+
+void MediaPlaybackTraceRelease(void)
+{
+	MediaPlaybackTraceHeader *header = __atomic_exchange_n(&g_mediaPlaybackTrace, NULL, __ATOMIC_ACQ_REL);
+
+	/* called once the other threads are gone, nobody writes any more */
+	if (header != NULL)
+	{
+		TCTimeSpanSetEndedCallBack(NULL);
+		(void)munmap(header, s_traceSize);
+		(void)shm_unlink(MEDIAPLAYBACK_TRACE_NAME);
+		s_entries = NULL;
+	}
+}
+
+void MediaPlaybackTraceWrite(uint32_t point, int64_t a0, int64_t a1, int64_t a2, int64_t a3)
+{
+	MediaPlaybackTraceHeader *header = __atomic_load_n(&g_mediaPlaybackTrace, __ATOMIC_ACQUIRE);
+	MediaPlaybackTraceEntry *entry;
+	uint64_t record;
+
+	if (header != NULL)
+	{
+		record = __atomic_fetch_add(&header->head, 1U, __ATOMIC_RELAXED);
+		entry = &s_entries[record & ((uint64_t)s_entryCount - 1U)];
+
+		/* a reader skips the entry until it holds this record */
+		__atomic_store_n(&entry->sequence, 0U, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		entry->timestamp = (uint64_t)TCTimeGetMonotonicNs();
+		entry->point = point;
+		entry->thread = (int32_t)syscall(SYS_gettid);
+		entry->args[0] = a0;
+		entry->args[1] = a1;
+		entry->args[2] = a2;
+		entry->args[3] = a3;
+
+		__atomic_store_n(&entry->sequence, record + 1U, __ATOMIC_RELEASE);
+	}
+}
+
+static void OnSpanEnded(const TCTimeSpanRecord *record)
+{
+	MEDIAPLAYBACK_TRACE(Span, record->name, record->playID, record->duration, 0);
+}
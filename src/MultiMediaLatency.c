@@ -0,0 +1,205 @@
+/****************************************************************************************
+ *   FileName    : MultiMediaLatency.c
+ *   Description : Telechips Multimedia Latency Probes
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "TCLog.h"
+#include "TCTime.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MultiMediaLatency.h"
+
+typedef enum {
+	LatencySinkIdle,
+	LatencySinkArmed,				/* waiting for the first buffer */
+	LatencySinkPrerolled			/* first buffer waits for PLAYING */
+} LatencySinkState;
+
+static void CompleteSink(uint32_t sink, int64_t now);
+static uint32_t GetBucket(uint32_t latency);
+
+#define MULTIMEDIA_LATENCY_REQUEST_NAME(name, text)	text,
+const char *g_multiMediaLatencyRequestNames[TotalMultiMediaLatencyRequests] = {
+	MULTIMEDIA_LATENCY_REQUEST_LIST(MULTIMEDIA_LATENCY_REQUEST_NAME)
+};
+
+static const char *s_sinkNames[TotalMultiMediaLatencySinks] = {
+	"audio",
+	"video"
+};
+
+static pthread_mutex_t s_latencyMutex = PTHREAD_MUTEX_INITIALIZER;
+/* read without the mutex by the buffer probes, so they cost a load while nothing is armed */
+static int32_t s_armed[TotalMultiMediaLatencySinks] = {0};
+static LatencySinkState s_sinkStates[TotalMultiMediaLatencySinks] = {LatencySinkIdle};
+static MultiMediaLatencyRequest s_request = MultiMediaLatencyPlay;
+static int32_t s_playID = 0;
+static int64_t s_received = 0;
+static MultiMediaLatencyEvent s_events[MULTIMEDIA_LATENCY_EVENTS];
+static uint32_t s_eventCount = 0;
+static MultiMediaLatencyHistogram s_histograms[TotalMultiMediaLatencyRequests][TotalMultiMediaLatencySinks];
+
+void MultiMediaLatencyArm(MultiMediaLatencyRequest request, int32_t playID, int64_t received)
+{
+	uint32_t sink;
+
+	/* a new request replaces one whose buffers never came */
+	(void)pthread_mutex_lock(&s_latencyMutex);
+	s_request = request;
+	s_playID = playID;
+	s_received = received;
+	for (sink = 0; sink < (uint32_t)TotalMultiMediaLatencySinks; sink++)
+	{
+		s_sinkStates[sink] = LatencySinkArmed;
+		__atomic_store_n(&s_armed[sink], 1, __ATOMIC_RELEASE);
+	}
+	(void)pthread_mutex_unlock(&s_latencyMutex);
+}
+
+void MultiMediaLatencyCancel(void)
+{
+	uint32_t sink;
+
+	(void)pthread_mutex_lock(&s_latencyMutex);
+	for (sink = 0; sink < (uint32_t)TotalMultiMediaLatencySinks; sink++)
+	{
+		s_sinkStates[sink] = LatencySinkIdle;
+		__atomic_store_n(&s_armed[sink], 0, __ATOMIC_RELEASE);
+	}
+	(void)pthread_mutex_unlock(&s_latencyMutex);
+}
+
+void MultiMediaLatencyBuffer(MultiMediaLatencySink sink, int32_t playID, bool playing)
+{
+	if (__atomic_load_n(&s_armed[sink], __ATOMIC_ACQUIRE) != 0)
+	{
+		(void)pthread_mutex_lock(&s_latencyMutex);
+		if ((s_sinkStates[sink] == LatencySinkArmed) && (playID == s_playID))
+		{
+			if (playing)
+			{
+				CompleteSink((uint32_t)sink, TCTimeGetMonotonicNs());
+			}
+			else
+			{
+				s_sinkStates[sink] = LatencySinkPrerolled;
+			}
+		}
+		(void)pthread_mutex_unlock(&s_latencyMutex);
+	}
+}
+
+void MultiMediaLatencyPlaying(void)
+{
+	int64_t now = TCTimeGetMonotonicNs();
+	uint32_t sink;
+
+	(void)pthread_mutex_lock(&s_latencyMutex);
+	for (sink = 0; sink < (uint32_t)TotalMultiMediaLatencySinks; sink++)
+	{
+		if (s_sinkStates[sink] == LatencySinkPrerolled)
+		{
+			CompleteSink(sink, now);
+		}
+	}
+	(void)pthread_mutex_unlock(&s_latencyMutex);
+}
+
+uint32_t MultiMediaLatencyGetEvents(MultiMediaLatencyEvent *events, uint32_t count)
+{
+	uint32_t copied = 0;
+	uint32_t first;
+	uint32_t idx;
+
+	/* oldest first */
+	(void)pthread_mutex_lock(&s_latencyMutex);
+	first = (s_eventCount > (uint32_t)MULTIMEDIA_LATENCY_EVENTS) ? (s_eventCount - (uint32_t)MULTIMEDIA_LATENCY_EVENTS) : 0U;
+	for (idx = first; (idx < s_eventCount) && (copied < count); idx++)
+	{
+		events[copied] = s_events[idx % (uint32_t)MULTIMEDIA_LATENCY_EVENTS];
+		copied++;
+	}
+	(void)pthread_mutex_unlock(&s_latencyMutex);
+
+	return copied;
+}
+
+void MultiMediaLatencyGetHistogram(MultiMediaLatencyRequest request, MultiMediaLatencySink sink,
+								   MultiMediaLatencyHistogram *histogram)
+{
+	(void)pthread_mutex_lock(&s_latencyMutex);
+	*histogram = s_histograms[request][sink];
+	(void)pthread_mutex_unlock(&s_latencyMutex);
+}
+
+static void CompleteSink(uint32_t sink, int64_t now)
+{
+	MultiMediaLatencyEvent *event = &s_events[s_eventCount % (uint32_t)MULTIMEDIA_LATENCY_EVENTS];
+	MultiMediaLatencyHistogram *histogram = &s_histograms[s_request][sink];
+	int64_t elapsed = (now - s_received) / 1000;
+	uint32_t latency = ((elapsed > 0) && (elapsed < (int64_t)UINT32_MAX)) ? (uint32_t)elapsed : 0U;
+
+	s_sinkStates[sink] = LatencySinkIdle;
+	__atomic_store_n(&s_armed[sink], 0, __ATOMIC_RELEASE);
+
+	event->request = (uint32_t)s_request;
+	event->sink = sink;
+	event->playID = s_playID;
+	event->latency = latency;
+	event->received = s_received;
+	s_eventCount++;
+
+	if ((histogram->count == 0U) || (latency < histogram->min))
+	{
+		histogram->min = latency;
+	}
+	if (latency > histogram->max)
+	{
+		histogram->max = latency;
+	}
+	histogram->count++;
+	histogram->sum += latency;
+	histogram->buckets[GetBucket(latency)]++;
+
+	INFO_PRINTF("%s to first %s buffer: %u us, playID(%d)\n",
+				g_multiMediaLatencyRequestNames[s_request], s_sinkNames[sink], latency, s_playID);
+}
+
+static uint32_t GetBucket(uint32_t latency)
+{
+	uint32_t bucket = 0;
+	uint32_t ms = latency / 1000U;
+
+	while ((ms != 0U) && (bucket < ((uint32_t)MULTIMEDIA_LATENCY_BUCKETS - 1U)))
+	{
+		ms >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
@@ -28,11 +28,13 @@ between Telechips and Company.
 #include <stdint.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <time.h>
 #include <pthread.h>
 #include <unistd.h> /* for open/close */
 #include <fcntl.h> /* for O_RDWR */
 #include <sys/mman.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
 #include <gst/gst.h>
@@ -42,6 +44,18 @@ between Telechips and Company.
 #include "TCMultiMediaType.h"
 #include "MultiMediaManager.h"
 #include "MediaPlaybackDBus.h"
+#include "MediaLibrary.h"
+#include "AlbumArtThumbnail.h"
+#include "AlbumArtSharedMemory.h"
+#include "AlbumArtCache.h"
+#include "MultiMediaState.h"
+#include "MediaPlaybackTrace.h"
+#include "MultiMediaLatency.h"
+#include "MultiMediaPipelineStats.h"
+#include "MultiMediaTaskPool.h"
+#include "AudioEqualizer.h"
+#include "AudioLoudness.h"
+#include "AudioCrossfade.h"
 
 #define AUDIO_SINK_LATENCY_TIME		92880
 #define AUDIO_SINK_BUFFER_TIME		371520
@@ -86,17 +100,36 @@ static char s_audioSinkName[MAX_SINK_DEVICE_NAME];
 static char s_audioDeviceName[MAX_SINK_DEVICE_NAME];
 static char *s_audioDeviceNamePtr = NULL;
 static char s_v4lDevice[MAX_SINK_DEVICE_NAME];
-static int32_t s_shm_id;
-static void * s_shm_addr;
+static char s_videoSinkName[MAX_SINK_DEVICE_NAME];
+static bool s_videoSinkOverlay = true;		/* VIDEO_SINK_NAME, which has the overlay properties */
 static uint8_t s_dualDisplay;
+static bool s_albumArtSharedMemory = true;
+static bool s_albumArtOnRequest = false;		/* copied into the segment by get_albumart_key instead of the tag */
+
+/* read by every *_PRINTF before it formats anything */
+int32_t g_mediaPlaybackLogLevel = TCLogLevelWarn;
 
 typedef struct stAlbumArt {
 	uint32_t length;
 	uint8_t *buf;
 	bool complete;
+	GstSample *sample;		/* embedded image, copied out only on request */
+	int32_t playID;
+	int32_t fd;				/* sealed memfd of sample, -1 until requested */
+	uint64_t hash;			/* AlbumArtCache key, 0 if not cached */
+	bool announce;			/* set, not yet signalled */
+	uint32_t slot;			/* legacy segment slot, ALBUMART_SHM_NO_SLOT until requested */
+	uint32_t generation;
 } AlbumArt;
 
-#define MAX_ID3_TAG_SIZE	512
+typedef struct stAlbumArtAnnouncement {
+	GstSample *sample;
+	int32_t playID;
+	uint32_t length;
+	uint64_t hash;
+} AlbumArtAnnouncement;
+
+#define MAX_ID3_TAG_SIZE	MULTIMEDIA_MAX_TAG_SIZE
 
 typedef struct stID3Information {
 	char title[MAX_ID3_TAG_SIZE];
@@ -104,6 +137,15 @@ typedef struct stID3Information {
 	char album[MAX_ID3_TAG_SIZE];
 	char genre[MAX_ID3_TAG_SIZE];
 	AlbumArt albumArt;
+	char composer[MAX_ID3_TAG_SIZE];
+	char codec[MULTIMEDIA_MAX_CODEC_SIZE];
+	uint32_t trackNumber;
+	uint32_t trackCount;
+	uint32_t discNumber;
+	uint32_t discCount;
+	uint32_t year;
+	uint32_t bitrate;
+	uint32_t channels;
 } ID3Information;
 
 typedef struct stVideoInfo {
@@ -144,10 +186,17 @@ typedef struct stMultiMediaPlayer {
 	bool fastforward;
 	bool updatePlayTime;
 	bool async_done;
+	bool folderArtRequested;	/* on the first preroll, not again after a seek */
 	bool getduration;
+	bool nextPosted;		/* the next track was requested when this one ends, atomic */
 	gboolean seek_enabled;
 } MultiMediaPlayer;
 
+typedef struct stFirstBufferProbeData {
+	MultiMediaLatencySink sink;
+	int32_t playID;			/* of the player that created the sink */
+} FirstBufferProbeData;
+
 typedef struct stPlayInfo {
 	int32_t id;
 	uint8_t content;
@@ -156,21 +205,47 @@ typedef struct stPlayInfo {
 	uint8_t min;
 	uint8_t sec;
 	uint8_t	keepPause;
+	int64_t received;					/* monotonic ns the last play, seek or resume was requested */
 } PlayInfo;
 
 static void MultiMediaSetResourceStatus(int32_t status);
 static void GetSamplerate(MultiMediaPlayer *player, int32_t playID);
 static gboolean GstBusHandler(GstBus *bus, GstMessage *msg, gpointer data);
+static GstBusSyncReply GstSyncBusHandler(GstBus *bus, GstMessage *msg, gpointer data);
 static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg);
 static void InitializeID3Information(void);
+static void ReleaseAlbumArt(AlbumArt *albumArt);
+static void SetAlbumArt(ID3Information *info, int32_t playID, GstSample *sample, uint64_t hash);
+static bool TakeAlbumArtAnnouncement(AlbumArt *albumArt, AlbumArtAnnouncement *announcement);
+static void AnnounceAlbumArt(AlbumArtAnnouncement *announcement);
+static bool PublishAlbumArt(AlbumArt *albumArt);
+static void RequestFolderAlbumArt(MultiMediaPlayer *player);
+static void OnFolderAlbumArt(int32_t playID, GstBuffer *image, uint64_t hash);
 static void SetID3Information(const GstTagList * list, const gchar * tag, gpointer user_data);
+static void SetID3InformationFromLibrary(AVPlayer *avPlayer, const char *path);
+static void SetExtendedInformation(const GstTagList *list, ID3Information *info);
+static bool IsExportedTag(const gchar *tag, bool bitrateKnown);
+static bool HasExportedTag(const GstTagList *list, bool bitrateKnown);
+static char *GetID3String(ID3Information *info, const gchar *tag);
+static uint32_t UpdateMetadata(const ID3Information *info, int32_t playID);
+static bool IsMetadataEqual(const MultiMediaMetadata *a, const MultiMediaMetadata *b);
+static void GetMetadataStrings(const MultiMediaMetadata *metadata, const char *strings[TotalMetaCategories]);
+static uint32_t SelectTagEmissions(uint32_t dirty, MultiMediaMetadata *metadata, int32_t *playID);
+static gboolean OnTagRateTimer(gpointer data);
+static void EmitTagUpdates(uint32_t ready, const MultiMediaMetadata *metadata, int32_t playID);
+static void CountStatistic(uint32_t *counter, uint32_t count);
 static bool MultiMediaPlayStart(const char *path, uint8_t hour, uint8_t min, uint8_t sec, bool video, int32_t id, uint8_t keepPause);
-static MultiMediaPlayer *CreateAVPlayer(bool video);
+static MultiMediaPlayer *CreateAVPlayer(bool video, int32_t playID);
+static GstElement *CreateAudioSink(void);
 static void ReleasePlayer(MultiMediaPlayer *player);
+static void AddFirstBufferProbe(GstElement *sink, MultiMediaLatencySink type, int32_t playID);
+static GstPadProbeReturn FirstBufferProbe(GstPad *pad, GstPadProbeInfo *info, gpointer data);
 static void ReleaseAVPlayer(AVPlayer *player);
 static void SetSourceLocation(GstElement *obj,  GstElement* arg, gpointer userdata);
 static bool StartPlayer(MultiMediaPlayer *player, uint8_t keepPause);
 static void StopPlayer(MultiMediaPlayer **player);
+static bool HandOffPlayer(MultiMediaPlayer **player);
+static bool StartNextTrack(MultiMediaPlayer *player);
 static void StartPlayTimeThread(void);
 static void StopPlayTimeThread(void);
 static void StartMediaStartThread(void);
@@ -185,11 +260,11 @@ static void UpdateVideoDisplay(bool update);
 static void UpdateDualVideoDisplay(void);
 static void ProcessGstErrorMessage(GstMessage *errorMsg, int32_t playID);
 static void *PlayTimeThread(void *arg);
+static bool WaitPlayTime(void);
 static void *MediaStartThread(void *arg);
 static void ReleasePlayInfo(void);
+static void ReleaseNextInfo(void);
 static char *CloneString(const char *string);
-static int32_t SharedMemoryInitialize(void);
-static int32_t SharedMemoryRelease(void);
 
 typedef enum {
 	MultiMediaCommandPlay,
@@ -215,11 +290,23 @@ static void ProcessPlayFastBackward(void);
 static void ProcessPlayTurboFastForward(void);
 static void ProcessPlayTurboFastBackward(void);
 static void ProcessPlaySeek(uint8_t hour, uint8_t min, uint8_t sec);
+static void ProcessNextRequest(int32_t playID);
+static void ProcessPlayNext(const char *path, bool video, int32_t playID);
 
 static MultiMediaPlayer *s_currentPlayer = NULL;
+/* ended by the bus handler once the pipeline prerolled */
+static TCTimeSpan s_prerollSpan;
+static TCTimeSpan s_seekSpan;
 static bool s_playtimeRun = false;
 static pthread_t s_playtimeThread;
 
+/* s_playtimeRun and the position interval are guarded by s_positionMutex */
+static pthread_mutex_t s_positionMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_positionCond;
+static uint32_t s_positionInterval = MULTIMEDIA_POSITION_INTERVAL_DEFAULT;
+static uint32_t s_positionGeneration = 0;
+static gint64 s_lastPosition = -1;
+
 static bool s_mediastartRun = false;
 static pthread_t s_mediastartThread;
 
@@ -236,12 +323,31 @@ static PlayInfo s_playInfo = {
 	0
 };
 
+/* played when the current track ends, set by MultiMediaSetNextTrack() */
+static PlayInfo s_nextInfo = {
+	0,
+	0,
+	NULL,
+	0,
+	0,
+	0
+};
+static pthread_mutex_t s_nextMutex = PTHREAD_MUTEX_INITIALIZER;
+/*
+ * Set by the main loop when the track of s_nextRequestID ends, taken by the
+ * command thread once the command slot is empty. Not posted through the
+ * slot: the main loop must not wait for s_cmdMutex, and a user command keeps
+ * its place and its playID.
+ */
+static bool s_nextRequested = false;
+static int32_t s_nextRequestID = 0;
+
 static ID3Information s_id3Information = {
 	"",					/* title */
 	"",					/* artist */
 	"",					/* album */
 	"",					/* genre */
-	{0, NULL, false}	/* album art(width, height, format, length, buffer) */
+	{0, NULL, false, NULL, -1, -1, 0, false, ALBUMART_SHM_NO_SLOT, 0}	/* album art(length, buffer, complete, sample, playID, fd, hash, announce, slot, generation) */
 };
 
 static VideoInfo s_videoInfo = {0, 0, 800, 480, 0, 0, 0, 0, 0, 0};
@@ -251,15 +357,61 @@ static MultiMediaPlayPaused_cb				MultiMediaPlayPausedCB = NULL;
 static MultiMediaPlayStopped_cb				MultiMediaPlayStoppedCB = NULL;
 static MultiMediaPlayTimeChange_cb			MultiMediaPlayTimeChangeCB = NULL;
 static MultiMediaTotalTimeChange_cb			MultiMediaTotalTimeChangeCB = NULL;
+static MultiMediaPositionChange_cb			MultiMediaPositionChangeCB = NULL;
 static MultiMediaID3Information_cb			MultiMediaID3InformationCB = NULL;
 static MultiMediaAlbumArt_cb				MultiMediaAlbumArtCB = NULL;
 static MultiMediaPlayCompleted_cb			MultiMediaPlayCompletedCB = NULL;
 static MultiMediaSeekCompleted_cb			MultiMediaSeekCompletedCB = NULL;
 static MultiMediaErrorOccurred_cb			MultiMediaErrorOccurredCB = NULL;
 static MultiMediaSamplerate_cb				MultiMediaSamplerateCB = NULL;
+static MultiMediaMetadata_cb				MultiMediaMetadataCB = NULL;
+
+/* latest metadata snapshot, guarded by s_mutex */
+static MultiMediaMetadata s_metadata;
+static int32_t s_metadataPlayID = -1;
+static bool s_metadataValid = false;
+/* the track whose folder cover is looked up, guarded by s_mutex */
+static int32_t s_folderArtPlayID = -1;
+
+/*
+ * Every MetaCategory and the aggregated metadata (TAG_EMIT_METADATA) is sent
+ * at most once per TAG_EMIT_INTERVAL_MS. A change inside the interval is kept
+ * pending and sent by a single timer with the snapshot of that time.
+ */
+#define TAG_EMIT_INTERVAL_MS		(1000)
+#define TAG_EMIT_METADATA			((uint32_t)TotalMetaCategories)
+#define TAG_EMIT_METADATA_BIT		(1U << TAG_EMIT_METADATA)
+
+static uint32_t s_tagPending = 0;
+static int64_t s_tagLastEmit[TotalMetaCategories + 1];
+static guint s_tagTimer = 0;
+static MultiMediaTagStatistics s_tagStatistics = {0, 0, 0, 0, 0};
+
+/* tags stored in ID3Information, the rest of a tag list is not parsed */
+static const char * const s_exportedTags[] = {
+	GST_TAG_TITLE,
+	GST_TAG_ARTIST,
+	GST_TAG_ALBUM,
+	GST_TAG_GENRE,
+	GST_TAG_IMAGE,
+	GST_TAG_COMPOSER,
+	GST_TAG_AUDIO_CODEC,
+	GST_TAG_TRACK_NUMBER,
+	GST_TAG_TRACK_COUNT,
+	GST_TAG_ALBUM_VOLUME_NUMBER,
+	GST_TAG_ALBUM_VOLUME_COUNT,
+	GST_TAG_DATE_TIME,
+	GST_TAG_DATE,
+	GST_TAG_NOMINAL_BITRATE,
+	GST_TAG_BITRATE
+};
 
 
+static void LockCommandSlot(void);
+static void PostCommand(MultiMediaCommand command);
+
 static MultiMediaCommand s_currentCmd = TotalMultiMediaCommands;
+static MultiMediaCommandStatistics s_commandStatistics = {0, 0, 0, 0, 0};
 static pthread_mutex_t s_cmdMutex;
 static pthread_mutex_t s_timeMutex;
 static pthread_mutex_t s_stopMutex;
@@ -268,6 +420,7 @@ static pthread_mutex_t s_errorMutex;
 
 void MultiMediaSetDebugLevel(int32_t level)
 {
+	__atomic_store_n(&g_mediaPlaybackLogLevel, level, __ATOMIC_RELAXED);
 	TCLogSetLevel(level);
 }
 
@@ -280,6 +433,7 @@ int32_t MultiMediaInitialize(void)
 	(void)memcpy(s_audioDeviceName, ALSA_DEFAULT_DEVICE_NAME, strnlen(ALSA_DEFAULT_DEVICE_NAME,MAX_SINK_DEVICE_NAME));
 	s_audioDeviceNamePtr = s_audioDeviceName;
 	(void)memcpy(s_v4lDevice, V4L_DEFAULT_DEVICE_NAME, strnlen(V4L_DEFAULT_DEVICE_NAME,MAX_SINK_DEVICE_NAME));
+	(void)memcpy(s_videoSinkName, VIDEO_SINK_NAME, strnlen(VIDEO_SINK_NAME,MAX_SINK_DEVICE_NAME));
 
 	err = pthread_mutex_init(&s_mutex, NULL);
 	if (err == 0)
@@ -311,6 +465,24 @@ int32_t MultiMediaInitialize(void)
 		ERROR_PRINTF("time mutex pthread_mutex_init failed: error(%d)\n", err);
 	}
 
+	{
+		pthread_condattr_t attr;
+
+		/* the position deadline must not move with the wall clock */
+		(void)pthread_condattr_init(&attr);
+		(void)pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		err = pthread_cond_init(&s_positionCond, &attr);
+		(void)pthread_condattr_destroy(&attr);
+	}
+	if (err == 0)
+	{
+		ret = 1;
+	}
+	else
+	{
+		ERROR_PRINTF("position pthread_cond_init failed: error(%d)\n", err);
+	}
+
 	err = pthread_mutex_init(&s_stopMutex, NULL);
 	if (err == 0)
 	{
@@ -331,12 +503,16 @@ int32_t MultiMediaInitialize(void)
 		ERROR_PRINTF("error mutex pthread_mutex_init failed: error(%d)\n", err);
 	}
 
-	(void)SharedMemoryInitialize();
+	(void)AlbumArtSharedMemoryInitialize();
+	{
+		TcAlbumArtCacheEventCB cb;
+
+		cb.AlbumArtCacheFolderImageCB = OnFolderAlbumArt;
+		AlbumArtCacheSetEventCallBackFunctions(&cb);
+	}
 	
 	StartMediaStartThread();
 	
-	SetCurrentTime();
-	
 	return ret;
 }
 
@@ -355,6 +531,7 @@ static void MultiMediaSetResourceStatus(int32_t status)
 	/* pthread_mutex_lock(&s_cmdMutex); */
 	s_ResourceBusy = status;
 	/* pthread_mutex_unlock(&s_cmdMutex); */
+	MultiMediaStateSetResourceStatus(status);
 }
 
 
@@ -367,12 +544,14 @@ void SetEventCallBackFunctions(TcMultiMediaEventCB *cb)
 		MultiMediaPlayStoppedCB = cb->MultiMediaPlayStoppedCB;
 		MultiMediaPlayTimeChangeCB = cb->MultiMediaPlayTimeChangeCB;
 		MultiMediaTotalTimeChangeCB = cb->MultiMediaTotalTimeChangeCB;
+		MultiMediaPositionChangeCB = cb->MultiMediaPositionChangeCB;
 		MultiMediaID3InformationCB = cb->MultiMediaID3InformationCB;
 		MultiMediaAlbumArtCB = cb->MultiMediaAlbumArtCB;
 		MultiMediaPlayCompletedCB = cb->MultiMediaPlayCompletedCB;
 		MultiMediaSeekCompletedCB = cb->MultiMediaSeekCompletedCB;
 		MultiMediaErrorOccurredCB = cb->MultiMediaErrorOccurredCB;
 		MultiMediaSamplerateCB = cb->MultiMediaSamplerateCB;
+		MultiMediaMetadataCB = cb->MultiMediaMetadataCB;
 	}
 }
 
@@ -387,8 +566,10 @@ void MultiMediaRelease(void)
 	}
 
 	ReleasePlayInfo();
+	ReleaseNextInfo();
 
 	StopMediaStartThread();	
+	AudioCrossfadeRelease();
 
 	err = pthread_mutex_destroy(&s_mutex);
 	if (err != 0)
@@ -408,6 +589,12 @@ void MultiMediaRelease(void)
 		ERROR_PRINTF("s_timeMutex destroy faild: error(%d)\n", err);
 	}
 
+	err = pthread_cond_destroy(&s_positionCond);
+	if (err != 0)
+	{
+		ERROR_PRINTF("s_positionCond destroy faild: error(%d)\n", err);
+	}
+
 	err = pthread_mutex_destroy(&s_stopMutex);
 	if (err != 0)
 	{
@@ -420,7 +607,8 @@ void MultiMediaRelease(void)
 		ERROR_PRINTF("s_errorMutex destroy faild: error(%d)\n", err);
 	}
 
-	(void)SharedMemoryRelease();
+	(void)AlbumArtSharedMemoryRelease();
+	MultiMediaStateRelease();
 }
 
 void MultiMediaSetMargin(uint32_t width, uint32_t height)
@@ -475,7 +663,7 @@ int32_t MultiMediaPlayStartAV(uint8_t content, const char *path, uint8_t hour, u
 	INFO_PRINTF("CONTENT(%u), PATH(%s), HOUR(%u), MINUTE(%u), SECOND(%u), ID(%d), keepPause(%d)\n",
 									 content, path, hour, min, sec, id, keepPause);
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 	if(s_ResourceBusy ==0)
 	{
 		s_playInfo.content = content;
@@ -489,16 +677,19 @@ int32_t MultiMediaPlayStartAV(uint8_t content, const char *path, uint8_t hour, u
 		s_playInfo.sec = sec;
 		s_playInfo.id = id;
 		s_playInfo.keepPause = keepPause;
+		s_playInfo.received = TCTimeGetMonotonicNs();
 		
-		s_currentCmd = MultiMediaCommandPlay;
+		PostCommand(MultiMediaCommandPlay);
 
 		s_ResourceBusy = 1;
+		MultiMediaStateSetResourceStatus(1);
 		ret =0;
 	}
 	else
 	{
 		INFO_PRINTF("Can't play -  Resouce is busy \n");
 		ret =-1;
+		CountStatistic(&s_commandStatistics.refused, 1U);
 	}
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
@@ -512,7 +703,7 @@ int32_t MultiMediaPlayStop(int32_t id)
 
 	INFO_PRINTF("\n");
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 
 	if(s_ResourceBusy == 1)
 	{
@@ -520,17 +711,19 @@ int32_t MultiMediaPlayStop(int32_t id)
 		INFO_PRINTF("Set stop cmd. request id(%d), play id(%d)\n", id, s_playInfo.id);
 		if(s_playInfo.id == id)
 		{
-			s_currentCmd = MultiMediaCommandStop;
+			PostCommand(MultiMediaCommandStop);
 		}
 		else
 		{
 			ret = -2;
+			CountStatistic(&s_commandStatistics.refused, 1U);
 		}
 	}
 	else
 	{
 		INFO_PRINTF("Resource is not playing.\n");
 		ret = -1;
+		CountStatistic(&s_commandStatistics.refused, 1U);
 	}
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
@@ -544,24 +737,26 @@ int32_t MultiMediaPlayPause(int32_t id)
 
 	INFO_PRINTF("\n");
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 
 	if(s_ResourceBusy == 1)
 	{
 		INFO_PRINTF("Set pause cmd. request id(%d), play id(%d)\n", id, s_playInfo.id);
 		if(s_playInfo.id == id)
 		{
-			s_currentCmd = MultiMediaCommandPause;
+			PostCommand(MultiMediaCommandPause);
 		}
 		else
 		{
 			ret = -2;
+			CountStatistic(&s_commandStatistics.refused, 1U);
 		}
 	}
 	else
 	{
 		INFO_PRINTF("Resource is not playing.\n");
 		ret = -1;
+		CountStatistic(&s_commandStatistics.refused, 1U);
 	}
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
@@ -574,24 +769,27 @@ int32_t MultiMediaPlayResume(int32_t id)
 
 	DEBUG_PRINTF("\n");
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 
 	if(s_ResourceBusy == 1)
 	{
 		INFO_PRINTF("Set resume cmd. request id(%d), play id(%d)\n", id, s_playInfo.id);
 		if(s_playInfo.id == id)
 		{
-			s_currentCmd = MultiMediaCommandResume;
+			s_playInfo.received = TCTimeGetMonotonicNs();
+			PostCommand(MultiMediaCommandResume);
 		}
 		else
 		{
 			ret = -2;
+			CountStatistic(&s_commandStatistics.refused, 1U);
 		}
 	}
 	else
 	{
 		INFO_PRINTF("Resource is not playing.\n");
 		ret = -1;
+		CountStatistic(&s_commandStatistics.refused, 1U);
 	}
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
@@ -604,9 +802,9 @@ void MultiMediaPlayNormal(void)
 {
 	INFO_PRINTF("\n");
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 
-	s_currentCmd = MultiMediaCommandNormal;
+	PostCommand(MultiMediaCommandNormal);
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
 }
@@ -615,9 +813,9 @@ void MultiMediaPlayFastForward(void)
 {
 	INFO_PRINTF("\n");
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 
-	s_currentCmd = MultiMediaCommandFastForward;
+	PostCommand(MultiMediaCommandFastForward);
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
 }
@@ -626,9 +824,9 @@ void MultiMediaPlayFastBackward(void)
 {
 	INFO_PRINTF("\n");
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 
-	s_currentCmd = MultiMediaCommandFastBackward;
+	PostCommand(MultiMediaCommandFastBackward);
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
 }
@@ -637,9 +835,9 @@ void MultiMediaPlayTurboFastForward(void)
 {
 	INFO_PRINTF("\n");
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 
-	s_currentCmd = MultiMediaCommandTurboFastForward;
+	PostCommand(MultiMediaCommandTurboFastForward);
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
 }
@@ -648,9 +846,9 @@ void MultiMediaPlayTurboFastBackward(void)
 {
 	INFO_PRINTF("\n");
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 
-	s_currentCmd = MultiMediaCommandTurboFastBackward;
+	PostCommand(MultiMediaCommandTurboFastBackward);
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
 }
@@ -661,7 +859,7 @@ int32_t MultiMediaPlaySeek(uint8_t hour, uint8_t min, uint8_t sec, int32_t id)
 
 	INFO_PRINTF("\n");
 
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	LockCommandSlot();
 
 	if(s_ResourceBusy == 1)
 	{
@@ -671,17 +869,20 @@ int32_t MultiMediaPlaySeek(uint8_t hour, uint8_t min, uint8_t sec, int32_t id)
 			s_playInfo.hour = hour;
 			s_playInfo.min = min;
 			s_playInfo.sec = sec;
+			s_playInfo.received = TCTimeGetMonotonicNs();
 
-			s_currentCmd = MultiMediaCommandSeek;
+			PostCommand(MultiMediaCommandSeek);
 		}
 		else
 		{
 			ret = -2;
+			CountStatistic(&s_commandStatistics.refused, 1U);
 		}
 	}
 	else
 	{
 		ret = -1;
+		CountStatistic(&s_commandStatistics.refused, 1U);
 	}
 
 	(void)pthread_mutex_unlock(&s_cmdMutex);
@@ -689,32 +890,215 @@ int32_t MultiMediaPlaySeek(uint8_t hour, uint8_t min, uint8_t sec, int32_t id)
 	return ret;
 }
 
+int32_t MultiMediaSetNextTrack(uint8_t content, const char *path, int32_t id)
+{
+	int32_t ret = 0;
+	char *clone = NULL;
+
+	INFO_PRINTF("CONTENT(%u), PATH(%s), ID(%d)\n", content, (path != NULL) ? path : "", id);
+
+	if ((path != NULL) && (path[0] != '\0'))
+	{
+		clone = CloneString(path);
+		if (clone == NULL)
+		{
+			ret = -1;
+		}
+	}
+
+	if (ret == 0)
+	{
+		(void)pthread_mutex_lock(&s_nextMutex);
+		if (s_nextInfo.path != NULL)
+		{
+			free(s_nextInfo.path);
+		}
+		s_nextInfo.path = clone;
+		s_nextInfo.content = content;
+		s_nextInfo.id = id;
+		(void)pthread_mutex_unlock(&s_nextMutex);
+	}
+
+	return ret;
+}
+
 int32_t MultiMediaGetAlbumArt(uint8_t **buffer, uint32_t *length)
 {
 	int32_t ret=-1;
-	(void)pthread_mutex_lock(&s_cmdMutex);
+	AlbumArt *albumArt = &s_id3Information.albumArt;
 
 	INFO_PRINTF("\n");
 
-	if(s_currentPlayer != NULL)
+	(void)pthread_mutex_lock(&s_mutex);
+	if (albumArt->sample != NULL)
 	{
-		if(s_currentPlayer->avPlayer.id3Info != NULL)
+		GstBuffer *img = gst_sample_get_buffer(albumArt->sample);
+		GstMapInfo mapInfo;
+
+		/* copied out of the sample on the first request, valid until the track changes */
+		if ((albumArt->buf == NULL) && (img != NULL) && gst_buffer_map(img, &mapInfo, GST_MAP_READ))
 		{
-			if((s_currentPlayer->avPlayer.id3Info->albumArt.buf != NULL)
-				&& (s_currentPlayer->avPlayer.id3Info->albumArt.length != (uint32_t)0))
+			albumArt->buf = (uint8_t *)malloc(mapInfo.size);
+			if (albumArt->buf != NULL)
 			{
-				*buffer = s_currentPlayer->avPlayer.id3Info->albumArt.buf;
-				*length = s_currentPlayer->avPlayer.id3Info->albumArt.length;
-				ret =0;
+				(void)memcpy(albumArt->buf, mapInfo.data, mapInfo.size);
+				albumArt->length = (uint32_t)mapInfo.size;
 			}
+			gst_buffer_unmap(img, &mapInfo);
+		}
+		(void)PublishAlbumArt(albumArt);
+
+		if ((albumArt->buf != NULL) && (albumArt->length != (uint32_t)0))
+		{
+			*buffer = albumArt->buf;
+			*length = albumArt->length;
+			ret =0;
 		}
 	}
+	(void)pthread_mutex_unlock(&s_mutex);
 
-	(void)pthread_mutex_unlock(&s_cmdMutex);
+	return ret;
+}
+
+int32_t MultiMediaPublishAlbumArt(int32_t *playID, uint32_t *slot, uint32_t *generation)
+{
+	int32_t ret = -1;
+	AlbumArt *albumArt = &s_id3Information.albumArt;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	if (PublishAlbumArt(albumArt))
+	{
+		*playID = albumArt->playID;
+		*slot = albumArt->slot;
+		*generation = albumArt->generation;
+		ret = 0;
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return ret;
+}
+
+int32_t MultiMediaGetAlbumArtFd(int32_t *playID, uint32_t *length)
+{
+	int32_t fd = -1;
+	AlbumArt *albumArt = &s_id3Information.albumArt;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	if (albumArt->sample != NULL)
+	{
+		GstBuffer *img = gst_sample_get_buffer(albumArt->sample);
+		GstMapInfo mapInfo;
+		struct stat status;
+
+		/* extracted once on the first request, later requests share the sealed memfd */
+		if (albumArt->fd < 0)
+		{
+			/* the cache keeps one memfd for every track with this cover */
+			albumArt->fd = AlbumArtCacheGetFd(albumArt->hash);
+		}
+		if ((albumArt->fd < 0) && (img != NULL) && gst_buffer_map(img, &mapInfo, GST_MAP_READ))
+		{
+			albumArt->fd = AlbumArtSharedMemoryCreateFd(mapInfo.data, (uint32_t)mapInfo.size);
+			gst_buffer_unmap(img, &mapInfo);
+		}
+
+		/* the memfd is sealed to the image size, it may come from the cache without a buffer */
+		if ((albumArt->fd >= 0) && (fstat(albumArt->fd, &status) == 0))
+		{
+			fd = dup(albumArt->fd);
+			*playID = albumArt->playID;
+			*length = (uint32_t)status.st_size;
+		}
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return fd;
+}
+
+int32_t MultiMediaGetMetadata(MultiMediaMetadata *metadata, int32_t *playID)
+{
+	int32_t ret = -1;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	if (s_metadataValid)
+	{
+		(void)memcpy(metadata, &s_metadata, sizeof(MultiMediaMetadata));
+		*playID = s_metadataPlayID;
+		ret = 0;
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
 
 	return ret;
 }
 
+void MultiMediaGetTagStatistics(MultiMediaTagStatistics *statistics)
+{
+	statistics->received = __atomic_load_n(&s_tagStatistics.received, __ATOMIC_RELAXED);
+	statistics->ignored = __atomic_load_n(&s_tagStatistics.ignored, __ATOMIC_RELAXED);
+	statistics->changed = __atomic_load_n(&s_tagStatistics.changed, __ATOMIC_RELAXED);
+	statistics->emitted = __atomic_load_n(&s_tagStatistics.emitted, __ATOMIC_RELAXED);
+	statistics->deferred = __atomic_load_n(&s_tagStatistics.deferred, __ATOMIC_RELAXED);
+}
+
+void MultiMediaGetCommandStatistics(MultiMediaCommandStatistics *statistics)
+{
+	statistics->posted = __atomic_load_n(&s_commandStatistics.posted, __ATOMIC_RELAXED);
+	statistics->overwritten = __atomic_load_n(&s_commandStatistics.overwritten, __ATOMIC_RELAXED);
+	statistics->refused = __atomic_load_n(&s_commandStatistics.refused, __ATOMIC_RELAXED);
+	statistics->lockWaitMax = __atomic_load_n(&s_commandStatistics.lockWaitMax, __ATOMIC_RELAXED);
+	statistics->lockWaitSum = __atomic_load_n(&s_commandStatistics.lockWaitSum, __ATOMIC_RELAXED);
+}
+
+static void LockCommandSlot(void)
+{
+	int64_t requested = TCTimeGetMonotonicNs();
+	uint32_t wait;
+
+	/* the command thread keeps s_cmdMutex while it processes a command */
+	(void)pthread_mutex_lock(&s_cmdMutex);
+	wait = (uint32_t)((TCTimeGetMonotonicNs() - requested) / 1000);
+	__atomic_store_n(&s_commandStatistics.lockWaitSum, s_commandStatistics.lockWaitSum + (uint64_t)wait, __ATOMIC_RELAXED);
+	if (wait > s_commandStatistics.lockWaitMax)
+	{
+		__atomic_store_n(&s_commandStatistics.lockWaitMax, wait, __ATOMIC_RELAXED);
+	}
+}
+
+static void PostCommand(MultiMediaCommand command)
+{
+	/* a single slot: a command the thread has not taken yet is lost */
+	if (s_currentCmd != TotalMultiMediaCommands)
+	{
+		WARN_PRINTF("command(%d) overwrites command(%d)\n", command, s_currentCmd);
+		CountStatistic(&s_commandStatistics.overwritten, 1U);
+	}
+	s_currentCmd = command;
+	CountStatistic(&s_commandStatistics.posted, 1U);
+}
+
+void MultiMediaSetPositionInterval(uint32_t interval)
+{
+	(void)pthread_mutex_lock(&s_positionMutex);
+	if (interval != s_positionInterval)
+	{
+		DEBUG_PRINTF("position interval %u -> %u ms\n", s_positionInterval, interval);
+		s_positionInterval = interval;
+		s_positionGeneration++;
+		(void)pthread_cond_broadcast(&s_positionCond);
+	}
+	(void)pthread_mutex_unlock(&s_positionMutex);
+}
+
+void MultiMediaSetAlbumArtSharedMemory(int32_t enable)
+{
+	s_albumArtSharedMemory = (enable != 0);
+}
+
+void MultiMediaSetAlbumArtSharedMemoryOnRequest(int32_t enable)
+{
+	s_albumArtOnRequest = (enable != 0);
+}
+
 void MultiMediaSetAudioSink(const char *audioSink,const char *device)
 {
 	if(audioSink!= NULL)
@@ -754,6 +1138,28 @@ void MultiMediaSetAudioSink(const char *audioSink,const char *device)
 	}
 }
 
+void MultiMediaSetVideoSink(const char *videoSink)
+{
+	if (videoSink != NULL)
+	{
+		uint32_t size;
+		INFO_PRINTF("set videoSink (%s)\n", videoSink);
+
+		if(strlen(videoSink) >= (size_t)MAX_SINK_DEVICE_NAME)
+		{
+			size = MAX_SINK_DEVICE_NAME-1;
+		}
+		else
+		{
+			size = strlen(videoSink);
+		}
+		(void)memset(s_videoSinkName, 0x00, MAX_SINK_DEVICE_NAME);
+		(void)strncpy(s_videoSinkName, videoSink, size);
+		/* other sinks, e.g. fakesink for a headless benchmark, only get "sync" */
+		s_videoSinkOverlay = (strcmp(s_videoSinkName, VIDEO_SINK_NAME) == 0);
+	}
+}
+
 void MultiMediaSetV4LDevice(const char *device)
 {
 	if (device != NULL)
@@ -796,15 +1202,31 @@ static void GetSamplerate(MultiMediaPlayer *player, int32_t playID)
 		if (audio_pad != NULL)
 		{
 			gint samplerate = 0;
+			gint channels = 0;
 			GstStructure *structure = NULL;
+			MultiMediaMetadata metadata;
+			int32_t metadataPlayID = -1;
+			uint32_t ready = 0;
 			caps = gst_pad_get_current_caps(audio_pad);
 			structure = gst_caps_get_structure(caps, 0);
 			gst_structure_get_int(structure,"rate",&samplerate);
-			INFO_PRINTF("samplerate = %d\n",samplerate);
+			(void)gst_structure_get_int(structure, "channels", &channels);
+			INFO_PRINTF("samplerate = %d, channels = %d\n",samplerate, channels);
+			MultiMediaStateSetSamplerate(samplerate);
 			if(MultiMediaSamplerateCB != NULL)
 			{
 				MultiMediaSamplerateCB(samplerate, playID);
 			}
+
+			if ((player->avPlayer.id3Info != NULL) && (channels > 0))
+			{
+				(void)pthread_mutex_lock(&s_mutex);
+				player->avPlayer.id3Info->channels = (uint32_t)channels;
+				ready = SelectTagEmissions(UpdateMetadata(player->avPlayer.id3Info, playID), &metadata, &metadataPlayID);
+				(void)pthread_mutex_unlock(&s_mutex);
+			}
+
+			EmitTagUpdates(ready, &metadata, metadataPlayID);
 			gst_object_unref(audio_pad);
 		}
 		else
@@ -828,6 +1250,19 @@ static gboolean GstBusHandler(GstBus *bus, GstMessage *msg, gpointer data)
 	return (gboolean)TRUE;
 }
 
+/* called by the thread posting the message, before a new streaming task starts */
+static GstBusSyncReply GstSyncBusHandler(GstBus *bus, GstMessage *msg, gpointer data)
+{
+	if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_STREAM_STATUS)
+	{
+		MultiMediaTaskPoolStreamStatus(msg);
+	}
+
+	(void)bus;
+	(void)data;
+	return GST_BUS_PASS;
+}
+
 static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 {
 
@@ -838,28 +1273,70 @@ static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 			case GST_MESSAGE_EOS:
 			{
 				INFO_PRINTF("GST_MESSAGE_EOS\n");
-				if (MultiMediaPlayCompletedCB != NULL)
+				if ((!StartNextTrack(player)) && (MultiMediaPlayCompletedCB != NULL))
 				{
 					MultiMediaPlayCompletedCB(player->avPlayer.playID);
 				}
 
 				break;
 			}
+			case GST_MESSAGE_APPLICATION:
+			{
+				const GstStructure *structure = gst_message_get_structure(msg);
+
+				/* the crossfade mixer: the next track has to preroll now */
+				if ((structure != NULL) && gst_structure_has_name(structure, AUDIO_CROSSFADE_ENDING_MESSAGE))
+				{
+					(void)StartNextTrack(player);
+				}
+				break;
+			}
 			case GST_MESSAGE_TAG:
 			{
 				if (player->avPlayer.video == (bool)0)
 				{
 					GstTagList *tags = NULL;
-
-					(void)pthread_mutex_lock(&s_mutex);
+					MultiMediaMetadata metadata;
+					int32_t metadataPlayID = -1;
+					uint32_t dirty;
+					uint32_t ready = 0;
+					AlbumArtAnnouncement announcement;
+					bool announced = false;
+					/* a stale read only costs one parse, or postpones the first bitrate to the next list */
+					bool bitrateKnown = (__atomic_load_n(&s_id3Information.bitrate, __ATOMIC_RELAXED) != 0U);
 
 					gst_message_parse_tag (msg, &tags);
+					CountStatistic(&s_tagStatistics.received, 1U);
+
+					/* VBR streams post a bitrate list every few frames, it is dropped without s_mutex */
+					if (HasExportedTag(tags, bitrateKnown))
+					{
+						(void)pthread_mutex_lock(&s_mutex);
+
+						player->avPlayer.id3Info = &s_id3Information;
+						gst_tag_list_foreach(tags, SetID3Information, &player->avPlayer);
+						SetExtendedInformation(tags, player->avPlayer.id3Info);
+						dirty = UpdateMetadata(player->avPlayer.id3Info, player->avPlayer.playID);
+						if (dirty != 0U)
+						{
+							CountStatistic(&s_tagStatistics.changed, 1U);
+						}
+						ready = SelectTagEmissions(dirty, &metadata, &metadataPlayID);
+						announced = TakeAlbumArtAnnouncement(&player->avPlayer.id3Info->albumArt, &announcement);
 
-					player->avPlayer.id3Info = &s_id3Information;
-					gst_tag_list_foreach(tags, SetID3Information, &player->avPlayer);
+						(void)pthread_mutex_unlock(&s_mutex);
+					}
+					else
+					{
+						CountStatistic(&s_tagStatistics.ignored, 1U);
+					}
 					gst_tag_list_free(tags);
 
-					(void)pthread_mutex_unlock(&s_mutex);
+					EmitTagUpdates(ready, &metadata, metadataPlayID);
+					if (announced)
+					{
+						AnnounceAlbumArt(&announcement);
+					}
 				}
 				break;
 			}
@@ -870,10 +1347,14 @@ static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 
 				if (strcmp(GST_OBJECT_NAME(msg->src), "player") == 0)
 				{
+					MEDIAPLAYBACK_TRACE(StateChanged, oldState, newState, 0, 0);
 					INFO_PRINTF("%s STATE CHANGED (%d->%d)\n",
 													 GST_OBJECT_NAME(msg->src), (int32_t)oldState, (int32_t)newState);
 					if ((newState == GST_STATE_PLAYING) && (oldState == GST_STATE_PAUSED))
 					{
+						/* the buffers prerolled in the sinks are rendered from now on */
+						MultiMediaLatencyPlaying();
+						MultiMediaStateSetPlayback(MultiMediaPlaybackPlaying, 1.0);
 						if (MultiMediaPlayStartedCB != NULL)
 						{
 							MultiMediaPlayStartedCB(player->avPlayer.playID);
@@ -893,6 +1374,7 @@ static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 								hour = min / 60;
 								min %= 60;
 								player->getduration = true;
+								MultiMediaStateSetDuration(duration);
 
 								if (MultiMediaTotalTimeChangeCB != NULL)
 								{
@@ -912,6 +1394,7 @@ static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 					else if (((newState == GST_STATE_PAUSED) && (oldState == GST_STATE_PLAYING))||
 						((newState == GST_STATE_PAUSED) && (oldState == GST_STATE_READY)))
 					{
+						MultiMediaStateSetPlayback(MultiMediaPlaybackPaused, 1.0);
 						if (player->userPause)
 						{
 							if (MultiMediaPlayPausedCB != NULL)
@@ -945,16 +1428,33 @@ static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 			{
 				player->async_done = true;
 				INFO_PRINTF("async_done\n");
+				(void)TCTimeSpanEnd(&s_prerollSpan);
+				(void)TCTimeSpanEnd(&s_seekSpan);
 				if( s_dualDisplay == 1)
 				{
 					GetSamplerate(player, player->avPlayer.playID);
 				}
+				if ((player->avPlayer.video == (bool)0) && (player->folderArtRequested == false))
+				{
+					player->folderArtRequested = true;
+					RequestFolderAlbumArt(player);
+				}
 				#if 0
 				 GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(player->avPlayer.playbin),GST_DEBUG_GRAPH_SHOW_ALL, "gst_dot" ); */
 				#endif
 
 				break;
 			}
+			case GST_MESSAGE_QOS:
+			case GST_MESSAGE_WARNING:
+			case GST_MESSAGE_BUFFERING:
+			case GST_MESSAGE_CLOCK_LOST:
+			{
+				/* glitches, counted for get_pipeline_stats */
+				MEDIAPLAYBACK_TRACE(GstMessage, GST_MESSAGE_TYPE(msg), 0, 0, 0);
+				MultiMediaPipelineStatsMessage(msg);
+				break;
+			}
 #ifndef GST_VER_0_10
 			case GST_MESSAGE_DURATION_CHANGED:
 			{
@@ -970,6 +1470,7 @@ static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 					min %= 60;
 
 					player->getduration = true;
+					MultiMediaStateSetDuration(duration);
 					if (MultiMediaTotalTimeChangeCB != NULL)
 					{
 						MultiMediaTotalTimeChangeCB(hour, min, sec,player->avPlayer.playID);
@@ -996,6 +1497,7 @@ static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 					hour = min / 60;
 					min %= 60;
 					player->getduration = true;
+					MultiMediaStateSetDuration(duration);
 					if (MultiMediaTotalTimeChangeCB != NULL)
 					{
 						MultiMediaTotalTimeChangeCB(hour, min, sec, player->avPlayer.playID);
@@ -1010,6 +1512,7 @@ static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 #endif
 			default:
 			{
+				MEDIAPLAYBACK_TRACE(GstMessage, GST_MESSAGE_TYPE(msg), 0, 0, 0);
 				DEBUG_PRINTF("GST MESSAGE([%d]%s) RECEIVED\n",
 						GST_MESSAGE_TYPE(msg),
 						GST_MESSAGE_TYPE_NAME(msg));
@@ -1021,190 +1524,615 @@ static void GStreamerMessageParser(MultiMediaPlayer *player, GstMessage *msg)
 
 static void InitializeID3Information(void)
 {
+	(void)pthread_mutex_lock(&s_mutex);
 	(void)memset(s_id3Information.title, 0x00, MAX_ID3_TAG_SIZE);
 	(void)memset(s_id3Information.artist, 0x00, MAX_ID3_TAG_SIZE);
 	(void)memset(s_id3Information.album, 0x00, MAX_ID3_TAG_SIZE);
-	s_id3Information.albumArt.length = 0;
-	if(s_id3Information.albumArt.buf != NULL)
-	{
-		free(s_id3Information.albumArt.buf);
-		s_id3Information.albumArt.buf = NULL;
-	}
+	(void)memset(s_id3Information.genre, 0x00, MAX_ID3_TAG_SIZE);
+	(void)memset(s_id3Information.composer, 0x00, MAX_ID3_TAG_SIZE);
+	(void)memset(s_id3Information.codec, 0x00, MULTIMEDIA_MAX_CODEC_SIZE);
+	s_id3Information.trackNumber = 0;
+	s_id3Information.trackCount = 0;
+	s_id3Information.discNumber = 0;
+	s_id3Information.discCount = 0;
+	s_id3Information.year = 0;
+	s_id3Information.bitrate = 0;
+	s_id3Information.channels = 0;
+	ReleaseAlbumArt(&s_id3Information.albumArt);
 	s_id3Information.albumArt.complete = false;
+	s_folderArtPlayID = -1;
+	/* the first tags of the next track are sent at once, a pending timer finds nothing to do */
+	s_tagPending = 0;
+	(void)memset(s_tagLastEmit, 0, sizeof(s_tagLastEmit));
+	(void)pthread_mutex_unlock(&s_mutex);
+}
 
+static void ReleaseAlbumArt(AlbumArt *albumArt)
+{
+	albumArt->length = 0;
+	if(albumArt->buf != NULL)
+	{
+		free(albumArt->buf);
+		albumArt->buf = NULL;
+	}
+	if (albumArt->sample != NULL)
+	{
+		gst_sample_unref(albumArt->sample);
+		albumArt->sample = NULL;
+	}
+	if (albumArt->fd >= 0)
+	{
+		(void)close(albumArt->fd);
+		albumArt->fd = -1;
+	}
+	albumArt->playID = -1;
+	albumArt->hash = 0;
+	albumArt->announce = false;
+	albumArt->slot = ALBUMART_SHM_NO_SLOT;
+	albumArt->generation = 0;
 }
 
 static void SetID3Information(const GstTagList * list, const gchar * tag, gpointer user_data)
 {
 	int32_t i, num;
 	AVPlayer *avPlayer = (AVPlayer *)user_data;
-	int32_t ID3_length;
-	
+	char *target;
+	const gchar *value = NULL;
+
 	if (avPlayer != NULL)
 	{
-		num = gst_tag_list_get_tag_size(list, tag);
-		for (i = 0; i < num; ++i)
+		target = GetID3String(avPlayer->id3Info, tag);
+		if (target != NULL)
 		{
-			/* DEBUG_PRINTF("PARSE ID3 TAG(%s)\n",tag); */
-											 
-			if(gst_tag_get_type (tag) == G_TYPE_STRING)
-		 	{
-				const GValue *val;
-				val = gst_tag_list_get_value_index (list, tag, i);
-
-				if (strncmp(tag, GST_TAG_TITLE, 5) == 0)
+			if (gst_tag_list_peek_string_index(list, tag, 0, &value))
+			{
+				/* a repeated value leaves the buffer untouched, UpdateMetadata finds what changed */
+				if (strncmp(target, value, (size_t)MAX_ID3_TAG_SIZE - 1U) != 0)
 				{
-					if (G_VALUE_HOLDS_STRING (val) == 1)
-					{
-						ID3_length = strlen(g_value_get_string(val));
-						if(ID3_length > MAX_ID3_TAG_SIZE)
-						{
-							ID3_length =MAX_ID3_TAG_SIZE;
-						}
-						(void)memset(avPlayer->id3Info->title, 0x00, MAX_ID3_TAG_SIZE);
-						(void)memcpy(avPlayer->id3Info->title, g_value_get_string(val), ID3_length);
-						DEBUG_PRINTF("PARSED ID3 TAG(%s:%s)\n", 
-														 tag, avPlayer->id3Info->title);
-						if (MultiMediaID3InformationCB != NULL)
-						{
-							MultiMediaID3InformationCB(MetaCategoryTitle, avPlayer->id3Info->title, avPlayer->playID);
-						}
-					}
-					else
-					{
-						WARN_PRINTF("G_VALUE_HOLDS_STRING failed\n");
-					}
+					(void)g_strlcpy(target, value, MAX_ID3_TAG_SIZE);
+					DEBUG_PRINTF("PARSED ID3 TAG(%s:%s)\n", tag, target);
 				}
-				else if (strncmp(tag, GST_TAG_ARTIST, 6) == 0)
-				{
-					if (G_VALUE_HOLDS_STRING (val) == 1)
-					{
-						ID3_length = strlen(g_value_get_string(val));
-						if(ID3_length > MAX_ID3_TAG_SIZE)
-						{
-							ID3_length =MAX_ID3_TAG_SIZE;
-						}
-						(void)memset(avPlayer->id3Info->artist, 0x00, MAX_ID3_TAG_SIZE);
-						(void)memcpy(avPlayer->id3Info->artist, g_value_get_string(val), ID3_length);
+			}
+			else
+			{
+				WARN_PRINTF("G_VALUE_HOLDS_STRING failed\n");
+			}
+		}
+		else if (strcmp(tag, GST_TAG_IMAGE) == 0)
+		{
+			num = gst_tag_list_get_tag_size(list, tag);
+			for (i = 0; i < num; ++i)
+			{
+				GstSample *sample = NULL;
 
-						DEBUG_PRINTF("PARSED ID3 TAG(%s:%s)\n",
-														 tag, avPlayer->id3Info->artist);
-						if (MultiMediaID3InformationCB != NULL)
-						{
-							MultiMediaID3InformationCB(MetaCategoryArtist, avPlayer->id3Info->artist, avPlayer->playID);
-						}
-					}
-					else
-					{
-						WARN_PRINTF("G_VALUE_HOLDS_STRING failed\n");
-					}
-				}
-				else if (strcmp(tag, GST_TAG_ALBUM) == 0)
+				if (gst_tag_list_get_sample_index (list, tag, i, &sample))
 				{
-					if (G_VALUE_HOLDS_STRING (val))
-					{
-						ID3_length = strlen(g_value_get_string(val));
-						if(ID3_length > MAX_ID3_TAG_SIZE)
-						{
-							ID3_length =MAX_ID3_TAG_SIZE;
-						}
-						(void)memset(avPlayer->id3Info->album, 0x00, MAX_ID3_TAG_SIZE);
-						(void)memcpy(avPlayer->id3Info->album, g_value_get_string(val), ID3_length);
-					
-						DEBUG_PRINTF("PARSED ID3 TAG(%s:%s)\n",
-														 tag, avPlayer->id3Info->album);
-						if (MultiMediaID3InformationCB != NULL)
-						{
-							MultiMediaID3InformationCB(MetaCategoryAlbum, avPlayer->id3Info->album, avPlayer->playID);
-						}
-					}
-					else
-					{
-						WARN_PRINTF("G_VALUE_HOLDS_STRING failed\n");
-					}
-				}
-				else if (strncmp(tag, GST_TAG_GENRE, 5) == 0)
-				{
-					if (G_VALUE_HOLDS_STRING (val) == 1)
+					GstBuffer *img = gst_sample_get_buffer (sample);
+					if (img)
 					{
+						DEBUG_PRINTF("PARSING ALBUMART. LENGTH(%u)\n", (uint32_t)gst_buffer_get_size(img));
 
-						ID3_length = strlen(g_value_get_string(val));
-						if(ID3_length > MAX_ID3_TAG_SIZE)
-						{
-							ID3_length =MAX_ID3_TAG_SIZE;
-						}
-						(void)memset(avPlayer->id3Info->genre, 0x00, MAX_ID3_TAG_SIZE);
-						(void)memcpy(avPlayer->id3Info->genre, g_value_get_string(val), ID3_length);
-					
-						DEBUG_PRINTF("PARSED ID3 TAG(%s:%s)\n",
-														 tag, avPlayer->id3Info->genre);
-						if (MultiMediaID3InformationCB != NULL)
+						if(avPlayer->id3Info->albumArt.complete == false)
 						{
-							MultiMediaID3InformationCB(MetaCategoryGenre, avPlayer->id3Info->genre, avPlayer->playID);
+							SetAlbumArt(avPlayer->id3Info, avPlayer->playID, sample, AlbumArtCacheAdd(img));
 						}
 					}
 					else
 					{
-						WARN_PRINTF("G_VALUE_HOLDS_STRING failed\n");
+						WARN_PRINTF("NULL BUFFER\n");
 					}
+					gst_sample_unref(sample);
 				}
-				else
+			}
+		}
+		else
+		{
+			;
+		}
+	}
+}
+
+static void SetAlbumArt(ID3Information *info, int32_t playID, GstSample *sample, uint64_t hash)
+{
+	/* called with s_mutex held. keep the sample, the image is copied only when a client requests it */
+	ReleaseAlbumArt(&info->albumArt);
+	info->albumArt.sample = gst_sample_ref(sample);
+	info->albumArt.playID = playID;
+	info->albumArt.hash = hash;
+	info->albumArt.complete = true;
+	info->albumArt.announce = true;
+}
+
+/* called with s_mutex held, the announcement is sent once the caller has unlocked it */
+static bool TakeAlbumArtAnnouncement(AlbumArt *albumArt, AlbumArtAnnouncement *announcement)
+{
+	bool ret = false;
+
+	if (albumArt->announce)
+	{
+		albumArt->announce = false;
+		announcement->sample = gst_sample_ref(albumArt->sample);
+		announcement->playID = albumArt->playID;
+		announcement->length = (uint32_t)gst_buffer_get_size(gst_sample_get_buffer(albumArt->sample));
+		announcement->hash = albumArt->hash;
+		ret = true;
+	}
+
+	return ret;
+}
+
+static void AnnounceAlbumArt(AlbumArtAnnouncement *announcement)
+{
+	uint32_t slot = ALBUMART_SHM_NO_SLOT;
+	uint32_t generation = 0;
+
+	/* clients read the segment when the signal arrives, so it is published first */
+	if ((s_albumArtSharedMemory) && (s_albumArtOnRequest == false))
+	{
+		GstBuffer *img = gst_sample_get_buffer(announcement->sample);
+		GstMapInfo mapInfo;
+
+		if ((img != NULL) && gst_buffer_map(img, &mapInfo, GST_MAP_READ))
+		{
+			if (AlbumArtSharedMemoryPublish(announcement->playID, mapInfo.data, (uint32_t)mapInfo.size,
+											&slot, &generation) != 0)
+			{
+				slot = ALBUMART_SHM_NO_SLOT;
+				generation = 0;
+			}
+			gst_buffer_unmap (img, &mapInfo);
+		}
+
+		(void)pthread_mutex_lock(&s_mutex);
+		if (s_id3Information.albumArt.sample == announcement->sample)
+		{
+			s_id3Information.albumArt.slot = slot;
+			s_id3Information.albumArt.generation = generation;
+		}
+		(void)pthread_mutex_unlock(&s_mutex);
+	}
+
+	if (MultiMediaAlbumArtCB != NULL)
+	{
+		MultiMediaAlbumArtCB(announcement->playID, announcement->length, slot, generation);
+	}
+	/* decoded and scaled on the thumbnail worker, unless the cache has it */
+	(void)AlbumArtThumbnailRequest(announcement->sample, announcement->playID, announcement->hash);
+	gst_sample_unref(announcement->sample);
+	announcement->sample = NULL;
+}
+
+/* called with s_mutex held, on request the image is copied into the legacy segment once per track */
+static bool PublishAlbumArt(AlbumArt *albumArt)
+{
+	if ((s_albumArtSharedMemory) && (s_albumArtOnRequest) &&
+		(albumArt->slot == ALBUMART_SHM_NO_SLOT) && (albumArt->sample != NULL))
+	{
+		GstBuffer *img = gst_sample_get_buffer(albumArt->sample);
+		GstMapInfo mapInfo;
+
+		if ((img != NULL) && gst_buffer_map(img, &mapInfo, GST_MAP_READ))
+		{
+			if (AlbumArtSharedMemoryPublish(albumArt->playID, mapInfo.data, (uint32_t)mapInfo.size,
+											&albumArt->slot, &albumArt->generation) != 0)
+			{
+				albumArt->slot = ALBUMART_SHM_NO_SLOT;
+			}
+			gst_buffer_unmap (img, &mapInfo);
+		}
+	}
+
+	return (albumArt->slot != ALBUMART_SHM_NO_SLOT);
+}
+
+/* main loop, every tag before preroll is parsed, a track without an embedded cover uses the one of its folder */
+static void RequestFolderAlbumArt(MultiMediaPlayer *player)
+{
+	bool embedded;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	embedded = s_id3Information.albumArt.complete;
+	if ((embedded == false) && (player->path != NULL) && (strncmp(player->path, "file://", 7) == 0))
+	{
+		player->avPlayer.id3Info = &s_id3Information;
+		s_folderArtPlayID = player->avPlayer.playID;
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	/* the directory is read on the cache worker */
+	if ((embedded == false) && (player->path != NULL) && (strncmp(player->path, "file://", 7) == 0))
+	{
+		(void)AlbumArtCacheRequestFolderImage(&player->path[7], player->avPlayer.playID);
+	}
+}
+
+/* cache worker, the track may have changed or found an embedded cover meanwhile */
+static void OnFolderAlbumArt(int32_t playID, GstBuffer *image, uint64_t hash)
+{
+	GstSample *sample = gst_sample_new(image, NULL, NULL, NULL);
+	AlbumArtAnnouncement announcement;
+	bool announced = false;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	if ((playID == s_folderArtPlayID) && (s_id3Information.albumArt.complete == false))
+	{
+		SetAlbumArt(&s_id3Information, playID, sample, hash);
+		announced = TakeAlbumArtAnnouncement(&s_id3Information.albumArt, &announcement);
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	if (announced)
+	{
+		AnnounceAlbumArt(&announcement);
+	}
+	gst_sample_unref(sample);
+}
+
+static void SetID3InformationFromLibrary(AVPlayer *avPlayer, const char *path)
+{
+	MediaLibraryTrack *track = (MediaLibraryTrack *)malloc(sizeof(MediaLibraryTrack));
+
+	if (track != NULL)
+	{
+		/* the index already holds the parsed tags, so they are sent before the pipeline prerolls */
+		if (MediaLibraryLookup(path, track) == 0)
+		{
+			const char *values[TotalMetaCategories];
+			char *targets[TotalMetaCategories];
+			MultiMediaMetadata *metadata = (MultiMediaMetadata *)malloc(sizeof(MultiMediaMetadata));
+			int32_t metadataPlayID = -1;
+			uint32_t ready = 0;
+			uint32_t idx;
+
+			DEBUG_PRINTF("library hit(%s)\n", path);
+
+			values[MetaCategoryTitle] = track->title;
+			values[MetaCategoryArtist] = track->artist;
+			values[MetaCategoryAlbum] = track->album;
+			values[MetaCategoryGenre] = track->genre;
+			targets[MetaCategoryTitle] = s_id3Information.title;
+			targets[MetaCategoryArtist] = s_id3Information.artist;
+			targets[MetaCategoryAlbum] = s_id3Information.album;
+			targets[MetaCategoryGenre] = s_id3Information.genre;
+
+			(void)pthread_mutex_lock(&s_mutex);
+			avPlayer->id3Info = &s_id3Information;
+			for (idx = 0; idx < (uint32_t)TotalMetaCategories; idx++)
+			{
+				(void)g_strlcpy(targets[idx], values[idx], MAX_ID3_TAG_SIZE);
+			}
+			if (metadata != NULL)
+			{
+				ready = SelectTagEmissions(UpdateMetadata(avPlayer->id3Info, avPlayer->playID), metadata, &metadataPlayID);
+			}
+			(void)pthread_mutex_unlock(&s_mutex);
+
+			EmitTagUpdates(ready, metadata, metadataPlayID);
+			free(metadata);
+		}
+		free(track);
+	}
+}
+
+static void SetExtendedInformation(const GstTagList *list, ID3Information *info)
+{
+	guint value;
+	gchar *string = NULL;
+	GstDateTime *dateTime = NULL;
+	GDate *date = NULL;
+
+	if (gst_tag_list_get_uint(list, GST_TAG_TRACK_NUMBER, &value))
+	{
+		info->trackNumber = value;
+	}
+	if (gst_tag_list_get_uint(list, GST_TAG_TRACK_COUNT, &value))
+	{
+		info->trackCount = value;
+	}
+	if (gst_tag_list_get_uint(list, GST_TAG_ALBUM_VOLUME_NUMBER, &value))
+	{
+		info->discNumber = value;
+	}
+	if (gst_tag_list_get_uint(list, GST_TAG_ALBUM_VOLUME_COUNT, &value))
+	{
+		info->discCount = value;
+	}
+
+	/* prefer the nominal bitrate, the actual one of VBR streams changes all the time */
+	if (gst_tag_list_get_uint(list, GST_TAG_NOMINAL_BITRATE, &value))
+	{
+		info->bitrate = value;
+	}
+	else if ((info->bitrate == 0U) && gst_tag_list_get_uint(list, GST_TAG_BITRATE, &value))
+	{
+		info->bitrate = value;
+	}
+	else
+	{
+		;
+	}
+
+	if (gst_tag_list_get_date_time(list, GST_TAG_DATE_TIME, &dateTime))
+	{
+		if (gst_date_time_has_year(dateTime))
+		{
+			info->year = (uint32_t)gst_date_time_get_year(dateTime);
+		}
+		gst_date_time_unref(dateTime);
+	}
+	else if (gst_tag_list_get_date(list, GST_TAG_DATE, &date))
+	{
+		if (g_date_valid(date))
+		{
+			info->year = (uint32_t)g_date_get_year(date);
+		}
+		g_date_free(date);
+	}
+	else
+	{
+		;
+	}
+
+	if (gst_tag_list_get_string(list, GST_TAG_COMPOSER, &string))
+	{
+		(void)g_strlcpy(info->composer, string, MAX_ID3_TAG_SIZE);
+		g_free(string);
+	}
+
+	if (gst_tag_list_get_string(list, GST_TAG_AUDIO_CODEC, &string))
+	{
+		(void)g_strlcpy(info->codec, string, MULTIMEDIA_MAX_CODEC_SIZE);
+		g_free(string);
+	}
+}
+
+static bool IsExportedTag(const gchar *tag, bool bitrateKnown)
+{
+	bool exported = false;
+	uint32_t idx;
+
+	for (idx = 0; (idx < (uint32_t)(sizeof(s_exportedTags) / sizeof(s_exportedTags[0]))) && (exported == false); idx++)
+	{
+		exported = (strcmp(tag, s_exportedTags[idx]) == 0);
+	}
+
+	/* the actual bitrate is only a fallback for a stream without a nominal one */
+	if (exported && bitrateKnown && (strcmp(tag, GST_TAG_BITRATE) == 0))
+	{
+		exported = false;
+	}
+
+	return exported;
+}
+
+static bool HasExportedTag(const GstTagList *list, bool bitrateKnown)
+{
+	bool found = false;
+	gint count = gst_tag_list_n_tags(list);
+	gint idx;
+
+	for (idx = 0; (idx < count) && (found == false); idx++)
+	{
+		found = IsExportedTag(gst_tag_list_nth_tag_name(list, (guint)idx), bitrateKnown);
+	}
+
+	return found;
+}
+
+static char *GetID3String(ID3Information *info, const gchar *tag)
+{
+	char *target = NULL;
+
+	/* exact names, title-sortname and the like must not overwrite the title */
+	if (strcmp(tag, GST_TAG_TITLE) == 0)
+	{
+		target = info->title;
+	}
+	else if (strcmp(tag, GST_TAG_ARTIST) == 0)
+	{
+		target = info->artist;
+	}
+	else if (strcmp(tag, GST_TAG_ALBUM) == 0)
+	{
+		target = info->album;
+	}
+	else if (strcmp(tag, GST_TAG_GENRE) == 0)
+	{
+		target = info->genre;
+	}
+	else
+	{
+		;
+	}
+
+	return target;
+}
+
+static uint32_t UpdateMetadata(const ID3Information *info, int32_t playID)
+{
+	MultiMediaMetadata metadata;
+	const char *current[TotalMetaCategories];
+	const char *previous[TotalMetaCategories];
+	bool reset = (s_metadataValid == false) || (playID != s_metadataPlayID);
+	uint32_t dirty = 0;
+	uint32_t idx;
+
+	(void)g_strlcpy(metadata.title, info->title, MULTIMEDIA_MAX_TAG_SIZE);
+	(void)g_strlcpy(metadata.artist, info->artist, MULTIMEDIA_MAX_TAG_SIZE);
+	(void)g_strlcpy(metadata.album, info->album, MULTIMEDIA_MAX_TAG_SIZE);
+	(void)g_strlcpy(metadata.genre, info->genre, MULTIMEDIA_MAX_TAG_SIZE);
+	(void)g_strlcpy(metadata.composer, info->composer, MULTIMEDIA_MAX_TAG_SIZE);
+	(void)g_strlcpy(metadata.codec, info->codec, MULTIMEDIA_MAX_CODEC_SIZE);
+	metadata.trackNumber = info->trackNumber;
+	metadata.trackCount = info->trackCount;
+	metadata.discNumber = info->discNumber;
+	metadata.discCount = info->discCount;
+	metadata.year = info->year;
+	metadata.bitrate = info->bitrate;
+	metadata.channels = info->channels;
+
+	if (reset || (IsMetadataEqual(&metadata, &s_metadata) == false))
+	{
+		/* a category is only sent when it has a value, as before */
+		GetMetadataStrings(&metadata, current);
+		GetMetadataStrings(&s_metadata, previous);
+		for (idx = 0; idx < (uint32_t)TotalMetaCategories; idx++)
+		{
+			if ((current[idx][0] != '\0') && (reset || (strcmp(current[idx], previous[idx]) != 0)))
+			{
+				dirty |= (1U << idx);
+			}
+		}
+		dirty |= TAG_EMIT_METADATA_BIT;
+
+		(void)memcpy(&s_metadata, &metadata, sizeof(MultiMediaMetadata));
+		s_metadataPlayID = playID;
+		s_metadataValid = true;
+		MultiMediaStateSetMetadata(&s_metadata);
+	}
+
+	return dirty;
+}
+
+static bool IsMetadataEqual(const MultiMediaMetadata *a, const MultiMediaMetadata *b)
+{
+	return ((strcmp(a->title, b->title) == 0) &&
+			(strcmp(a->artist, b->artist) == 0) &&
+			(strcmp(a->album, b->album) == 0) &&
+			(strcmp(a->genre, b->genre) == 0) &&
+			(strcmp(a->composer, b->composer) == 0) &&
+			(strcmp(a->codec, b->codec) == 0) &&
+			(a->trackNumber == b->trackNumber) &&
+			(a->trackCount == b->trackCount) &&
+			(a->discNumber == b->discNumber) &&
+			(a->discCount == b->discCount) &&
+			(a->year == b->year) &&
+			(a->bitrate == b->bitrate) &&
+			(a->channels == b->channels));
+}
+
+static void GetMetadataStrings(const MultiMediaMetadata *metadata, const char *strings[TotalMetaCategories])
+{
+	strings[MetaCategoryTitle] = metadata->title;
+	strings[MetaCategoryArtist] = metadata->artist;
+	strings[MetaCategoryAlbum] = metadata->album;
+	strings[MetaCategoryGenre] = metadata->genre;
+}
+
+static uint32_t SelectTagEmissions(uint32_t dirty, MultiMediaMetadata *metadata, int32_t *playID)
+{
+	uint32_t ready = 0;
+	uint32_t deferred = 0;
+	int64_t now = TCTimeGetMonotonicMs();
+	int64_t wait = TAG_EMIT_INTERVAL_MS;
+	uint32_t idx;
+
+	/* called with s_mutex held */
+	s_tagPending |= dirty;
+	for (idx = 0; idx <= TAG_EMIT_METADATA; idx++)
+	{
+		if ((s_tagPending & (1U << idx)) != 0U)
+		{
+			int64_t elapsed = now - s_tagLastEmit[idx];
+
+			if ((s_tagLastEmit[idx] == 0) || (elapsed >= TAG_EMIT_INTERVAL_MS))
+			{
+				ready |= (1U << idx);
+				s_tagLastEmit[idx] = now;
+			}
+			else
+			{
+				if ((TAG_EMIT_INTERVAL_MS - elapsed) < wait)
 				{
-					;
+					wait = TAG_EMIT_INTERVAL_MS - elapsed;
 				}
-		 	}
-			 else if (gst_tag_get_type (tag) == GST_TYPE_SAMPLE)
-		 	{
-				if (strncmp(tag, GST_TAG_IMAGE, 5) == 0)
+				if ((dirty & (1U << idx)) != 0U)
 				{
+					deferred++;
+				}
+			}
+		}
+	}
+	s_tagPending &= ~ready;
 
-					GstSample *sample = NULL;
+	if ((s_tagPending != 0U) && (s_tagTimer == 0U))
+	{
+		s_tagTimer = g_timeout_add((guint)wait, OnTagRateTimer, NULL);
+	}
 
-					if (gst_tag_list_get_sample_index (list, tag, i, &sample))
-					{
-						GstBuffer *img = gst_sample_get_buffer (sample);
-						if (img)
-						{
-							GstMapInfo mapInfo;
-							(void)gst_buffer_map(img, &mapInfo, GST_MAP_READ);
+	if (ready != 0U)
+	{
+		(void)memcpy(metadata, &s_metadata, sizeof(MultiMediaMetadata));
+		*playID = s_metadataPlayID;
+	}
 
-							DEBUG_PRINTF("PARSING ALBUMART. BUFFER(%p), LENGTH(%u)\n",
-							mapInfo.data, mapInfo.size);
+	for (idx = 0; idx <= TAG_EMIT_METADATA; idx++)
+	{
+		if ((ready & (1U << idx)) != 0U)
+		{
+			CountStatistic(&s_tagStatistics.emitted, 1U);
+		}
+	}
+	CountStatistic(&s_tagStatistics.deferred, deferred);
 
-							if(avPlayer->id3Info->albumArt.buf  != NULL)
-							{
-								free(avPlayer->id3Info->albumArt.buf);
-								avPlayer->id3Info->albumArt.buf = NULL;
-							}
+	return ready;
+}
 
-							if(avPlayer->id3Info->albumArt.complete == false)
-							{
-								(void)memcpy((uint8_t*)s_shm_addr, mapInfo.data, mapInfo.size);
-								avPlayer->id3Info->albumArt.complete = true;
-								if (MultiMediaAlbumArtCB != NULL)
-								{
-									MultiMediaAlbumArtCB(avPlayer->playID, mapInfo.size);
-								}
-							}
-							gst_buffer_unmap (img, &mapInfo);
-						}
-						else
-						{
-							WARN_PRINTF("NULL BUFFER\n");
-						}
-					}
-				}
-		 	}
-			 else
-		 	{
-		 		;
-		 	}
+static gboolean OnTagRateTimer(gpointer data)
+{
+	MultiMediaMetadata *metadata = (MultiMediaMetadata *)malloc(sizeof(MultiMediaMetadata));
+	int32_t playID = -1;
+	uint32_t ready = 0;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	s_tagTimer = 0;
+	if (metadata != NULL)
+	{
+		ready = SelectTagEmissions(0, metadata, &playID);
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	EmitTagUpdates(ready, metadata, playID);
+	free(metadata);
+
+	(void)data;
+	return (gboolean)FALSE;
+}
+
+static void EmitTagUpdates(uint32_t ready, const MultiMediaMetadata *metadata, int32_t playID)
+{
+	const char *strings[TotalMetaCategories];
+	uint32_t idx;
+
+	if (ready != 0U)
+	{
+		GetMetadataStrings(metadata, strings);
+		for (idx = 0; idx < (uint32_t)TotalMetaCategories; idx++)
+		{
+			if (((ready & (1U << idx)) != 0U) && (MultiMediaID3InformationCB != NULL))
+			{
+				MultiMediaID3InformationCB((MetaCategory)idx, strings[idx], playID);
+			}
+		}
+
+		if (((ready & TAG_EMIT_METADATA_BIT) != 0U) && (MultiMediaMetadataCB != NULL))
+		{
+			MultiMediaMetadataCB(metadata, playID);
 		}
 	}
 }
 
+static void CountStatistic(uint32_t *counter, uint32_t count)
+{
+	if (count != 0U)
+	{
+		(void)__atomic_fetch_add(counter, count, __ATOMIC_RELAXED);
+	}
+}
+
 static bool MultiMediaPlayStart(const char *path, uint8_t hour, uint8_t min, uint8_t sec, bool video, int32_t id, uint8_t keepPause)
 {
+	MultiMediaPlayer *player;
 	uint32_t totalSec;
 	bool ret;
 
@@ -1222,7 +2150,14 @@ static bool MultiMediaPlayStart(const char *path, uint8_t hour, uint8_t min, uin
 
 	s_errorOccurred = 0;
 
-	s_currentPlayer = CreateAVPlayer(video);
+	/* the equalizer of the new player starts with the loudness gain of the track */
+	AudioEqualizerSetGain(video ? 0.0f : AudioLoudnessGetGain(path));
+	player = CreateAVPlayer(video, id);
+
+	/* s_stopMutex guards every change of s_currentPlayer, the main loop compares against it */
+	(void)pthread_mutex_lock(&s_stopMutex);
+	s_currentPlayer = player;
+	(void)pthread_mutex_unlock(&s_stopMutex);
 
 	if (s_currentPlayer != NULL)
 	{
@@ -1234,6 +2169,14 @@ static bool MultiMediaPlayStart(const char *path, uint8_t hour, uint8_t min, uin
 		s_currentPlayer->startPos = GST_SECOND * totalSec;
 		s_currentPlayer->position = 0;
 		s_currentPlayer->avPlayer.playID = id;
+		MultiMediaPipelineStatsAttach(s_currentPlayer->avPlayer.playbin, id);
+		MultiMediaStateReset(id, video ? (uint8_t)MultiMediaContentTypeVideo : (uint8_t)MultiMediaContentTypeAudio,
+							 s_currentPlayer->startPos);
+
+		if (!video)
+		{
+			SetID3InformationFromLibrary(&s_currentPlayer->avPlayer, path);
+		}
 
 		if (StartPlayer(s_currentPlayer, keepPause))
 		{
@@ -1242,8 +2185,10 @@ static bool MultiMediaPlayStart(const char *path, uint8_t hour, uint8_t min, uin
 		}
 		else
 		{
+			(void)pthread_mutex_lock(&s_stopMutex);
 			ReleasePlayer(s_currentPlayer);
 			s_currentPlayer = NULL;
+			(void)pthread_mutex_unlock(&s_stopMutex);
 			ret = false;
 			ERROR_PRINTF("StartPlayer failed\n");
 		}
@@ -1257,9 +2202,10 @@ static bool MultiMediaPlayStart(const char *path, uint8_t hour, uint8_t min, uin
 	return ret;
 }
 
-static MultiMediaPlayer *CreateAVPlayer(bool video)
+static MultiMediaPlayer *CreateAVPlayer(bool video, int32_t playID)
 {
 	MultiMediaPlayer *player = (MultiMediaPlayer *)malloc(sizeof (MultiMediaPlayer));
+	GstElement *equalizer;
 	bool created = false;
 
 	INFO_PRINTF("\n");
@@ -1287,6 +2233,8 @@ static MultiMediaPlayer *CreateAVPlayer(bool video)
 		player->updatePlayTime = false;
 		player->getduration = false;
 		player->async_done = false;
+		player->folderArtRequested = false;
+		player->nextPosted = false;
 		player->seek_enabled = FALSE;
 
 		InitializeID3Information();
@@ -1296,29 +2244,42 @@ static MultiMediaPlayer *CreateAVPlayer(bool video)
 		player->avPlayer.playbin = gst_element_factory_make("playbin", "player");
 		if (player->avPlayer.playbin != NULL)
 		{
-			INFO_PRINTF("CREATE AUDIO SINK, sink=%s, device=%s \n",
-											 s_audioSinkName, s_audioDeviceName);
-			player->avPlayer.audioSink = gst_element_factory_make(s_audioSinkName, "audio-sink");
-			if (player->avPlayer.audioSink != NULL)
+			/* with a crossfade the mixer keeps the device, a video player takes it back */
+			if (video == true)
 			{
-				if (s_audioDeviceNamePtr != NULL)
-				{
-					g_object_set(player->avPlayer.audioSink, "device", s_audioDeviceNamePtr, NULL);
-					INFO_PRINTF("audio-sink-speaker device : %s\n",
-													 s_audioDeviceNamePtr);
-				}
+				AudioCrossfadeClose();
+			}
+			else if (AudioCrossfadeIsEnabled() && (AudioCrossfadeIsOpen() || (AudioCrossfadeOpen(CreateAudioSink()) == 1)))
+			{
+				player->avPlayer.audioSink = AudioCrossfadeCreateSink(playID);
 			}
 			else
 			{
-				(void)fprintf(stderr, "%s: gst_element_factory_make(%s) failed\n", __FUNCTION__, s_audioSinkName);
+				;
+			}
+
+			if (player->avPlayer.audioSink == NULL)
+			{
+				player->avPlayer.audioSink = CreateAudioSink();
+			}
+
+			if (player->avPlayer.audioSink != NULL)
+			{
+				AddFirstBufferProbe(player->avPlayer.audioSink, MultiMediaLatencyAudio, playID);
+			}
+
+			equalizer = AudioEqualizerCreate();
+			if (equalizer != NULL)
+			{
+				g_object_set(player->avPlayer.playbin, "audio-filter", equalizer, NULL);
 			}
 
 			if(video == true)
 			{
 				INFO_PRINTF("CREATE VIDEO SINK, sink=%s, device=%s \n",
-												 VIDEO_SINK_NAME, s_v4lDevice);
-				player->avPlayer.videoSink = gst_element_factory_make(VIDEO_SINK_NAME, "video-sink");
-				if (player->avPlayer.videoSink != NULL)
+												 s_videoSinkName, s_v4lDevice);
+				player->avPlayer.videoSink = gst_element_factory_make(s_videoSinkName, "video-sink");
+				if ((player->avPlayer.videoSink != NULL) && (s_videoSinkOverlay))
 				{
 					g_object_set(player->avPlayer.videoSink, s_videoSinkProperty.x_start, s_videoInfo.x, NULL);
 					g_object_set(player->avPlayer.videoSink, s_videoSinkProperty.y_start, s_videoInfo.y, NULL);
@@ -1339,10 +2300,15 @@ static MultiMediaPlayer *CreateAVPlayer(bool video)
 					g_object_set(player->avPlayer.videoSink, s_videoSinkProperty.aspectratio, 1, NULL);
 					g_object_set(player->avPlayer.videoSink, "device", s_v4lDevice, NULL);
 					INFO_PRINTF("video-sink device : %s\n", s_v4lDevice);
+					AddFirstBufferProbe(player->avPlayer.videoSink, MultiMediaLatencyVideo, playID);
+				}
+				else if (player->avPlayer.videoSink != NULL)
+				{
+					AddFirstBufferProbe(player->avPlayer.videoSink, MultiMediaLatencyVideo, playID);
 				}
 				else
 				{
-					ERROR_PRINTF("gst_element_factory_make(%s) failed\n",VIDEO_SINK_NAME);
+					ERROR_PRINTF("gst_element_factory_make(%s) failed\n",s_videoSinkName);
 				}
 			}
 
@@ -1352,6 +2318,7 @@ static MultiMediaPlayer *CreateAVPlayer(bool video)
 
 			if (player->avPlayer.bus != NULL)
 			{
+				gst_bus_set_sync_handler(player->avPlayer.bus, GstSyncBusHandler, NULL, NULL);
 				DEBUG_PRINTF("ADD WATCH BUS HANDLER\n");
 				player->avPlayer.watchID = gst_bus_add_watch(player->avPlayer.bus, GstBusHandler, player);
 				if (player->avPlayer.watchID != FALSE)
@@ -1385,6 +2352,65 @@ static MultiMediaPlayer *CreateAVPlayer(bool video)
 	return player;
 }
 
+static GstElement *CreateAudioSink(void)
+{
+	GstElement *sink;
+
+	INFO_PRINTF("CREATE AUDIO SINK, sink=%s, device=%s \n",
+									 s_audioSinkName, s_audioDeviceName);
+	sink = gst_element_factory_make(s_audioSinkName, "audio-sink");
+	if (sink != NULL)
+	{
+		if (s_audioDeviceNamePtr != NULL)
+		{
+			g_object_set(sink, "device", s_audioDeviceNamePtr, NULL);
+			INFO_PRINTF("audio-sink-speaker device : %s\n",
+											 s_audioDeviceNamePtr);
+		}
+	}
+	else
+	{
+		(void)fprintf(stderr, "%s: gst_element_factory_make(%s) failed\n", __FUNCTION__, s_audioSinkName);
+	}
+
+	return sink;
+}
+
+static void AddFirstBufferProbe(GstElement *sink, MultiMediaLatencySink type, int32_t playID)
+{
+	GstPad *pad = gst_element_get_static_pad(sink, "sink");
+	FirstBufferProbeData *data;
+
+	/*
+	 * stays for the life of the sink, it costs one load per buffer while nothing is armed.
+	 * a sink handed off to the crossfade mixer plays on, its playID keeps it from the next request.
+	 */
+	if (pad != NULL)
+	{
+		data = g_new0(FirstBufferProbeData, 1);
+		data->sink = type;
+		data->playID = playID;
+		(void)gst_pad_add_probe(pad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+								FirstBufferProbe, data, g_free);
+		gst_object_unref(pad);
+	}
+	else
+	{
+		WARN_PRINTF("sink has no sink pad, no latency probe\n");
+	}
+}
+
+static GstPadProbeReturn FirstBufferProbe(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+	GstElement *sink = GST_PAD_PARENT(pad);
+	const FirstBufferProbeData *probe = (const FirstBufferProbeData *)data;
+
+	(void)info;
+	MultiMediaLatencyBuffer(probe->sink, probe->playID, (sink != NULL) && (GST_STATE(sink) == GST_STATE_PLAYING));
+
+	return GST_PAD_PROBE_OK;
+}
+
 static void ReleasePlayer(MultiMediaPlayer *player)
 {
 	if (player != NULL)
@@ -1422,6 +2448,9 @@ static void ReleaseAVPlayer(AVPlayer *player)
 			gst_object_unref(player->bus);
 		}
 
+		/* a sink handed off to the mixer stays there */
+		AudioCrossfadeRemoveSink(player->audioSink);
+
 		if (player->playbin != NULL)
 		{
 			gst_object_unref(GST_OBJECT(player->playbin));
@@ -1429,12 +2458,9 @@ static void ReleaseAVPlayer(AVPlayer *player)
 
 		if(player->id3Info!=NULL)
 		{
-			player->id3Info->albumArt.length =0;
-			if(player->id3Info->albumArt.buf != NULL)
-			{
-				free(player->id3Info->albumArt.buf);
-				player->id3Info->albumArt.buf = NULL;
-			}
+			(void)pthread_mutex_lock(&s_mutex);
+			ReleaseAlbumArt(&player->id3Info->albumArt);
+			(void)pthread_mutex_unlock(&s_mutex);
 			player->id3Info = NULL;
 		}
 	}
@@ -1523,6 +2549,7 @@ static bool StartPlayer(MultiMediaPlayer *player, uint8_t keepPause)
 			if (gst_element_query (player->avPlayer.playbin, query))
 			{
 				gst_query_parse_seeking (query, NULL, &player->seek_enabled, &start, &end);
+				MultiMediaStateSetSeekable(player->seek_enabled != FALSE);
 				if (!player->seek_enabled)
 				{
 					INFO_PRINTF("Seeking is DISABLED.\n");
@@ -1635,10 +2662,12 @@ static void StopPlayer(MultiMediaPlayer **player)
 		int32_t currentID = stopPlayer->avPlayer.playID;
 		StopPlayTimeThread();
 		(void)ChangePlayerState(stopPlayer->avPlayer.playbin, GST_STATE_NULL);
+		MultiMediaPipelineStatsDetach();
 		ReleasePlayer(stopPlayer);
 
 		*player = NULL;
 		MultiMediaSetResourceStatus(0);
+		MultiMediaStateSetPlayback(MultiMediaPlaybackStopped, 1.0);
 		if (MultiMediaPlayStoppedCB != NULL)
 		{
 			MultiMediaPlayStoppedCB(currentID);
@@ -1652,6 +2681,69 @@ static void StopPlayer(MultiMediaPlayer **player)
 	(void)pthread_mutex_unlock(&s_stopMutex);
 }
 
+/* the crossfade mixer plays the track on, the player goes without stopping its pipeline */
+static bool HandOffPlayer(MultiMediaPlayer **player)
+{
+	MultiMediaPlayer *handOffPlayer;
+	bool handedOff = false;
+
+	(void)pthread_mutex_lock(&s_stopMutex);
+	handOffPlayer = *player;
+	if ((handOffPlayer != NULL) &&
+		(AudioCrossfadeHandOff(handOffPlayer->avPlayer.audioSink, handOffPlayer->avPlayer.playbin) == 1))
+	{
+		int32_t currentID = handOffPlayer->avPlayer.playID;
+
+		INFO_PRINTF("playID(%d) handed off\n", currentID);
+		StopPlayTimeThread();
+		MultiMediaPipelineStatsDetach();
+		ReleasePlayer(handOffPlayer);
+
+		*player = NULL;
+		if (MultiMediaPlayStoppedCB != NULL)
+		{
+			MultiMediaPlayStoppedCB(currentID);
+		}
+		handedOff = true;
+	}
+	(void)pthread_mutex_unlock(&s_stopMutex);
+
+	return handedOff;
+}
+
+/* main loop: requests the next track once, when the current one ends or the mixer needs it */
+static bool StartNextTrack(MultiMediaPlayer *player)
+{
+	bool started = false;
+
+	/* under s_stopMutex the command thread can neither replace nor release the current player */
+	(void)pthread_mutex_lock(&s_stopMutex);
+	if ((player != NULL) && (player == s_currentPlayer))
+	{
+		if (__atomic_load_n(&player->nextPosted, __ATOMIC_RELAXED))
+		{
+			started = true;
+		}
+		else
+		{
+			(void)pthread_mutex_lock(&s_nextMutex);
+			started = (s_nextInfo.path != NULL);
+			(void)pthread_mutex_unlock(&s_nextMutex);
+
+			if (started)
+			{
+				INFO_PRINTF("next track of playID(%d) requested\n", player->avPlayer.playID);
+				__atomic_store_n(&player->nextPosted, true, __ATOMIC_RELAXED);
+				__atomic_store_n(&s_nextRequestID, player->avPlayer.playID, __ATOMIC_RELAXED);
+				__atomic_store_n(&s_nextRequested, true, __ATOMIC_RELEASE);
+			}
+		}
+	}
+	(void)pthread_mutex_unlock(&s_stopMutex);
+
+	return started;
+}
+
 static void StartPlayTimeThread(void)
 {
 	int32_t err;
@@ -1659,11 +2751,16 @@ static void StartPlayTimeThread(void)
 	DEBUG_PRINTF("\n");
 	(void)pthread_mutex_lock(&s_timeMutex);
 
+	(void)pthread_mutex_lock(&s_positionMutex);
 	s_playtimeRun = true;
+	s_lastPosition = -1;
+	(void)pthread_mutex_unlock(&s_positionMutex);
 	err = pthread_create(&s_playtimeThread, NULL, PlayTimeThread, NULL);
 	if (err != 0)
 	{
+		(void)pthread_mutex_lock(&s_positionMutex);
 		s_playtimeRun = false;
+		(void)pthread_mutex_unlock(&s_positionMutex);
 		ERROR_PRINTF("create PlayTime thread failed: error(%d)\n", err);
 	}
 
@@ -1679,7 +2776,10 @@ static void StopPlayTimeThread(void)
 	{
 		void *res;
 		int32_t err;
+		(void)pthread_mutex_lock(&s_positionMutex);
 		s_playtimeRun = false;
+		(void)pthread_cond_broadcast(&s_positionCond);
+		(void)pthread_mutex_unlock(&s_positionMutex);
 		err = pthread_join(s_playtimeThread, &res);
 		if (err != 0)
 		{
@@ -1805,8 +2905,13 @@ static void SetAVSync(bool sink)
 			g_object_set(s_currentPlayer->avPlayer.videoSink, "sync", sink ? TRUE : FALSE, NULL);
 		}
 
-		INFO_PRINTF("Set auidosink : %d\n", sink);
-		g_object_set(s_currentPlayer->avPlayer.audioSink, "sync", sink ? TRUE : FALSE, NULL);
+		/* a crossfade input has no sync, the mixer paces it */
+		if ((s_currentPlayer->avPlayer.audioSink != NULL) &&
+			(g_object_class_find_property(G_OBJECT_GET_CLASS(s_currentPlayer->avPlayer.audioSink), "sync") != NULL))
+		{
+			INFO_PRINTF("Set auidosink : %d\n", sink);
+			g_object_set(s_currentPlayer->avPlayer.audioSink, "sync", sink ? TRUE : FALSE, NULL);
+		}
 
 		(void)pthread_mutex_unlock(&s_mutex);
 
@@ -1822,7 +2927,7 @@ static void UpdateVideoDisplay(bool update)
 	
 	if (s_currentPlayer != NULL)
 	{
-		if ((s_currentPlayer->avPlayer.video) && (s_currentPlayer->avPlayer.videoSink != NULL))
+		if ((s_currentPlayer->avPlayer.video) && (s_currentPlayer->avPlayer.videoSink != NULL) && (s_videoSinkOverlay))
 		{
 			(void)pthread_mutex_lock(&s_mutex);
 
@@ -1850,7 +2955,7 @@ static void UpdateDualVideoDisplay(void)
 
 	if (s_currentPlayer != NULL)
 	{
-		if ((s_currentPlayer->avPlayer.video) && (s_currentPlayer->avPlayer.videoSink != NULL))
+		if ((s_currentPlayer->avPlayer.video) && (s_currentPlayer->avPlayer.videoSink != NULL) && (s_videoSinkOverlay))
 		{
 			(void)pthread_mutex_lock(&s_mutex);
 
@@ -1889,6 +2994,7 @@ static void SetForward(MultiMediaPlayer *player, gint64 position, gdouble speed)
 			{
 				s_currentPlayer->backward = false;
 				s_currentPlayer->fastforward = true;
+				MultiMediaStateSetPlayback(MultiMediaPlaybackTrick, speed);
 			}
 			else
 			{
@@ -1928,6 +3034,7 @@ static void SetBackward(MultiMediaPlayer *player, gint64 position, gdouble speed
 			{
 				player->backward = true;
 				player->fastforward = false;
+				MultiMediaStateSetPlayback(MultiMediaPlaybackTrick, -speed);
 			}
 			else
 			{
@@ -2043,9 +3150,8 @@ static void ProcessGstErrorMessage(GstMessage *errorMsg, int32_t playID)
 
 static void *PlayTimeThread(void *arg)
 {
-	while (s_playtimeRun)
+	while (WaitPlayTime())
 	{
-		usleep(250000);
 		MultiMediaPlayer *pPlayer = s_currentPlayer;
 
 		if (pPlayer != NULL)
@@ -2066,6 +3172,7 @@ static void *PlayTimeThread(void *arg)
 					min %= 60;
 
 					pPlayer->getduration = true;
+					MultiMediaStateSetDuration(duration);
 					if (MultiMediaTotalTimeChangeCB != NULL)
 					{
 						MultiMediaTotalTimeChangeCB(hour, min, sec, pPlayer->avPlayer.playID);
@@ -2081,6 +3188,7 @@ static void *PlayTimeThread(void *arg)
 			{
 				int64_t hour, min, sec, prevSec;
 				bool update;
+				MultiMediaStateSetPosition(pos);
 				sec = (int32_t)GST_TIME_AS_SECONDS(pos);
 				prevSec = (int32_t)GST_TIME_AS_SECONDS(pPlayer->position);
 
@@ -2111,6 +3219,12 @@ static void *PlayTimeThread(void *arg)
 					}
 					pPlayer->position = pos;
 				}
+
+				if ((pos != s_lastPosition) && (MultiMediaPositionChangeCB != NULL))
+				{
+					MultiMediaPositionChangeCB((uint32_t)GST_TIME_AS_MSECONDS(pos), pPlayer->avPlayer.playID);
+				}
+				s_lastPosition = pos;
 			}
 		}
 	}	
@@ -2119,13 +3233,76 @@ static void *PlayTimeThread(void *arg)
 	pthread_exit((void *)"update play time thread exit\n");
 }
 
+static bool WaitPlayTime(void)
+{
+	struct timespec deadline;
+	const MultiMediaPlayer *pPlayer = s_currentPlayer;
+	uint32_t interval;
+	uint32_t generation;
+	int32_t err = 0;
+	bool run;
+
+	(void)pthread_mutex_lock(&s_positionMutex);
+	interval = s_positionInterval;
+	generation = s_positionGeneration;
+
+	if ((interval == 0U) && ((pPlayer == NULL) || pPlayer->getduration))
+	{
+		/* nobody follows the position, sleep until an interval is set */
+		while (s_playtimeRun && (s_positionInterval == 0U))
+		{
+			(void)pthread_cond_wait(&s_positionCond, &s_positionMutex);
+		}
+	}
+	else
+	{
+		if (interval == 0U)
+		{
+			/* keep polling for the duration only */
+			interval = MULTIMEDIA_POSITION_INTERVAL_DEFAULT;
+		}
+		(void)clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += (time_t)(interval / 1000U);
+		deadline.tv_nsec += (long)(interval % 1000U) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+
+		/* a new interval applies at once instead of after the current one */
+		while (s_playtimeRun && (err != ETIMEDOUT) && (generation == s_positionGeneration))
+		{
+			err = pthread_cond_timedwait(&s_positionCond, &s_positionMutex, &deadline);
+		}
+	}
+	run = s_playtimeRun;
+	(void)pthread_mutex_unlock(&s_positionMutex);
+
+	return run;
+}
+
 static void *MediaStartThread(void *arg)
 {
+	TCTimeSpan commandSpan = {0};
+
 	while (s_mediastartRun)
 	{
 		usleep(1000);
 		(void)pthread_mutex_lock(&s_cmdMutex);
 
+		if (s_currentCmd != TotalMultiMediaCommands)
+		{
+			MEDIAPLAYBACK_TRACE(Command, s_currentCmd, s_playInfo.id, 0, 0);
+			TCTimeSpanBegin(&commandSpan, TCTimeSpanCommand, s_playInfo.id);
+		}
+
+		/* a user command goes first, the request waits for the next turn */
+		if ((s_currentCmd == TotalMultiMediaCommands) && __atomic_exchange_n(&s_nextRequested, false, __ATOMIC_ACQUIRE))
+		{
+			ProcessNextRequest(__atomic_load_n(&s_nextRequestID, __ATOMIC_RELAXED));
+		}
+
 		switch (s_currentCmd)
 		{
 			case MultiMediaCommandPlay:
@@ -2164,6 +3341,7 @@ static void *MediaStartThread(void *arg)
 			default:
 				break;
 		}
+		(void)TCTimeSpanEnd(&commandSpan);
 		
 		s_currentCmd = TotalMultiMediaCommands;
 		
@@ -2185,6 +3363,17 @@ static void ReleasePlayInfo(void)
 	}
 }
 
+static void ReleaseNextInfo(void)
+{
+	(void)pthread_mutex_lock(&s_nextMutex);
+	if (s_nextInfo.path != NULL)
+	{
+		free(s_nextInfo.path);
+		s_nextInfo.path = NULL;
+	}
+	(void)pthread_mutex_unlock(&s_nextMutex);
+}
+
 static char *CloneString(const char *string)
 {
 	char *clone = NULL;
@@ -2211,24 +3400,99 @@ static void ProcessPlayStart(const char *path, uint8_t hour, uint8_t min, uint8_
 	{
 		bool ret;
 
+		TCTimeSpanBegin(&s_prerollSpan, TCTimeSpanPreroll, playID);
+		MultiMediaLatencyArm(MultiMediaLatencyPlay, playID, s_playInfo.received);
 		ret = MultiMediaPlayStart(path, hour, min, sec, video, playID, keepPause);
-		if(ret == true)
-		{
-			SetCurrentTime();
-		}
-		else
+		if(ret == false)
 		{
+			TCTimeSpanCancel(&s_prerollSpan);
+			MultiMediaLatencyCancel();
 			MultiMediaSetResourceStatus(0);
 			MultiMediaErrorOccurred(-1, playID);
 		}
 	}
 }
 
+/* under s_cmdMutex: the next track follows playID if that is still the current track */
+static void ProcessNextRequest(int32_t playID)
+{
+	PlayInfo next;
+
+	(void)pthread_mutex_lock(&s_nextMutex);
+	next = s_nextInfo;
+	s_nextInfo.path = NULL;
+	(void)pthread_mutex_unlock(&s_nextMutex);
+
+	if ((s_currentPlayer != NULL) && (s_currentPlayer->avPlayer.playID == playID) && (next.path != NULL))
+	{
+		INFO_PRINTF("next track of playID(%d): ID(%d), PATH(%s)\n", playID, next.id, next.path);
+
+		ReleasePlayInfo();
+		s_playInfo.content = next.content;
+		s_playInfo.path = next.path;
+		s_playInfo.hour = 0;
+		s_playInfo.min = 0;
+		s_playInfo.sec = 0;
+		s_playInfo.id = next.id;
+		s_playInfo.keepPause = 0;
+		s_playInfo.received = TCTimeGetMonotonicNs();
+
+		ProcessPlayNext(s_playInfo.path, (s_playInfo.content == MultiMediaContentTypeVideo), s_playInfo.id);
+	}
+	else
+	{
+		if ((s_currentPlayer != NULL) && (s_currentPlayer->avPlayer.playID == playID))
+		{
+			/* cleared meanwhile, the end of the track is reported again */
+			__atomic_store_n(&s_currentPlayer->nextPosted, false, __ATOMIC_RELAXED);
+		}
+
+		/* a track the user stopped or replaced meanwhile keeps the next one queued */
+		if (next.path != NULL)
+		{
+			(void)pthread_mutex_lock(&s_nextMutex);
+			if (s_nextInfo.path == NULL)
+			{
+				s_nextInfo = next;
+			}
+			else
+			{
+				free(next.path);
+			}
+			(void)pthread_mutex_unlock(&s_nextMutex);
+		}
+	}
+}
+
+/* the current track ended, it is handed to the crossfade mixer if it plays there */
+static void ProcessPlayNext(const char *path, bool video, int32_t playID)
+{
+	DEBUG_PRINTF("\n");
+
+	/* nothing follows a track the user stopped meanwhile */
+	if (s_currentPlayer != NULL)
+	{
+		if (video || (!HandOffPlayer(&s_currentPlayer)))
+		{
+			s_currentPlayer->userStop = true;
+			StopPlayer(&s_currentPlayer);
+		}
+
+		MultiMediaSetResourceStatus(1);
+		ProcessPlayStart(path, 0, 0, 0, video, playID, 0);
+	}
+}
+
 static void ProcessPlayStop(void)
 {
 
 	DEBUG_PRINTF("\n");
 
+	/* a stopped pipeline never prerolls for them */
+	TCTimeSpanCancel(&s_prerollSpan);
+	TCTimeSpanCancel(&s_seekSpan);
+	MultiMediaLatencyCancel();
+
 	if (s_currentPlayer != NULL)
 	{
 		s_currentPlayer->userStop = true;
@@ -2239,6 +3503,7 @@ static void ProcessPlayStop(void)
 	else
 	{
 		MultiMediaSetResourceStatus(0);
+		MultiMediaStateSetPlayback(MultiMediaPlaybackStopped, 1.0);
 		if (MultiMediaPlayStoppedCB != NULL)
 		{
 			MultiMediaPlayStoppedCB(-1);
@@ -2270,6 +3535,14 @@ static void ProcessPlayResume(void)
 	DEBUG_PRINTF("\n");
 	if (s_currentPlayer != NULL)
 	{
+		/* the buffers prerolled while paused are the first ones rendered */
+		MultiMediaLatencyArm(MultiMediaLatencyResume, s_currentPlayer->avPlayer.playID, s_playInfo.received);
+		MultiMediaLatencyBuffer(MultiMediaLatencyAudio, s_currentPlayer->avPlayer.playID, false);
+		if (s_currentPlayer->avPlayer.videoSink != NULL)
+		{
+			MultiMediaLatencyBuffer(MultiMediaLatencyVideo, s_currentPlayer->avPlayer.playID, false);
+		}
+
 		if (ChangePlayerState(s_currentPlayer->avPlayer.playbin, GST_STATE_PLAYING))
 		{
 			s_currentPlayer->backward = false;
@@ -2313,6 +3586,7 @@ static void ProcessPlayNormal(void)
 				{
 					s_currentPlayer->backward = false;
 					s_currentPlayer->fastforward = false;
+					MultiMediaStateSetPlayback(MultiMediaPlaybackPlaying, 1.0);
 				}
 				else
 				{
@@ -2434,13 +3708,21 @@ static void ProcessPlaySeek(uint8_t hour, uint8_t min, uint8_t sec)
 		(void)pthread_mutex_lock(&s_mutex);
 		if(s_currentPlayer->seek_enabled)
 		{
+			TCTimeSpanBegin(&s_seekSpan, TCTimeSpanSeek, s_currentPlayer->avPlayer.playID);
 			if (gst_element_seek_simple(s_currentPlayer->avPlayer.playbin, GST_FORMAT_TIME, (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT), position))
 			{
+				/* the flush is done, so the next buffer in a sink is from the new position */
+				MultiMediaLatencyArm(MultiMediaLatencySeek, s_currentPlayer->avPlayer.playID, s_playInfo.received);
+				MultiMediaStateSetPosition(position);
 				if (MultiMediaSeekCompletedCB != NULL)
 				{
 					MultiMediaSeekCompletedCB(hour,min,sec, s_currentPlayer->avPlayer.playID);
 				}
 			}
+			else
+			{
+				TCTimeSpanCancel(&s_seekSpan);
+			}
 		}
 		else
 		{
@@ -2452,66 +3734,6 @@ static void ProcessPlaySeek(uint8_t hour, uint8_t min, uint8_t sec)
 	}
 }
 
-static int32_t SharedMemoryInitialize(void)
-{
-	int32_t ret = 0;
-	int32_t shm_id;
-	void *shm_addr;
-
-	shm_id = shmget((key_t)KEY_NUM, (size_t)MEM_SIZE, 0666 |IPC_CREAT);
-
-	if(shm_id == -1)
-	{
-		ERROR_PRINTF("shmget failed\n");
-		ret = -1;
-	}
-	else
-	{
-		s_shm_id = shm_id;
-		shm_addr = shmat(shm_id, (void *)0, 0);
-		if(shm_addr == (void *)-1)
-		{
-			ERROR_PRINTF("shmat failed\n");
-			ret = -1;
-		}
-		else
-		{
-			s_shm_addr = shm_addr;
-		}
-	}
-	return ret;
-}
-
-static int32_t SharedMemoryRelease(void)
-{
-	int32_t ret = 0;
-	void *shm_addr;
-	int32_t shm_id, shm_dt, shm_ctl;
-	shm_addr = s_shm_addr;
-	shm_id = s_shm_id;
-	shm_dt = shmdt(shm_addr);
-	if(shm_dt == -1)
-	{
-		ERROR_PRINTF("failed distribute shared memory\n");
-		ret = -1;
-	}
-	else
-	{
-		shm_ctl = shmctl(shm_id, IPC_RMID, 0);
-		if(shm_ctl == -1)
-		{
-			ERROR_PRINTF("failed remove shared momory \n");
-			ret = -1;
-		}
-		else
-		{
-			s_shm_id = 0;
-			s_shm_addr = NULL;
-		}
-	}
-	return ret;
-}
-
 int32_t getCurrentPlayID(void)
 {
 	int32_t ret = 0;
@@ -0,0 +1,740 @@
+/****************************************************************************************
+ *   FileName    : MultiMediaPipelineStats.c
+ *   Description : Telechips Multimedia Pipeline Statistics
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include "TCLog.h"
+#include "TCTime.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MultiMediaPipelineStats.h"
+
+#define PIPELINE_STATS_PATH_SIZE		256
+#define PIPELINE_STATS_MAX_INTERVAL		3600
+#define PIPELINE_STATS_GAP				(20 * GST_MSECOND)	/* audio timestamps further apart are a discontinuity */
+#define PIPELINE_STATS_PROBES			(MULTIMEDIA_PIPELINE_STATS_ELEMENTS * 4)
+
+typedef struct stPipelineElement {
+	MultiMediaElementStats stats;	/* counters are updated with atomics by the streaming threads */
+	GstElement *element;			/* referenced until the pipeline is detached */
+	int64_t lastIn;					/* monotonic ns a buffer came in, 0 once it went out */
+	uint32_t queueIn;
+	uint32_t queueOut;
+	/* audio sinks, only used by their streaming thread */
+	GstSegment segment;
+	GstClockTime next;
+	bool late;
+} PipelineElement;
+
+typedef struct stPipelineProbe {
+	GstPad *pad;					/* referenced, the element may go before the pipeline is detached */
+	gulong id;
+} PipelineProbe;
+
+static void OnElementAdded(GstBin *bin, GstBin *parent, GstElement *element, gpointer data);
+static MultiMediaElementKind GetElementKind(GstElement *element, const gchar *factory);
+static gboolean AddPadProbe(GstElement *element, GstPad *pad, gpointer data);
+static void OnPadAdded(GstElement *element, GstPad *pad, gpointer data);
+static void OnQueueOverrun(GstElement *element, gpointer data);
+static void OnQueueUnderrun(GstElement *element, gpointer data);
+static GstPadProbeReturn SinkPadProbe(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+static GstPadProbeReturn SrcPadProbe(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+static void CheckAudioBuffer(PipelineElement *record, GstBuffer *buffer);
+static void GetBufferSize(GstPadProbeInfo *info, uint32_t *buffers, uint64_t *bytes, GstBuffer **first);
+static PipelineElement *FindElement(GstObject *object);
+static bool IsAttached(const PipelineElement *record, const GstElement *element);
+static void RemoveProbes(void);
+static void CountElement(uint32_t *counter);
+static void UpdateMax(uint32_t *max, uint32_t value);
+static void CopyElement(const PipelineElement *record, MultiMediaElementStats *stats);
+static gboolean OnWriteTimer(gpointer data);
+static void WriteFile(void);
+
+#define MULTIMEDIA_ELEMENT_KIND_NAME(name, text)		text,
+const char *g_multiMediaElementKindNames[TotalMultiMediaElementKinds] = {
+	MULTIMEDIA_ELEMENT_KIND_LIST(MULTIMEDIA_ELEMENT_KIND_NAME)
+};
+
+static pthread_mutex_t s_statsMutex = PTHREAD_MUTEX_INITIALIZER;
+static PipelineElement s_elements[MULTIMEDIA_PIPELINE_STATS_ELEMENTS];
+static uint32_t s_elementCount = 0;		/* published with release once an entry is complete */
+static MultiMediaPipelineStats s_pipeline;
+static int64_t s_started = 0;
+static int64_t s_stopped = 0;
+static bool s_buffering = false;
+/* the pipeline whose elements are in s_elements, NULL once it is detached */
+static GstElement *s_attached = NULL;
+static PipelineProbe s_probes[PIPELINE_STATS_PROBES];
+static uint32_t s_probeCount = 0;
+
+static char s_path[PIPELINE_STATS_PATH_SIZE];
+static uint32_t s_interval = MULTIMEDIA_PIPELINE_STATS_DEFAULT_INTERVAL;
+static guint s_writeTimer = 0;
+
+int32_t MultiMediaPipelineStatsSetFile(const char *path)
+{
+	int32_t ret = 0;
+
+	if ((path != NULL) && (path[0] != '\0') && (strlen(path) < sizeof(s_path)))
+	{
+		(void)strncpy(s_path, path, sizeof(s_path) - 1U);
+		ret = 1;
+	}
+	else
+	{
+		ERROR_PRINTF("invalid pipeline statistics file(%s)\n", (path != NULL) ? path : "null");
+	}
+
+	return ret;
+}
+
+int32_t MultiMediaPipelineStatsSetInterval(const char *seconds)
+{
+	int32_t ret = 0;
+	unsigned long interval = 0;
+
+	if (seconds != NULL)
+	{
+		interval = strtoul(seconds, NULL, 10);
+	}
+
+	if ((interval > 0UL) && (interval <= (unsigned long)PIPELINE_STATS_MAX_INTERVAL))
+	{
+		s_interval = (uint32_t)interval;
+		ret = 1;
+	}
+	else
+	{
+		ERROR_PRINTF("invalid pipeline statistics interval(%s), 1 to %d seconds\n",
+					 (seconds != NULL) ? seconds : "null", PIPELINE_STATS_MAX_INTERVAL);
+	}
+
+	return ret;
+}
+
+void MultiMediaPipelineStatsInitialize(void)
+{
+	if ((s_path[0] != '\0') && (s_writeTimer == 0U))
+	{
+		INFO_PRINTF("pipeline statistics to %s every %u s\n", s_path, s_interval);
+		s_writeTimer = g_timeout_add_seconds(s_interval, OnWriteTimer, NULL);
+	}
+}
+
+void MultiMediaPipelineStatsRelease(void)
+{
+	if (s_writeTimer != 0U)
+	{
+		(void)g_source_remove(s_writeTimer);
+		s_writeTimer = 0;
+		WriteFile();
+	}
+}
+
+void MultiMediaPipelineStatsAttach(GstElement *pipeline, int32_t playID)
+{
+	(void)pthread_mutex_lock(&s_statsMutex);
+	/* none of the probes and handlers of the previous pipeline may write into the reused records */
+	RemoveProbes();
+	s_attached = GST_ELEMENT(gst_object_ref(pipeline));
+	__atomic_store_n(&s_elementCount, 0U, __ATOMIC_RELEASE);
+	(void)memset(s_elements, 0, sizeof(s_elements));
+	(void)memset(&s_pipeline, 0, sizeof(s_pipeline));
+	s_pipeline.playID = playID;
+	s_started = TCTimeGetMonotonicNs();
+	s_stopped = 0;
+	s_buffering = false;
+	(void)pthread_mutex_unlock(&s_statsMutex);
+
+	(void)g_signal_connect(pipeline, "deep-element-added", G_CALLBACK(OnElementAdded), NULL);
+}
+
+void MultiMediaPipelineStatsDetach(void)
+{
+	/* a handed off pipeline streams on, its counters stay as they were */
+	(void)pthread_mutex_lock(&s_statsMutex);
+	RemoveProbes();
+	if ((s_started != 0) && (s_stopped == 0))
+	{
+		s_stopped = TCTimeGetMonotonicNs();
+	}
+	(void)pthread_mutex_unlock(&s_statsMutex);
+}
+
+void MultiMediaPipelineStatsMessage(GstMessage *msg)
+{
+	PipelineElement *record = FindElement(GST_MESSAGE_SRC(msg));
+	const gchar *name = (GST_MESSAGE_SRC(msg) != NULL) ? GST_OBJECT_NAME(GST_MESSAGE_SRC(msg)) : "";
+
+	switch (GST_MESSAGE_TYPE(msg))
+	{
+		case GST_MESSAGE_QOS:
+		{
+			GstFormat format;
+			guint64 processed;
+			guint64 dropped;
+
+			/* posted for every buffer an element dropped or rendered late */
+			gst_message_parse_qos_stats(msg, &format, &processed, &dropped);
+			if (record != NULL)
+			{
+				CountElement(&record->stats.late);
+				if ((format != GST_FORMAT_UNDEFINED) && (dropped != (guint64)-1))
+				{
+					__atomic_store_n(&record->stats.dropped, (uint32_t)dropped, __ATOMIC_RELAXED);
+				}
+			}
+			DEBUG_PRINTF("QoS from %s: processed(%llu), dropped(%llu)\n", name,
+						 (unsigned long long)processed, (unsigned long long)dropped);
+			break;
+		}
+		case GST_MESSAGE_WARNING:
+		{
+			GError *error = NULL;
+			gchar *debug = NULL;
+
+			gst_message_parse_warning(msg, &error, &debug);
+			WARN_PRINTF("%s: %s (%s)\n", name, (error != NULL) ? error->message : "",
+						(debug != NULL) ? debug : "");
+			if (record != NULL)
+			{
+				CountElement(&record->stats.warnings);
+			}
+			CountElement(&s_pipeline.warnings);
+			if (error != NULL)
+			{
+				g_error_free(error);
+			}
+			g_free(debug);
+			break;
+		}
+		case GST_MESSAGE_BUFFERING:
+		{
+			gint percent = 100;
+
+			gst_message_parse_buffering(msg, &percent);
+			if ((percent < 100) && (s_buffering == false))
+			{
+				INFO_PRINTF("buffering(%d%%)\n", percent);
+				CountElement(&s_pipeline.buffering);
+			}
+			s_buffering = (percent < 100);
+			break;
+		}
+		case GST_MESSAGE_CLOCK_LOST:
+		{
+			WARN_PRINTF("pipeline clock lost\n");
+			CountElement(&s_pipeline.clockLost);
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+}
+
+uint32_t MultiMediaPipelineStatsGet(MultiMediaPipelineStats *pipeline, MultiMediaElementStats *elements, uint32_t count)
+{
+	uint32_t available = __atomic_load_n(&s_elementCount, __ATOMIC_ACQUIRE);
+	uint32_t idx;
+
+	(void)pthread_mutex_lock(&s_statsMutex);
+	pipeline->playID = s_pipeline.playID;
+	pipeline->elapsed = (s_started == 0) ? 0U :
+						(uint32_t)((((s_stopped != 0) ? s_stopped : TCTimeGetMonotonicNs()) - s_started) / 1000000);
+	pipeline->elements = __atomic_load_n(&s_pipeline.elements, __ATOMIC_RELAXED);
+	pipeline->warnings = __atomic_load_n(&s_pipeline.warnings, __ATOMIC_RELAXED);
+	pipeline->clockLost = __atomic_load_n(&s_pipeline.clockLost, __ATOMIC_RELAXED);
+	pipeline->buffering = __atomic_load_n(&s_pipeline.buffering, __ATOMIC_RELAXED);
+	(void)pthread_mutex_unlock(&s_statsMutex);
+
+	if (available > count)
+	{
+		available = count;
+	}
+	for (idx = 0; idx < available; idx++)
+	{
+		CopyElement(&s_elements[idx], &elements[idx]);
+	}
+
+	return available;
+}
+
+static void OnElementAdded(GstBin *bin, GstBin *parent, GstElement *element, gpointer data)
+{
+	GstElementFactory *factory = gst_element_get_factory(element);
+	const gchar *factoryName = (factory != NULL) ? gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : "";
+	PipelineElement *record = NULL;
+	uint32_t count;
+
+	(void)parent;
+	(void)data;
+
+	/* the children of a bin are added on their own */
+	(void)pthread_mutex_lock(&s_statsMutex);
+	if ((!GST_IS_BIN(element)) && (bin == (GstBin *)s_attached))
+	{
+		CountElement(&s_pipeline.elements);
+		count = __atomic_load_n(&s_elementCount, __ATOMIC_RELAXED);
+		if (count < (uint32_t)MULTIMEDIA_PIPELINE_STATS_ELEMENTS)
+		{
+			record = &s_elements[count];
+			record->element = GST_ELEMENT(gst_object_ref(element));
+			(void)strncpy(record->stats.name, GST_OBJECT_NAME(element), sizeof(record->stats.name) - 1U);
+			(void)strncpy(record->stats.factory, factoryName, sizeof(record->stats.factory) - 1U);
+			record->stats.kind = (uint32_t)GetElementKind(element, factoryName);
+			gst_segment_init(&record->segment, GST_FORMAT_UNDEFINED);
+			record->next = GST_CLOCK_TIME_NONE;
+			__atomic_store_n(&s_elementCount, count + 1U, __ATOMIC_RELEASE);
+		}
+	}
+
+	/* probes and handlers are added under the mutex, so detaching removes all of them */
+	if (record != NULL)
+	{
+		DEBUG_PRINTF("%s(%s) is a %s\n", record->stats.name, record->stats.factory,
+					 g_multiMediaElementKindNames[record->stats.kind]);
+		(void)gst_element_foreach_pad(element, AddPadProbe, record);
+		(void)g_signal_connect(element, "pad-added", G_CALLBACK(OnPadAdded), record);
+		if (g_signal_lookup("overrun", G_OBJECT_TYPE(element)) != 0U)
+		{
+			(void)g_signal_connect(element, "overrun", G_CALLBACK(OnQueueOverrun), record);
+		}
+		if (g_signal_lookup("underrun", G_OBJECT_TYPE(element)) != 0U)
+		{
+			(void)g_signal_connect(element, "underrun", G_CALLBACK(OnQueueUnderrun), record);
+		}
+	}
+	(void)pthread_mutex_unlock(&s_statsMutex);
+}
+
+static MultiMediaElementKind GetElementKind(GstElement *element, const gchar *factory)
+{
+	GstElementFactory *elementFactory = gst_element_get_factory(element);
+	const gchar *klass = (elementFactory != NULL) ?
+						 gst_element_factory_get_metadata(elementFactory, GST_ELEMENT_METADATA_KLASS) : NULL;
+	MultiMediaElementKind kind = MultiMediaElementFilter;
+
+	if ((strcmp(factory, "queue") == 0) || (strcmp(factory, "queue2") == 0) || (strcmp(factory, "multiqueue") == 0))
+	{
+		kind = MultiMediaElementQueue;
+	}
+	else if (klass == NULL)
+	{
+		;
+	}
+	else if (strstr(klass, "Decoder") != NULL)
+	{
+		kind = MultiMediaElementDecoder;
+	}
+	else if ((strstr(klass, "Sink") != NULL) && (strstr(klass, "Audio") != NULL))
+	{
+		kind = MultiMediaElementAudioSink;
+	}
+	else if ((strstr(klass, "Sink") != NULL) && (strstr(klass, "Video") != NULL))
+	{
+		kind = MultiMediaElementVideoSink;
+	}
+	else
+	{
+		;
+	}
+
+	return kind;
+}
+
+/* called with s_statsMutex */
+static gboolean AddPadProbe(GstElement *element, GstPad *pad, gpointer data)
+{
+	gulong id = 0;
+
+	(void)element;
+
+	if (s_probeCount >= (uint32_t)PIPELINE_STATS_PROBES)
+	{
+		DEBUG_PRINTF("no statistics for %s, too many pads\n", GST_OBJECT_NAME(pad));
+	}
+	else if (GST_PAD_DIRECTION(pad) == GST_PAD_SINK)
+	{
+		id = gst_pad_add_probe(pad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST |
+													  GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH),
+							   SinkPadProbe, data, NULL);
+	}
+	else if (GST_PAD_DIRECTION(pad) == GST_PAD_SRC)
+	{
+		id = gst_pad_add_probe(pad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+							   SrcPadProbe, data, NULL);
+	}
+	else
+	{
+		;
+	}
+
+	if (id != 0UL)
+	{
+		s_probes[s_probeCount].pad = GST_PAD(gst_object_ref(pad));
+		s_probes[s_probeCount].id = id;
+		s_probeCount++;
+	}
+
+	return TRUE;
+}
+
+static void OnPadAdded(GstElement *element, GstPad *pad, gpointer data)
+{
+	(void)pthread_mutex_lock(&s_statsMutex);
+	if (IsAttached((const PipelineElement *)data, element))
+	{
+		(void)AddPadProbe(element, pad, data);
+	}
+	(void)pthread_mutex_unlock(&s_statsMutex);
+}
+
+static void OnQueueOverrun(GstElement *element, gpointer data)
+{
+	(void)element;
+	CountElement(&((PipelineElement *)data)->stats.overruns);
+}
+
+static void OnQueueUnderrun(GstElement *element, gpointer data)
+{
+	(void)element;
+	CountElement(&((PipelineElement *)data)->stats.underruns);
+}
+
+static GstPadProbeReturn SinkPadProbe(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+	PipelineElement *record = (PipelineElement *)data;
+	uint32_t buffers = 0;
+	uint64_t bytes = 0;
+	GstBuffer *first = NULL;
+	uint32_t queued;
+
+	(void)pad;
+
+	if ((GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_BOTH) != 0)
+	{
+		GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+
+		if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP)
+		{
+			/* a flushed queue is empty */
+			__atomic_store_n(&record->queueOut, __atomic_load_n(&record->queueIn, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+			record->next = GST_CLOCK_TIME_NONE;
+			record->late = false;
+		}
+		else if ((GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) && (record->stats.kind == (uint32_t)MultiMediaElementAudioSink))
+		{
+			gst_event_copy_segment(event, &record->segment);
+			record->next = GST_CLOCK_TIME_NONE;
+			record->late = false;
+		}
+		else
+		{
+			;
+		}
+	}
+	else
+	{
+		GetBufferSize(info, &buffers, &bytes, &first);
+		(void)__atomic_fetch_add(&record->stats.bytes, bytes, __ATOMIC_RELAXED);
+
+		switch ((MultiMediaElementKind)record->stats.kind)
+		{
+			case MultiMediaElementQueue:
+				queued = __atomic_add_fetch(&record->queueIn, buffers, __ATOMIC_RELAXED) -
+						 __atomic_load_n(&record->queueOut, __ATOMIC_RELAXED);
+				UpdateMax(&record->stats.levelMax, queued);
+				break;
+			case MultiMediaElementAudioSink:
+				(void)__atomic_fetch_add(&record->stats.buffers, buffers, __ATOMIC_RELAXED);
+				if (first != NULL)
+				{
+					CheckAudioBuffer(record, first);
+				}
+				break;
+			case MultiMediaElementVideoSink:
+				(void)__atomic_fetch_add(&record->stats.buffers, buffers, __ATOMIC_RELAXED);
+				break;
+			default:
+				__atomic_store_n(&record->lastIn, TCTimeGetMonotonicNs(), __ATOMIC_RELAXED);
+				break;
+		}
+	}
+
+	return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn SrcPadProbe(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+	PipelineElement *record = (PipelineElement *)data;
+	uint32_t buffers = 0;
+	uint64_t bytes = 0;
+	int64_t in;
+	uint32_t process;
+
+	(void)pad;
+
+	GetBufferSize(info, &buffers, &bytes, NULL);
+	(void)__atomic_fetch_add(&record->stats.buffers, buffers, __ATOMIC_RELAXED);
+
+	if (record->stats.kind == (uint32_t)MultiMediaElementQueue)
+	{
+		(void)__atomic_fetch_add(&record->queueOut, buffers, __ATOMIC_RELAXED);
+	}
+	else
+	{
+		/* pushed from the chain function of the buffer that came in, the rest of its outputs are not timed */
+		in = __atomic_exchange_n(&record->lastIn, 0, __ATOMIC_RELAXED);
+		if (in != 0)
+		{
+			process = (uint32_t)((TCTimeGetMonotonicNs() - in) / 1000);
+			(void)__atomic_fetch_add(&record->stats.processSum, (uint64_t)process, __ATOMIC_RELAXED);
+			UpdateMax(&record->stats.processMax, process);
+		}
+	}
+
+	return GST_PAD_PROBE_OK;
+}
+
+static void CheckAudioBuffer(PipelineElement *record, GstBuffer *buffer)
+{
+	GstClockTime timestamp = GST_BUFFER_PTS(buffer);
+	GstClockTime duration = GST_BUFFER_DURATION(buffer);
+	GstClockTime running;
+	GstClockTime now;
+	GstClock *clock;
+	bool late = false;
+
+	if (GST_CLOCK_TIME_IS_VALID(timestamp))
+	{
+		if (GST_CLOCK_TIME_IS_VALID(record->next) &&
+			(GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DISCONT) ||
+			 (timestamp > (record->next + PIPELINE_STATS_GAP)) || ((timestamp + PIPELINE_STATS_GAP) < record->next)))
+		{
+			CountElement(&record->stats.discontinuities);
+		}
+		record->next = GST_CLOCK_TIME_IS_VALID(duration) ? (timestamp + duration) : GST_CLOCK_TIME_NONE;
+
+		/* data that comes after its play time was needed by the ring buffer, which played silence */
+		clock = (GST_STATE(record->element) == GST_STATE_PLAYING) ? gst_element_get_clock(record->element) : NULL;
+		if ((clock != NULL) && (record->segment.format == GST_FORMAT_TIME))
+		{
+			running = gst_segment_to_running_time(&record->segment, GST_FORMAT_TIME, timestamp);
+			now = gst_clock_get_time(clock) - gst_element_get_base_time(record->element);
+			late = GST_CLOCK_TIME_IS_VALID(running) && ((running + (GST_CLOCK_TIME_IS_VALID(duration) ? duration : 0U)) < now);
+		}
+		if (clock != NULL)
+		{
+			gst_object_unref(clock);
+		}
+
+		if (late && (record->late == false))
+		{
+			CountElement(&record->stats.underruns);
+		}
+		record->late = late;
+	}
+}
+
+static void GetBufferSize(GstPadProbeInfo *info, uint32_t *buffers, uint64_t *bytes, GstBuffer **first)
+{
+	if ((GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) != 0)
+	{
+		GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+
+		*buffers = gst_buffer_list_length(list);
+		*bytes = (uint64_t)gst_buffer_list_calculate_size(list);
+		if ((first != NULL) && (*buffers > 0U))
+		{
+			*first = gst_buffer_list_get(list, 0);
+		}
+	}
+	else
+	{
+		GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+
+		*buffers = 1;
+		*bytes = (uint64_t)gst_buffer_get_size(buffer);
+		if (first != NULL)
+		{
+			*first = buffer;
+		}
+	}
+}
+
+static PipelineElement *FindElement(GstObject *object)
+{
+	PipelineElement *record = NULL;
+	uint32_t count = __atomic_load_n(&s_elementCount, __ATOMIC_ACQUIRE);
+	uint32_t idx;
+
+	for (idx = 0; (idx < count) && (record == NULL); idx++)
+	{
+		if ((GstObject *)s_elements[idx].element == object)
+		{
+			record = &s_elements[idx];
+		}
+	}
+
+	return record;
+}
+
+/* called with s_statsMutex, a record of a detached pipeline may already belong to the next one */
+static bool IsAttached(const PipelineElement *record, const GstElement *element)
+{
+	return (s_attached != NULL) && (record->element == element);
+}
+
+/* called with s_statsMutex, the counters and the element names stay for MultiMediaPipelineStatsGet */
+static void RemoveProbes(void)
+{
+	uint32_t count = __atomic_load_n(&s_elementCount, __ATOMIC_RELAXED);
+	uint32_t idx;
+
+	if (s_attached != NULL)
+	{
+		(void)g_signal_handlers_disconnect_by_func(s_attached, (gpointer)OnElementAdded, NULL);
+		for (idx = 0; idx < s_probeCount; idx++)
+		{
+			gst_pad_remove_probe(s_probes[idx].pad, s_probes[idx].id);
+			gst_object_unref(s_probes[idx].pad);
+		}
+		s_probeCount = 0;
+		for (idx = 0; idx < count; idx++)
+		{
+			(void)g_signal_handlers_disconnect_by_data(s_elements[idx].element, &s_elements[idx]);
+			gst_object_unref(s_elements[idx].element);
+		}
+		gst_object_unref(s_attached);
+		s_attached = NULL;
+	}
+}
+
+static void CountElement(uint32_t *counter)
+{
+	(void)__atomic_fetch_add(counter, 1U, __ATOMIC_RELAXED);
+}
+
+static void UpdateMax(uint32_t *max, uint32_t value)
+{
+	uint32_t current = __atomic_load_n(max, __ATOMIC_RELAXED);
+
+	while ((value > current) &&
+		   (!__atomic_compare_exchange_n(max, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)))
+	{
+		;
+	}
+}
+
+static void CopyElement(const PipelineElement *record, MultiMediaElementStats *stats)
+{
+	(void)memcpy(stats->name, record->stats.name, sizeof(stats->name));
+	(void)memcpy(stats->factory, record->stats.factory, sizeof(stats->factory));
+	stats->kind = record->stats.kind;
+	stats->buffers = __atomic_load_n(&record->stats.buffers, __ATOMIC_RELAXED);
+	stats->bytes = __atomic_load_n(&record->stats.bytes, __ATOMIC_RELAXED);
+	stats->processSum = __atomic_load_n(&record->stats.processSum, __ATOMIC_RELAXED);
+	stats->processMax = __atomic_load_n(&record->stats.processMax, __ATOMIC_RELAXED);
+	stats->level = __atomic_load_n(&record->queueIn, __ATOMIC_RELAXED) - __atomic_load_n(&record->queueOut, __ATOMIC_RELAXED);
+	stats->levelMax = __atomic_load_n(&record->stats.levelMax, __ATOMIC_RELAXED);
+	stats->overruns = __atomic_load_n(&record->stats.overruns, __ATOMIC_RELAXED);
+	stats->underruns = __atomic_load_n(&record->stats.underruns, __ATOMIC_RELAXED);
+	stats->late = __atomic_load_n(&record->stats.late, __ATOMIC_RELAXED);
+	stats->dropped = __atomic_load_n(&record->stats.dropped, __ATOMIC_RELAXED);
+	stats->discontinuities = __atomic_load_n(&record->stats.discontinuities, __ATOMIC_RELAXED);
+	stats->warnings = __atomic_load_n(&record->stats.warnings, __ATOMIC_RELAXED);
+
+	/* a queue level is read from two counters, it is never below 0 */
+	if (stats->level > stats->levelMax)
+	{
+		stats->level = 0;
+	}
+}
+
+static gboolean OnWriteTimer(gpointer data)
+{
+	(void)data;
+	WriteFile();
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void WriteFile(void)
+{
+	MultiMediaPipelineStats pipeline;
+	MultiMediaElementStats elements[MULTIMEDIA_PIPELINE_STATS_ELEMENTS];
+	char temporary[PIPELINE_STATS_PATH_SIZE + 8];
+	uint32_t count;
+	uint32_t idx;
+	FILE *file;
+	bool written;
+
+	count = MultiMediaPipelineStatsGet(&pipeline, elements, (uint32_t)MULTIMEDIA_PIPELINE_STATS_ELEMENTS);
+
+	/* renamed over the file, so a reader never sees half of it */
+	(void)snprintf(temporary, sizeof(temporary), "%s.tmp", s_path);
+	file = fopen(temporary, "w");
+	if (file != NULL)
+	{
+		(void)fprintf(file, "{\n  \"play_id\": %d,\n  \"elapsed_ms\": %u,\n  \"elements_added\": %u,\n"
+					  "  \"warnings\": %u,\n  \"clock_lost\": %u,\n  \"buffering\": %u,\n  \"elements\": [\n",
+					  pipeline.playID, pipeline.elapsed, pipeline.elements,
+					  pipeline.warnings, pipeline.clockLost, pipeline.buffering);
+		for (idx = 0; idx < count; idx++)
+		{
+			const MultiMediaElementStats *stats = &elements[idx];
+
+			(void)fprintf(file, "    { \"name\": \"%s\", \"factory\": \"%s\", \"kind\": \"%s\", \"buffers\": %u, "
+						  "\"bytes\": %llu, \"process_us\": %llu, \"process_max_us\": %u, \"throughput\": %.1f, "
+						  "\"level\": %u, \"level_max\": %u, \"overruns\": %u, \"underruns\": %u, \"late\": %u, "
+						  "\"dropped\": %u, \"discontinuities\": %u, \"warnings\": %u }%s\n",
+						  stats->name, stats->factory, g_multiMediaElementKindNames[stats->kind], stats->buffers,
+						  (unsigned long long)stats->bytes, (unsigned long long)stats->processSum, stats->processMax,
+						  (stats->processSum > 0U) ? (((double)stats->buffers * 1000000.0) / (double)stats->processSum) : 0.0,
+						  stats->level, stats->levelMax, stats->overruns, stats->underruns, stats->late,
+						  stats->dropped, stats->discontinuities, stats->warnings,
+						  ((idx + 1U) < count) ? "," : "");
+		}
+		(void)fprintf(file, "  ]\n}\n");
+		written = (fclose(file) == 0);
+
+		if ((!written) || (rename(temporary, s_path) != 0))
+		{
+			ERROR_PRINTF("writing %s failed\n", s_path);
+			(void)remove(temporary);
+		}
+	}
+	else
+	{
+		ERROR_PRINTF("can't open %s\n", temporary);
+	}
+}
@@ -0,0 +1,360 @@
+/****************************************************************************************
+ *   FileName    : MultiMediaState.c
+ *   Description : Telechips Multimedia State Snapshot
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		/* memfd_create, F_ADD_SEALS */
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include "TCLog.h"
+#include "TCTime.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MultiMediaState.h"
+
+#define STATE_NS_PER_MS					(1000000LL)
+/* clients may map the page but neither resize nor write it, the daemon keeps writing to it */
+#ifdef F_SEAL_FUTURE_WRITE
+#define STATUS_PAGE_SEALS				(F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE | F_SEAL_SEAL)
+#else
+#define STATUS_PAGE_SEALS				(F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL)
+#endif
+
+static int64_t GetPosition(int64_t now);
+static int32_t CreateStatusPage(void);
+static void PublishStatusPage(void);
+static void NotifyStateChange(uint32_t changed);
+
+/* s_position is in ns, s_sampledAt is when it was last set */
+static MultiMediaState s_state = {0, -1, (uint32_t)MultiMediaPlaybackStopped, 0, 0, 1.0, false,
+								  (uint8_t)MultiMediaContentTypeAudio, 0, false};
+static int64_t s_position = 0;
+static int64_t s_sampledAt = 0;
+static uint32_t s_metadataGeneration = 0;
+static MultiMediaStatusPage *s_statusPage = NULL;
+static int32_t s_statusPageFd = -1;
+static pthread_mutex_t s_stateMutex = PTHREAD_MUTEX_INITIALIZER;
+static MultiMediaStateChange_cb MultiMediaStateChangeCB = NULL;
+
+void MultiMediaStateSetEventCallBack(MultiMediaStateChange_cb cb)
+{
+	(void)pthread_mutex_lock(&s_stateMutex);
+	MultiMediaStateChangeCB = cb;
+	(void)pthread_mutex_unlock(&s_stateMutex);
+}
+
+void MultiMediaStateRelease(void)
+{
+	(void)pthread_mutex_lock(&s_stateMutex);
+	if (s_statusPage != NULL)
+	{
+		/* mappings held by clients stay valid, they just stop changing */
+		(void)munmap(s_statusPage, (size_t)MULTIMEDIA_STATUS_PAGE_SIZE);
+		(void)close(s_statusPageFd);
+		s_statusPage = NULL;
+		s_statusPageFd = -1;
+	}
+	(void)pthread_mutex_unlock(&s_stateMutex);
+}
+
+void MultiMediaStateReset(int32_t playID, uint8_t content, int64_t startPosition)
+{
+	uint32_t changed = 0;
+
+	(void)pthread_mutex_lock(&s_stateMutex);
+	changed |= (s_state.playID != playID) ? MULTIMEDIA_STATE_PLAYID : 0U;
+	changed |= (s_state.playback != (uint32_t)MultiMediaPlaybackStopped) ? MULTIMEDIA_STATE_PLAYBACK : 0U;
+	changed |= (s_state.duration != 0U) ? MULTIMEDIA_STATE_DURATION : 0U;
+	changed |= (s_state.rate != 1.0) ? MULTIMEDIA_STATE_RATE : 0U;
+	changed |= s_state.seekable ? MULTIMEDIA_STATE_SEEKABLE : 0U;
+	changed |= (s_state.content != content) ? MULTIMEDIA_STATE_CONTENT : 0U;
+	changed |= (s_state.samplerate != 0) ? MULTIMEDIA_STATE_SAMPLERATE : 0U;
+	changed |= s_state.metadataValid ? MULTIMEDIA_STATE_METADATA : 0U;
+
+	s_state.playID = playID;
+	s_state.playback = (uint32_t)MultiMediaPlaybackStopped;
+	s_state.duration = 0;
+	s_state.rate = 1.0;
+	s_state.seekable = false;
+	s_state.content = content;
+	s_state.samplerate = 0;
+	s_state.metadataValid = false;
+	(void)memset(&s_state.metadata, 0, sizeof(MultiMediaMetadata));
+	s_position = startPosition;
+	s_sampledAt = TCTimeGetMonotonicNs();
+	if ((changed & MULTIMEDIA_STATE_METADATA) != 0U)
+	{
+		s_metadataGeneration++;
+	}
+	PublishStatusPage();
+	(void)pthread_mutex_unlock(&s_stateMutex);
+
+	NotifyStateChange(changed);
+}
+
+void MultiMediaStateSetResourceStatus(int32_t status)
+{
+	uint32_t changed;
+
+	(void)pthread_mutex_lock(&s_stateMutex);
+	changed = (s_state.resourceStatus != status) ? MULTIMEDIA_STATE_RESOURCE : 0U;
+	s_state.resourceStatus = status;
+	PublishStatusPage();
+	(void)pthread_mutex_unlock(&s_stateMutex);
+
+	NotifyStateChange(changed);
+}
+
+void MultiMediaStateSetPlayback(MultiMediaPlaybackState playback, double rate)
+{
+	int64_t now = TCTimeGetMonotonicNs();
+	uint32_t changed = 0;
+
+	(void)pthread_mutex_lock(&s_stateMutex);
+	/* keep what the old rate advanced so far, the new one counts from now */
+	s_position = GetPosition(now);
+	s_sampledAt = now;
+	changed |= (s_state.playback != (uint32_t)playback) ? MULTIMEDIA_STATE_PLAYBACK : 0U;
+	changed |= (s_state.rate != rate) ? MULTIMEDIA_STATE_RATE : 0U;
+	s_state.playback = (uint32_t)playback;
+	s_state.rate = rate;
+	PublishStatusPage();
+	(void)pthread_mutex_unlock(&s_stateMutex);
+
+	NotifyStateChange(changed);
+}
+
+void MultiMediaStateSetPosition(int64_t position)
+{
+	(void)pthread_mutex_lock(&s_stateMutex);
+	s_position = position;
+	s_sampledAt = TCTimeGetMonotonicNs();
+	PublishStatusPage();
+	(void)pthread_mutex_unlock(&s_stateMutex);
+}
+
+void MultiMediaStateSetDuration(int64_t duration)
+{
+	uint32_t changed;
+
+	(void)pthread_mutex_lock(&s_stateMutex);
+	changed = (s_state.duration != (uint32_t)(duration / STATE_NS_PER_MS)) ? MULTIMEDIA_STATE_DURATION : 0U;
+	s_state.duration = (uint32_t)(duration / STATE_NS_PER_MS);
+	PublishStatusPage();
+	(void)pthread_mutex_unlock(&s_stateMutex);
+
+	NotifyStateChange(changed);
+}
+
+void MultiMediaStateSetSeekable(bool seekable)
+{
+	uint32_t changed;
+
+	(void)pthread_mutex_lock(&s_stateMutex);
+	changed = (s_state.seekable != seekable) ? MULTIMEDIA_STATE_SEEKABLE : 0U;
+	s_state.seekable = seekable;
+	PublishStatusPage();
+	(void)pthread_mutex_unlock(&s_stateMutex);
+
+	NotifyStateChange(changed);
+}
+
+void MultiMediaStateSetSamplerate(int32_t samplerate)
+{
+	uint32_t changed;
+
+	(void)pthread_mutex_lock(&s_stateMutex);
+	changed = (s_state.samplerate != samplerate) ? MULTIMEDIA_STATE_SAMPLERATE : 0U;
+	s_state.samplerate = samplerate;
+	PublishStatusPage();
+	(void)pthread_mutex_unlock(&s_stateMutex);
+
+	NotifyStateChange(changed);
+}
+
+void MultiMediaStateSetMetadata(const MultiMediaMetadata *metadata)
+{
+	(void)pthread_mutex_lock(&s_stateMutex);
+	(void)memcpy(&s_state.metadata, metadata, sizeof(MultiMediaMetadata));
+	s_state.metadataValid = true;
+	s_metadataGeneration++;
+	PublishStatusPage();
+	(void)pthread_mutex_unlock(&s_stateMutex);
+
+	/* only called when the metadata changed */
+	NotifyStateChange(MULTIMEDIA_STATE_METADATA);
+}
+
+void MultiMediaStateGet(MultiMediaState *state)
+{
+	int64_t now = TCTimeGetMonotonicNs();
+
+	(void)pthread_mutex_lock(&s_stateMutex);
+	(void)memcpy(state, &s_state, sizeof(MultiMediaState));
+	state->position = (uint32_t)(GetPosition(now) / STATE_NS_PER_MS);
+	(void)pthread_mutex_unlock(&s_stateMutex);
+}
+
+int32_t MultiMediaStateGetStatusPageFd(void)
+{
+	int32_t fd = -1;
+	char path[32];
+
+	(void)pthread_mutex_lock(&s_stateMutex);
+	if ((s_statusPage != NULL) || (CreateStatusPage() == 0))
+	{
+		/* reopened read only, so the client cannot map the page writable */
+		(void)snprintf(path, sizeof(path), "/proc/self/fd/%d", s_statusPageFd);
+		fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+		{
+			ERROR_PRINTF("open %s failed: error(%d)\n", path, errno);
+		}
+	}
+	(void)pthread_mutex_unlock(&s_stateMutex);
+
+	return fd;
+}
+
+static int32_t CreateStatusPage(void)
+{
+	int32_t ret = -1;
+	int32_t fd;
+	void *addr = MAP_FAILED;
+
+	/* created when the first client asks for it, nobody pays for it before */
+	fd = memfd_create("mediaplayback-status", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0)
+	{
+		ERROR_PRINTF("memfd_create failed: error(%d)\n", errno);
+	}
+	else
+	{
+		/* sealed after the daemon mapped it, F_SEAL_FUTURE_WRITE leaves that mapping writable */
+		if (ftruncate(fd, (off_t)MULTIMEDIA_STATUS_PAGE_SIZE) == 0)
+		{
+			addr = mmap(NULL, (size_t)MULTIMEDIA_STATUS_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+
+		if ((addr == MAP_FAILED) || (fcntl(fd, F_ADD_SEALS, STATUS_PAGE_SEALS) != 0))
+		{
+			ERROR_PRINTF("status page size/map/seal failed: error(%d)\n", errno);
+			if (addr != MAP_FAILED)
+			{
+				(void)munmap(addr, (size_t)MULTIMEDIA_STATUS_PAGE_SIZE);
+			}
+			(void)close(fd);
+		}
+		else
+		{
+			s_statusPage = (MultiMediaStatusPage *)addr;
+			s_statusPageFd = fd;
+			s_statusPage->magic = MULTIMEDIA_STATUS_PAGE_MAGIC;
+			s_statusPage->version = MULTIMEDIA_STATUS_PAGE_VERSION;
+			s_statusPage->size = (uint32_t)sizeof(MultiMediaStatusPage);
+			PublishStatusPage();
+			ret = 0;
+		}
+	}
+
+	return ret;
+}
+
+/* called with s_stateMutex held, the only writer of the page */
+static void PublishStatusPage(void)
+{
+	MultiMediaStatusPage *page = s_statusPage;
+
+	if (page != NULL)
+	{
+		/* odd sequence: readers discard what they copy until it is even again */
+		__atomic_store_n(&page->sequence, page->sequence + 1U, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		page->playID = s_state.playID;
+		page->playback = s_state.playback;
+		page->position = s_position;
+		page->timestamp = s_sampledAt;
+		page->rate = s_state.rate;
+		page->duration = (int64_t)s_state.duration * STATE_NS_PER_MS;
+		page->samplerate = s_state.samplerate;
+		page->metadataGeneration = s_metadataGeneration;
+		page->resourceStatus = s_state.resourceStatus;
+		page->seekable = s_state.seekable ? 1U : 0U;
+		page->content = (uint32_t)s_state.content;
+
+		__atomic_store_n(&page->sequence, page->sequence + 1U, __ATOMIC_RELEASE);
+	}
+}
+
+static int64_t GetPosition(int64_t now)
+{
+	int64_t position = s_position;
+	int64_t duration = (int64_t)s_state.duration * STATE_NS_PER_MS;
+
+	/* the position is only sampled as often as somebody follows it */
+	if ((s_state.playback == (uint32_t)MultiMediaPlaybackPlaying) ||
+		(s_state.playback == (uint32_t)MultiMediaPlaybackTrick))
+	{
+		position += (int64_t)((double)(now - s_sampledAt) * s_state.rate);
+		if (position < 0)
+		{
+			position = 0;
+		}
+		else if ((duration != 0) && (position > duration))
+		{
+			position = duration;
+		}
+		else
+		{
+			;
+		}
+	}
+
+	return position;
+}
+
+static void NotifyStateChange(uint32_t changed)
+{
+	MultiMediaStateChange_cb cb;
+
+	if (changed != 0U)
+	{
+		(void)pthread_mutex_lock(&s_stateMutex);
+		cb = MultiMediaStateChangeCB;
+		(void)pthread_mutex_unlock(&s_stateMutex);
+
+		if (cb != NULL)
+		{
+			cb(changed);
+		}
+	}
+}
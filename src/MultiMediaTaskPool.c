@@ -0,0 +1,760 @@
+/****************************************************************************************
+ *   FileName    : MultiMediaTaskPool.c
+ *   Description : Telechips Multimedia Streaming Thread Pool
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include "TCLog.h"
+#include "TCMultiMediaType.h"
+#include "MultiMediaManager.h"
+#include "MultiMediaTaskPool.h"
+
+#define TASK_POOL_MAX_CPUS		CPU_SETSIZE
+#define TASK_POOL_RT_PRIORITY	30			/* fifo or rr given without a priority */
+
+typedef enum {
+	TaskWorkerIdle,
+	TaskWorkerBusy,
+	TaskWorkerDone				/* the task returned but was not joined yet */
+} TaskWorkerState;
+
+typedef struct stTaskWorker {
+	pthread_t thread;
+	pthread_cond_t wake;
+	GstTaskPoolFunction func;
+	gpointer data;
+	gpointer task;				/* GstTask the worker is reserved for, NULL if free */
+	MultiMediaThreadClass threadClass;
+	uint32_t index;
+	TaskWorkerState state;
+	bool created;
+} TaskWorker;
+
+typedef struct stThreadClassConfig {
+	int32_t policy;
+	int32_t priority;			/* nice value with SCHED_OTHER */
+	bool pinned;
+	cpu_set_t cpus;
+} ThreadClassConfig;
+
+typedef struct stThreadClassStatistics {
+	uint32_t threads;
+	uint32_t tasks;
+	uint32_t refused;
+} ThreadClassStatistics;
+
+typedef struct stMultiMediaTaskPool {
+	GstTaskPool parent;
+	MultiMediaThreadClass threadClass;
+} MultiMediaTaskPool;
+
+typedef struct stMultiMediaTaskPoolClass {
+	GstTaskPoolClass parent;
+} MultiMediaTaskPoolClass;
+
+static GType GetTaskPoolType(void);
+static void TaskPoolClassInit(gpointer klass, gpointer data);
+static void TaskPoolPrepare(GstTaskPool *pool, GError **error);
+static void TaskPoolCleanup(GstTaskPool *pool);
+static gpointer TaskPoolPush(GstTaskPool *pool, GstTaskPoolFunction func, gpointer data, GError **error);
+static void TaskPoolJoin(GstTaskPool *pool, gpointer id);
+static TaskWorker *GetIdleWorker(MultiMediaThreadClass threadClass, bool create);
+static TaskWorker *GetReservedWorker(MultiMediaThreadClass threadClass, gpointer task);
+static void OnTaskFinalized(gpointer data, GObject *task);
+static void *TaskWorkerThread(void *arg);
+static void ApplyThreadClass(MultiMediaThreadClass threadClass);
+static MultiMediaThreadClass GetThreadClass(GstElement *owner);
+static bool IsAudioSink(GstElement *element);
+static bool HasAudioSinkSibling(GstElement *element);
+static const gchar *GetFactoryName(GstElement *element);
+static bool ParsePolicy(const char *spec, const char **end, int32_t *policy);
+static bool ParseCpus(const char *spec, cpu_set_t *cpus);
+
+#define MULTIMEDIA_THREAD_CLASS_NAME(name, text)		text,
+const char *g_multiMediaThreadClassNames[TotalMultiMediaThreadClasses] = {
+	MULTIMEDIA_THREAD_CLASS_LIST(MULTIMEDIA_THREAD_CLASS_NAME)
+};
+
+static ThreadClassConfig s_config[TotalMultiMediaThreadClasses] = {
+	{ SCHED_FIFO, 60, false },
+	{ SCHED_OTHER, 0, false },
+	{ SCHED_OTHER, 0, false }
+};
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_done = PTHREAD_COND_INITIALIZER;
+static TaskWorker s_workers[TotalMultiMediaThreadClasses][MULTIMEDIA_TASK_POOL_THREADS];
+static ThreadClassStatistics s_statistics[TotalMultiMediaThreadClasses];
+static GstTaskPool *s_pools[TotalMultiMediaThreadClasses];
+static uint32_t s_warned = 0;			/* bit per class, real time scheduling was refused */
+static bool s_quit = false;
+
+int32_t MultiMediaTaskPoolSetClass(MultiMediaThreadClass threadClass, const char *spec)
+{
+	ThreadClassConfig config;
+	const char *next = NULL;
+	char *end = NULL;
+	bool valid = false;
+	int32_t ret = 0;
+
+	(void)memset(&config, 0, sizeof(config));
+
+	if ((threadClass < TotalMultiMediaThreadClasses) && (spec != NULL) &&
+		(ParsePolicy(spec, &next, &config.policy)))
+	{
+		valid = true;
+		if (*next == ':')
+		{
+			long priority = strtol(&next[1], &end, 10);
+			if (config.policy == SCHED_OTHER)
+			{
+				valid = ((priority >= -20L) && (priority <= 19L));
+			}
+			else
+			{
+				valid = ((priority >= (long)sched_get_priority_min(config.policy)) &&
+						 (priority <= (long)sched_get_priority_max(config.policy)));
+			}
+			config.priority = (int32_t)priority;
+			next = end;
+		}
+		else if ((config.policy != SCHED_OTHER) && (s_config[threadClass].policy != SCHED_OTHER))
+		{
+			config.priority = s_config[threadClass].priority;
+		}
+		else if (config.policy != SCHED_OTHER)
+		{
+			config.priority = TASK_POOL_RT_PRIORITY;
+		}
+		else
+		{
+			;
+		}
+
+		if (valid && (*next == '@'))
+		{
+			valid = ParseCpus(&next[1], &config.cpus);
+			config.pinned = true;
+		}
+		else if (*next != '\0')
+		{
+			valid = false;
+		}
+		else
+		{
+			;
+		}
+	}
+
+	if (valid)
+	{
+		s_config[threadClass] = config;
+		ret = 1;
+	}
+	else
+	{
+		ERROR_PRINTF("invalid %s threads(%s), policy[:priority][@cpus] with fifo, rr or other\n",
+					 (threadClass < TotalMultiMediaThreadClasses) ? g_multiMediaThreadClassNames[threadClass] : "unknown",
+					 (spec != NULL) ? spec : "null");
+	}
+
+	return ret;
+}
+
+void MultiMediaTaskPoolInitialize(void)
+{
+	uint32_t idx;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	s_quit = false;
+	for (idx = 0; idx < (uint32_t)TotalMultiMediaThreadClasses; idx++)
+	{
+		if (s_pools[idx] == NULL)
+		{
+			MultiMediaTaskPool *pool = (MultiMediaTaskPool *)g_object_new(GetTaskPoolType(), NULL);
+			pool->threadClass = (MultiMediaThreadClass)idx;
+			s_pools[idx] = GST_TASK_POOL(gst_object_ref_sink(pool));
+		}
+		INFO_PRINTF("%s threads: policy(%d), priority(%d), pinned(%d, %d cpus)\n", g_multiMediaThreadClassNames[idx],
+					s_config[idx].policy, s_config[idx].priority, s_config[idx].pinned,
+					s_config[idx].pinned ? CPU_COUNT(&s_config[idx].cpus) : 0);
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+}
+
+void MultiMediaTaskPoolRelease(void)
+{
+	uint32_t idx;
+	uint32_t worker;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	s_quit = true;
+	for (idx = 0; idx < (uint32_t)TotalMultiMediaThreadClasses; idx++)
+	{
+		for (worker = 0; worker < (uint32_t)MULTIMEDIA_TASK_POOL_THREADS; worker++)
+		{
+			if (s_workers[idx][worker].created)
+			{
+				(void)pthread_cond_signal(&s_workers[idx][worker].wake);
+			}
+		}
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	for (idx = 0; idx < (uint32_t)TotalMultiMediaThreadClasses; idx++)
+	{
+		for (worker = 0; worker < (uint32_t)MULTIMEDIA_TASK_POOL_THREADS; worker++)
+		{
+			TaskWorker *record = &s_workers[idx][worker];
+			if (record->created && (record->state != TaskWorkerBusy))
+			{
+				(void)pthread_join(record->thread, NULL);
+				(void)pthread_cond_destroy(&record->wake);
+				record->created = false;
+			}
+			else if (record->created)
+			{
+				WARN_PRINTF("%s thread %u still runs a task\n", g_multiMediaThreadClassNames[idx], worker);
+			}
+			else
+			{
+				;
+			}
+		}
+
+		INFO_PRINTF("%s threads: created(%u), tasks(%u), refused(%u)\n", g_multiMediaThreadClassNames[idx],
+					s_statistics[idx].threads, s_statistics[idx].tasks, s_statistics[idx].refused);
+
+		if (s_pools[idx] != NULL)
+		{
+			gst_object_unref(s_pools[idx]);
+			s_pools[idx] = NULL;
+		}
+	}
+}
+
+void MultiMediaTaskPoolStreamStatus(GstMessage *msg)
+{
+	GstStreamStatusType type = GST_STREAM_STATUS_TYPE_CREATE;
+	GstElement *owner = NULL;
+	const GValue *value = gst_message_get_stream_status_object(msg);
+	bool task = ((value != NULL) && (G_VALUE_HOLDS(value, GST_TYPE_TASK)));
+
+	gst_message_parse_stream_status(msg, &type, &owner);
+
+	if ((owner != NULL) && (s_pools[MultiMediaThreadAudio] != NULL))
+	{
+		MultiMediaThreadClass threadClass = GetThreadClass(owner);
+
+		if ((type == GST_STREAM_STATUS_TYPE_CREATE) && task)
+		{
+			GstTask *gstTask = GST_TASK(g_value_get_object(value));
+			TaskWorker *worker = NULL;
+
+			/* the worker is held by the task until it is finalized, a later push cannot find the class full */
+			(void)pthread_mutex_lock(&s_mutex);
+			if (!s_quit)
+			{
+				worker = GetIdleWorker(threadClass, true);
+			}
+			if (worker != NULL)
+			{
+				worker->task = gstTask;
+				g_object_weak_ref(G_OBJECT(gstTask), OnTaskFinalized, worker);
+			}
+			else
+			{
+				s_statistics[threadClass].refused++;
+			}
+			(void)pthread_mutex_unlock(&s_mutex);
+
+			if (worker != NULL)
+			{
+				DEBUG_PRINTF("%s task of %s\n", g_multiMediaThreadClassNames[threadClass], GST_OBJECT_NAME(owner));
+				gst_task_set_pool(gstTask, s_pools[threadClass]);
+			}
+			else
+			{
+				WARN_PRINTF("no %s thread left, %s keeps the default pool\n",
+							g_multiMediaThreadClassNames[threadClass], GST_OBJECT_NAME(owner));
+			}
+		}
+		else if ((type == GST_STREAM_STATUS_TYPE_ENTER) && (!task))
+		{
+			/* a thread the element created itself, posted from that thread */
+			DEBUG_PRINTF("%s thread of %s\n", g_multiMediaThreadClassNames[threadClass], GST_OBJECT_NAME(owner));
+			ApplyThreadClass(threadClass);
+		}
+		else
+		{
+			;
+		}
+	}
+}
+
+void MultiMediaTaskPoolApplyClass(MultiMediaThreadClass threadClass)
+{
+	if ((uint32_t)threadClass < (uint32_t)TotalMultiMediaThreadClasses)
+	{
+		ApplyThreadClass(threadClass);
+	}
+}
+
+static GType GetTaskPoolType(void)
+{
+	static gsize s_type = 0;
+
+	if (g_once_init_enter(&s_type) != FALSE)
+	{
+		GType type = g_type_register_static_simple(GST_TYPE_TASK_POOL, "TcMultiMediaTaskPool",
+												   (guint)sizeof(MultiMediaTaskPoolClass), TaskPoolClassInit,
+												   (guint)sizeof(MultiMediaTaskPool), NULL, (GTypeFlags)0);
+		g_once_init_leave(&s_type, type);
+	}
+
+	return (GType)s_type;
+}
+
+static void TaskPoolClassInit(gpointer klass, gpointer data)
+{
+	GstTaskPoolClass *poolClass = (GstTaskPoolClass *)klass;
+
+	(void)data;
+	poolClass->prepare = TaskPoolPrepare;
+	poolClass->cleanup = TaskPoolCleanup;
+	poolClass->push = TaskPoolPush;
+	poolClass->join = TaskPoolJoin;
+}
+
+static void TaskPoolPrepare(GstTaskPool *pool, GError **error)
+{
+	/* the threads are shared by every pool of a class and live until MultiMediaTaskPoolRelease() */
+	(void)pool;
+	(void)error;
+}
+
+static void TaskPoolCleanup(GstTaskPool *pool)
+{
+	(void)pool;
+}
+
+static gpointer TaskPoolPush(GstTaskPool *pool, GstTaskPoolFunction func, gpointer data, GError **error)
+{
+	MultiMediaThreadClass threadClass = ((MultiMediaTaskPool *)pool)->threadClass;
+	TaskWorker *worker = NULL;
+
+	/* GstTask pushes itself as data */
+	(void)pthread_mutex_lock(&s_mutex);
+	if (!s_quit)
+	{
+		worker = GetReservedWorker(threadClass, data);
+	}
+	if ((!s_quit) && (worker == NULL))
+	{
+		worker = GetIdleWorker(threadClass, true);
+	}
+	if (worker != NULL)
+	{
+		worker->func = func;
+		worker->data = data;
+		worker->state = TaskWorkerBusy;
+		s_statistics[threadClass].tasks++;
+		(void)pthread_cond_signal(&worker->wake);
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	if (worker == NULL)
+	{
+		ERROR_PRINTF("no %s thread left\n", g_multiMediaThreadClassNames[threadClass]);
+		g_set_error(error, GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "no %s thread left",
+					g_multiMediaThreadClassNames[threadClass]);
+	}
+
+	return worker;
+}
+
+static void TaskPoolJoin(GstTaskPool *pool, gpointer id)
+{
+	TaskWorker *worker = (TaskWorker *)id;
+
+	(void)pool;
+	if (worker != NULL)
+	{
+		(void)pthread_mutex_lock(&s_mutex);
+		while (worker->state == TaskWorkerBusy)
+		{
+			(void)pthread_cond_wait(&s_done, &s_mutex);
+		}
+		worker->state = TaskWorkerIdle;
+		(void)pthread_mutex_unlock(&s_mutex);
+	}
+}
+
+/* with s_mutex held */
+static TaskWorker *GetIdleWorker(MultiMediaThreadClass threadClass, bool create)
+{
+	TaskWorker *worker = NULL;
+	TaskWorker *unused = NULL;
+	uint32_t idx;
+
+	for (idx = 0; (idx < (uint32_t)MULTIMEDIA_TASK_POOL_THREADS) && (worker == NULL); idx++)
+	{
+		TaskWorker *record = &s_workers[threadClass][idx];
+		if (record->created && (record->state == TaskWorkerIdle) && (record->task == NULL))
+		{
+			worker = record;
+		}
+		else if ((!record->created) && (unused == NULL))
+		{
+			unused = record;
+		}
+		else
+		{
+			;
+		}
+	}
+
+	if ((worker == NULL) && (unused != NULL) && create)
+	{
+		int err;
+
+		unused->threadClass = threadClass;
+		unused->index = (uint32_t)(unused - s_workers[threadClass]);
+		unused->state = TaskWorkerIdle;
+		(void)pthread_cond_init(&unused->wake, NULL);
+		err = pthread_create(&unused->thread, NULL, TaskWorkerThread, unused);
+		if (err == 0)
+		{
+			unused->created = true;
+			s_statistics[threadClass].threads++;
+			worker = unused;
+		}
+		else
+		{
+			ERROR_PRINTF("pthread_create failed: error(%d)\n", err);
+			(void)pthread_cond_destroy(&unused->wake);
+		}
+	}
+	else if (worker == NULL)
+	{
+		worker = unused;
+	}
+	else
+	{
+		;
+	}
+
+	return worker;
+}
+
+/* with s_mutex held, a task restarted before it was joined gets its worker back as well */
+static TaskWorker *GetReservedWorker(MultiMediaThreadClass threadClass, gpointer task)
+{
+	TaskWorker *worker = NULL;
+	uint32_t idx;
+
+	for (idx = 0; (idx < (uint32_t)MULTIMEDIA_TASK_POOL_THREADS) && (worker == NULL); idx++)
+	{
+		TaskWorker *record = &s_workers[threadClass][idx];
+		if (record->created && (record->task == task) && (record->state != TaskWorkerBusy))
+		{
+			worker = record;
+		}
+	}
+
+	return worker;
+}
+
+static void OnTaskFinalized(gpointer data, GObject *task)
+{
+	TaskWorker *worker = (TaskWorker *)data;
+
+	(void)pthread_mutex_lock(&s_mutex);
+	if (worker->task == (gpointer)task)
+	{
+		worker->task = NULL;
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+}
+
+static void *TaskWorkerThread(void *arg)
+{
+	TaskWorker *worker = (TaskWorker *)arg;
+	char name[16];
+
+	(void)snprintf(name, sizeof(name), "%.11s-%u", g_multiMediaThreadClassNames[worker->threadClass], worker->index);
+	(void)pthread_setname_np(pthread_self(), name);
+	ApplyThreadClass(worker->threadClass);
+
+	(void)pthread_mutex_lock(&s_mutex);
+	while (!s_quit)
+	{
+		if (worker->state == TaskWorkerBusy)
+		{
+			GstTaskPoolFunction func = worker->func;
+			gpointer data = worker->data;
+
+			(void)pthread_mutex_unlock(&s_mutex);
+			func(data);
+			(void)pthread_mutex_lock(&s_mutex);
+
+			worker->func = NULL;
+			worker->data = NULL;
+			worker->state = TaskWorkerDone;
+			(void)pthread_cond_broadcast(&s_done);
+		}
+		else
+		{
+			(void)pthread_cond_wait(&worker->wake, &s_mutex);
+		}
+	}
+	(void)pthread_mutex_unlock(&s_mutex);
+
+	return NULL;
+}
+
+static void ApplyThreadClass(MultiMediaThreadClass threadClass)
+{
+	const ThreadClassConfig *config = &s_config[threadClass];
+	struct sched_param param;
+	int32_t policy = config->policy;
+	int err = 0;
+
+	(void)memset(&param, 0, sizeof(param));
+
+	if (policy != SCHED_OTHER)
+	{
+		param.sched_priority = config->priority;
+		err = pthread_setschedparam(pthread_self(), policy, &param);
+		if (err == EPERM)
+		{
+			/* no CAP_SYS_NICE, an unprivileged thread may still go up to RLIMIT_RTPRIO */
+			struct rlimit limit;
+			if ((getrlimit(RLIMIT_RTPRIO, &limit) == 0) && (limit.rlim_cur > 0U))
+			{
+				if (limit.rlim_cur < (rlim_t)config->priority)
+				{
+					param.sched_priority = (int)limit.rlim_cur;
+				}
+				err = pthread_setschedparam(pthread_self(), policy, &param);
+			}
+		}
+
+		if (err != 0)
+		{
+			if ((__atomic_fetch_or(&s_warned, 1U << (uint32_t)threadClass, __ATOMIC_RELAXED) & (1U << (uint32_t)threadClass)) == 0U)
+			{
+				WARN_PRINTF("%s threads stay SCHED_OTHER, priority(%d) refused: error(%d)\n",
+							g_multiMediaThreadClassNames[threadClass], config->priority, err);
+			}
+			policy = SCHED_OTHER;
+		}
+		else if (param.sched_priority != config->priority)
+		{
+			DEBUG_PRINTF("%s thread priority(%d) lowered to RLIMIT_RTPRIO\n",
+						 g_multiMediaThreadClassNames[threadClass], param.sched_priority);
+		}
+		else
+		{
+			;
+		}
+	}
+	else if (config->priority != 0)
+	{
+		if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), config->priority) != 0)
+		{
+			DEBUG_PRINTF("%s thread nice(%d) refused: error(%d)\n",
+						 g_multiMediaThreadClassNames[threadClass], config->priority, errno);
+		}
+	}
+	else
+	{
+		;
+	}
+
+	if (config->pinned)
+	{
+		err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &config->cpus);
+		if (err != 0)
+		{
+			WARN_PRINTF("pthread_setaffinity_np(%s) failed: error(%d)\n", g_multiMediaThreadClassNames[threadClass], err);
+		}
+	}
+}
+
+static MultiMediaThreadClass GetThreadClass(GstElement *owner)
+{
+	GstElementFactory *factory = gst_element_get_factory(owner);
+	const gchar *klass = (factory != NULL) ?
+						 gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS) : NULL;
+	const gchar *name = GetFactoryName(owner);
+	MultiMediaThreadClass threadClass = MultiMediaThreadBackground;
+
+	if (IsAudioSink(owner))
+	{
+		threadClass = MultiMediaThreadAudio;
+	}
+	else if ((name != NULL) && (strcmp(name, "queue") == 0) && HasAudioSinkSibling(owner))
+	{
+		/* the queue in the audio chain of playsink pushes into the sink */
+		threadClass = MultiMediaThreadAudio;
+	}
+	else if ((name != NULL) && (strcmp(name, "appsrc") == 0) && HasAudioSinkSibling(owner))
+	{
+		/* the crossfade output, the mixer pushes through it into the sink */
+		threadClass = MultiMediaThreadAudio;
+	}
+	else if ((name != NULL) && (strcmp(name, "multiqueue") == 0))
+	{
+		threadClass = MultiMediaThreadDecoder;
+	}
+	else if ((klass != NULL) && ((strstr(klass, "Decoder") != NULL) || (strstr(klass, "Demuxer") != NULL) ||
+								 (strstr(klass, "Parser") != NULL)))
+	{
+		threadClass = MultiMediaThreadDecoder;
+	}
+	else
+	{
+		;
+	}
+
+	return threadClass;
+}
+
+static bool IsAudioSink(GstElement *element)
+{
+	GstElementFactory *factory = gst_element_get_factory(element);
+	const gchar *klass = (factory != NULL) ?
+						 gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS) : NULL;
+
+	return ((klass != NULL) && (strstr(klass, "Sink") != NULL) && (strstr(klass, "Audio") != NULL));
+}
+
+static bool HasAudioSinkSibling(GstElement *element)
+{
+	GstObject *parent = gst_object_get_parent(GST_OBJECT(element));
+	bool found = false;
+
+	if (parent != NULL)
+	{
+		if (GST_IS_BIN(parent))
+		{
+			GList *child;
+
+			GST_OBJECT_LOCK(parent);
+			for (child = GST_BIN_CHILDREN(parent); (child != NULL) && (!found); child = child->next)
+			{
+				found = IsAudioSink(GST_ELEMENT(child->data));
+			}
+			GST_OBJECT_UNLOCK(parent);
+		}
+		gst_object_unref(parent);
+	}
+
+	return found;
+}
+
+static const gchar *GetFactoryName(GstElement *element)
+{
+	GstElementFactory *factory = gst_element_get_factory(element);
+
+	return (factory != NULL) ? gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : NULL;
+}
+
+static bool ParsePolicy(const char *spec, const char **end, int32_t *policy)
+{
+	static const struct {
+		const char *name;
+		int32_t policy;
+	} s_policies[] = {
+		{ "fifo", SCHED_FIFO },
+		{ "rr", SCHED_RR },
+		{ "other", SCHED_OTHER }
+	};
+	bool found = false;
+	uint32_t idx;
+
+	for (idx = 0; (idx < (uint32_t)(sizeof(s_policies) / sizeof(s_policies[0]))) && (!found); idx++)
+	{
+		size_t length = strlen(s_policies[idx].name);
+		if ((strncmp(spec, s_policies[idx].name, length) == 0) &&
+			((spec[length] == '\0') || (spec[length] == ':') || (spec[length] == '@')))
+		{
+			*policy = s_policies[idx].policy;
+			*end = &spec[length];
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+static bool ParseCpus(const char *spec, cpu_set_t *cpus)
+{
+	const char *next = spec;
+	bool valid = true;
+
+	CPU_ZERO(cpus);
+	while (valid && (*next != '\0'))
+	{
+		char *end = NULL;
+		unsigned long first = strtoul(next, &end, 10);
+		unsigned long last = first;
+
+		valid = (end != next);
+		if (valid && (*end == '-'))
+		{
+			next = &end[1];
+			last = strtoul(next, &end, 10);
+			valid = ((end != next) && (last >= first));
+		}
+
+		if (valid && (last < (unsigned long)TASK_POOL_MAX_CPUS))
+		{
+			for (; first <= last; first++)
+			{
+				CPU_SET((int)first, cpus);
+			}
+			next = (*end == ',') ? &end[1] : end;
+			valid = ((*end == ',') || (*end == '\0'));
+		}
+		else
+		{
+			valid = false;
+		}
+	}
+
+	return (valid && (CPU_COUNT(cpus) > 0));
+}
@@ -22,87 +22,215 @@ This source code is provided subject to the terms of a Mutual Non-Disclosure Agr
 between Telechips and Company.
 *
 ****************************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		/* CLOCK_BOOTTIME, syscall */
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
-#include <sys/time.h>
+#include <string.h>
+#include <pthread.h>
 #include <time.h>
-#include <math.h>
-#define TC_LOCALTIME(__time) localtime_r(&(__time), &g_tm)
+#include <unistd.h>
+#include <sys/syscall.h>
 #include "TCTime.h"
 
-static time_t g_time;
-static int32_t g_us;
-static struct tm g_tm;
+/* one ring per thread, so ending a span never takes a lock */
+typedef struct stTCTimeSpanBuffer {
+	struct stTCTimeSpanBuffer *next;
+	int32_t thread;
+	uint32_t count;						/* records ever written, published with release */
+	TCTimeSpanRecord records[TCTIME_SPAN_RECORDS];
+} TCTimeSpanBuffer;
 
-void SetTime(int32_t year, int32_t month, int32_t day, int32_t hour, int32_t minute, float64_t second)
+static int64_t GetClockNs(clockid_t clock);
+static void CreateSpanKey(void);
+static void ReleaseSpanBuffer(void *data);
+static TCTimeSpanBuffer *GetSpanBuffer(void);
+
+#define TCTIME_SPAN_LIST_NAME(name, text)		text,
+const char *g_tcTimeSpanNames[TotalTCTimeSpanNames] = {
+	TCTIME_SPAN_LIST(TCTIME_SPAN_LIST_NAME)
+};
+
+static pthread_once_t s_spanKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t s_spanKey;
+static int32_t s_spanKeyValid = 0;
+static pthread_mutex_t s_spanMutex = PTHREAD_MUTEX_INITIALIZER;
+static TCTimeSpanBuffer *s_spanBuffers = NULL;
+static TCTimeSpanEnded_cb s_spanEndedCB = NULL;		/* loaded on every end, set with release */
+
+int64_t TCTimeGetMonotonicNs(void)
 {
-	struct tm tmBuf;
-	tmBuf.tm_year = year - 1900;
-	tmBuf.tm_mon = month - 1;
-	tmBuf.tm_mday = day;
-	tmBuf.tm_hour = hour;
-	tmBuf.tm_min = minute;
-	tmBuf.tm_sec = (int32_t)second;
-	g_us = (int32_t)(((second - floor(second)) * 1000000) + 0.5);
-	if (g_us >= 1000000)
-	{
-		tmBuf.tm_sec++;
-		g_us %= 1000000;
-	}
-	g_time = mktime(&tmBuf);
-	(void)TC_LOCALTIME(g_time);
+	return GetClockNs(CLOCK_MONOTONIC);
 }
 
-void SetCurrentTime(void)
+int64_t TCTimeGetMonotonicMs(void)
 {
-	struct timeval timeVal;
-	(void)gettimeofday(&timeVal, NULL);
-	g_time = timeVal.tv_sec;
-	g_us = timeVal.tv_usec;
+	return GetClockNs(CLOCK_MONOTONIC) / 1000000;
+}
 
-	if (g_us >= 1000000)
-	{
-		g_time++;
-		g_us %= 1000000;
-	}
-	TC_LOCALTIME(g_time);
+int64_t TCTimeGetBoottimeNs(void)
+{
+	return GetClockNs(CLOCK_BOOTTIME);
 }
 
-int32_t GetYear(void)
+void TCTimeSpanSetEndedCallBack(TCTimeSpanEnded_cb cb)
 {
-	return g_tm.tm_year + 1900;
+	__atomic_store_n(&s_spanEndedCB, cb, __ATOMIC_RELEASE);
 }
 
-int32_t GetMonth(void)
+void TCTimeSpanBegin(TCTimeSpan *span, TCTimeSpanName name, int32_t playID)
 {
-	return g_tm.tm_mon + 1;
+	int64_t now = TCTimeGetMonotonicNs();
+
+	span->name = (uint32_t)name;
+	span->playID = playID;
+	/* 0 marks a span that is not running */
+	__atomic_store_n(&span->begin, (now != 0) ? now : 1, __ATOMIC_RELEASE);
 }
 
-int32_t GetDay(void)
+int64_t TCTimeSpanEnd(TCTimeSpan *span)
 {
-	return g_tm.tm_mday;
+	int64_t duration = -1;
+	int64_t begin;
+	TCTimeSpanBuffer *buffer;
+	TCTimeSpanRecord *record;
+	TCTimeSpanRecord ended;
+	TCTimeSpanEnded_cb endedCB;
+	uint32_t count;
+
+	/* only the first end of a span counts, whichever thread it is on */
+	begin = __atomic_exchange_n(&span->begin, 0, __ATOMIC_ACQ_REL);
+	if (begin != 0)
+	{
+		duration = TCTimeGetMonotonicNs() - begin;
+		buffer = GetSpanBuffer();
+		ended.name = span->name;
+		ended.playID = span->playID;
+		ended.thread = (buffer != NULL) ? buffer->thread : 0;
+		ended.begin = begin;
+		ended.duration = duration;
+		if (buffer != NULL)
+		{
+			count = buffer->count;
+			record = &buffer->records[count % (uint32_t)TCTIME_SPAN_RECORDS];
+			*record = ended;
+			__atomic_store_n(&buffer->count, count + 1U, __ATOMIC_RELEASE);
+		}
+
+		endedCB = __atomic_load_n(&s_spanEndedCB, __ATOMIC_ACQUIRE);
+		if (endedCB != NULL)
+		{
+			endedCB(&ended);
+		}
+	}
+
+	return duration;
 }
 
-int32_t GetHour(void)
+void TCTimeSpanCancel(TCTimeSpan *span)
 {
-	return g_tm.tm_hour;
+	__atomic_store_n(&span->begin, 0, __ATOMIC_RELEASE);
 }
 
-int32_t GetMinute(void)
+uint32_t TCTimeSpanCollect(TCTimeSpanRecord *records, uint32_t count)
 {
-	return g_tm.tm_min;
+	uint32_t collected = 0;
+	const TCTimeSpanBuffer *buffer;
+	uint32_t written;
+	uint32_t first;
+	uint32_t idx;
+
+	/* the latest records of every thread; a record overwritten while it is copied is dropped */
+	(void)pthread_mutex_lock(&s_spanMutex);
+	for (buffer = s_spanBuffers; (buffer != NULL) && (collected < count); buffer = buffer->next)
+	{
+		written = __atomic_load_n(&buffer->count, __ATOMIC_ACQUIRE);
+		first = (written > (uint32_t)TCTIME_SPAN_RECORDS) ? (written - (uint32_t)TCTIME_SPAN_RECORDS) : 0U;
+		for (idx = first; (idx < written) && (collected < count); idx++)
+		{
+			records[collected] = buffer->records[idx % (uint32_t)TCTIME_SPAN_RECORDS];
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if ((__atomic_load_n(&buffer->count, __ATOMIC_RELAXED) - idx) < (uint32_t)TCTIME_SPAN_RECORDS)
+			{
+				collected++;
+			}
+		}
+	}
+	(void)pthread_mutex_unlock(&s_spanMutex);
+
+	return collected;
 }
 
-float64_t GetSecond(void)
+static int64_t GetClockNs(clockid_t clock)
 {
-	return g_tm.tm_sec + (g_us / 1000000.0);
+	struct timespec now;
+	int64_t ns = 0;
+
+	if (clock_gettime(clock, &now) == 0)
+	{
+		ns = ((int64_t)now.tv_sec * 1000000000) + (int64_t)now.tv_nsec;
+	}
+
+	return ns;
+}
+
+static void CreateSpanKey(void)
+{
+	if (pthread_key_create(&s_spanKey, ReleaseSpanBuffer) == 0)
+	{
+		s_spanKeyValid = 1;
+	}
 }
 
-float64_t GetSecondsUntilNow(void)
+static void ReleaseSpanBuffer(void *data)
 {
-	struct timeval now;
-	(void)gettimeofday(&now, NULL);
-	return now.tv_sec - g_time + ((now.tv_usec - g_us) / 1000000.0);
+	TCTimeSpanBuffer *buffer = (TCTimeSpanBuffer *)data;
+	TCTimeSpanBuffer **link;
+
+	(void)pthread_mutex_lock(&s_spanMutex);
+	for (link = &s_spanBuffers; *link != NULL; link = &(*link)->next)
+	{
+		if (*link == buffer)
+		{
+			*link = buffer->next;
+			break;
+		}
+	}
+	(void)pthread_mutex_unlock(&s_spanMutex);
+	free(buffer);
 }
 
+static TCTimeSpanBuffer *GetSpanBuffer(void)
+{
+	TCTimeSpanBuffer *buffer = NULL;
+
+	(void)pthread_once(&s_spanKeyOnce, CreateSpanKey);
+	if (s_spanKeyValid != 0)
+	{
+		buffer = (TCTimeSpanBuffer *)pthread_getspecific(s_spanKey);
+		if (buffer == NULL)
+		{
+			buffer = (TCTimeSpanBuffer *)calloc(1, sizeof(TCTimeSpanBuffer));
+			if (buffer != NULL)
+			{
+				buffer->thread = (int32_t)syscall(SYS_gettid);
+				if (pthread_setspecific(s_spanKey, buffer) == 0)
+				{
+					(void)pthread_mutex_lock(&s_spanMutex);
+					buffer->next = s_spanBuffers;
+					s_spanBuffers = buffer;
+					(void)pthread_mutex_unlock(&s_spanMutex);
+				}
+				else
+				{
+					free(buffer);
+					buffer = NULL;
+				}
+			}
+		}
+	}
+
+	return buffer;
+}
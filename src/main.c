@@ -37,13 +37,28 @@ between Telechips and Company.
 #endif
 #include "TCLog.h"
 #include "MultiMediaManager.h"
+#include "MultiMediaState.h"
 #include "MediaPlaybackDBus.h"
+#include "MediaPlaybackChannel.h"
+#include "MediaPlaybackTrace.h"
+#include "MediaLibrary.h"
+#include "AlbumArtThumbnail.h"
+#include "AlbumArtCache.h"
+#include "AlbumArtSharedMemory.h"
+#include "MultiMediaPipelineStats.h"
+#include "MultiMediaTaskPool.h"
+#include "AudioEqualizer.h"
+#include "AudioLoudness.h"
+#include "AudioCrossfade.h"
 
 #define STACK_BUF_SIZE 100
 
 static void SignalHandler(int32_t sig);
 static void Daemonize(void);
 static int32_t InitializeMultimediaInterface(void);
+static void InitializeMediaLibrary(const char *indexDir);
+static void OnLibraryScanCompleted(const char *root, uint32_t count, int32_t result);
+static void InitializeAlbumArtThumbnail(void);
 static void usage(void);
 
 static GMainLoop *s_mainLoop = NULL;
@@ -57,7 +72,12 @@ int main(int argc, char *argv[])
 	char *audioSink = NULL;
 	char *audioDevice = NULL;
 	char *videoDevice = NULL;
+	char *videoSink = NULL;
+	char *libraryDir = NULL;
 	int32_t daemonize = 1;
+	int32_t albumArtSharedMemory = 1;
+	int32_t albumArtOnRequest = 0;
+	int32_t positionBroadcast = 1;
 	int32_t debugLevel = TCLogLevelWarn;
 
 	if (argc > 1)
@@ -112,6 +132,213 @@ int main(int argc, char *argv[])
 					ret = 0;
 				}
 			}
+			else if (strncmp(argv[idx], "--video-sink", 12) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					videoSink = argv[idx+1];
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--library-dir", 13) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					libraryDir = argv[idx+1];
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--albumart-thumbnail", 20) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = AlbumArtThumbnailAddSize(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--albumart-memfd-only", 21) == 0)
+			{
+				albumArtSharedMemory = 0;
+			}
+			else if (strncmp(argv[idx], "--albumart-shm-on-request", 25) == 0)
+			{
+				albumArtOnRequest = 1;
+			}
+			else if (strncmp(argv[idx], "--albumart-shm-slots", 20) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = AlbumArtSharedMemorySetSlots(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--control-socket", 16) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = MediaPlaybackChannelSetPath(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--trace-ring", 12) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = MediaPlaybackTraceSetSize(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--no-position-broadcast", 23) == 0)
+			{
+				positionBroadcast = 0;
+			}
+			else if (strncmp(argv[idx], "--albumart-format", 17) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = AlbumArtThumbnailSetFormat(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--albumart-cache-size", 21) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = AlbumArtCacheSetBudget(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--albumart-cache-dir", 20) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = AlbumArtCacheSetDirectory(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--pipeline-stats-interval", 25) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = MultiMediaPipelineStatsSetInterval(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--pipeline-stats", 16) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = MultiMediaPipelineStatsSetFile(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--no-equalizer", 14) == 0)
+			{
+				AudioEqualizerDisable();
+			}
+			else if (strncmp(argv[idx], "--equalizer", 11) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = AudioEqualizerSetPreset(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--no-loudness", 13) == 0)
+			{
+				AudioLoudnessDisable();
+			}
+			else if (strncmp(argv[idx], "--loudness-target", 17) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = AudioLoudnessSetTarget(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--crossfade", 11) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = AudioCrossfadeSetLength(argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--audio-threads", 15) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = MultiMediaTaskPoolSetClass(MultiMediaThreadAudio, argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--decoder-threads", 17) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = MultiMediaTaskPoolSetClass(MultiMediaThreadDecoder, argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
+			else if (strncmp(argv[idx], "--background-threads", 20) == 0)
+			{
+				if(argv[idx+1] != NULL)
+				{
+					ret = MultiMediaTaskPoolSetClass(MultiMediaThreadBackground, argv[idx+1]);
+				}
+				else
+				{
+					ret = 0;
+				}
+			}
 			else if((strncmp(argv[idx], "--help", 6) == 0)||
 				(strncmp(argv[idx], "-h", 2) == 0))
 			{
@@ -151,7 +378,8 @@ int main(int argc, char *argv[])
 			{
 				debugLevel = TCLogLevelDebug;
 			}
-			TCLogSetLevel(debugLevel);
+			MultiMediaSetDebugLevel(debugLevel);
+			(void)MediaPlaybackTraceInitialize();
 
 			MediaPlaybackDBusInitialize();
 			(void)setenv("PULSE_PROP_media.role", "media", 1);
@@ -173,11 +401,41 @@ int main(int argc, char *argv[])
 					MultiMediaSetV4LDevice(videoDevice);
 				}
 
+				if(videoSink != NULL)
+				{
+					MultiMediaSetVideoSink(videoSink);
+				}
+
+				MultiMediaSetAlbumArtSharedMemory(albumArtSharedMemory);
+				MultiMediaSetAlbumArtSharedMemoryOnRequest(albumArtOnRequest);
+				MediaPlaybackSetPositionBroadcast(positionBroadcast);
+
+				InitializeMediaLibrary(libraryDir);
+				(void)AlbumArtCacheInitialize();
+				InitializeAlbumArtThumbnail();
+				MultiMediaPipelineStatsInitialize();
+				MultiMediaTaskPoolInitialize();
+				if (AudioLoudnessInitialize(libraryDir) == 1)
+				{
+					AudioLoudnessAnalyzeLibrary();
+				}
+				else
+				{
+					ERROR_PRINTF("AudioLoudness initialize failed\n");
+				}
+
 				g_main_loop_run(s_mainLoop);
 				g_main_loop_unref(s_mainLoop);
 				s_mainLoop = NULL;
 
+				AudioLoudnessRelease();
+				MediaLibraryRelease();
+				AlbumArtThumbnailRelease();
+				/* its folder worker calls into the player */
+				AlbumArtCacheRelease();
 				MultiMediaRelease();
+				MultiMediaPipelineStatsRelease();
+				MultiMediaTaskPoolRelease();
 				MediaPlaybackDBusRelease();
 
 			}
@@ -186,6 +444,7 @@ int main(int argc, char *argv[])
 				ERROR_PRINTF("MediaPlayback initialize failed\n");
 				ret = -1;
 			}
+			MediaPlaybackTraceRelease();
 		}
 		else
 		{
@@ -301,18 +560,59 @@ static int32_t InitializeMultimediaInterface(void)
 		cb.MultiMediaPlayStoppedCB = MediaPlaybackEmitStopped;
 		cb.MultiMediaPlayTimeChangeCB = MediaPlaybackEmitPlayPosition;
 		cb.MultiMediaTotalTimeChangeCB = MediaPlaybackEmitDuration;
+		cb.MultiMediaPositionChangeCB = MediaPlaybackEmitPosition;
 		cb.MultiMediaID3InformationCB = MediaPlaybackEmitPlayTaginfo;
 		cb.MultiMediaAlbumArtCB = MediaPlaybackEmitAlbumart;
 		cb.MultiMediaPlayCompletedCB = MediaPlaybackEmitPlayEnded;
 		cb.MultiMediaSeekCompletedCB = MediaPlaybackEmitSeekCompleted;
 		cb.MultiMediaErrorOccurredCB = MediaPlaybackEmitError;
 		cb.MultiMediaSamplerateCB =  MediaPlaybackEmitSamplerate;
+		cb.MultiMediaMetadataCB = MediaPlaybackEmitMetadata;
 		
 		SetEventCallBackFunctions(&cb);
+		MultiMediaStateSetEventCallBack(MediaPlaybackPropertiesChanged);
+		AudioCrossfadeSetEventCallBack(MediaPlaybackEmitCrossfade);
 	}
 	return ret;
 }
 
+static void InitializeMediaLibrary(const char *indexDir)
+{
+	TcMediaLibraryEventCB cb;
+
+	cb.MediaLibraryScanProgressCB = MediaPlaybackEmitLibraryProgress;
+	cb.MediaLibraryScanCompletedCB = OnLibraryScanCompleted;
+	MediaLibrarySetEventCallBackFunctions(&cb);
+
+	if (MediaLibraryInitialize(indexDir) != 1)
+	{
+		ERROR_PRINTF("MediaLibrary initialize failed\n");
+	}
+}
+
+/* the loudness of the tracks a scan found is measured in the background */
+static void OnLibraryScanCompleted(const char *root, uint32_t count, int32_t result)
+{
+	MediaPlaybackEmitLibraryCompleted(root, count, result);
+	if (result == (int32_t)MediaLibraryScanCompleted)
+	{
+		AudioLoudnessAnalyzeLibrary();
+	}
+}
+
+static void InitializeAlbumArtThumbnail(void)
+{
+	TcAlbumArtThumbnailEventCB cb;
+
+	cb.AlbumArtThumbnailCompletedCB = MediaPlaybackEmitAlbumArtThumbnail;
+	AlbumArtThumbnailSetEventCallBackFunctions(&cb);
+
+	if (AlbumArtThumbnailInitialize() != 1)
+	{
+		ERROR_PRINTF("AlbumArtThumbnail initialize failed\n");
+	}
+}
+
 static void usage (void)
 {
 	(void)fprintf(stderr, "media-playback : Telechips mulitmedia playback daemon.\n");
@@ -322,6 +622,28 @@ static void usage (void)
 	(void)fprintf(stderr, "\t--audio-sink sink-name : set GSteamer audio sink, default (%s) \n",DEFAULT_AUDIO_SINK_NAME);
 	(void)fprintf(stderr, "\t--audio-device device-name : set device of audio-sink, default (%s)\n", ALSA_DEFAULT_DEVICE_NAME);
 	(void)fprintf(stderr, "\t--vidoe-device device-name : set device of video-sink(v4l2sink) device, default (%s)\n", V4L_DEFAULT_DEVICE_NAME);
+	(void)fprintf(stderr, "\t--video-sink sink-name : set GStreamer video sink, default (%s)\n", VIDEO_SINK_NAME);
+	(void)fprintf(stderr, "\t--library-dir directory : set directory of media library index, default (%s)\n", MEDIA_LIBRARY_DEFAULT_INDEX_DIR);
+	(void)fprintf(stderr, "\t--albumart-thumbnail WIDTHxHEIGHT : publish album art scaled to fit the size, up to %d times\n", ALBUMART_THUMBNAIL_MAX_SIZES);
+	(void)fprintf(stderr, "\t--albumart-format argb8888|rgb565 : set pixel format of album art thumbnails, default (argb8888)\n");
+	(void)fprintf(stderr, "\t--albumart-cache-size kilobytes : set memory budget of the album art cache, default (%d)\n", ALBUMART_CACHE_DEFAULT_BUDGET);
+	(void)fprintf(stderr, "\t--albumart-cache-dir directory : keep scaled album art in the directory across restarts\n");
+	(void)fprintf(stderr, "\t--albumart-memfd-only : serve album art only as memfd, don't create the shared memory (%d)\n", KEY_NUM);
+	(void)fprintf(stderr, "\t--albumart-shm-on-request : copy album art into the shared memory only when a client asks for its key\n");
+	(void)fprintf(stderr, "\t--albumart-shm-slots count : keep up to %d images in the shared memory, each of MEM_SIZE / count, default (%d)\n", ALBUMART_SHM_MAX_SLOTS, ALBUMART_SHM_DEFAULT_SLOTS);
+	(void)fprintf(stderr, "\t--control-socket path : also take calls and send events on a Unix socket, bypassing the bus\n");
+	(void)fprintf(stderr, "\t--no-position-broadcast : send the play position only to subscribed clients\n");
+	(void)fprintf(stderr, "\t--trace-ring entries : record hot path events in %s for TCMediaPlaybackTraceDump\n", MEDIAPLAYBACK_TRACE_NAME);
+	(void)fprintf(stderr, "\t--pipeline-stats file : write the pipeline statistics to the file as JSON\n");
+	(void)fprintf(stderr, "\t--pipeline-stats-interval seconds : set how often the file is written, default (%d)\n", MULTIMEDIA_PIPELINE_STATS_DEFAULT_INTERVAL);
+	(void)fprintf(stderr, "\t--equalizer preset : start with the equalizer preset, default (flat)\n");
+	(void)fprintf(stderr, "\t--no-equalizer : play without the equalizer\n");
+	(void)fprintf(stderr, "\t--loudness-target LUFS : normalize tracks to the loudness, default (%.0f)\n", AUDIO_LOUDNESS_DEFAULT_TARGET);
+	(void)fprintf(stderr, "\t--no-loudness : play tracks at the level they were mastered\n");
+	(void)fprintf(stderr, "\t--crossfade seconds : fade from track to track over the seconds, 0 for gapless, up to %d\n", AUDIO_CROSSFADE_MAX_LENGTH / 1000);
+	(void)fprintf(stderr, "\t--audio-threads policy[:priority][@cpus] : schedule the audio sink threads, default (fifo:60)\n");
+	(void)fprintf(stderr, "\t--decoder-threads policy[:priority][@cpus] : schedule the demuxer and decoder threads, default (other)\n");
+	(void)fprintf(stderr, "\t--background-threads policy[:priority][@cpus] : schedule the other streaming threads, default (other)\n");
 	(void)fprintf(stderr, "\t--no-daemon : Don't fork\n");
 	(void)fprintf(stderr, "\t--help or -h : show this message\n");
 }
@@ -0,0 +1,191 @@
+/****************************************************************************************
+ *   FileName    : TraceDump.c
+ *   Description : Telechips Media Playback Trace Ring Dump
+ ****************************************************************************************
+ *
+ *   TCC Version 1.0
+ *   Copyright (c) Telechips Inc.
+ *   All rights reserved
+
+This source code contains confidential information of Telechips.
+Any unauthorized use without a written permission of Telechips including not limited
+to re-distribution in source or binary form is strictly prohibited.
+This source code is provided AS IS and nothing contained in this source code
+shall constitute any express or implied warranty of any kind, including without limitation,
+any warranty of merchantability, fitness for a particular purpose or non-infringement of any patent,
+copyright or other third party intellectual property right.
+No warranty is made, express or implied, regarding the informations accuracy,
+completeness, or performance.
+In no event shall Telechips be liable for any claim, damages or other liability arising from,
+out of or in connection with this source code or the use in the source code.
+This source code is provided subject to the terms of a Mutual Non-Disclosure Agreement
+between Telechips and Company.
+*
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "DBusMsgDef.h"
+#include "MediaPlaybackTrace.h"
+#include "TCTime.h"
+
+/*
+ * Prints the trace ring of TCMediaPlayback --trace-ring, oldest record
+ * first. The ring is read from MEDIAPLAYBACK_TRACE_NAME, or from a copy of
+ * /dev/shm/tc-mediaplayback-trace given as argument, and may be read while
+ * the daemon runs or after it died.
+ *
+ *   TCMediaPlaybackTraceDump [file]
+ */
+#define TRACE_FORMAT_ENTRY(name, format)		format,
+#define TRACE_NAME_ENTRY(name, format)			#name,
+#define TRACE_SPAN_ENTRY(name, text)			text,
+
+static const char *s_formats[TotalMediaPlaybackTracePoints] = {
+	MEDIAPLAYBACK_TRACE_LIST(TRACE_FORMAT_ENTRY)
+};
+
+static const char *s_names[TotalMediaPlaybackTracePoints] = {
+	MEDIAPLAYBACK_TRACE_LIST(TRACE_NAME_ENTRY)
+};
+
+static const char *s_spanNames[TotalTCTimeSpanNames] = {
+	TCTIME_SPAN_LIST(TRACE_SPAN_ENTRY)
+};
+
+static void PrintEntry(const MediaPlaybackTraceEntry *entry)
+{
+	(void)printf("%10llu.%06llu [%5d] ",
+				 (unsigned long long)(entry->timestamp / 1000000000ULL),
+				 (unsigned long long)((entry->timestamp % 1000000000ULL) / 1000ULL),
+				 entry->thread);
+
+	if (entry->point < (uint32_t)TotalMediaPlaybackTracePoints)
+	{
+		(void)printf("%-13s ", s_names[entry->point]);
+		(void)printf(s_formats[entry->point], (long long)entry->args[0], (long long)entry->args[1],
+					 (long long)entry->args[2], (long long)entry->args[3]);
+
+		if ((entry->point == (uint32_t)MediaPlaybackTraceSignal) &&
+			(entry->args[0] >= 0) && (entry->args[0] < (int64_t)TotalSignalMediaPlaybackEvents))
+		{
+			(void)printf(" %s", g_signalMediaPlaybackEventNames[entry->args[0]]);
+		}
+		else if ((entry->point == (uint32_t)MediaPlaybackTraceSpan) &&
+				 (entry->args[0] >= 0) && (entry->args[0] < (int64_t)TotalTCTimeSpanNames))
+		{
+			(void)printf(" %s", s_spanNames[entry->args[0]]);
+		}
+		else
+		{
+			;
+		}
+	}
+	else
+	{
+		(void)printf("unknown point(%u)", entry->point);
+	}
+	(void)printf("\n");
+}
+
+static int32_t Dump(const uint8_t *addr, size_t size)
+{
+	int32_t ret = -1;
+	const MediaPlaybackTraceHeader *header = (const MediaPlaybackTraceHeader *)(const void *)addr;
+	const MediaPlaybackTraceEntry *entries;
+	MediaPlaybackTraceEntry entry;
+	uint64_t head;
+	uint64_t record;
+	uint64_t skipped = 0;
+
+	if ((size < sizeof(MediaPlaybackTraceHeader)) ||
+		(header->magic != MEDIAPLAYBACK_TRACE_MAGIC) || (header->version != MEDIAPLAYBACK_TRACE_VERSION) ||
+		(header->entrySize != (uint32_t)sizeof(MediaPlaybackTraceEntry)) || (header->entryCount == 0U) ||
+		(size < ((size_t)header->headerSize + ((size_t)header->entryCount * sizeof(MediaPlaybackTraceEntry)))))
+	{
+		(void)fprintf(stderr, "not a trace ring of version %d\n", MEDIAPLAYBACK_TRACE_VERSION);
+	}
+	else
+	{
+		entries = (const MediaPlaybackTraceEntry *)(const void *)(addr + header->headerSize);
+		head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+		record = (head > (uint64_t)header->entryCount) ? (head - (uint64_t)header->entryCount) : 0U;
+
+		for (; record < head; record++)
+		{
+			const MediaPlaybackTraceEntry *source = &entries[record & ((uint64_t)header->entryCount - 1U)];
+
+			/* an entry being rewritten by the daemon no longer holds this record */
+			entry = *source;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if ((entry.sequence == (record + 1U)) &&
+				(__atomic_load_n(&source->sequence, __ATOMIC_RELAXED) == (record + 1U)))
+			{
+				PrintEntry(&entry);
+			}
+			else
+			{
+				skipped++;
+			}
+		}
+
+		(void)fprintf(stderr, "%llu records written, %llu skipped\n",
+					  (unsigned long long)head, (unsigned long long)skipped);
+		ret = 0;
+	}
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t ret = 1;
+	int32_t fd;
+	struct stat status;
+	void *addr;
+
+	if (argc > 2)
+	{
+		(void)fprintf(stderr, "usage: %s [file]\n", argv[0]);
+	}
+	else
+	{
+		fd = (argc == 2) ? open(argv[1], O_RDONLY | O_CLOEXEC) :
+						   shm_open(MEDIAPLAYBACK_TRACE_NAME, O_RDONLY | O_CLOEXEC, 0);
+		if (fd < 0)
+		{
+			(void)fprintf(stderr, "open %s failed: %s\n", (argc == 2) ? argv[1] : MEDIAPLAYBACK_TRACE_NAME,
+						  strerror(errno));
+		}
+		else
+		{
+			if ((fstat(fd, &status) == 0) && (status.st_size > 0))
+			{
+				addr = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+				if (addr != MAP_FAILED)
+				{
+					ret = (Dump((const uint8_t *)addr, (size_t)status.st_size) == 0) ? 0 : 1;
+					(void)munmap(addr, (size_t)status.st_size);
+				}
+				else
+				{
+					(void)fprintf(stderr, "mmap failed: %s\n", strerror(errno));
+				}
+			}
+			else
+			{
+				(void)fprintf(stderr, "empty trace ring\n");
+			}
+			(void)close(fd);
+		}
+	}
+
+	return ret;
+}